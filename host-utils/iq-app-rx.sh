@@ -41,7 +41,7 @@ if [ $fifo -gt $[$maxsize/2] ];then
 fi
 
 # Use second half of iqflood region for TX FIFO i.e. 128KB fifo at offset iqfloodSize/2 
-taskset 0x4 iq_app -r -c 0 -f $1 -s $2 -F $[$maxsize/2] $fifo &
+iq_app -A 2 -P 80 -L -r -c 0 -f $1 -s $2 -F $[$maxsize/2] $fifo &
 ./iq-start-rxfifo.sh $fifo4k
  
  
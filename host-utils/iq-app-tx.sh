@@ -39,5 +39,5 @@ if [ $fifo -gt $[$maxsize/2] ];then
 fi
 
 # Use first half of iqflood region for TX FIFO i.e. 32KB fifo at offset 0 
-taskset 0x8 iq_app -t -f $1 -F 0x00000000 $fifo &
+iq_app -A 3 -P 80 -L -t -f $1 -F 0x00000000 $fifo &
 ./iq-start-txfifo.sh $fifo4k
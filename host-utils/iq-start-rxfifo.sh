@@ -6,8 +6,9 @@
 
 print_usage()
 {
-echo "usage: ./iq-start-rxfifo.sh <fifo size num 4KB>"
+echo "usage: ./iq-start-rxfifo.sh <fifo size num 4KB> [msi every n rx chunks] [msi watermark n rx chunks]"
 echo "ex : ./iq-start-rxfifo.sh 8"
+echo "ex : ./iq-start-rxfifo.sh 8 4 : raise MSI every 4 chunks written in fifo"
 }
 
 # check parameters
@@ -33,6 +34,13 @@ if [ $1 -gt $[$maxsize/2/4096] ];then
         exit 1
 fi
 
+# optional MSI notification, 0 disables
+msi_every=${2:-0}
+msi_wm=${3:-0}
+cmd=`printf "0x%X\n" $[0x07800000 + $msi_wm * 256 + $msi_every]`
+vspa_mbox send 0 0 $cmd 0
+vspa_mbox recv 0 0
+
 cmd=`printf "0x%X\n" $[0x06900000 + $1]`
 vspa_mbox send 0 0 $cmd $buffep
 vspa_mbox recv 0 0
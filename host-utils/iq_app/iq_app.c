@@ -18,10 +18,12 @@
 #include <sys/ioctl.h>
 #include <sys/timerfd.h>
 #include <sys/mman.h>
+#include <sys/resource.h>
 #include <errno.h>
 #include <stdbool.h>
 #include <pthread.h>
 #include <sched.h>
+#include <time.h>
 #include <assert.h>
 #include <semaphore.h>
 #include <signal.h>
@@ -30,12 +32,17 @@
 #include <la9310_host_if.h>
 
 #include "iq_app.h"
+#include "iq_capture.h"
 #include "imx8-host.h"
 #include "l1-trace-host.h"
 #include "lib_iqplayer_api.h"
 
 int process_ant_tx_streaming_app(void *arg);
 int process_ant_rx_streaming_app(void *arg);
+int process_ant_rx_capture_app(void *arg);
+int process_ant_tx_mmap_app(void *arg);
+int process_full_duplex_app(void);
+static void stream_rt_setup(stream_ctx_t *ctx, const char *name);
 
 static const char *FilePath;
 uint32_t file_size=0;
@@ -51,6 +58,41 @@ uint32_t RxChanID;
 uint32_t modem_ddr_fifo_start;
 uint32_t modem_ddr_fifo_size;
 
+/* fifo wait policy (spin by default), timeout lets loops check running flag */
+uint32_t wait_policy = IQ_WAIT_SPIN;
+uint32_t wait_sample_rate;
+#define IQ_APP_WAIT_TIMEOUT_NS 100000000ULL
+
+/* doorbell coalescing (off by default) */
+uint32_t doorbell_min_size;
+uint32_t doorbell_max_us;
+
+/* tx file playback from mmap instead of malloc+fread, MAP_POPULATE prefaults whole file */
+#define IQ_APP_MMAP_SEQUENTIAL 1
+#define IQ_APP_MMAP_POPULATE 2
+uint32_t tx_mmap;
+
+/* streaming rx capture to disk, files rotated every capture_rotate_size bytes / capture_rotate_sec (0 : never) */
+uint32_t capture_stream;
+uint64_t capture_rotate_size;
+uint32_t capture_rotate_sec;
+
+/* full duplex : tx fifo (-T), rx fifo (-F) split between channels, rx files <duplex_rx_path>.rx<chan> */
+#define IQ_APP_MAX_RX_CHAN 4
+int duplex_cpu = -1;
+uint32_t duplex_tx_fifo_start;
+uint32_t duplex_tx_fifo_size;
+static const char *duplex_rx_path;
+
+/* real time setup of each stream thread : cpu (-A, -d), SCHED_FIFO priority or SCHED_DEADLINE reservation */
+int rt_cpu = -1;
+int rt_priority;
+uint32_t rt_dl_runtime_us;
+uint32_t rt_dl_period_us;
+uint32_t rt_mlockall;
+uint32_t rt_check_isolation;
+uint32_t rt_jitter_ms = 100;
+
 void print_host_trace(void);
 
 modinfo_t mi;
@@ -139,6 +181,19 @@ void print_cmd_help(void) {
     fprintf(stderr, "\n|\t-c	RX chanID 0-3 (0 default)");
     fprintf(stderr, "\n|\t-a    <poffset> <size>  Buffer in DDR (in IQFLOOD region)");
     fprintf(stderr, "\n|\t-f    <poffset> <size>  Fifo in DDR (in IQFLOOD region)");
+    fprintf(stderr, "\n|\t-w    <policy> <rate>  Fifo wait policy 0:spin 1:yield 2:sleep 3:adaptive, sample rate in Hz");
+    fprintf(stderr, "\n|\t-b    <bytes> <us>  Coalesce fifo doorbells, publish every <bytes> or <us>");
+    fprintf(stderr, "\n|\t-m    <mode>  Tx file playback from mmap 1:sequential readahead 2:populate");
+    fprintf(stderr, "\n|\t-d    <cpu>  Full duplex, tx and all rx channels, one thread per stream pinned from <cpu> (-1 : no)");
+    fprintf(stderr, "\n|\t-T    <poffset> <size>  Full duplex tx Fifo in DDR (in IQFLOOD region), -F is rx Fifo of all channels");
+    fprintf(stderr, "\n|\t-o    <file>  Full duplex rx output, one <file>.rx<chan> per channel");
+    fprintf(stderr, "\n|\t-A    <cpu>  Stream thread cpu affinity");
+    fprintf(stderr, "\n|\t-P    <prio>  Stream threads SCHED_FIFO priority");
+    fprintf(stderr, "\n|\t-D    <runtime us> <period us>  Stream threads SCHED_DEADLINE reservation");
+    fprintf(stderr, "\n|\t-L	mlockall() process memory");
+    fprintf(stderr, "\n|\t-I	Check stream cpus are isolated / nohz_full");
+    fprintf(stderr, "\n|\t-J    <ms>  Poll loop / wake-up jitter measure per stream at startup (100 default, 0 : off)");
+    fprintf(stderr, "\n|\t-S    <MB> <s>  Rx streaming capture to file, rotated every <MB> or <s> (0 : no rotation)");
     fprintf(stderr, "\n|\t-v	version");
     fprintf(stderr, "\n++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++"
                     "++++++++++\n");
@@ -146,6 +201,7 @@ void print_cmd_help(void) {
 }
 
 int main(int argc, char *argv[]) {
+    stream_ctx_t ctx = { 0 };
     int32_t c, i, ret;
     command_e command = 0;
     struct stat status;
@@ -160,7 +216,7 @@ int main(int argc, char *argv[]) {
     signal(SIGUSR1, sigusr1_process);
 
     /* command line parser */
-    while ((c = getopt(argc, argv, "htrF:f:c:s:")) != EOF) {
+    while ((c = getopt(argc, argv, "htrF:f:c:s:w:b:S:m:d:T:o:A:P:D:LIJ:")) != EOF) {
         switch (c) {
         case 'h':
             print_cmd_help();
@@ -185,6 +241,52 @@ int main(int argc, char *argv[]) {
         case 'f':
             FilePath = argv[optind - 1];
             break;
+        case 'w':
+            wait_policy = strtoul(argv[optind - 1], 0, 0);
+            wait_sample_rate = strtoul(argv[optind], 0, 0);
+            break;
+        case 'b':
+            doorbell_min_size = strtoul(argv[optind - 1], 0, 0);
+            doorbell_max_us = strtoul(argv[optind], 0, 0);
+            break;
+        case 'm':
+            tx_mmap = strtoul(argv[optind - 1], 0, 0);
+            break;
+        case 'd':
+            command = OP_FULL_DUPLEX;
+            duplex_cpu = strtol(argv[optind - 1], 0, 0);
+            break;
+        case 'T':
+            duplex_tx_fifo_start = strtoull(argv[optind - 1], 0, 0);
+            duplex_tx_fifo_size = strtoul(argv[optind], 0, 0);
+            break;
+        case 'o':
+            duplex_rx_path = argv[optind - 1];
+            break;
+        case 'A':
+            rt_cpu = strtol(argv[optind - 1], 0, 0);
+            break;
+        case 'P':
+            rt_priority = strtol(argv[optind - 1], 0, 0);
+            break;
+        case 'D':
+            rt_dl_runtime_us = strtoul(argv[optind - 1], 0, 0);
+            rt_dl_period_us = strtoul(argv[optind], 0, 0);
+            break;
+        case 'L':
+            rt_mlockall = 1;
+            break;
+        case 'I':
+            rt_check_isolation = 1;
+            break;
+        case 'J':
+            rt_jitter_ms = strtoul(argv[optind - 1], 0, 0);
+            break;
+        case 'S':
+            capture_stream = 1;
+            capture_rotate_size = strtoull(argv[optind - 1], 0, 0) * 1024 * 1024;
+            capture_rotate_sec = strtoul(argv[optind], 0, 0);
+            break;
         default:
             print_cmd_help();
             exit(1);
@@ -220,37 +322,85 @@ int main(int argc, char *argv[]) {
         exit(EXIT_FAILURE);
     }
 
+    if (rt_mlockall && iq_rt_lock_memory())
+        printf("\n mlockall failed, running with pageable memory\n");
+
     ret = iq_player_init(v_iqflood_ddr_addr, mi.iqflood.size, v_la9310_bar2);
     if (!ret) {
         printf("\n TX : iq_player_init failed\n");
         fflush(stdout);
         return 0;
     }
+    iq_player_init_wait(wait_policy, wait_sample_rate);
+    iq_player_init_doorbell(doorbell_min_size, doorbell_max_us);
 
     /* start Tx/Rx */
+    ctx.chan = RxChanID;
+    ctx.path = FilePath;
+    ctx.fifo_start = modem_ddr_fifo_start;
+    ctx.fifo_size = modem_ddr_fifo_size;
+    ctx.cpu = rt_cpu;
+    if (command == OP_TX_ONLY || command == OP_RX_ONLY)
+        stream_rt_setup(&ctx, command == OP_TX_ONLY ? "TX" : "RX");
+    ret = 0;
     if (command == OP_TX_ONLY) {
-        process_ant_tx_streaming_app(NULL);
+        if (tx_mmap)
+            process_ant_tx_mmap_app(&ctx);
+        else
+            process_ant_tx_streaming_app(&ctx);
     }
     if (command == OP_RX_ONLY) {
-        process_ant_rx_streaming_app(NULL);
+        if (capture_stream)
+            ret = process_ant_rx_capture_app(&ctx);
+        else
+            process_ant_rx_streaming_app(&ctx);
+    }
+    if (command == OP_FULL_DUPLEX) {
+        ret = process_full_duplex_app();
     }
 
     // print_host_trace();
 
-    return 0;
+    return ret;
+}
+
+static uint64_t app_now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* tx startup cost : time from playback start to first bytes in fifo, and peak resident memory */
+static void tx_report_first_sample(uint64_t start_ns) {
+    printf("\n TX : first sample after %.3f ms\n", (double)(app_now_ns() - start_ns) / 1000000.0);
+    fflush(stdout);
+}
+
+static void tx_report_rss(void) {
+    struct rusage ru;
+
+    getrusage(RUSAGE_SELF, &ru);
+    printf("\n TX : peak RSS %ld KB\n", ru.ru_maxrss);
+    fflush(stdout);
 }
 
 int process_ant_tx_streaming_app(void *arg) {
-    uint32_t ddr_rd_offset = 0, size_sent = 0;
+    stream_ctx_t *ctx = arg;
+    uint32_t ddr_rd_offset = 0, play_size, send_max, chunk;
+    int32_t size_sent = 0;
+    uint64_t doorbells, chunks;
+    uint64_t start_ns = app_now_ns();
+    bool first = true;
     void *buffer;
     int ret=0;
     FILE *ptr;
     void *ddr_src;
 
     // Load input file into local buffer
-    FILE *fp = fopen(FilePath, "rb");
+    FILE *fp = fopen(ctx->path, "rb");
     if (!fp) {
-        fprintf(stderr, "Error opening '%s': %s\n", FilePath, strerror(errno));
+        fprintf(stderr, "Error opening '%s': %s\n", ctx->path, strerror(errno));
         ret = EXIT_FAILURE;
         goto out0;
     }
@@ -268,9 +418,9 @@ int process_ant_tx_streaming_app(void *arg) {
         goto out1;
     }
 
-    buffer = (uint8_t *)malloc(file_size);
+    buffer = iq_mem_alloc(file_size);
     if (!buffer) {
-        fprintf(stderr, "malloc(%x) failed\n", file_size);
+        fprintf(stderr, "iq_mem_alloc(%x) failed\n", file_size);
         ret=EXIT_FAILURE;
         goto out1;
    }
@@ -285,7 +435,7 @@ int process_ant_tx_streaming_app(void *arg) {
     }
 	
     // init tx channel
-    ret = iq_player_init_tx(modem_ddr_fifo_start, modem_ddr_fifo_size);
+    ret = iq_player_init_tx(ctx->fifo_start, ctx->fifo_size);
     if (!ret) {
         printf("\n TX : iq_player_init_tx failed\n");
         fflush(stdout);
@@ -293,46 +443,181 @@ int process_ant_tx_streaming_app(void *arg) {
 		goto out2;
     }
 
+    // compressed fifo takes whole chunks only : loop on the file up to its last whole chunk
+    chunk = iq_tx_chunk_size(iq_player_tx_stream(iq_player_get_default()));
+    play_size = file_size - file_size % chunk;
+    send_max = ctx->fifo_size - ctx->fifo_size % chunk;
+    if (play_size == 0 || send_max == 0) {
+        printf("\n TX : file or fifo smaller than one %u bytes chunk\n", chunk);
+        fflush(stdout);
+        ret = EXIT_FAILURE;
+        goto out2;
+    }
+
     // start feeding tx fifo
 	ddr_rd_offset = 0;
     while (running) {
         // prepare next transmit
         ddr_src = (void *)((uint64_t)buffer + ddr_rd_offset);
-        if (file_size - ddr_rd_offset > modem_ddr_fifo_size) {
-            size_sent = iq_player_send_data(ddr_src, modem_ddr_fifo_size);
+        if (play_size - ddr_rd_offset > send_max) {
+            size_sent = iq_player_send_wait(ddr_src, send_max, IQ_APP_WAIT_TIMEOUT_NS);
         } else {
-            size_sent = iq_player_send_data(ddr_src, file_size - ddr_rd_offset);
+            size_sent = iq_player_send_wait(ddr_src, play_size - ddr_rd_offset, IQ_APP_WAIT_TIMEOUT_NS);
+        }
+        if (size_sent < 0) {
+            // underrun, keep playing from current file position
+            printf("\n TX underrun, %d bytes lost\n", iq_player_tx_lost_size());
+            fflush(stdout);
+            ctx->lost += iq_player_tx_lost_size();
+            continue;
+        }
+        ctx->bytes += size_sent;
+        if (first && size_sent > 0) {
+            tx_report_first_sample(start_ns);
+            first = false;
         }
         // update pointers
         ddr_rd_offset += size_sent;
-        if (ddr_rd_offset >= file_size) {
+        if (ddr_rd_offset >= play_size) {
             ddr_rd_offset = 0;
         }
     }
+    iq_player_tx_flush();
+    iq_player_tx_doorbell_stats(&doorbells, &chunks);
+    printf("\n TX : %" PRIu64 " doorbells for %" PRIu64 " chunks\n", doorbells, chunks);
+    tx_report_rss();
+    ret = 0;
 
 out2:	
-	free(buffer);
+	iq_mem_free(buffer, file_size);
 out1:
 	fclose(fp);
 out0:
     return ret;
 }
 
+/*
+ * mmap playback : file pages are read ahead by kernel as playback advances (MADV_SEQUENTIAL), or faulted in
+ * up front (MAP_POPULATE). Played pages are dropped every IQ_APP_MMAP_RELEASE bytes so resident memory
+ * stays bounded whatever the waveform size.
+ */
+#define IQ_APP_MMAP_RELEASE (64 * 1024 * 1024)
+
+int process_ant_tx_mmap_app(void *arg) {
+    stream_ctx_t *ctx = arg;
+    uint64_t ddr_rd_offset = 0, released = 0, map_size, play_size, len;
+    uint32_t send_max, chunk;
+    uint64_t start_ns = app_now_ns();
+    uint64_t doorbells, chunks;
+    int32_t size_sent = 0;
+    bool first = true;
+    struct stat st;
+    uint8_t *buffer;
+    int fd, flags;
+    int ret = 0;
+
+    fd = open(ctx->path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Error opening '%s': %s\n", ctx->path, strerror(errno));
+        return EXIT_FAILURE;
+    }
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        fprintf(stderr, "fstat failed: %s\n", strerror(errno));
+        ret = EXIT_FAILURE;
+        goto out0;
+    }
+    map_size = st.st_size;
+
+    flags = MAP_SHARED;
+    if (tx_mmap == IQ_APP_MMAP_POPULATE)
+        flags |= MAP_POPULATE;
+    buffer = mmap(NULL, map_size, PROT_READ, flags, fd, 0);
+    if (buffer == MAP_FAILED) {
+        perror("mmap tx file failed");
+        ret = EXIT_FAILURE;
+        goto out0;
+    }
+    madvise(buffer, map_size, MADV_SEQUENTIAL);
+
+    ret = iq_player_init_tx(ctx->fifo_start, ctx->fifo_size);
+    if (!ret) {
+        printf("\n TX : iq_player_init_tx failed\n");
+        fflush(stdout);
+        ret = EXIT_FAILURE;
+        goto out1;
+    }
+
+    // compressed fifo takes whole chunks only : loop on the file up to its last whole chunk
+    chunk = iq_tx_chunk_size(iq_player_tx_stream(iq_player_get_default()));
+    play_size = map_size - map_size % chunk;
+    send_max = ctx->fifo_size - ctx->fifo_size % chunk;
+    if (play_size == 0 || send_max == 0) {
+        printf("\n TX : file or fifo smaller than one %u bytes chunk\n", chunk);
+        fflush(stdout);
+        ret = EXIT_FAILURE;
+        goto out1;
+    }
+
+    while (running) {
+        len = play_size - ddr_rd_offset;
+        if (len > send_max)
+            len = send_max;
+        size_sent = iq_player_send_wait((uint32_t *)(buffer + ddr_rd_offset), len, IQ_APP_WAIT_TIMEOUT_NS);
+        if (size_sent < 0) {
+            printf("\n TX underrun, %d bytes lost\n", iq_player_tx_lost_size());
+            fflush(stdout);
+            ctx->lost += iq_player_tx_lost_size();
+            continue;
+        }
+        ctx->bytes += size_sent;
+        if (first && size_sent > 0) {
+            tx_report_first_sample(start_ns);
+            first = false;
+        }
+        ddr_rd_offset += size_sent;
+
+        // drop played pages, page aligned
+        if (tx_mmap != IQ_APP_MMAP_POPULATE && ddr_rd_offset - released >= IQ_APP_MMAP_RELEASE) {
+            len = (ddr_rd_offset - released) & ~(uint64_t)(sysconf(_SC_PAGESIZE) - 1);
+            madvise(buffer + released, len, MADV_DONTNEED);
+            released += len;
+        }
+        if (ddr_rd_offset >= play_size) {
+            ddr_rd_offset = 0;
+            released = 0;
+        }
+    }
+    iq_player_tx_flush();
+    iq_player_tx_doorbell_stats(&doorbells, &chunks);
+    printf("\n TX : %" PRIu64 " doorbells for %" PRIu64 " chunks\n", doorbells, chunks);
+    tx_report_rss();
+    ret = 0;
+
+out1:
+    munmap(buffer, map_size);
+out0:
+    close(fd);
+    return ret;
+}
+
 int process_ant_rx_streaming_app(void *arg) {
-    uint32_t ddr_wr_offset = 0, size_received = 0;
+    stream_ctx_t *ctx = arg;
+    uint32_t ddr_wr_offset = 0;
+    int32_t size_received = 0;
+    uint64_t doorbells, chunks;
     void *ddr_dst;
     int ret=0;
     void *buffer;
 
-    buffer = (uint8_t *)malloc(file_size);
+    buffer = iq_mem_alloc(file_size);
     if (!buffer) {
-        fprintf(stderr, "malloc(%d) failed\n", file_size);
+        fprintf(stderr, "iq_mem_alloc(%d) failed\n", file_size);
         ret= EXIT_FAILURE;
         goto out0;
     }
 
     // init tx channel
-    ret = iq_player_init_rx(RxChanID, modem_ddr_fifo_start, modem_ddr_fifo_size);
+    ret = iq_player_init_rx(ctx->chan, ctx->fifo_start, ctx->fifo_size);
     if (!ret) {
         printf("\n RX : iq_player_init_rx failed\n");
         fflush(stdout);
@@ -344,22 +629,33 @@ int process_ant_rx_streaming_app(void *arg) {
     while (running) {
         // prepare next transmit
         ddr_dst = (void *)((uint64_t)buffer + ddr_wr_offset);
-        if (file_size - ddr_wr_offset > modem_ddr_fifo_size) {
-            size_received = iq_player_receive_data(RxChanID, ddr_dst, modem_ddr_fifo_size);
+        if (file_size - ddr_wr_offset > ctx->fifo_size) {
+            size_received = iq_player_receive_wait(ctx->chan, ddr_dst, 1, ctx->fifo_size, IQ_APP_WAIT_TIMEOUT_NS);
         } else {
-            size_received = iq_player_receive_data(RxChanID, ddr_dst, file_size - ddr_wr_offset);
+            size_received = iq_player_receive_wait(ctx->chan, ddr_dst, 1, file_size - ddr_wr_offset, IQ_APP_WAIT_TIMEOUT_NS);
+        }
+        if (size_received < 0) {
+            // overrun, capture goes on with a gap
+            printf("\n RX overrun, %d bytes lost\n", iq_player_rx_lost_size(ctx->chan));
+            fflush(stdout);
+            ctx->lost += iq_player_rx_lost_size(ctx->chan);
+            continue;
         }
+        ctx->bytes += size_received;
         // update pointers
         ddr_wr_offset += size_received;
         if (ddr_wr_offset >= file_size) {
             ddr_wr_offset = 0;
         }
     }
+    iq_player_rx_flush(ctx->chan);
+    iq_player_rx_doorbell_stats(ctx->chan, &doorbells, &chunks);
+    printf("\n RX : %" PRIu64 " doorbells for %" PRIu64 " chunks\n", doorbells, chunks);
 	
 	// write buffer to File
-    FILE *fp = fopen(FilePath, "wb");
+    FILE *fp = fopen(ctx->path, "wb");
     if (!fp) {
-        fprintf(stderr, "Error opening '%s': %s\n", FilePath, strerror(errno));
+        fprintf(stderr, "Error opening '%s': %s\n", ctx->path, strerror(errno));
         ret=EXIT_FAILURE;
         goto out1;
     }
@@ -376,7 +672,149 @@ int process_ant_rx_streaming_app(void *arg) {
 out2:	
 	fclose(fp);
 out1:
-	free(buffer);
+	iq_mem_free(buffer, file_size);
 out0:
     return ret;
 }
+
+/* streaming capture (iq_capture.c), failed open/write ends the run */
+int process_ant_rx_capture_app(void *arg) {
+    iq_capture_cfg_t cfg = { .rotate_size = capture_rotate_size, .rotate_sec = capture_rotate_sec, .running = &running };
+
+    return iq_capture_run(arg, &cfg);
+}
+
+/*
+ * Real time setup of calling stream thread, then report what its polling loop gets from the cpu
+ */
+static void stream_rt_setup(stream_ctx_t *ctx, const char *name) {
+    iq_rt_jitter_t j;
+    uint32_t flags;
+    int ret;
+
+    if (ctx->cpu >= 0) {
+        ret = iq_rt_set_affinity(ctx->cpu);
+        if (ret)
+            printf("\n %s : cpu %d affinity failed (%s)", name, ctx->cpu, strerror(-ret));
+        if (rt_check_isolation) {
+            flags = iq_rt_check_cpu(ctx->cpu);
+            if (!(flags & IQ_RT_CPU_ISOLATED))
+                printf("\n %s : warning cpu %d is not isolated (isolcpus=)", name, ctx->cpu);
+            if (!(flags & IQ_RT_CPU_NOHZ_FULL))
+                printf("\n %s : warning cpu %d is not tickless (nohz_full=)", name, ctx->cpu);
+        }
+    }
+    if (rt_dl_runtime_us && rt_dl_period_us) {
+        ret = iq_rt_set_deadline((uint64_t)rt_dl_runtime_us * 1000, (uint64_t)rt_dl_period_us * 1000,
+                                 (uint64_t)rt_dl_period_us * 1000);
+        if (ret)
+            printf("\n %s : SCHED_DEADLINE %u/%u us failed (%s)", name, rt_dl_runtime_us, rt_dl_period_us, strerror(-ret));
+    } else if (rt_priority > 0) {
+        ret = iq_rt_set_fifo(rt_priority);
+        if (ret)
+            printf("\n %s : SCHED_FIFO %d failed (%s)", name, rt_priority, strerror(-ret));
+    }
+
+    if (rt_jitter_ms) {
+        iq_rt_measure_jitter(rt_jitter_ms, &j);
+        printf("\n %s : cpu %d poll max gap %" PRIu64 " us (%" PRIu64 " gaps > 10us), wake-up latency avg %" PRIu64
+               " us max %" PRIu64 " us",
+               name, sched_getcpu(), j.poll_max_gap_ns / 1000, j.poll_gaps, j.wake_avg_ns / 1000, j.wake_max_ns / 1000);
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+/*
+ * Full duplex : tx plus every rx channel reported by modem in one process, each stream in its own thread
+ * pinned on duplex_cpu, duplex_cpu + 1, ... Rx channels are captured to disk (streaming capture), main thread
+ * reports all stream rates every second until stopped.
+ */
+static void *stream_thread(void *arg) {
+    stream_ctx_t *ctx = arg;
+    char name[8];
+
+    if (ctx->run == process_ant_rx_capture_app)
+        snprintf(name, sizeof(name), "RX%u", ctx->chan);
+    else
+        snprintf(name, sizeof(name), "TX");
+    stream_rt_setup(ctx, name);
+    ctx->ret = ctx->run(ctx);
+    // a failed stream (e.g. capture disk error) ends the run
+    if (ctx->ret)
+        running = 0;
+    return NULL;
+}
+
+static int stream_start(stream_ctx_t *ctx) {
+    return pthread_create(&ctx->thread, NULL, stream_thread, ctx);
+}
+
+int process_full_duplex_app(void) {
+    stream_ctx_t tx = { 0 }, rx[IQ_APP_MAX_RX_CHAN] = { 0 };
+    char rx_path[IQ_APP_MAX_RX_CHAN][512];
+    uint64_t last_tx = 0, last_rx[IQ_APP_MAX_RX_CHAN] = { 0 };
+    uint64_t now, last_ns;
+    uint32_t num_chan, chan;
+    bool tx_started;
+    int ret;
+
+    num_chan = iq_player_rx_num_chan(iq_player_get_default());
+    if (num_chan > IQ_APP_MAX_RX_CHAN)
+        num_chan = IQ_APP_MAX_RX_CHAN;
+    if (FilePath == NULL || duplex_rx_path == NULL || duplex_tx_fifo_size == 0 || modem_ddr_fifo_size == 0) {
+        fprintf(stderr, "full duplex needs -f <tx file> -o <rx file> -T <tx fifo> and -F <rx fifo>\n");
+        return EXIT_FAILURE;
+    }
+
+    tx.path = FilePath;
+    tx.fifo_start = duplex_tx_fifo_start;
+    tx.fifo_size = duplex_tx_fifo_size;
+    tx.cpu = duplex_cpu >= 0 ? duplex_cpu : rt_cpu;
+    tx.quiet = true;
+    tx.run = tx_mmap ? process_ant_tx_mmap_app : process_ant_tx_streaming_app;
+    tx_started = stream_start(&tx) == 0;
+
+    // modem splits rx fifo evenly between channels
+    for (chan = 0; chan < num_chan; chan++) {
+        snprintf(rx_path[chan], sizeof(rx_path[chan]), "%s.rx%u", duplex_rx_path, chan);
+        rx[chan].chan = chan;
+        rx[chan].path = rx_path[chan];
+        rx[chan].fifo_size = modem_ddr_fifo_size / num_chan;
+        rx[chan].fifo_start = modem_ddr_fifo_start + chan * rx[chan].fifo_size;
+        rx[chan].cpu = duplex_cpu >= 0 ? duplex_cpu + 1 + chan : -1;
+        rx[chan].quiet = true;
+        rx[chan].run = process_ant_rx_capture_app;
+        if (stream_start(&rx[chan]))
+            rx[chan].run = NULL;
+    }
+
+    // shared stats reporter
+    last_ns = app_now_ns();
+    while (running) {
+        sleep(1);
+        now = app_now_ns();
+        printf("\n TX %.1f MB/s lost %" PRIu64, (double)(tx.bytes - last_tx) * 1000.0 / (now - last_ns), tx.lost);
+        last_tx = tx.bytes;
+        for (chan = 0; chan < num_chan; chan++) {
+            printf(" | RX%u %.1f MB/s lost %" PRIu64, chan, (double)(rx[chan].bytes - last_rx[chan]) * 1000.0 / (now - last_ns),
+                   rx[chan].lost);
+            last_rx[chan] = rx[chan].bytes;
+        }
+        fflush(stdout);
+        last_ns = now;
+    }
+
+    if (tx_started)
+        pthread_join(tx.thread, NULL);
+    ret = tx_started ? tx.ret : 0;
+    for (chan = 0; chan < num_chan; chan++) {
+        if (rx[chan].run) {
+            pthread_join(rx[chan].thread, NULL);
+            ret |= rx[chan].ret;
+        }
+    }
+    printf("\n");
+
+    return ret ? EXIT_FAILURE : 0;
+}
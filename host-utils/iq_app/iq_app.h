@@ -7,6 +7,21 @@
 #ifndef __IQ_APP_H__
 #define __IQ_APP_H__
 
-typedef enum { OP_TX_ONLY = 0, OP_RX_ONLY, OP_STATS, OP_DUMP_TRACE, OP_DMA_PERF, OP_CLEAR_STATS, OP_MAX } command_e;
+typedef enum { OP_TX_ONLY = 0, OP_RX_ONLY, OP_STATS, OP_DUMP_TRACE, OP_DMA_PERF, OP_CLEAR_STATS, OP_FULL_DUPLEX, OP_MAX } command_e;
+
+/* one tx or rx stream, run by process_ant_xx_app(ctx) in main or in its own thread (full duplex) */
+typedef struct {
+    uint32_t chan;
+    const char *path;
+    uint32_t fifo_start;
+    uint32_t fifo_size;
+    int cpu;
+    bool quiet; /* rates reported by full duplex reporter */
+    int (*run)(void *arg);
+    int ret;
+    pthread_t thread;
+    volatile uint64_t bytes; /* moved through fifo */
+    volatile uint64_t lost;  /* underrun / overrun bytes */
+} stream_ctx_t;
 
 #endif
@@ -0,0 +1,266 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "iq_capture.h"
+#include "lib_iqplayer_api.h"
+
+/*
+ * Streaming capture : rx loop fills IQ_CAPTURE_NUM_BUF aligned buffers, a writer thread pushes full ones to disk
+ * with O_DIRECT (buffered io if filesystem refuses it). When writer falls behind and no buffer is free, received
+ * data is dropped and counted, rx fifo keeps being drained so modem never overruns because of disk.
+ * A writer that fails stops the rx loop.
+ */
+#define IQ_CAPTURE_BUF_SIZE (4 * 1024 * 1024)
+#define IQ_CAPTURE_NUM_BUF 8
+#define IQ_CAPTURE_ALIGN 4096
+#define IQ_CAPTURE_WAIT_TIMEOUT_NS 100000000ULL
+
+typedef struct {
+    stream_ctx_t *ctx;
+    iq_capture_cfg_t *cfg;
+    uint8_t *buf[IQ_CAPTURE_NUM_BUF];
+    uint32_t len[IQ_CAPTURE_NUM_BUF];
+    uint32_t head; /* buffers filled by rx loop */
+    uint32_t tail; /* buffers written by writer thread */
+    bool done;
+    bool failed; /* writer gave up, atomic */
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int fd;
+    uint32_t file_index;
+    uint64_t file_size;
+    uint64_t file_start_ns;
+    uint64_t written;
+    uint64_t dropped; /* rx loop adds, writer reports, atomic */
+} capture_t;
+
+static uint64_t capture_now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int capture_open(capture_t *cap) {
+    char name[512];
+
+    if (cap->fd >= 0)
+        close(cap->fd);
+    if (cap->cfg->rotate_size || cap->cfg->rotate_sec)
+        snprintf(name, sizeof(name), "%s.%04u", cap->ctx->path, cap->file_index++);
+    else
+        snprintf(name, sizeof(name), "%s", cap->ctx->path);
+
+    cap->fd = open(name, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+    if (cap->fd < 0 && errno == EINVAL)
+        cap->fd = open(name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (cap->fd < 0) {
+        fprintf(stderr, "Error opening '%s': %s\n", name, strerror(errno));
+        return -1;
+    }
+    cap->file_size = 0;
+    cap->file_start_ns = capture_now_ns();
+
+    return 0;
+}
+
+static int capture_write(capture_t *cap, uint8_t *buf, uint32_t len) {
+    ssize_t ret;
+    int flags;
+
+    // O_DIRECT needs block multiple, last partial buffer goes through page cache
+    if (len % IQ_CAPTURE_ALIGN) {
+        flags = fcntl(cap->fd, F_GETFL);
+        fcntl(cap->fd, F_SETFL, flags & ~O_DIRECT);
+    }
+    while (len) {
+        ret = write(cap->fd, buf, len);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            fprintf(stderr, "capture write failed: %s\n", strerror(errno));
+            return -1;
+        }
+        buf += ret;
+        len -= ret;
+        cap->file_size += ret;
+        cap->written += ret;
+    }
+
+    return 0;
+}
+
+static void *capture_writer(void *arg) {
+    capture_t *cap = arg;
+    uint64_t start_ns, report_ns, report_written = 0, now;
+    uint32_t idx;
+
+    start_ns = report_ns = capture_now_ns();
+    while (1) {
+        pthread_mutex_lock(&cap->lock);
+        while (cap->head == cap->tail && !cap->done)
+            pthread_cond_wait(&cap->cond, &cap->lock);
+        if (cap->head == cap->tail) {
+            pthread_mutex_unlock(&cap->lock);
+            break;
+        }
+        idx = cap->tail % IQ_CAPTURE_NUM_BUF;
+        pthread_mutex_unlock(&cap->lock);
+
+        now = capture_now_ns();
+        if ((cap->cfg->rotate_size && cap->file_size >= cap->cfg->rotate_size) ||
+            (cap->cfg->rotate_sec && now - cap->file_start_ns >= (uint64_t)cap->cfg->rotate_sec * 1000000000ULL)) {
+            if (capture_open(cap)) {
+                __atomic_store_n(&cap->failed, true, __ATOMIC_RELEASE);
+                break;
+            }
+        }
+        if (capture_write(cap, cap->buf[idx], cap->len[idx])) {
+            __atomic_store_n(&cap->failed, true, __ATOMIC_RELEASE);
+            break;
+        }
+
+        pthread_mutex_lock(&cap->lock);
+        cap->tail++;
+        pthread_mutex_unlock(&cap->lock);
+
+        // report sustained rate about every second
+        now = capture_now_ns();
+        if (!cap->ctx->quiet && now - report_ns >= 1000000000ULL) {
+            printf("\n RX capture : %.1f MB/s, %" PRIu64 " MB written, %" PRIu64 " bytes dropped",
+                   (double)(cap->written - report_written) * 1000.0 / (now - report_ns), cap->written >> 20,
+                   __atomic_load_n(&cap->dropped, __ATOMIC_RELAXED));
+            fflush(stdout);
+            report_ns = now;
+            report_written = cap->written;
+        }
+    }
+
+    now = capture_now_ns();
+    printf("\n RX%u capture : %" PRIu64 " bytes in %u file(s), %.1f MB/s average, %" PRIu64 " bytes dropped%s\n",
+           cap->ctx->chan, cap->written, cap->file_index ? cap->file_index : 1,
+           (double)cap->written * 1000.0 / (now - start_ns + 1), __atomic_load_n(&cap->dropped, __ATOMIC_RELAXED),
+           __atomic_load_n(&cap->failed, __ATOMIC_ACQUIRE) ? ", stopped on error" : "");
+    fflush(stdout);
+
+    return NULL;
+}
+
+int iq_capture_run(stream_ctx_t *ctx, iq_capture_cfg_t *cfg) {
+    capture_t cap = { .fd = -1, .ctx = ctx, .cfg = cfg };
+    pthread_t writer;
+    uint32_t idx, fill = 0;
+    int32_t size_received;
+    uint8_t *dst;
+    bool drop = false;
+    void *scratch = NULL;
+    int ret = 0, i;
+
+    for (i = 0; i < IQ_CAPTURE_NUM_BUF; i++) {
+        cap.buf[i] = iq_mem_alloc(IQ_CAPTURE_BUF_SIZE);
+        if (!cap.buf[i]) {
+            fprintf(stderr, "iq_mem_alloc(%d) failed\n", IQ_CAPTURE_BUF_SIZE);
+            ret = EXIT_FAILURE;
+            goto out0;
+        }
+    }
+    scratch = iq_mem_alloc(ctx->fifo_size);
+    if (!scratch) {
+        fprintf(stderr, "iq_mem_alloc(%d) failed\n", ctx->fifo_size);
+        ret = EXIT_FAILURE;
+        goto out0;
+    }
+    pthread_mutex_init(&cap.lock, NULL);
+    pthread_cond_init(&cap.cond, NULL);
+
+    ret = iq_player_init_rx(ctx->chan, ctx->fifo_start, ctx->fifo_size);
+    if (!ret) {
+        printf("\n RX : iq_player_init_rx failed\n");
+        fflush(stdout);
+        ret = EXIT_FAILURE;
+        goto out0;
+    }
+    if (capture_open(&cap)) {
+        ret = EXIT_FAILURE;
+        goto out0;
+    }
+    if (pthread_create(&writer, NULL, capture_writer, &cap)) {
+        ret = EXIT_FAILURE;
+        goto out1;
+    }
+
+    while (*cfg->running && !__atomic_load_n(&cap.failed, __ATOMIC_ACQUIRE)) {
+        // select a free buffer, or drop while writer is behind
+        if (fill == 0) {
+            pthread_mutex_lock(&cap.lock);
+            drop = cap.head - cap.tail >= IQ_CAPTURE_NUM_BUF;
+            pthread_mutex_unlock(&cap.lock);
+        }
+        idx = cap.head % IQ_CAPTURE_NUM_BUF;
+        dst = cap.buf[idx] + fill;
+        if (drop)
+            size_received = iq_player_receive_wait(ctx->chan, scratch, 1, ctx->fifo_size, IQ_CAPTURE_WAIT_TIMEOUT_NS);
+        else
+            size_received =
+                iq_player_receive_wait(ctx->chan, (uint32_t *)dst, 1, IQ_CAPTURE_BUF_SIZE - fill, IQ_CAPTURE_WAIT_TIMEOUT_NS);
+        if (size_received < 0) {
+            printf("\n RX overrun, %d bytes lost\n", iq_player_rx_lost_size(ctx->chan));
+            fflush(stdout);
+            ctx->lost += iq_player_rx_lost_size(ctx->chan);
+            continue;
+        }
+        ctx->bytes += size_received;
+        if (drop) {
+            __atomic_fetch_add(&cap.dropped, size_received, __ATOMIC_RELAXED);
+            continue;
+        }
+        fill += size_received;
+        if (fill == IQ_CAPTURE_BUF_SIZE) {
+            cap.len[idx] = fill;
+            fill = 0;
+            pthread_mutex_lock(&cap.lock);
+            cap.head++;
+            pthread_cond_signal(&cap.cond);
+            pthread_mutex_unlock(&cap.lock);
+        }
+    }
+    iq_player_rx_flush(ctx->chan);
+
+    // hand over last partial buffer and let writer drain
+    pthread_mutex_lock(&cap.lock);
+    if (fill && !drop) {
+        cap.len[cap.head % IQ_CAPTURE_NUM_BUF] = fill;
+        cap.head++;
+    }
+    cap.done = true;
+    pthread_cond_signal(&cap.cond);
+    pthread_mutex_unlock(&cap.lock);
+    pthread_join(writer, NULL);
+    ret = cap.failed ? EXIT_FAILURE : 0;
+
+out1:
+    close(cap.fd);
+out0:
+    cfg->written = cap.written;
+    cfg->dropped = cap.dropped;
+    cfg->files = cap.file_index ? cap.file_index : 1;
+    iq_mem_free(scratch, ctx->fifo_size);
+    for (i = 0; i < IQ_CAPTURE_NUM_BUF; i++)
+        iq_mem_free(cap.buf[i], IQ_CAPTURE_BUF_SIZE);
+    return ret;
+}
@@ -0,0 +1,33 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#ifndef __IQ_CAPTURE_H__
+#define __IQ_CAPTURE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "iq_app.h"
+
+/* streaming rx capture to disk, files rotated every rotate_size bytes / rotate_sec (0 : never) */
+typedef struct {
+    uint64_t rotate_size;
+    uint32_t rotate_sec;
+    volatile uint32_t *running; /* capture stops once cleared */
+    /* results */
+    uint64_t written;
+    uint64_t dropped;
+    uint32_t files;
+} iq_capture_cfg_t;
+
+/*
+ * Capture ctx->chan of the default player to ctx->path (<path>.NNNN when rotating) until *running is cleared.
+ * Returns 0, or EXIT_FAILURE on setup error or once a file can't be opened or written.
+ */
+int iq_capture_run(stream_ctx_t *ctx, iq_capture_cfg_t *cfg);
+
+#endif
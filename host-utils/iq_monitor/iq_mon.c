@@ -52,7 +52,6 @@ t_stats *host_stats;
 t_tx_ch_host_proxy *tx_vspa_proxy_ro;
 t_rx_ch_host_proxy *rx_vspa_proxy_ro;
 uint32_t *v_tx_vspa_proxy_wo;
-uint32_t *v_rx_vspa_proxy_wo;
 
 uint32_t *BAR0_addr;
 uint32_t *BAR1_addr;
@@ -152,7 +151,6 @@ int map_physical_regions(void) {
 
     /* use dmem structure at hardcoded address to write host status/request */
     v_tx_vspa_proxy_wo = (uint32_t *)((uint64_t)BAR2_addr + 0x400000 + 0x00000000);
-    v_rx_vspa_proxy_wo = (uint32_t *)((uint64_t)BAR2_addr + 0x400000 + 0x00000040);
 
     close(devmem_fd);
 
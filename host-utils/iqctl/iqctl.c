@@ -0,0 +1,293 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <getopt.h>
+
+#include "iqctl.h"
+
+#define SIZE_4K 4096
+
+static bool quiet;
+
+static void usage(char *prog) {
+    printf("usage: %s [-f shm_name] [-M modem_id] [-t timeout_us] [-q] command [args]\n", prog);
+    printf("   -f : fake modem, libvspambox mock window in /dev/shm/<shm_name> served by 'fake-vspa'\n");
+    printf("commands :\n");
+    printf("   info                                  iqflood/ccsr regions\n");
+    printf("   tx-fifo <size 4KB> [half dup] [cmp width]\n");
+    printf("                                         as iq-start-txfifo.sh, BFP compressed when width set\n");
+    printf("   replay <file> <size 4KB> [half dup]   as iq-replay.sh\n");
+    printf("   rx-fifo <size 4KB> [msi every] [wm] [cmp width]\n");
+    printf("                                         as iq-start-rxfifo.sh, BFP compressed when width set\n");
+    printf("   capture <file> <size 4KB> [half dup]  as iq-capture.sh\n");
+    printf("   stop [tx|rx]                          as iq-stop.sh, both by default\n");
+    printf("   qec <tx|rx> <chan> <idx> <val> [rst]  MBOX_OPC_IQ_CORR\n");
+    printf("   qec-load <tx|rx> <chan> [rst] [tN=f] [dc_i=f dc_q=f] [delay=n]\n");
+    printf("                                         MBOX_OPC_IQ_CORR_BLOCK, taps t0..t11\n");
+    printf("   dco <tx|rx> <i> <q>                   MBOX_OPC_TX/RX_DCO_CORR\n");
+    printf("   stats <counter id | -1>               as stats.sh, -1 resets\n");
+    printf("   proxy-offset [offset]                 get / set iqflood proxy offset\n");
+    printf("   raw <msb> <lsb>                       as vspa_mbox send + recv\n");
+    printf("   bench [nb] [msb lsb]                  round trip latency, ack only command by default\n");
+    printf("   fake-vspa [nb]                        serve the -f fake mailbox\n");
+}
+
+static int report(iqctl_t *c, const char *what, int ret) {
+    if (ret == -ETIMEDOUT)
+        printf("%s: VSPA mailbox 0 is not responding!!\n", what);
+    else if (ret == -EIO)
+        printf("%s: NACK\n", what);
+    else if (ret == -EINVAL)
+        printf("%s: invalid parameter\n", what);
+    else if (ret < 0)
+        printf("%s: error %d\n", what, ret);
+    else if (!quiet)
+        printf("%s: ACK, rtt %lu us\n", what, c->mbox.stats.last_ns / 1000);
+
+    return ret < 0 ? 1 : 0;
+}
+
+static int load_file(iqctl_t *c, const char *path, uint32_t size) {
+    uint8_t *iqflood = iqctl_iqflood(c);
+    size_t len;
+    FILE *fp;
+
+    if (iqflood == NULL)
+        return -ENOMEM;
+    fp = fopen(path, "rb");
+    if (fp == NULL) {
+        printf("%s file not found\n", path);
+        return -ENOENT;
+    }
+    len = fread(iqflood, 1, size, fp);
+    fclose(fp);
+    if (len < size)
+        printf("%s : %zu bytes, short of %u\n", path, len, size);
+
+    return 0;
+}
+
+static int dump_file(iqctl_t *c, const char *path, uint32_t size) {
+    uint8_t *iqflood = iqctl_iqflood(c);
+    FILE *fp;
+
+    if (iqflood == NULL)
+        return -ENOMEM;
+    fp = fopen(path, "wb");
+    if (fp == NULL) {
+        perror(path);
+        return -errno;
+    }
+    if (fwrite(iqflood + c->iqflood_region.size / 2, 1, size, fp) != size) {
+        fclose(fp);
+        return -EIO;
+    }
+    fclose(fp);
+
+    return 0;
+}
+
+static int cmp_rtt(const void *a, const void *b) {
+    const vspa_mbox_msg_t *x = a, *y = b;
+
+    return x->rtt_ns < y->rtt_ns ? -1 : x->rtt_ns > y->rtt_ns;
+}
+
+/* batch of identical commands back to back, per command rtt percentiles */
+static int cmd_bench(iqctl_t *c, int argc, char *argv[]) {
+    uint32_t nb = argc > 0 ? strtoul(argv[0], NULL, 0) : 1000;
+    uint32_t msb = MBOX_CMD_OPC(MBOX_OPC_EMPTY_2), lsb = 0, i;
+    vspa_mbox_msg_t *msgs;
+    int done;
+
+    if (argc > 2) {
+        msb = strtoul(argv[1], NULL, 16);
+        lsb = strtoul(argv[2], NULL, 16);
+    }
+    msgs = calloc(nb, sizeof(vspa_mbox_msg_t));
+    if (nb == 0 || msgs == NULL)
+        return 1;
+    for (i = 0; i < nb; i++) {
+        msgs[i].msb = msb;
+        msgs[i].lsb = lsb;
+    }
+
+    vspa_mbox_stats_reset(&c->mbox);
+    done = vspa_mbox_send_batch(&c->mbox, msgs, nb);
+    vspa_mbox_stats_print(&c->mbox, "bench");
+    if (done > 0 && msgs[done - 1].ret == -ETIMEDOUT)
+        done--;
+    if (done > 0) {
+        qsort(msgs, done, sizeof(vspa_mbox_msg_t), cmp_rtt);
+        printf("bench: rtt p50 %lu p99 %lu p99.9 %lu ns\n", msgs[done / 2].rtt_ns, msgs[(uint64_t)done * 99 / 100].rtt_ns,
+               msgs[(uint64_t)done * 999 / 1000].rtt_ns);
+    }
+    free(msgs);
+
+    return c->mbox.stats.timeouts ? 1 : 0;
+}
+
+/* build the whole QEC set, staged in iqflood and applied by VSPA in one command */
+static int cmd_qec_load(iqctl_t *c, int argc, char *argv[]) {
+    float dc_i = 0, dc_q = 0;
+    bool dc = false;
+    mbox_qec_block_t blk;
+    uint32_t tap, err = 0;
+    int i, ret;
+
+    iqctl_qec_block_init(&blk, !strcmp(argv[0], "tx"), strtoul(argv[1], NULL, 0), false);
+    for (i = 2; i < argc; i++) {
+        if (!strcmp(argv[i], "rst")) {
+            blk.flags |= MBOX_QEC_BLOCK_RST;
+        } else if (sscanf(argv[i], "t%u=", &tap) == 1 && tap < MBOX_QEC_BLOCK_NB_TAPS) {
+            iqctl_qec_block_set_tap(&blk, tap, strtof(strchr(argv[i], '=') + 1, NULL));
+        } else if (!strncmp(argv[i], "dc_i=", 5)) {
+            dc_i = strtof(argv[i] + 5, NULL);
+            dc = true;
+        } else if (!strncmp(argv[i], "dc_q=", 5)) {
+            dc_q = strtof(argv[i] + 5, NULL);
+            dc = true;
+        } else if (!strncmp(argv[i], "delay=", 6)) {
+            iqctl_qec_block_set_delay(&blk, strtoul(argv[i] + 6, NULL, 0));
+        } else {
+            printf("qec-load: unknown argument %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (dc)
+        iqctl_qec_block_set_dc(&blk, dc_i, dc_q);
+
+    ret = iqctl_qec_load(c, &blk, &err);
+    if (ret == -EIO)
+        printf("qec-load: block rejected, error %u\n", err);
+
+    return report(c, "qec-load", ret);
+}
+
+int main(int argc, char *argv[]) {
+    const char *shm_name = NULL, *cmd;
+    char *prog = argv[0];
+    uint32_t size_4k, val, msb, lsb, width;
+    int modem_id = 0, c_opt, ret;
+    uint32_t timeout_us = VSPA_MBOX_DEFAULT_TIMEOUT_US;
+    bool half, tx;
+    iqctl_t c;
+
+    while ((c_opt = getopt(argc, argv, "+hf:M:t:q")) != EOF) {
+        switch (c_opt) {
+        case 'f':
+            shm_name = optarg;
+            break;
+        case 'M':
+            modem_id = strtoul(optarg, NULL, 0);
+            break;
+        case 't':
+            timeout_us = strtoul(optarg, NULL, 0);
+            break;
+        case 'q':
+            quiet = true;
+            break;
+        case 'h':
+        default:
+            usage(argv[0]);
+            return 0;
+        }
+    }
+    if (optind >= argc) {
+        usage(argv[0]);
+        return 1;
+    }
+    cmd = argv[optind];
+    argc -= optind + 1;
+    argv += optind + 1;
+
+    ret = shm_name ? iqctl_open_fake(&c, shm_name) : iqctl_open(&c, modem_id);
+    if (ret < 0)
+        return 1;
+    c.mbox.timeout_us = timeout_us;
+
+    if (!strcmp(cmd, "info")) {
+        printf("IQFLOOD host 0x%lx modem 0x%lx size 0x%x\n", (uint64_t)c.iqflood_region.host_phy_addr,
+               (uint64_t)c.iqflood_region.modem_phy_addr, c.iqflood_region.size);
+        printf("CCSR    host 0x%lx modem 0x%lx size 0x%x\n", (uint64_t)c.ccsr_region.host_phy_addr,
+               (uint64_t)c.ccsr_region.modem_phy_addr, c.ccsr_region.size);
+        ret = 0;
+    } else if (!strcmp(cmd, "tx-fifo") && argc >= 1) {
+        // half duplex : 2 dma channels, multi burst
+        half = argc > 1 && atoi(argv[1]) == 1;
+        width = argc > 2 ? strtoul(argv[2], NULL, 0) : 0;
+        ret = report(&c, cmd, iqctl_tx_fifo_start(&c, strtoul(argv[0], NULL, 0), half ? 2 : 0, half, width));
+    } else if (!strcmp(cmd, "replay") && argc >= 2) {
+        size_4k = strtoul(argv[1], NULL, 0);
+        half = argc > 2 && atoi(argv[2]) == 1;
+        ret = 1;
+        if (size_4k * SIZE_4K <= c.iqflood_region.size && load_file(&c, argv[0], size_4k * SIZE_4K) == 0)
+            ret = report(&c, cmd, iqctl_tx_replay_start(&c, size_4k, half ? 2 : 0, half));
+    } else if (!strcmp(cmd, "rx-fifo") && argc >= 1) {
+        ret = report(&c, "msi", iqctl_rx_msi_config(&c, argc > 1 ? strtoul(argv[1], NULL, 0) : 0,
+                                                    argc > 2 ? strtoul(argv[2], NULL, 0) : 0));
+        if (!ret)
+            ret = report(&c, cmd, iqctl_rx_fifo_start(&c, strtoul(argv[0], NULL, 0), 0, argc > 3 ? strtoul(argv[3], NULL, 0) : 0));
+    } else if (!strcmp(cmd, "capture") && argc >= 2) {
+        size_4k = strtoul(argv[1], NULL, 0);
+        half = argc > 2 && atoi(argv[2]) == 1;
+        ret = report(&c, cmd, iqctl_rx_capture_start(&c, size_4k, half ? 2 : 0));
+        if (!ret)
+            ret = dump_file(&c, argv[0], size_4k * SIZE_4K) ? 1 : 0;
+    } else if (!strcmp(cmd, "stop")) {
+        ret = 0;
+        if (argc == 0 || !strcmp(argv[0], "rx"))
+            ret |= report(&c, "stop rx", iqctl_rx_stop(&c));
+        if (argc == 0 || !strcmp(argv[0], "tx"))
+            ret |= report(&c, "stop tx", iqctl_tx_stop(&c));
+    } else if (!strcmp(cmd, "qec") && argc >= 4) {
+        tx = !strcmp(argv[0], "tx");
+        ret = report(&c, cmd, iqctl_qec(&c, tx, strtoul(argv[1], NULL, 0), argc > 4 && atoi(argv[4]) == 1,
+                                        strtoul(argv[2], NULL, 0), strtoul(argv[3], NULL, 0)));
+    } else if (!strcmp(cmd, "qec-load") && argc >= 2) {
+        ret = cmd_qec_load(&c, argc, argv);
+    } else if (!strcmp(cmd, "dco") && argc >= 3) {
+        tx = !strcmp(argv[0], "tx");
+        ret = report(&c, cmd, iqctl_dco(&c, tx, strtol(argv[1], NULL, 0), strtol(argv[2], NULL, 0)));
+    } else if (!strcmp(cmd, "stats") && argc >= 1) {
+        if (atoi(argv[0]) == -1)
+            ret = report(&c, cmd, iqctl_stats_read(&c, 0, true, &val));
+        else
+            ret = report(&c, cmd, iqctl_stats_read(&c, strtoul(argv[0], NULL, 0), false, &val));
+        if (!ret)
+            printf("counter %s : %u\n", argv[0], val);
+    } else if (!strcmp(cmd, "proxy-offset")) {
+        ret = report(&c, cmd, iqctl_proxy_offset(&c, argc > 0, argc > 0 ? strtoul(argv[0], NULL, 0) : 0, &val));
+        if (!ret)
+            printf("0x%x\n", val);
+    } else if (!strcmp(cmd, "raw") && argc >= 2) {
+        ret = iqctl_cmd(&c, strtoul(argv[0], NULL, 16), strtoul(argv[1], NULL, 16), &msb, &lsb);
+        if (ret != -ETIMEDOUT)
+            printf("Received from VSPA:0, MBox:0, MSB:0x%08x, LSB:0x%08x.\n", msb, lsb);
+        ret = report(&c, cmd, ret);
+    } else if (!strcmp(cmd, "bench")) {
+        ret = cmd_bench(&c, argc, argv);
+    } else if (!strcmp(cmd, "fake-vspa") && shm_name) {
+        ret = iqctl_fake_vspa(&c, argc > 0 ? strtoull(argv[0], NULL, 0) : 0) ? 1 : 0;
+    } else {
+        usage(prog);
+        ret = 1;
+    }
+
+    iqctl_close(&c);
+
+    return ret;
+}
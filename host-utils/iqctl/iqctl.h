@@ -0,0 +1,79 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#ifndef __IQCTL_H__
+#define __IQCTL_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "vspa_mbox.h"
+#include "vspa_mbox_cmd.h"
+
+/*
+ * iqctl : iq player control library, replaces la9310_modem_info parsing + vspa_mbox forks of the scripts.
+ * Modem is opened once, modinfo_t regions are cached, VSPA core 0 mailbox 0 is kept open with libvspambox
+ * (ACK busy-wait, per command round trip in mbox.stats).
+ * Only iqctl_open() (iqctl_modinfo.c) needs la9310_modinfo.h, command building and fake modem build without it.
+ */
+
+/* fake modem : vspa mock window + iqflood in a /dev/shm file, served by iqctl_fake_vspa() */
+#define IQCTL_FAKE_IQFLOOD_SIZE 0x100000
+#define IQCTL_FAKE_IQFLOOD_MODEM_ADDR 0xA0000000
+
+/* modinfo_t region cached by iqctl_open() */
+typedef struct {
+    uint64_t host_phy_addr;
+    uint64_t modem_phy_addr;
+    uint32_t size;
+} iqctl_region_t;
+
+typedef struct {
+    iqctl_region_t iqflood_region;
+    iqctl_region_t ccsr_region;
+    vspa_mbox_t mbox;
+    uint8_t *shm;     /* fake modem mapping */
+    uint8_t *iqflood; /* host mapping of iqflood, mapped on first use */
+    int mem_fd;
+    bool fake;
+} iqctl_t;
+
+void iqctl_init(iqctl_t *c);
+int iqctl_open(iqctl_t *c, int modem_id);
+int iqctl_open_fake(iqctl_t *c, const char *shm_name);
+void iqctl_close(iqctl_t *c);
+uint8_t *iqctl_iqflood(iqctl_t *c);
+
+/* post one mailbox 0 command and wait for ACK, returns 0 on ACK, -EIO on NACK, -ETIMEDOUT */
+int iqctl_cmd(iqctl_t *c, uint32_t msb, uint32_t lsb, uint32_t *rsp_msb, uint32_t *rsp_lsb);
+
+/* tx : size in 4KB units, dma_ch 0 selects firmware default, mburst only meaningful with dma_ch */
+int iqctl_tx_fifo_start(iqctl_t *c, uint32_t size_4k, uint32_t dma_ch, bool mburst, uint32_t cmp_width);
+int iqctl_tx_replay_start(iqctl_t *c, uint32_t size_4k, uint32_t dma_ch, bool mburst);
+int iqctl_tx_stop(iqctl_t *c);
+/* rx : fifo / capture buffer in upper half of iqflood as iq-start-rxfifo.sh / iq-capture.sh, tx at bottom */
+int iqctl_rx_fifo_start(iqctl_t *c, uint32_t size_4k, uint32_t dma_ch, uint32_t cmp_width);
+int iqctl_rx_capture_start(iqctl_t *c, uint32_t size_4k, uint32_t dma_ch);
+int iqctl_rx_stop(iqctl_t *c);
+int iqctl_rx_msi_config(iqctl_t *c, uint32_t every, uint32_t watermark);
+
+int iqctl_qec(iqctl_t *c, bool tx, uint32_t chan, bool rst, uint32_t idx, uint32_t val);
+/* MBOX_OPC_IQ_CORR_BLOCK : whole QEC set in one round trip, block staged just below the iqflood proxy */
+void iqctl_qec_block_init(mbox_qec_block_t *blk, bool tx, uint32_t chan, bool rst);
+void iqctl_qec_block_set_tap(mbox_qec_block_t *blk, uint32_t tap, float val);
+void iqctl_qec_block_set_dc(mbox_qec_block_t *blk, float dc_i, float dc_q);
+void iqctl_qec_block_set_delay(mbox_qec_block_t *blk, uint32_t delay);
+void iqctl_qec_block_seal(mbox_qec_block_t *blk);
+int iqctl_qec_block_validate(const mbox_qec_block_t *blk);
+int iqctl_qec_load(iqctl_t *c, mbox_qec_block_t *blk, uint32_t *err);
+int iqctl_dco(iqctl_t *c, bool tx, int16_t i, int16_t q);
+int iqctl_stats_read(iqctl_t *c, uint32_t idx, bool rst, uint32_t *val);
+int iqctl_proxy_offset(iqctl_t *c, bool set, uint32_t offset, uint32_t *cur);
+
+/* fake vspa responder loop on an iqctl_open_fake() handle, acks like firmware, exits after nb commands (0 forever) */
+int iqctl_fake_vspa(iqctl_t *c, uint64_t nb);
+
+#endif
@@ -0,0 +1,62 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <la9310_modinfo.h>
+
+#include "iqctl.h"
+
+/* la93xx_host_sw uapi only needed here : modinfo is read once and its regions cached in iqctl_t */
+#define IQCTL_REGION_CACHE(r, mi_region)                                                                                  \
+    do {                                                                                                                  \
+        (r)->host_phy_addr = (mi_region).host_phy_addr;                                                                   \
+        (r)->modem_phy_addr = (mi_region).modem_phy_addr;                                                                 \
+        (r)->size = (mi_region).size;                                                                                     \
+    } while (0)
+
+int iqctl_open(iqctl_t *c, int modem_id) {
+    char dev_name[32];
+    modinfo_t mi;
+    int fd, ret;
+
+    iqctl_init(c);
+
+    sprintf(dev_name, "/dev/%s%d", LA9310_DEV_NAME_PREFIX, modem_id);
+    fd = open(dev_name, O_RDWR);
+    if (fd < 0) {
+        printf("File %s open error, is LA9310 shiva started ?\n", dev_name);
+        return -ENODEV;
+    }
+    ret = ioctl(fd, IOCTL_LA93XX_MODINFO_GET, &mi);
+    close(fd);
+    if (ret < 0) {
+        printf("IOCTL_LA9310_MODINFO_GET failed.\n");
+        return -ENODEV;
+    }
+    IQCTL_REGION_CACHE(&c->iqflood_region, mi.iqflood);
+    IQCTL_REGION_CACHE(&c->ccsr_region, mi.ccsr);
+
+    ret = vspa_mbox_open(&c->mbox, c->ccsr_region.host_phy_addr + VSPA_MBOX_CCSR_OFFSET, 0, 0);
+    if (ret < 0)
+        return ret;
+
+    c->mem_fd = open("/dev/mem", O_RDWR | O_SYNC);
+    if (c->mem_fd < 0) {
+        perror("/dev/mem open failed");
+        vspa_mbox_close(&c->mbox);
+        return -errno;
+    }
+
+    return 0;
+}
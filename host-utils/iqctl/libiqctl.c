@@ -0,0 +1,338 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <stddef.h>
+
+#include "vspa_dmem_proxy.h"
+#include "iqctl.h"
+
+#define SIZE_4K 4096
+
+/* firmware DMAs the block as is, layout must not depend on host ABI */
+_Static_assert(sizeof(mbox_qec_block_t) == MBOX_QEC_BLOCK_SIZE, "mbox_qec_block_t size");
+_Static_assert(offsetof(mbox_qec_block_t, ftaps) == 5 * 4, "mbox_qec_block_t ftaps offset");
+_Static_assert(offsetof(mbox_qec_block_t, dc_i) == 17 * 4, "mbox_qec_block_t dc_i offset");
+_Static_assert(offsetof(mbox_qec_block_t, seq) == 20 * 4, "mbox_qec_block_t seq offset");
+_Static_assert(offsetof(mbox_qec_block_t, checksum) == (MBOX_QEC_BLOCK_WORDS - 1) * 4, "mbox_qec_block_t checksum offset");
+
+void iqctl_init(iqctl_t *c) {
+    memset(c, 0, sizeof(iqctl_t));
+    c->mem_fd = -1;
+}
+
+int iqctl_open_fake(iqctl_t *c, const char *shm_name) {
+    uint32_t size = VSPA_MBOX_MAP_SIZE + IQCTL_FAKE_IQFLOOD_SIZE;
+    uint8_t *shm;
+
+    iqctl_init(c);
+    c->fake = true;
+
+    c->mem_fd = shm_open(shm_name, O_RDWR | O_CREAT, 0666);
+    if (c->mem_fd < 0) {
+        perror("fake mailbox shm_open failed");
+        return -errno;
+    }
+    if (ftruncate(c->mem_fd, size) < 0) {
+        perror("fake mailbox ftruncate failed");
+        close(c->mem_fd);
+        c->mem_fd = -1;
+        return -EIO;
+    }
+    shm = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, c->mem_fd, 0);
+    if (shm == MAP_FAILED) {
+        perror("fake mailbox mmap failed");
+        close(c->mem_fd);
+        c->mem_fd = -1;
+        return -ENOMEM;
+    }
+    c->shm = shm;
+    c->iqflood = shm + VSPA_MBOX_MAP_SIZE;
+    c->iqflood_region.modem_phy_addr = IQCTL_FAKE_IQFLOOD_MODEM_ADDR;
+    c->iqflood_region.size = IQCTL_FAKE_IQFLOOD_SIZE;
+
+    return vspa_mbox_open_mock(&c->mbox, shm, 0, 0);
+}
+
+void iqctl_close(iqctl_t *c) {
+    vspa_mbox_close(&c->mbox);
+    if (c->shm)
+        munmap(c->shm, VSPA_MBOX_MAP_SIZE + IQCTL_FAKE_IQFLOOD_SIZE);
+    else if (c->iqflood)
+        munmap(c->iqflood, c->iqflood_region.size);
+    if (c->mem_fd >= 0)
+        close(c->mem_fd);
+    c->shm = NULL;
+    c->iqflood = NULL;
+    c->mem_fd = -1;
+}
+
+/* host mapping of iqflood region, i.e. bin2mem target */
+uint8_t *iqctl_iqflood(iqctl_t *c) {
+    void *p;
+
+    if (c->iqflood == NULL) {
+        p = mmap(NULL, c->iqflood_region.size, PROT_READ | PROT_WRITE, MAP_SHARED, c->mem_fd, c->iqflood_region.host_phy_addr);
+        if (p == MAP_FAILED) {
+            perror("Mapping iqflood failed");
+            return NULL;
+        }
+        c->iqflood = p;
+    }
+
+    return c->iqflood;
+}
+
+int iqctl_cmd(iqctl_t *c, uint32_t msb, uint32_t lsb, uint32_t *rsp_msb, uint32_t *rsp_lsb) {
+    return vspa_mbox_transact(&c->mbox, msb, lsb, rsp_msb, rsp_lsb);
+}
+
+static inline uint32_t iqctl_iqmod_flags(uint32_t dma_ch, bool mburst) {
+    return MBOX_IQMOD_DMA_CH(dma_ch) | (mburst ? MBOX_IQMOD_TX_MBURST : 0);
+}
+
+/* cmp_width : BFP mantissa width of DDR chunks, 0 for cs16 */
+int iqctl_tx_fifo_start(iqctl_t *c, uint32_t size_4k, uint32_t dma_ch, bool mburst, uint32_t cmp_width) {
+    uint32_t msb;
+
+    // fifo at bottom of iqflood, proxy in last 1KB
+    if (size_4k == 0 || size_4k * SIZE_4K > c->iqflood_region.size - VSPA_DMEM_PROXY_SIZE)
+        return -EINVAL;
+    if (cmp_width > MBOX_IQMOD_TX_CMP_WIDTH_MASK)
+        return -EINVAL;
+    msb = MBOX_CMD_OPC(MBOX_OPC_IQ_MOD_TX) | MBOX_IQMOD_START | iqctl_iqmod_flags(dma_ch, mburst) | MBOX_IQMOD_SIZE_4K(size_4k) |
+          (cmp_width ? MBOX_IQMOD_TX_CMP : 0);
+
+    return iqctl_cmd(c, msb, c->iqflood_region.modem_phy_addr | cmp_width, NULL, NULL);
+}
+
+int iqctl_tx_replay_start(iqctl_t *c, uint32_t size_4k, uint32_t dma_ch, bool mburst) {
+    uint32_t msb;
+
+    if (size_4k == 0 || size_4k * SIZE_4K > c->iqflood_region.size - VSPA_DMEM_PROXY_SIZE)
+        return -EINVAL;
+    msb = MBOX_CMD_OPC(MBOX_OPC_IQ_MOD_TX) | MBOX_IQMOD_START | MBOX_IQMOD_FC_DISABLE | iqctl_iqmod_flags(dma_ch, mburst) |
+          MBOX_IQMOD_SIZE_4K(size_4k);
+
+    return iqctl_cmd(c, msb, c->iqflood_region.modem_phy_addr, NULL, NULL);
+}
+
+int iqctl_tx_stop(iqctl_t *c) {
+    return iqctl_cmd(c, MBOX_CMD_OPC(MBOX_OPC_IQ_MOD_TX), 0, NULL, NULL);
+}
+
+/* cmp_width : BFP mantissa width of DDR chunks, 0 for cs16 */
+int iqctl_rx_fifo_start(iqctl_t *c, uint32_t size_4k, uint32_t dma_ch, uint32_t cmp_width) {
+    uint32_t msb;
+
+    if (size_4k == 0 || size_4k * SIZE_4K > c->iqflood_region.size / 2)
+        return -EINVAL;
+    if (cmp_width > MBOX_IQMOD_RX_CMP_WIDTH_MASK)
+        return -EINVAL;
+    msb = MBOX_CMD_OPC(MBOX_OPC_IQ_MOD_RX) | MBOX_IQMOD_START | MBOX_IQMOD_RX_CONTINUOUS | MBOX_IQMOD_DMA_CH(dma_ch) |
+          MBOX_IQMOD_SIZE_4K(size_4k) | (cmp_width ? MBOX_IQMOD_RX_CMP : 0);
+
+    return iqctl_cmd(c, msb, (c->iqflood_region.modem_phy_addr + c->iqflood_region.size / 2) | cmp_width, NULL, NULL);
+}
+
+int iqctl_rx_capture_start(iqctl_t *c, uint32_t size_4k, uint32_t dma_ch) {
+    uint32_t msb;
+
+    if (size_4k == 0 || size_4k * SIZE_4K > c->iqflood_region.size / 2)
+        return -EINVAL;
+    msb = MBOX_CMD_OPC(MBOX_OPC_IQ_MOD_RX) | MBOX_IQMOD_START | MBOX_IQMOD_FC_DISABLE | MBOX_IQMOD_DMA_CH(dma_ch) |
+          MBOX_IQMOD_SIZE_4K(size_4k);
+
+    return iqctl_cmd(c, msb, c->iqflood_region.modem_phy_addr + c->iqflood_region.size / 2, NULL, NULL);
+}
+
+int iqctl_rx_stop(iqctl_t *c) {
+    return iqctl_cmd(c, MBOX_CMD_OPC(MBOX_OPC_IQ_MOD_RX), 0, NULL, NULL);
+}
+
+int iqctl_rx_msi_config(iqctl_t *c, uint32_t every, uint32_t watermark) {
+    uint32_t msb = MBOX_CMD_OPC(MBOX_OPC_MSI) | MBOX_MSI_CONFIG | MBOX_MSI_WATERMARK(watermark) | MBOX_MSI_EVERY(every);
+
+    return iqctl_cmd(c, msb, 0, NULL, NULL);
+}
+
+int iqctl_qec(iqctl_t *c, bool tx, uint32_t chan, bool rst, uint32_t idx, uint32_t val) {
+    uint32_t msb;
+
+    msb = MBOX_CMD_OPC(MBOX_OPC_IQ_CORR) | (tx ? MBOX_IQ_CORR_TX : 0) | (rst ? MBOX_IQ_CORR_RST : 0) | MBOX_IQ_CORR_CHAN(chan) |
+          MBOX_IQ_CORR_IDX(idx);
+
+    return iqctl_cmd(c, msb, val, NULL, NULL);
+}
+
+void iqctl_qec_block_init(mbox_qec_block_t *blk, bool tx, uint32_t chan, bool rst) {
+    memset(blk, 0, sizeof(mbox_qec_block_t));
+    blk->magic = MBOX_QEC_BLOCK_MAGIC;
+    blk->version = MBOX_QEC_BLOCK_VERSION;
+    blk->flags = (tx ? MBOX_QEC_BLOCK_TX : 0) | (rst ? MBOX_QEC_BLOCK_RST : 0);
+    blk->chan = chan;
+}
+
+void iqctl_qec_block_set_tap(mbox_qec_block_t *blk, uint32_t tap, float val) {
+    if (tap >= MBOX_QEC_BLOCK_NB_TAPS)
+        return;
+    blk->ftaps[tap] = val;
+    blk->valid_mask |= MBOX_QEC_BLOCK_FTAP(tap);
+}
+
+void iqctl_qec_block_set_dc(mbox_qec_block_t *blk, float dc_i, float dc_q) {
+    blk->dc_i = dc_i;
+    blk->dc_q = dc_q;
+    blk->valid_mask |= MBOX_QEC_BLOCK_DC_I | MBOX_QEC_BLOCK_DC_Q;
+}
+
+void iqctl_qec_block_set_delay(mbox_qec_block_t *blk, uint32_t delay) {
+    blk->delay = delay;
+    blk->valid_mask |= MBOX_QEC_BLOCK_FDELAY;
+}
+
+void iqctl_qec_block_seal(mbox_qec_block_t *blk) {
+    blk->checksum = mbox_qec_block_checksum((const uint32_t *)blk);
+}
+
+/* same checks as firmware, returns 0 or MBOX_QEC_BLOCK_ERR_xxx */
+int iqctl_qec_block_validate(const mbox_qec_block_t *blk) {
+    if (blk->magic != MBOX_QEC_BLOCK_MAGIC)
+        return MBOX_QEC_BLOCK_ERR_MAGIC;
+    if (blk->version != MBOX_QEC_BLOCK_VERSION)
+        return MBOX_QEC_BLOCK_ERR_VERSION;
+    if (blk->checksum != mbox_qec_block_checksum((const uint32_t *)blk))
+        return MBOX_QEC_BLOCK_ERR_CHECKSUM;
+
+    return 0;
+}
+
+/* NACK returns -EIO, firmware MBOX_QEC_BLOCK_ERR_xxx in *err */
+int iqctl_qec_load(iqctl_t *c, mbox_qec_block_t *blk, uint32_t *err) {
+    uint32_t offset = c->iqflood_region.size - VSPA_DMEM_PROXY_SIZE - MBOX_QEC_BLOCK_SIZE;
+    uint8_t *iqflood = iqctl_iqflood(c);
+    uint32_t seq;
+    int ret;
+
+    if (iqflood == NULL)
+        return -ENOMEM;
+
+    blk->seq++;
+    iqctl_qec_block_seal(blk);
+    if (iqctl_qec_block_validate(blk))
+        return -EINVAL;
+
+    // iqflood is mapped non cacheable, block is visible to VSPA DMA once mailbox is posted
+    memcpy(iqflood + offset, blk, MBOX_QEC_BLOCK_SIZE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    ret = iqctl_cmd(c, MBOX_CMD_OPC(MBOX_OPC_IQ_CORR_BLOCK), c->iqflood_region.modem_phy_addr + offset, &seq, NULL);
+    if (ret == -EIO && err)
+        *err = seq;
+    // ack must echo the block just staged
+    if (ret == 0 && seq != blk->seq)
+        return -EPROTO;
+
+    return ret;
+}
+
+int iqctl_dco(iqctl_t *c, bool tx, int16_t i, int16_t q) {
+    uint32_t msb = MBOX_CMD_OPC(tx ? MBOX_OPC_TX_DCO_CORR : MBOX_OPC_RX_DCO_CORR);
+
+    return iqctl_cmd(c, msb, ((uint32_t)(uint16_t)q << 16) | (uint16_t)i, NULL, NULL);
+}
+
+int iqctl_stats_read(iqctl_t *c, uint32_t idx, bool rst, uint32_t *val) {
+    uint32_t msb = MBOX_CMD_OPC(MBOX_OPC_GET_STATS_COUNT) | (rst ? MBOX_STATS_RST : 0) | MBOX_STATS_IDX(idx);
+
+    return iqctl_cmd(c, msb, 0, val, NULL);
+}
+
+int iqctl_proxy_offset(iqctl_t *c, bool set, uint32_t offset, uint32_t *cur) {
+    uint32_t msb = MBOX_CMD_OPC(MBOX_OPC_PROXY_OFFSET) | (set ? 0 : MBOX_PROXY_OFFSET_RO);
+
+    return iqctl_cmd(c, msb, offset, cur, NULL);
+}
+
+/* fake vspa : acks mailbox 0 commands the way firmware main loop does, no streaming */
+struct iqctl_fake_state {
+    uint32_t stats[16];
+    uint32_t proxy_offset;
+    iqctl_t *c;
+};
+
+static uint32_t iqctl_fake_handler(void *arg, uint32_t msb, uint32_t lsb, uint32_t *rsp_msb) {
+    struct iqctl_fake_state *st = arg;
+
+    switch ((msb & MBOX_OPC_MASK) >> MBOX_OPC_SHIFT) {
+    case MBOX_OPC_IQ_MOD_TX:
+    case MBOX_OPC_IQ_MOD_RX:
+        if (((msb & MBOX_IQMOD_DMA_CH_MASK) >> 16) > 4)
+            return 0;
+        return 0x1;
+    case MBOX_OPC_MSI:
+    case MBOX_OPC_EMPTY_2:
+        return 0x1;
+    case MBOX_OPC_IQ_CORR:
+    case MBOX_OPC_TX_DCO_CORR:
+    case MBOX_OPC_RX_DCO_CORR:
+    case MBOX_OPC_RX_CHAN_SELECT:
+        *rsp_msb = lsb;
+        return 0x1;
+    case MBOX_OPC_IQ_CORR_BLOCK: {
+        // "DMA" the block from fake iqflood
+        uint32_t offset = lsb - (uint32_t)st->c->iqflood_region.modem_phy_addr;
+        const mbox_qec_block_t *blk = (const mbox_qec_block_t *)(st->c->iqflood + offset);
+
+        if ((lsb & 0xF) || offset > st->c->iqflood_region.size - MBOX_QEC_BLOCK_SIZE) {
+            *rsp_msb = MBOX_QEC_BLOCK_ERR_ALIGN;
+            return 0;
+        }
+        *rsp_msb = iqctl_qec_block_validate(blk);
+        if (*rsp_msb)
+            return 0;
+        *rsp_msb = blk->seq;
+        return 0x1;
+    }
+    case MBOX_OPC_GET_STATS_COUNT:
+        // fake counters : number of reads per stats index
+        *rsp_msb = st->stats[msb & 0xF]++;
+        if (msb & MBOX_STATS_RST)
+            memset(st->stats, 0, sizeof(st->stats));
+        return 0x1;
+    case MBOX_OPC_PROXY_OFFSET:
+        if (!(msb & MBOX_PROXY_OFFSET_RO))
+            st->proxy_offset = lsb;
+        *rsp_msb = st->proxy_offset;
+        return 0x1;
+    default:
+        return 0;
+    }
+}
+
+int iqctl_fake_vspa(iqctl_t *c, uint64_t nb) {
+    struct iqctl_fake_state st;
+
+    if (!c->fake)
+        return -EINVAL;
+    memset(&st, 0, sizeof(st));
+    st.proxy_offset = c->iqflood_region.size - VSPA_DMEM_PROXY_SIZE;
+    st.c = c;
+
+    return vspa_mbox_mock_serve(&c->mbox, iqctl_fake_handler, &st, nb);
+}
@@ -10,6 +10,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 
 #include "imx8-host.h"
 
@@ -30,3 +31,102 @@ void flush_region(void *region, uint32_t size) {
         dcbf((uint32_t *)(ptr));
     }
 }
+
+#if defined(__aarch64__)
+
+/*
+ * TX fifo copy : stream 64B lines with non-temporal stores (stnp) and clean each line right after it is
+ * written, i.e. memcpy() + flush_region() in a single pass. dst must be cache line aligned.
+ */
+void copy_flush_region(void *dst, const void *src, uint32_t size) {
+    uint8_t *d = (uint8_t *)dst;
+    const uint8_t *s = (const uint8_t *)src;
+    uint32_t index, tail;
+
+    if ((uint64_t)d & (CACHE_LINE_SIZE - 1)) {
+        memcpy(dst, src, size);
+        flush_region(dst, size + CACHE_LINE_SIZE - 1);
+        asm volatile("dsb st" : : : "memory");
+        return;
+    }
+
+    for (index = 0; index < size / CACHE_LINE_SIZE; index++, d += CACHE_LINE_SIZE, s += CACHE_LINE_SIZE) {
+        asm volatile("ldp q0, q1, [%[s]]\n\t"
+                     "ldp q2, q3, [%[s], #32]\n\t"
+                     "stnp q0, q1, [%[d]]\n\t"
+                     "stnp q2, q3, [%[d], #32]\n\t"
+                     "dc cvac, %[d]\n\t"
+                     :
+                     : [d] "r"(d), [s] "r"(s)
+                     : "v0", "v1", "v2", "v3", "memory");
+    }
+
+    tail = size % CACHE_LINE_SIZE;
+    if (tail) {
+        memcpy(d, s, tail);
+        dcbf(d);
+    }
+
+    // lines reach point of coherency before modem doorbell
+    asm volatile("dsb st" : : : "memory");
+}
+
+/*
+ * RX fifo copy : invalidate a block of lines, then read it with non-temporal loads (ldnp), i.e.
+ * invalidate_region() + memcpy() in a single pass over the fifo. src must be cache line aligned.
+ */
+#define COPY_INV_BLOCK_LINES 16
+
+void invalidate_copy_region(void *dst, const void *src, uint32_t size) {
+    uint8_t *d = (uint8_t *)dst;
+    const uint8_t *s = (const uint8_t *)src;
+    uint32_t index, block, done, lines, tail;
+
+    if ((uint64_t)s & (CACHE_LINE_SIZE - 1)) {
+        invalidate_region((void *)src, size + CACHE_LINE_SIZE - 1);
+        asm volatile("dsb sy" : : : "memory");
+        memcpy(dst, src, size);
+        return;
+    }
+
+    lines = size / CACHE_LINE_SIZE;
+    for (done = 0; done < lines; done += block) {
+        block = lines - done < COPY_INV_BLOCK_LINES ? lines - done : COPY_INV_BLOCK_LINES;
+        for (index = 0; index < block; index++) {
+            dccivac(s + index * CACHE_LINE_SIZE);
+        }
+        asm volatile("dsb sy" : : : "memory");
+
+        for (index = 0; index < block; index++, d += CACHE_LINE_SIZE, s += CACHE_LINE_SIZE) {
+            asm volatile("ldnp q0, q1, [%[s]]\n\t"
+                         "ldnp q2, q3, [%[s], #32]\n\t"
+                         "stp q0, q1, [%[d]]\n\t"
+                         "stp q2, q3, [%[d], #32]\n\t"
+                         :
+                         : [d] "r"(d), [s] "r"(s)
+                         : "v0", "v1", "v2", "v3", "memory");
+        }
+    }
+
+    tail = size % CACHE_LINE_SIZE;
+    if (tail) {
+        dccivac(s);
+        asm volatile("dsb sy" : : : "memory");
+        memcpy(d, s, tail);
+    }
+}
+
+#else
+
+/* portable fallback (x86 test builds), cache maintenance macros are no-op */
+void copy_flush_region(void *dst, const void *src, uint32_t size) {
+    memcpy(dst, src, size);
+    flush_region(dst, size);
+}
+
+void invalidate_copy_region(void *dst, const void *src, uint32_t size) {
+    invalidate_region((void *)src, size);
+    memcpy(dst, src, size);
+}
+
+#endif
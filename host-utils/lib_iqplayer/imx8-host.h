@@ -9,14 +9,26 @@
 
 #define CACHE_LINE_SIZE 64
 
+#if defined(__aarch64__)
 // Data Cache Flush/Clean
 #define dcbf(p) \
     { asm volatile("dc cvac, %0" : : "r"(p) : "memory"); }
 // Clean and Invalidate data cache
 #define dccivac(p) \
     { asm volatile("dc civac, %0" : : "r"(p) : "memory"); }
+#else
+// coherent test host, no cache maintenance
+#define dcbf(p) \
+    { (void)(p); }
+#define dccivac(p) \
+    { (void)(p); }
+#endif
 
 void invalidate_region(void *region, uint32_t size);
 void flush_region(void *region, uint32_t size);
 
+/* fifo copies fused with cache maintenance (NEON on aarch64, memcpy fallback elsewhere) */
+void copy_flush_region(void *dst, const void *src, uint32_t size);
+void invalidate_copy_region(void *dst, const void *src, uint32_t size);
+
 #endif
@@ -0,0 +1,356 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#if !defined(IQ_CONVERT_SCALAR)
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#define IQ_CONVERT_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define IQ_CONVERT_SSE2 1
+#endif
+#endif
+
+#include "lib_iqplayer_api.h"
+#include "iq_convert.h"
+#include "iq_bfp.h"
+
+#define IQ_CF32_SCALE 32768.0f
+
+uint32_t iq_convert_sample_size(uint32_t fmt) {
+    switch (fmt) {
+    case IQ_FMT_CS8:
+        return 2;
+    case IQ_FMT_CF32:
+    case IQ_FMT_CF32_SCALED:
+        return 8;
+    case IQ_FMT_CS16:
+    default:
+        return 4;
+    }
+}
+
+/*
+ * scalar reference, also used for vector kernel tails
+ */
+static inline int16_t iq_f32_to_s16(float x, float scale) {
+    float v = x * scale;
+
+    if (v > 32767.0f)
+        v = 32767.0f;
+    if (v < -32768.0f)
+        v = -32768.0f;
+    return (int16_t)lrintf(v);
+}
+
+static inline int8_t iq_s16_to_s8(int16_t x) {
+    int32_t v = ((int32_t)x + 128) >> 8;
+
+    return v > 127 ? 127 : (int8_t)v;
+}
+
+static void cs8_to_cs16_ref(int16_t *dst, const int8_t *src, uint32_t n) {
+    uint32_t i;
+
+    for (i = 0; i < n; i++)
+        dst[i] = (int16_t)((uint16_t)(uint8_t)src[i] << 8);
+}
+
+static void cs16_to_cs8_ref(int8_t *dst, const int16_t *src, uint32_t n) {
+    uint32_t i;
+
+    for (i = 0; i < n; i++)
+        dst[i] = iq_s16_to_s8(src[i]);
+}
+
+static void cf32_to_cs16_ref(int16_t *dst, const float *src, uint32_t n, float scale) {
+    uint32_t i;
+
+    for (i = 0; i < n; i++)
+        dst[i] = iq_f32_to_s16(src[i], scale);
+}
+
+static void cs16_to_cf32_ref(float *dst, const int16_t *src, uint32_t n, float inv_scale) {
+    uint32_t i;
+
+    for (i = 0; i < n; i++)
+        dst[i] = (float)src[i] * inv_scale;
+}
+
+#if defined(IQ_CONVERT_NEON)
+
+static void cs8_to_cs16(int16_t *dst, const int8_t *src, uint32_t n) {
+    uint32_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        int8x16_t v = vld1q_s8(src + i);
+        vst1q_s16(dst + i, vshll_n_s8(vget_low_s8(v), 8));
+        vst1q_s16(dst + i + 8, vshll_n_s8(vget_high_s8(v), 8));
+    }
+    cs8_to_cs16_ref(dst + i, src + i, n - i);
+}
+
+static void cs16_to_cs8(int8_t *dst, const int16_t *src, uint32_t n) {
+    uint32_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        int8x8_t lo = vqrshrn_n_s16(vld1q_s16(src + i), 8);
+        int8x8_t hi = vqrshrn_n_s16(vld1q_s16(src + i + 8), 8);
+        vst1q_s8(dst + i, vcombine_s8(lo, hi));
+    }
+    cs16_to_cs8_ref(dst + i, src + i, n - i);
+}
+
+static void cf32_to_cs16(int16_t *dst, const float *src, uint32_t n, float scale) {
+    float32x4_t vscale = vdupq_n_f32(scale);
+    float32x4_t vmax = vdupq_n_f32(32767.0f);
+    float32x4_t vmin = vdupq_n_f32(-32768.0f);
+    uint32_t i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        float32x4_t a = vmulq_f32(vld1q_f32(src + i), vscale);
+        float32x4_t b = vmulq_f32(vld1q_f32(src + i + 4), vscale);
+        a = vmaxq_f32(vminq_f32(a, vmax), vmin);
+        b = vmaxq_f32(vminq_f32(b, vmax), vmin);
+        vst1q_s16(dst + i, vcombine_s16(vmovn_s32(vcvtnq_s32_f32(a)), vmovn_s32(vcvtnq_s32_f32(b))));
+    }
+    cf32_to_cs16_ref(dst + i, src + i, n - i, scale);
+}
+
+static void cs16_to_cf32(float *dst, const int16_t *src, uint32_t n, float inv_scale) {
+    float32x4_t vinv = vdupq_n_f32(inv_scale);
+    uint32_t i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        int16x8_t v = vld1q_s16(src + i);
+        vst1q_f32(dst + i, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), vinv));
+        vst1q_f32(dst + i + 4, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), vinv));
+    }
+    cs16_to_cf32_ref(dst + i, src + i, n - i, inv_scale);
+}
+
+#elif defined(IQ_CONVERT_SSE2)
+
+static void cs8_to_cs16(int16_t *dst, const int8_t *src, uint32_t n) {
+    __m128i zero = _mm_setzero_si128();
+    uint32_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_unpacklo_epi8(zero, v));
+        _mm_storeu_si128((__m128i *)(dst + i + 8), _mm_unpackhi_epi8(zero, v));
+    }
+    cs8_to_cs16_ref(dst + i, src + i, n - i);
+}
+
+static void cs16_to_cs8(int8_t *dst, const int16_t *src, uint32_t n) {
+    __m128i rnd = _mm_set1_epi16(128);
+    uint32_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        __m128i lo = _mm_srai_epi16(_mm_adds_epi16(_mm_loadu_si128((const __m128i *)(src + i)), rnd), 8);
+        __m128i hi = _mm_srai_epi16(_mm_adds_epi16(_mm_loadu_si128((const __m128i *)(src + i + 8)), rnd), 8);
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packs_epi16(lo, hi));
+    }
+    cs16_to_cs8_ref(dst + i, src + i, n - i);
+}
+
+static void cf32_to_cs16(int16_t *dst, const float *src, uint32_t n, float scale) {
+    __m128 vscale = _mm_set1_ps(scale);
+    __m128 vmax = _mm_set1_ps(32767.0f);
+    __m128 vmin = _mm_set1_ps(-32768.0f);
+    uint32_t i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        __m128 a = _mm_mul_ps(_mm_loadu_ps(src + i), vscale);
+        __m128 b = _mm_mul_ps(_mm_loadu_ps(src + i + 4), vscale);
+        a = _mm_max_ps(_mm_min_ps(a, vmax), vmin);
+        b = _mm_max_ps(_mm_min_ps(b, vmax), vmin);
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+    }
+    cf32_to_cs16_ref(dst + i, src + i, n - i, scale);
+}
+
+static void cs16_to_cf32(float *dst, const int16_t *src, uint32_t n, float inv_scale) {
+    __m128 vinv = _mm_set1_ps(inv_scale);
+    uint32_t i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), vinv));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), vinv));
+    }
+    cs16_to_cf32_ref(dst + i, src + i, n - i, inv_scale);
+}
+
+#else
+
+#define cs8_to_cs16 cs8_to_cs16_ref
+#define cs16_to_cs8 cs16_to_cs8_ref
+#define cf32_to_cs16 cf32_to_cs16_ref
+#define cs16_to_cf32 cs16_to_cf32_ref
+
+#endif
+
+#if defined(IQ_CONVERT_NEON)
+
+/*
+ * 8 components of width bits are width bytes, starting byte aligned. One 16B load covers them (width <= 15),
+ * a table lookup builds each lane 32-bit word from its 3 bytes, then per lane shifts move the field to the top,
+ * sign extend it and apply the block exponent.
+ */
+static void bfp_to_cs16(int16_t *dst, const uint8_t *src, uint32_t nb_blocks, uint32_t width) {
+    const uint8_t *exps = src + nb_blocks * 4 * width;
+    uint8_t idx[32];
+    int32_t sh[8];
+    uint8x16_t tbl_lo, tbl_hi;
+    int32x4_t sh_lo, sh_hi, sext = vdupq_n_s32(-(int32_t)(32 - width)), vexp;
+    uint32_t b, g, i, bit;
+
+    for (i = 0; i < 8; i++) {
+        bit = i * width;
+        idx[4 * i] = bit >> 3;
+        idx[4 * i + 1] = (bit >> 3) + 1;
+        idx[4 * i + 2] = (bit >> 3) + 2;
+        idx[4 * i + 3] = 0xFF; /* out of table : 0 */
+        sh[i] = 32 - width - (bit & 7);
+    }
+    tbl_lo = vld1q_u8(idx);
+    tbl_hi = vld1q_u8(idx + 16);
+    sh_lo = vld1q_s32(sh);
+    sh_hi = vld1q_s32(sh + 4);
+
+    for (b = 0; b < nb_blocks; b++) {
+        vexp = vdupq_n_s32(exps[b]);
+        for (g = 0; g < IQ_BFP_BLOCK_COMP / 8; g++) {
+            uint8x16_t v = vld1q_u8(src + (b * 4 + g) * width);
+            int32x4_t lo = vreinterpretq_s32_u32(vshlq_u32(vreinterpretq_u32_u8(vqtbl1q_u8(v, tbl_lo)), sh_lo));
+            int32x4_t hi = vreinterpretq_s32_u32(vshlq_u32(vreinterpretq_u32_u8(vqtbl1q_u8(v, tbl_hi)), sh_hi));
+            lo = vshlq_s32(vshlq_s32(lo, sext), vexp);
+            hi = vshlq_s32(vshlq_s32(hi, sext), vexp);
+            vst1q_s16(dst + b * IQ_BFP_BLOCK_COMP + g * 8, vcombine_s16(vmovn_s32(lo), vmovn_s32(hi)));
+        }
+    }
+}
+
+/*
+ * Saturated magnitude, block max and rounding shift are done on 4 vectors of 8 components, giving the same
+ * mantissas as iq_bfp_compress_block(), then fields are packed through a 64-bit accumulator.
+ */
+static void cs16_to_bfp(uint8_t *dst, const int16_t *src, uint32_t nb_blocks, uint32_t width) {
+    uint32_t *out = (uint32_t *)dst;
+    uint8_t *exps = dst + nb_blocks * 4 * width;
+    uint16x8_t vmmax = vdupq_n_u16((1 << (width - 1)) - 1);
+    uint32_t b, g, k, e, max, bits, nbits, mask = (1U << width) - 1;
+    int16_t q[IQ_BFP_BLOCK_COMP];
+    int16x8_t x[4], vsh;
+    uint16x8_t mag[4];
+    uint64_t acc;
+
+    for (b = 0; b < nb_blocks; b++) {
+        for (g = 0; g < 4; g++) {
+            x[g] = vld1q_s16(src + b * IQ_BFP_BLOCK_COMP + g * 8);
+            mag[g] = vreinterpretq_u16_s16(vqabsq_s16(x[g]));
+        }
+        max = vmaxvq_u16(vmaxq_u16(vmaxq_u16(mag[0], mag[1]), vmaxq_u16(mag[2], mag[3])));
+        bits = max ? 32 - __builtin_clz(max) : 0;
+        e = bits > width - 1 ? bits - (width - 1) : 0;
+        vsh = vdupq_n_s16(-(int16_t)e);
+        for (g = 0; g < 4; g++) {
+            int16x8_t m = vreinterpretq_s16_u16(vminq_u16(vrshlq_u16(mag[g], vsh), vmmax));
+            vst1q_s16(q + g * 8, vbslq_s16(vcltzq_s16(x[g]), vnegq_s16(m), m));
+        }
+
+        acc = 0;
+        nbits = 0;
+        for (k = 0; k < IQ_BFP_BLOCK_COMP; k++) {
+            acc |= (uint64_t)((uint16_t)q[k] & mask) << nbits;
+            nbits += width;
+            if (nbits >= 32) {
+                *out++ = (uint32_t)acc;
+                acc >>= 32;
+                nbits -= 32;
+            }
+        }
+        exps[b] = e;
+    }
+    memset(exps + nb_blocks, 0, IQ_BFP_EXP_SIZE(nb_blocks) - nb_blocks);
+}
+
+#else
+
+static void bfp_to_cs16(int16_t *dst, const uint8_t *src, uint32_t nb_blocks, uint32_t width) {
+    iq_bfp_decompress(dst, (const uint32_t *)src, nb_blocks, width);
+}
+
+static void cs16_to_bfp(uint8_t *dst, const int16_t *src, uint32_t nb_blocks, uint32_t width) {
+    uint8_t *exps = dst + nb_blocks * 4 * width;
+    uint16_t sm[IQ_BFP_BLOCK_COMP];
+    uint32_t b, k;
+
+    for (b = 0; b < nb_blocks; b++) {
+        for (k = 0; k < IQ_BFP_BLOCK_COMP; k++)
+            sm[k] = iq_bfp_cs16_to_sm(src[b * IQ_BFP_BLOCK_COMP + k]);
+        exps[b] = iq_bfp_compress_block((uint32_t *)dst + b * width, sm, width);
+    }
+    memset(exps + nb_blocks, 0, IQ_BFP_EXP_SIZE(nb_blocks) - nb_blocks);
+}
+
+#endif
+
+void iq_convert_bfp_to_cs16(int16_t *dst, const void *chunk, uint32_t raw_size, uint32_t width) {
+    bfp_to_cs16(dst, chunk, raw_size / IQ_BFP_BLOCK_SIZE, width);
+}
+
+void iq_convert_cs16_to_bfp(void *chunk, const int16_t *src, uint32_t raw_size, uint32_t width) {
+    cs16_to_bfp(chunk, src, raw_size / IQ_BFP_BLOCK_SIZE, width);
+}
+
+void iq_convert_to_cs16(int16_t *dst, const void *src, uint32_t nb_comp, uint32_t fmt, float scale) {
+    switch (fmt) {
+    case IQ_FMT_CS8:
+        cs8_to_cs16(dst, (const int8_t *)src, nb_comp);
+        break;
+    case IQ_FMT_CF32:
+        cf32_to_cs16(dst, (const float *)src, nb_comp, IQ_CF32_SCALE);
+        break;
+    case IQ_FMT_CF32_SCALED:
+        cf32_to_cs16(dst, (const float *)src, nb_comp, scale);
+        break;
+    case IQ_FMT_CS16:
+    default:
+        memcpy(dst, src, nb_comp * sizeof(int16_t));
+        break;
+    }
+}
+
+void iq_convert_from_cs16(void *dst, const int16_t *src, uint32_t nb_comp, uint32_t fmt, float scale) {
+    switch (fmt) {
+    case IQ_FMT_CS8:
+        cs16_to_cs8((int8_t *)dst, src, nb_comp);
+        break;
+    case IQ_FMT_CF32:
+        cs16_to_cf32((float *)dst, src, nb_comp, 1.0f / IQ_CF32_SCALE);
+        break;
+    case IQ_FMT_CF32_SCALED:
+        cs16_to_cf32((float *)dst, src, nb_comp, 1.0f / scale);
+        break;
+    case IQ_FMT_CS16:
+    default:
+        memcpy(dst, src, nb_comp * sizeof(int16_t));
+        break;
+    }
+}
@@ -0,0 +1,39 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#ifndef __IQ_CONVERT_H__
+#define __IQ_CONVERT_H__
+
+#include <stdint.h>
+
+/*
+ * Sample format conversion to/from modem cs16 (16-bit two's complement I/Q), nb_comp is the number of
+ * I or Q components (2 per sample). NEON or SSE2 kernels are selected at build time, define
+ * IQ_CONVERT_SCALAR to build the scalar reference only. All variants are bit exact :
+ * cs8 -> cs16 : x << 8
+ * cs16 -> cs8 : (x + 128) >> 8 saturated
+ * cf32 -> cs16 : x * scale clamped to [-32768, 32767] in float, rounded to nearest even
+ * cs16 -> cf32 : x * (1 / scale)
+ */
+void iq_convert_to_cs16(int16_t *dst, const void *src, uint32_t nb_comp, uint32_t fmt, float scale);
+void iq_convert_from_cs16(void *dst, const int16_t *src, uint32_t nb_comp, uint32_t fmt, float scale);
+
+/*
+ * RX BFP chunk (iq_bfp.h) of raw_size cs16 bytes back to cs16, width is the mantissa width. NEON kernel is
+ * bit exact with iq_bfp_decompress(), chunk buffer must be IQ_BFP_CHUNK_SIZE(raw_size, width) bytes.
+ */
+void iq_convert_bfp_to_cs16(int16_t *dst, const void *chunk, uint32_t raw_size, uint32_t width);
+
+/*
+ * TX : raw_size cs16 bytes to a BFP chunk of IQ_BFP_CHUNK_SIZE(raw_size, width) bytes, bit exact with
+ * iq_bfp_compress() fed with iq_bfp_cs16_to_sm() samples.
+ */
+void iq_convert_cs16_to_bfp(void *chunk, const int16_t *src, uint32_t raw_size, uint32_t width);
+
+/* bytes per I/Q sample for a given format */
+uint32_t iq_convert_sample_size(uint32_t fmt);
+
+#endif
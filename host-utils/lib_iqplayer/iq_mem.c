@@ -0,0 +1,71 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "lib_iqplayer_api.h"
+
+/*
+ * Stream buffer allocator : 2MB hugepages from hugetlbfs pool when available, else 2MB aligned anonymous
+ * memory with transparent hugepages requested. Buffer is locked and prefaulted so streaming never takes
+ * tlb refill storms or page faults. Size is rounded up to 2MB, same size must be given to iq_mem_free().
+ */
+#define IQ_MEM_HUGEPAGE_SIZE (2 * 1024 * 1024UL)
+
+static inline size_t iq_mem_round(size_t size) {
+    return (size + IQ_MEM_HUGEPAGE_SIZE - 1) & ~(IQ_MEM_HUGEPAGE_SIZE - 1);
+}
+
+void *iq_mem_alloc(size_t size) {
+    size_t page = sysconf(_SC_PAGESIZE);
+    uint8_t *buf, *aligned;
+    size_t i;
+
+    if (size == 0)
+        return NULL;
+    size = iq_mem_round(size);
+
+    buf = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+    if (buf != MAP_FAILED) {
+        mlock(buf, size);
+        return buf;
+    }
+
+    // no hugetlbfs pages, map 2MB more to trim an aligned window then ask for THP
+    buf = mmap(NULL, size + IQ_MEM_HUGEPAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buf == MAP_FAILED)
+        return NULL;
+    aligned = (uint8_t *)(((uintptr_t)buf + IQ_MEM_HUGEPAGE_SIZE - 1) & ~(IQ_MEM_HUGEPAGE_SIZE - 1));
+    if (aligned > buf)
+        munmap(buf, aligned - buf);
+    munmap(aligned + size, buf + IQ_MEM_HUGEPAGE_SIZE - aligned);
+    madvise(aligned, size, MADV_HUGEPAGE);
+
+    // mlock faults pages in, touch them anyway when locking is not permitted
+    if (mlock(aligned, size)) {
+        for (i = 0; i < size; i += page)
+            aligned[i] = 0;
+    }
+
+    return aligned;
+}
+
+void iq_mem_free(void *ptr, size_t size) {
+    if (ptr == NULL)
+        return;
+    size = iq_mem_round(size);
+    munlock(ptr, size);
+    munmap(ptr, size);
+}
@@ -0,0 +1,169 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sched.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "lib_iqplayer_api.h"
+
+/*
+ * Real time setup of the calling thread, and measure of what the polling loop will actually get from the cpu.
+ * Calls return 0 or -errno, settings needing privilege fail with -EPERM.
+ */
+#define IQ_RT_POLL_GAP_NS 10000  /* poll loop interruption threshold */
+#define IQ_RT_WAKE_PERIOD_NS 100000
+
+/* glibc has no sched_setattr() wrapper */
+struct iq_sched_attr {
+    uint32_t size;
+    uint32_t sched_policy;
+    uint64_t sched_flags;
+    int32_t sched_nice;
+    uint32_t sched_priority;
+    uint64_t sched_runtime;
+    uint64_t sched_deadline;
+    uint64_t sched_period;
+};
+
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE 6
+#endif
+
+static inline uint64_t iq_rt_now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+int iq_rt_set_affinity(int cpu) {
+    cpu_set_t cpuset;
+
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+    return -pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+}
+
+int iq_rt_set_fifo(int priority) {
+    struct sched_param param = { .sched_priority = priority };
+
+    return -pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+}
+
+int iq_rt_set_deadline(uint64_t runtime_ns, uint64_t deadline_ns, uint64_t period_ns) {
+    struct iq_sched_attr attr;
+
+#ifdef SYS_sched_setattr
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.sched_policy = SCHED_DEADLINE;
+    attr.sched_runtime = runtime_ns;
+    attr.sched_deadline = deadline_ns;
+    attr.sched_period = period_ns;
+    if (syscall(SYS_sched_setattr, 0, &attr, 0))
+        return -errno;
+    return 0;
+#else
+    (void)attr;
+    return -ENOSYS;
+#endif
+}
+
+int iq_rt_lock_memory(void) {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE))
+        return -errno;
+    return 0;
+}
+
+static bool iq_rt_cpu_in_list(const char *path, int cpu) {
+    char list[256], *tok, *save;
+    int first, last;
+    FILE *fp;
+
+    fp = fopen(path, "r");
+    if (!fp)
+        return false;
+    if (!fgets(list, sizeof(list), fp))
+        list[0] = 0;
+    fclose(fp);
+
+    // cpu list format : "2-3,5"
+    for (tok = strtok_r(list, ",\n", &save); tok; tok = strtok_r(NULL, ",\n", &save)) {
+        if (sscanf(tok, "%d-%d", &first, &last) == 2) {
+            if (cpu >= first && cpu <= last)
+                return true;
+        } else if (sscanf(tok, "%d", &first) == 1 && cpu == first) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* busy poll cpu checks : returns IQ_RT_CPU_xx bits set for cpu */
+uint32_t iq_rt_check_cpu(int cpu) {
+    uint32_t flags = 0;
+
+    if (iq_rt_cpu_in_list("/sys/devices/system/cpu/isolated", cpu))
+        flags |= IQ_RT_CPU_ISOLATED;
+    if (iq_rt_cpu_in_list("/sys/devices/system/cpu/nohz_full", cpu))
+        flags |= IQ_RT_CPU_NOHZ_FULL;
+
+    return flags;
+}
+
+/*
+ * Measure for duration_ms, half busy polling the clock as fifo loops do (largest gap is time stolen
+ * from the loop by interrupts / other tasks), half sleeping on IQ_RT_WAKE_PERIOD_NS absolute deadlines
+ * (late wake-up is what sleep / adaptive wait policies will see).
+ */
+void iq_rt_measure_jitter(uint32_t duration_ms, iq_rt_jitter_t *j) {
+    uint64_t start, end, prev, now, gap, late, next, wakes = 0, late_sum = 0;
+    struct timespec ts;
+
+    memset(j, 0, sizeof(*j));
+
+    start = prev = iq_rt_now_ns();
+    end = start + (uint64_t)duration_ms * 1000000 / 2;
+    while ((now = iq_rt_now_ns()) < end) {
+        gap = now - prev;
+        if (gap > j->poll_max_gap_ns)
+            j->poll_max_gap_ns = gap;
+        if (gap > IQ_RT_POLL_GAP_NS)
+            j->poll_gaps++;
+        prev = now;
+    }
+
+    next = iq_rt_now_ns();
+    end = next + (uint64_t)duration_ms * 1000000 / 2;
+    while (next < end) {
+        next += IQ_RT_WAKE_PERIOD_NS;
+        ts.tv_sec = next / 1000000000ULL;
+        ts.tv_nsec = next % 1000000000ULL;
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+        now = iq_rt_now_ns();
+        late = now > next ? now - next : 0;
+        if (late > j->wake_max_ns)
+            j->wake_max_ns = late;
+        late_sum += late;
+        wakes++;
+    }
+    if (wakes)
+        j->wake_avg_ns = late_sum / wakes;
+}
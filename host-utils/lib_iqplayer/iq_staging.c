@@ -0,0 +1,254 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include "imx8-host.h"
+#include "lib_iqplayer_api.h"
+
+/*
+ * Staging ring between application and a library feeder thread servicing the IQFLOOD fifo.
+ * Ring is single producer / single consumer : head is only written by producer, tail by consumer,
+ * each on its own cache line, published with release stores and read with acquire loads.
+ * TX : application produces with iq_feeder_write(), feeder thread consumes into tx fifo.
+ * RX : feeder thread produces from rx fifo, application consumes with iq_feeder_read().
+ */
+#define IQ_FEEDER_WAIT_NS 10000000ULL /* fifo wait timeout, bounds stop latency */
+#define IQ_FEEDER_IDLE_NS 20000       /* ring empty (tx) / full (rx) poll period */
+
+struct iq_feeder_s {
+    uint8_t *buf;
+    uint32_t size; /* power of 2 */
+    bool tx;
+    iq_tx_stream_t *tx_stream;
+    iq_rx_stream_t *rx_stream;
+    pthread_t thread;
+    volatile bool running;
+    uint64_t head __attribute__((aligned(CACHE_LINE_SIZE))); /* bytes produced */
+    uint64_t stalls;                                        /* producer found ring full */
+    uint64_t tail __attribute__((aligned(CACHE_LINE_SIZE))); /* bytes consumed */
+    uint64_t moved;                                         /* feeder thread : bytes moved to/from fifo */
+    uint64_t lost;                                          /* fifo underrun/overrun bytes */
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+static inline void iq_feeder_idle(void) {
+    struct timespec ts = { 0, IQ_FEEDER_IDLE_NS };
+
+    nanosleep(&ts, NULL);
+}
+
+/* contiguous readable / writable part of ring, at most up to ring wrap */
+static inline uint32_t iq_ring_readable(iq_feeder_t *f, uint8_t **ptr) {
+    uint64_t head = __atomic_load_n(&f->head, __ATOMIC_ACQUIRE);
+    uint32_t offset = f->tail & (f->size - 1);
+    uint32_t len = head - f->tail;
+
+    *ptr = f->buf + offset;
+    return len < f->size - offset ? len : f->size - offset;
+}
+
+static inline uint32_t iq_ring_writable(iq_feeder_t *f, uint8_t **ptr) {
+    uint64_t tail = __atomic_load_n(&f->tail, __ATOMIC_ACQUIRE);
+    uint32_t offset = f->head & (f->size - 1);
+    uint32_t len = f->size - (uint32_t)(f->head - tail);
+
+    *ptr = f->buf + offset;
+    return len < f->size - offset ? len : f->size - offset;
+}
+
+static void *iq_tx_feeder_thread(void *arg) {
+    iq_feeder_t *f = arg;
+    uint32_t chunk = iq_tx_chunk_size(f->tx_stream);
+    uint32_t len;
+    uint8_t *src;
+    int ret;
+
+    while (f->running) {
+        len = iq_ring_readable(f, &src);
+        len -= len % chunk;
+        if (len == 0) {
+            iq_feeder_idle();
+            continue;
+        }
+        ret = iq_tx_send_wait(f->tx_stream, (uint32_t *)src, len, IQ_FEEDER_WAIT_NS);
+        if (ret < 0) {
+            f->lost += iq_tx_lost_size(f->tx_stream);
+            continue;
+        }
+        f->moved += ret;
+        __atomic_store_n(&f->tail, f->tail + ret, __ATOMIC_RELEASE);
+    }
+    iq_tx_flush(f->tx_stream);
+
+    return NULL;
+}
+
+static void *iq_rx_feeder_thread(void *arg) {
+    iq_feeder_t *f = arg;
+    uint32_t chunk = iq_rx_chunk_size(f->rx_stream);
+    uint32_t len;
+    uint8_t *dst;
+    int ret;
+
+    while (f->running) {
+        len = iq_ring_writable(f, &dst);
+        len -= len % chunk;
+        if (len == 0) {
+            // application late, modem overrun will show up in lost count if it lasts
+            f->stalls++;
+            iq_feeder_idle();
+            continue;
+        }
+        ret = iq_rx_receive_wait(f->rx_stream, (uint32_t *)dst, 1, len, IQ_FEEDER_WAIT_NS);
+        if (ret < 0) {
+            f->lost += iq_rx_lost_size(f->rx_stream);
+            continue;
+        }
+        f->moved += ret;
+        __atomic_store_n(&f->head, f->head + ret, __ATOMIC_RELEASE);
+    }
+    iq_rx_flush(f->rx_stream);
+
+    return NULL;
+}
+
+static iq_feeder_t *iq_feeder_start(iq_tx_stream_t *tx, iq_rx_stream_t *rx, uint32_t ring_size, int cpu, int priority) {
+    struct sched_param param;
+    pthread_attr_t attr;
+    cpu_set_t cpuset;
+    iq_feeder_t *f;
+    int ret;
+
+    // power of 2, cache line multiple, at least one compressed stream chunk
+    if (ring_size < CACHE_LINE_SIZE || (ring_size & (ring_size - 1)))
+        return NULL;
+    if (ring_size < (tx ? iq_tx_chunk_size(tx) : iq_rx_chunk_size(rx)))
+        return NULL;
+
+    if (posix_memalign((void **)&f, CACHE_LINE_SIZE, sizeof(iq_feeder_t)))
+        return NULL;
+    memset(f, 0, sizeof(iq_feeder_t));
+    f->buf = iq_mem_alloc(ring_size);
+    if (f->buf == NULL) {
+        free(f);
+        return NULL;
+    }
+    f->size = ring_size;
+    f->tx = tx != NULL;
+    f->tx_stream = tx;
+    f->rx_stream = rx;
+    f->running = true;
+
+    pthread_attr_init(&attr);
+    if (cpu >= 0) {
+        CPU_ZERO(&cpuset);
+        CPU_SET(cpu, &cpuset);
+        pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t), &cpuset);
+    }
+    if (priority > 0) {
+        pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+        pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+        param.sched_priority = priority;
+        pthread_attr_setschedparam(&attr, &param);
+    }
+    ret = pthread_create(&f->thread, &attr, f->tx ? iq_tx_feeder_thread : iq_rx_feeder_thread, f);
+    if (ret == EPERM && priority > 0) {
+        // no rt privilege, run feeder with default policy
+        printf("\n iq_player : feeder SCHED_FIFO %d not permitted, using default policy\n", priority);
+        fflush(stdout);
+        pthread_attr_setinheritsched(&attr, PTHREAD_INHERIT_SCHED);
+        ret = pthread_create(&f->thread, &attr, f->tx ? iq_tx_feeder_thread : iq_rx_feeder_thread, f);
+    }
+    pthread_attr_destroy(&attr);
+    if (ret) {
+        iq_mem_free(f->buf, f->size);
+        free(f);
+        return NULL;
+    }
+
+    return f;
+}
+
+iq_feeder_t *iq_tx_feeder_start(iq_tx_stream_t *s, uint32_t ring_size, int cpu, int priority) {
+    return iq_feeder_start(s, NULL, ring_size, cpu, priority);
+}
+
+iq_feeder_t *iq_rx_feeder_start(iq_rx_stream_t *s, uint32_t ring_size, int cpu, int priority) {
+    return iq_feeder_start(NULL, s, ring_size, cpu, priority);
+}
+
+void iq_feeder_stop(iq_feeder_t *f) {
+    if (f == NULL)
+        return;
+    f->running = false;
+    pthread_join(f->thread, NULL);
+    iq_mem_free(f->buf, f->size);
+    free(f);
+}
+
+/* queue up to size bytes for tx, never blocks, returns bytes queued */
+int iq_feeder_write(iq_feeder_t *f, const void *v_buffer, uint32_t size) {
+    uint32_t done = 0, len;
+    uint8_t *dst;
+
+    if (!f->tx)
+        return -EINVAL;
+
+    while (done < size) {
+        len = iq_ring_writable(f, &dst);
+        if (len == 0) {
+            f->stalls++;
+            break;
+        }
+        if (len > size - done)
+            len = size - done;
+        memcpy(dst, (const uint8_t *)v_buffer + done, len);
+        done += len;
+        __atomic_store_n(&f->head, f->head + len, __ATOMIC_RELEASE);
+    }
+
+    return done;
+}
+
+/* dequeue up to max_size received bytes, never blocks, returns bytes read */
+int iq_feeder_read(iq_feeder_t *f, void *v_buffer, uint32_t max_size) {
+    uint32_t done = 0, len;
+    uint8_t *src;
+
+    if (f->tx)
+        return -EINVAL;
+
+    while (done < max_size) {
+        len = iq_ring_readable(f, &src);
+        if (len == 0)
+            break;
+        if (len > max_size - done)
+            len = max_size - done;
+        memcpy((uint8_t *)v_buffer + done, src, len);
+        done += len;
+        __atomic_store_n(&f->tail, f->tail + len, __ATOMIC_RELEASE);
+    }
+
+    return done;
+}
+
+/* moved : bytes between ring and fifo, lost : fifo underrun/overrun bytes, stalls : ring full events */
+void iq_feeder_stats(iq_feeder_t *f, uint64_t *moved, uint64_t *lost, uint64_t *stalls) {
+    *moved = f->moved;
+    *lost = f->lost;
+    *stalls = f->stalls;
+}
@@ -34,7 +34,9 @@ l1_trace_host_code_t l1_trace_host_code[] = { { 0x100, "L1_TRACE_MSG_DMA_XFR " }
 uint64_t rte_get_tsc_cycles(void) {
     uint64_t time;
 
+#if defined(__aarch64__)
     asm volatile("isb;mrs %0, pmccntr_el0" : "=r"(time));
+#endif
     time=0xdeadbeef;
     return time;
 }
@@ -80,17 +82,22 @@ void l1_trace_host_clear(void) {
 }
 
 void l1_trace(uint32_t msg, uint32_t param) {
+    uint32_t index, next;
+
     if (l1_trace_disable)
         return;
 
-    l1_trace_host_data[l1_trace_index].cnt = rte_get_tsc_cycles();
-    l1_trace_host_data[l1_trace_index].msg = msg;
-    l1_trace_host_data[l1_trace_index].param = param;
-    l1_trace_index++;
-
-    if (l1_trace_index >= L1_TRACE_HOST_SIZE) {
-        l1_trace_index = 0;
-    }
+    /* tx and rx streams may trace from different threads, reserve slot atomically */
+    index = __atomic_load_n(&l1_trace_index, __ATOMIC_RELAXED);
+    do {
+        next = index + 1;
+        if (next >= L1_TRACE_HOST_SIZE)
+            next = 0;
+    } while (!__atomic_compare_exchange_n(&l1_trace_index, &index, next, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    l1_trace_host_data[index].cnt = rte_get_tsc_cycles();
+    l1_trace_host_data[index].msg = msg;
+    l1_trace_host_data[index].param = param;
 }
 
 #else  // L1_TRACE
@@ -7,12 +7,155 @@
 #ifndef __LIB_IQ_API_H__
 #define __LIB_IQ_API_H__
 
+/*
+ * Data calls return bytes moved, 0 when fifo is not ready, or -EPIPE on tx underrun / rx overrun : stream
+ * is then resynchronized on modem position and xx_lost_size() gives the number of bytes lost. On rx overrun
+ * only overwritten data is lost, following calls return the fifo_size - RX_DDR_STEP most recent bytes.
+ */
+
+/*
+ * Handle based api : one iq_player_t per modem, one stream object for tx and per rx channel.
+ * Each stream may be driven by its own thread, a given stream must not be used by two threads.
+ */
+typedef struct iq_player_s iq_player_t;
+typedef struct iq_tx_stream_s iq_tx_stream_t;
+typedef struct iq_rx_stream_s iq_rx_stream_t;
+struct iovec;
+
+/* wait policy of blocking calls, sample_rate (Hz, 0 unknown) is used to predict next chunk arrival */
+typedef enum { IQ_WAIT_SPIN = 0, IQ_WAIT_YIELD, IQ_WAIT_SLEEP, IQ_WAIT_ADAPTIVE, IQ_WAIT_MAX } iq_wait_policy_e;
+#define IQ_WAIT_FOREVER ((uint64_t)-1)
+
+/*
+ * application sample format of xx_fmt() calls, modem side is always cs16 :
+ * cs8 uses the 8 msb, cf32 is full scale at +/-1.0, cf32 scaled is cs16 = cf32 * scale (saturated)
+ */
+typedef enum { IQ_FMT_CS16 = 0, IQ_FMT_CS8, IQ_FMT_CF32, IQ_FMT_CF32_SCALED, IQ_FMT_MAX } iq_sample_fmt_e;
+
+iq_player_t *iq_player_open(uint32_t *v_iqflood, uint32_t iqflood_size, uint32_t *v_la9310_pci_bar2);
+void iq_player_close(iq_player_t *p);
+uint32_t iq_player_rx_num_chan(iq_player_t *p);
+iq_tx_stream_t *iq_player_tx_stream(iq_player_t *p);
+iq_rx_stream_t *iq_player_rx_stream(iq_player_t *p, uint32_t chan);
+void iq_player_set_wait_policy(iq_player_t *p, uint32_t policy, uint32_t sample_rate);
+/* coalesce modem flow control writes : publish once min_size bytes or max_delay_us pending (0,0 : every call) */
+void iq_player_set_doorbell(iq_player_t *p, uint32_t min_size, uint32_t max_delay_us);
+
+/* rx notification fd (uio device of modem MSI, or eventfd simulated source when dev is NULL) */
+int iq_player_rx_event_open(iq_player_t *p, const char *dev);
+int iq_player_rx_event_ack(iq_player_t *p);
+int iq_player_rx_event_notify(iq_player_t *p);
+
+/*
+ * TX fifo BFP compressed (proxy tx_cmp_mode) : send calls take cs16 and compress it, whole TX_DDR_STEP chunks only
+ * (iq_tx_chunk_size()). iq_tx_send() leaves a shorter tail to the caller, iq_tx_send_wait() returns -EINVAL when
+ * size is not a chunk multiple. acquire / sendv / fmt calls return -EOPNOTSUPP
+ */
+int iq_tx_init(iq_tx_stream_t *s, uint32_t fifo_start, uint32_t fifo_size);
+int iq_tx_send(iq_tx_stream_t *s, uint32_t *v_buffer, uint32_t size);
+int iq_tx_acquire(iq_tx_stream_t *s, void **ptr, uint32_t *len);
+int iq_tx_commit(iq_tx_stream_t *s, uint32_t len);
+int iq_tx_sendv(iq_tx_stream_t *s, const struct iovec *iov, int iovcnt);
+int iq_tx_send_fmt(iq_tx_stream_t *s, const void *v_buffer, uint32_t nb_samples, uint32_t fmt, float scale);
+int iq_tx_send_wait(iq_tx_stream_t *s, uint32_t *v_buffer, uint32_t size, uint64_t timeout_ns);
+uint32_t iq_tx_lost_size(iq_tx_stream_t *s);
+uint32_t iq_tx_chunk_size(iq_tx_stream_t *s);
+void iq_tx_flush(iq_tx_stream_t *s);
+void iq_tx_doorbell_stats(iq_tx_stream_t *s, uint64_t *doorbells, uint64_t *chunks);
+
+/*
+ * RX fifo BFP compressed by modem (proxy rx_cmp_mode) : receive calls return cs16, whole RX_DDR_STEP chunks only
+ * (iq_rx_chunk_size()), -ENOSPC when max_size is below one chunk. peek / recvv / fmt calls return -EOPNOTSUPP
+ */
+int iq_rx_init(iq_rx_stream_t *s, uint32_t fifo_start, uint32_t fifo_size);
+int iq_rx_receive(iq_rx_stream_t *s, uint32_t *v_buffer, uint32_t max_size);
+int iq_rx_peek(iq_rx_stream_t *s, void **seg0, uint32_t *len0, void **seg1, uint32_t *len1);
+int iq_rx_release(iq_rx_stream_t *s, uint32_t len);
+int iq_rx_recvv(iq_rx_stream_t *s, const struct iovec *iov, int iovcnt);
+int iq_rx_receive_fmt(iq_rx_stream_t *s, void *v_buffer, uint32_t max_samples, uint32_t fmt, float scale);
+int iq_rx_receive_wait(iq_rx_stream_t *s, uint32_t *v_buffer, uint32_t min_size, uint32_t max_size, uint64_t timeout_ns);
+uint32_t iq_rx_lost_size(iq_rx_stream_t *s);
+uint32_t iq_rx_chunk_size(iq_rx_stream_t *s);
+void iq_rx_flush(iq_rx_stream_t *s);
+void iq_rx_doorbell_stats(iq_rx_stream_t *s, uint64_t *doorbells, uint64_t *chunks);
+
+/* stream buffers : 2MB hugepages (hugetlbfs, else THP), locked and prefaulted, free with same size */
+void *iq_mem_alloc(size_t size);
+void iq_mem_free(void *ptr, size_t size);
+
+/* real time setup of calling thread, 0 or -errno */
+int iq_rt_set_affinity(int cpu);
+int iq_rt_set_fifo(int priority);
+int iq_rt_set_deadline(uint64_t runtime_ns, uint64_t deadline_ns, uint64_t period_ns);
+int iq_rt_lock_memory(void);
+
+/* cpu isolation of a busy polling cpu, and measured poll loop gaps / sleep wake-up latency */
+#define IQ_RT_CPU_ISOLATED 0x1
+#define IQ_RT_CPU_NOHZ_FULL 0x2
+uint32_t iq_rt_check_cpu(int cpu);
+typedef struct {
+    uint64_t poll_max_gap_ns;
+    uint64_t poll_gaps; /* poll loop interrupted more than 10us */
+    uint64_t wake_avg_ns;
+    uint64_t wake_max_ns;
+} iq_rt_jitter_t;
+void iq_rt_measure_jitter(uint32_t duration_ms, iq_rt_jitter_t *j);
+
+/*
+ * Optional feeder thread : services a stream fifo from a lock-free spsc staging ring (from iq_mem_alloc()),
+ * so application jitter does not reach the fifo. ring_size is a power of 2, at least one chunk of a compressed
+ * stream, cpu < 0 leaves affinity unset, priority > 0 requests SCHED_FIFO. write/read never block and return bytes
+ * queued/dequeued. A compressed tx feeder sends whole chunks, a shorter tail stays in the ring.
+ */
+typedef struct iq_feeder_s iq_feeder_t;
+iq_feeder_t *iq_tx_feeder_start(iq_tx_stream_t *s, uint32_t ring_size, int cpu, int priority);
+iq_feeder_t *iq_rx_feeder_start(iq_rx_stream_t *s, uint32_t ring_size, int cpu, int priority);
+void iq_feeder_stop(iq_feeder_t *f);
+int iq_feeder_write(iq_feeder_t *f, const void *v_buffer, uint32_t size);
+int iq_feeder_read(iq_feeder_t *f, void *v_buffer, uint32_t max_size);
+void iq_feeder_stats(iq_feeder_t *f, uint64_t *moved, uint64_t *lost, uint64_t *stalls);
+
+/*
+ * Legacy single modem api, same as above on a default instance
+ */
+
 int iq_player_init(uint32_t *v_iqflood, uint32_t iqflood_size, uint32_t *v_la9310_pci_bar2);
 
 int iq_player_init_tx(uint32_t fifo_start, uint32_t fifo_size);
 int iq_player_send_data(uint32_t *v_buffer, uint32_t size);
+/* scatter/gather : move data across fifo wrap and user buffers, one modem flow control update per call */
+int iq_player_sendv(const struct iovec *iov, int iovcnt);
+int iq_player_recvv(uint32_t chan, const struct iovec *iov, int iovcnt);
+/* send / receive with sample format conversion, sizes and return in samples */
+int iq_player_send_data_fmt(const void *v_buffer, uint32_t nb_samples, uint32_t fmt, float scale);
+
+/* zero-copy tx : fill fifo window in place, then commit up to len acquired bytes */
+int iq_player_tx_acquire(void **ptr, uint32_t *len);
+int iq_player_tx_commit(uint32_t len);
 
 int iq_player_init_rx(uint32_t chan, uint32_t fifo_start, uint32_t fifo_size);
 int iq_player_receive_data(uint32_t chan, uint32_t *v_buffer, uint32_t max_size);
+int iq_player_receive_data_fmt(uint32_t chan, void *v_buffer, uint32_t max_samples, uint32_t fmt, float scale);
+
+/* zero-copy rx : read ready data in place (seg1 is set when data wraps), then release consumed bytes */
+int iq_player_rx_peek(uint32_t chan, void **seg0, uint32_t *len0, void **seg1, uint32_t *len1);
+int iq_player_rx_release(uint32_t chan, uint32_t len);
+
+/* blocking : return once size (tx) / at least min_size (rx) bytes are moved or timeout_ns elapsed */
+int iq_player_init_wait(uint32_t policy, uint32_t sample_rate);
+int iq_player_send_wait(uint32_t *v_buffer, uint32_t size, uint64_t timeout_ns);
+int iq_player_receive_wait(uint32_t chan, uint32_t *v_buffer, uint32_t min_size, uint32_t max_size, uint64_t timeout_ns);
+uint32_t iq_player_tx_lost_size(void);
+uint32_t iq_player_rx_lost_size(uint32_t chan);
+
+/* doorbell coalescing, flush pending flow control at end of stream, doorbells written vs chunks moved */
+int iq_player_init_doorbell(uint32_t min_size, uint32_t max_delay_us);
+void iq_player_tx_flush(void);
+void iq_player_rx_flush(uint32_t chan);
+void iq_player_tx_doorbell_stats(uint64_t *doorbells, uint64_t *chunks);
+void iq_player_rx_doorbell_stats(uint32_t chan, uint64_t *doorbells, uint64_t *chunks);
+
+/* handle of default instance, once iq_player_init() done, to use handle based calls with legacy init */
+iq_player_t *iq_player_get_default(void);
 
 #endif
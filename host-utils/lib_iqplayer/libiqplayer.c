@@ -17,11 +17,14 @@
 #include <sys/stat.h>
 #include <sys/ioctl.h>
 #include <sys/timerfd.h>
+#include <sys/eventfd.h>
 #include <sys/mman.h>
+#include <sys/uio.h>
 #include <errno.h>
 #include <stdbool.h>
 #include <pthread.h>
 #include <sched.h>
+#include <time.h>
 #include <assert.h>
 #include <semaphore.h>
 #include <signal.h>
@@ -30,61 +33,237 @@
 #include "vspa_dmem_proxy.h"
 #include "imx8-host.h"
 #include "l1-trace-host.h"
+#include "lib_iqplayer_api.h"
+#include "iq_convert.h"
+#include "iq_bfp.h"
 
-uint32_t *v_iqflood_ddr_addr = NULL;
-uint32_t *BAR2_addr = NULL;
-uint32_t *v_vspa_dmem_proxy_ro = NULL;
-t_tx_ch_host_proxy *tx_vspa_proxy_ro = NULL;
-t_rx_ch_host_proxy *rx_vspa_proxy_ro = NULL;
-uint32_t *v_tx_vspa_proxy_wo;
-uint32_t *v_rx_vspa_proxy_wo;
-t_stats *app_stats = NULL;
-
-#define TX_DDR_STEP (((t_vspa_dmem_proxy *)v_vspa_dmem_proxy_ro)->tx_state_readonly.tx_ddr_step)
-#define RX_DDR_STEP (((t_vspa_dmem_proxy *)v_vspa_dmem_proxy_ro)->tx_state_readonly.rx_ddr_step)
-#define RX_DECIM (((t_vspa_dmem_proxy *)v_vspa_dmem_proxy_ro)->tx_state_readonly.rx_decim)
-#define TX_UPSMP (((t_vspa_dmem_proxy *)v_vspa_dmem_proxy_ro)->tx_state_readonly.tx_upsmp)
-#define RX_NUM_CHAN (((t_vspa_dmem_proxy *)v_vspa_dmem_proxy_ro)->tx_state_readonly.rx_num_chan)
+/*
+ * One iq_player_t per modem. TX and each RX channel state live in their own cache line aligned
+ * stream object, so streams can be driven from separate threads without sharing host cache lines.
+ * Shared player fields are only written by iq_player_open().
+ */
+struct iq_tx_stream_s {
+    iq_player_t *player;
+    uint32_t fifo_start;
+    uint32_t fifo_size;
+    uint32_t fifo_offset;
+    uint64_t total_produced_size; /* Bytes copied into modem tx Fifo */
+    uint64_t total_consumed_size; /* Bytes sent out of modem tx Fifo */
+    uint32_t acquired_size;
+    uint32_t cmp_width;      /* BFP mantissa width of modem chunks, 0 : cs16 */
+    uint32_t cmp_chunk_size; /* DDR bytes per TX_DDR_STEP cs16 bytes */
+    uint32_t lost_size;      /* Bytes played by modem without host data on last underrun */
+    bool lost_pending;
+    uint64_t published_size; /* host_produced_size last written to modem */
+    uint64_t doorbell_ns;
+    uint64_t doorbells;
+    uint64_t chunks;
+} __attribute__((aligned(CACHE_LINE_SIZE)));
 
-int iq_player_init(uint32_t *v_iqflood, uint32_t iqflood_size, uint32_t *v_la9310_pci_bar2) {
-    v_iqflood_ddr_addr = v_iqflood;
+struct iq_rx_stream_s {
+    iq_player_t *player;
+    uint32_t chan;
+    uint32_t fifo_start;
+    uint32_t fifo_size;
+    uint32_t fifo_offset;
+    uint64_t total_consumed_size; /* Bytes copied from modem rx Fifo */
+    uint64_t total_produced_size; /* Bytes received in modem rx Fifo */
+    uint32_t peeked_size;
+    uint32_t cmp_width;      /* BFP mantissa width of modem chunks, 0 : cs16 */
+    uint32_t cmp_chunk_size; /* DDR bytes per RX_DDR_STEP cs16 bytes */
+    uint32_t lost_size;      /* Bytes dropped on last overrun */
+    bool lost_pending;
+    uint64_t published_size; /* host_consumed_size last written to modem */
+    uint64_t doorbell_ns;
+    uint64_t doorbells;
+    uint64_t chunks;
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+struct iq_player_s {
+    uint32_t *v_iqflood_ddr_addr;
+    uint32_t *BAR2_addr;
+    t_vspa_dmem_proxy *vspa_dmem_proxy_ro;
+    t_tx_ch_host_proxy *tx_vspa_proxy_ro;
+    t_rx_ch_host_proxy *rx_vspa_proxy_ro;
+    t_tx_ch_host_proxy *tx_vspa_proxy_wo;
+    t_stats *app_stats;
+    uint32_t wait_policy;
+    uint32_t sample_rate;
+    uint32_t doorbell_min_size;
+    uint64_t doorbell_max_ns;
+    int rx_event_fd;
+    bool rx_event_uio;
+    bool allocated;
+    iq_tx_stream_t tx;
+    iq_rx_stream_t rx[RX_NUM_MAX_CHAN];
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+#define TX_DDR_STEP(p) ((p)->vspa_dmem_proxy_ro->tx_state_readonly.tx_ddr_step)
+#define RX_DDR_STEP(p) ((p)->vspa_dmem_proxy_ro->tx_state_readonly.rx_ddr_step)
+#define RX_DECIM(p) ((p)->vspa_dmem_proxy_ro->tx_state_readonly.rx_decim)
+#define TX_UPSMP(p) ((p)->vspa_dmem_proxy_ro->tx_state_readonly.tx_upsmp)
+#define RX_NUM_CHAN(p) ((p)->vspa_dmem_proxy_ro->tx_state_readonly.rx_num_chan)
+
+/* instance behind legacy iq_player_xxx() single modem api */
+static iq_player_t iq_player_default;
+
+/*
+ * Proxy flow counters are 64-bit, split in 32-bit low word and _hi epoch word. Full value is read once at
+ * init, then only low words are polled and extended from last known value, as counters never move by 4GB
+ * between two polls. This avoids torn lo/hi reads while proxy is refreshed by vspa dma.
+ */
+static inline uint64_t iq_proxy_cnt_read(uint32_t lo, uint32_t hi) {
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static inline uint64_t iq_proxy_cnt_extend(uint64_t prev, uint32_t lo) {
+    return prev + (uint32_t)(lo - (uint32_t)prev);
+}
+
+static inline uint64_t iq_wait_now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * Doorbell coalescing : host_produced_size / host_consumed_size are uncached BAR2 writes, competing on PCIe
+ * with data DMA. Once doorbell_min_size is set, local counters move on each chunk but modem is only told
+ * when doorbell_min_size bytes are pending, doorbell_max_ns elapsed since last write, or when modem is
+ * close to starve (tx backlog / rx room below doorbell_min_size). Fifo full (tx) / empty (rx) always rings.
+ */
+static inline bool iq_doorbell_due(iq_player_t *p, uint64_t pending, uint64_t margin, uint64_t last_ns) {
+    if (pending >= p->doorbell_min_size || margin < p->doorbell_min_size)
+        return true;
+    return p->doorbell_max_ns && iq_wait_now_ns() - last_ns >= p->doorbell_max_ns;
+}
+
+static void iq_tx_doorbell(iq_tx_stream_t *s, bool force) {
+    iq_player_t *p = s->player;
+    uint64_t pending = s->total_produced_size - s->published_size;
+
+    if (pending == 0)
+        return;
+    if (!force && !iq_doorbell_due(p, pending, s->published_size - s->total_consumed_size, s->doorbell_ns))
+        return;
+
+    p->tx_vspa_proxy_wo->host_produced_size_hi = s->total_produced_size >> 32;
+    p->tx_vspa_proxy_wo->host_produced_size = (uint32_t)s->total_produced_size;
+    s->published_size = s->total_produced_size;
+    s->doorbells++;
+    if (p->doorbell_max_ns)
+        s->doorbell_ns = iq_wait_now_ns();
+}
+
+static void iq_rx_doorbell(iq_rx_stream_t *s, bool force) {
+    iq_player_t *p = s->player;
+    uint32_t chan = s->chan;
+    uint64_t pending = s->total_consumed_size - s->published_size;
+
+    if (pending == 0)
+        return;
+    if (!force && !iq_doorbell_due(p, pending, s->fifo_size - (s->total_produced_size - s->published_size), s->doorbell_ns))
+        return;
+
+    p->tx_vspa_proxy_wo->host_consumed_size_hi[chan] = s->total_consumed_size >> 32;
+    p->tx_vspa_proxy_wo->host_consumed_size[chan] = (uint32_t)s->total_consumed_size;
+    s->published_size = s->total_consumed_size;
+    s->doorbells++;
+    if (p->doorbell_max_ns)
+        s->doorbell_ns = iq_wait_now_ns();
+}
+
+static int iq_player_setup(iq_player_t *p, uint32_t *v_iqflood, uint32_t iqflood_size, uint32_t *v_la9310_pci_bar2) {
+    uint32_t chan;
+
+    p->v_iqflood_ddr_addr = v_iqflood;
 
     /* use last 256 bytes of iqflood as shared vspa dmem proxy , vspa will write mirrored dmem value to avoid PCI read from host */
-    v_vspa_dmem_proxy_ro = (uint32_t *)(v_iqflood_ddr_addr + (iqflood_size - VSPA_DMEM_PROXY_SIZE) / 4);
-    rx_vspa_proxy_ro = &(((t_vspa_dmem_proxy *)v_vspa_dmem_proxy_ro)->rx_state_readonly[0]);
-    tx_vspa_proxy_ro = &(((t_vspa_dmem_proxy *)v_vspa_dmem_proxy_ro)->tx_state_readonly);
-    app_stats = &(((t_vspa_dmem_proxy *)v_vspa_dmem_proxy_ro)->app_stats);
-    BAR2_addr = v_la9310_pci_bar2;
+    p->vspa_dmem_proxy_ro = (t_vspa_dmem_proxy *)(v_iqflood + (iqflood_size - VSPA_DMEM_PROXY_SIZE) / 4);
+    p->rx_vspa_proxy_ro = &(p->vspa_dmem_proxy_ro->rx_state_readonly[0]);
+    p->tx_vspa_proxy_ro = &(p->vspa_dmem_proxy_ro->tx_state_readonly);
+    p->app_stats = &(p->vspa_dmem_proxy_ro->app_stats);
+    p->BAR2_addr = v_la9310_pci_bar2;
 
     /* use dmem structure at hardcoded address to write host status/request */
-    dccivac((uint32_t *)tx_vspa_proxy_ro);
-    if (tx_vspa_proxy_ro->rx_num_chan == 1) {
-        v_tx_vspa_proxy_wo = (uint32_t *)((uint64_t)BAR2_addr + 0x400000 + 0x00000000);
-        v_rx_vspa_proxy_wo = (uint32_t *)((uint64_t)BAR2_addr + 0x400000 + 0x00000040);
-
+    dccivac((uint32_t *)p->tx_vspa_proxy_ro);
+    if (p->tx_vspa_proxy_ro->rx_num_chan == 1) {
+        p->tx_vspa_proxy_wo = (t_tx_ch_host_proxy *)((uint64_t)p->BAR2_addr + 0x400000 + 0x00000000);
     } else {
-        v_tx_vspa_proxy_wo = (uint32_t *)((uint64_t)BAR2_addr + 0x500000 + 0x00004000);
-        v_rx_vspa_proxy_wo = (uint32_t *)((uint64_t)BAR2_addr + 0x500000 + 0x00004040);
+        p->tx_vspa_proxy_wo = (t_tx_ch_host_proxy *)((uint64_t)p->BAR2_addr + 0x500000 + 0x00004000);
+    }
+
+    p->rx_event_fd = -1;
+    p->tx.player = p;
+    for (chan = 0; chan < RX_NUM_MAX_CHAN; chan++) {
+        p->rx[chan].player = p;
+        p->rx[chan].chan = chan;
+    }
+
+    if (p->tx_vspa_proxy_ro->proxy_version != VSPA_DMEM_PROXY_VERSION) {
+        printf("\n iq_player : vspa proxy version %d, expected %d\n", p->tx_vspa_proxy_ro->proxy_version,
+               VSPA_DMEM_PROXY_VERSION);
+        fflush(stdout);
+        return 0;
     }
 
     return 1;
 }
 
-uint32_t app_TX_total_produced_size = 0; /* Bytes copied into modem tx Fifo */
-uint32_t app_TX_total_consumed_size = 0; /* Bytes sent out of modem tx Fifo */
-uint32_t tx_modem_ddr_fifo_start;
-uint32_t tx_modem_ddr_fifo_size;
-uint32_t tx_modem_fifo_offset;
+iq_player_t *iq_player_open(uint32_t *v_iqflood, uint32_t iqflood_size, uint32_t *v_la9310_pci_bar2) {
+    iq_player_t *p;
 
-int iq_player_init_tx(uint32_t fifo_start, uint32_t fifo_size) {
-    (void)VSPA_stat_gbl_string; /* unused variables  */
-    (void)VSPA_stat_tx_string;
-    (void)VSPA_stat_rx_string;
+    if (v_iqflood == NULL || v_la9310_pci_bar2 == NULL || iqflood_size < VSPA_DMEM_PROXY_SIZE)
+        return NULL;
+
+    if (posix_memalign((void **)&p, CACHE_LINE_SIZE, sizeof(iq_player_t)))
+        return NULL;
+    memset(p, 0, sizeof(iq_player_t));
+
+    if (!iq_player_setup(p, v_iqflood, iqflood_size, v_la9310_pci_bar2)) {
+        free(p);
+        return NULL;
+    }
+    p->allocated = true;
+
+    return p;
+}
 
-    if (v_iqflood_ddr_addr == NULL)
+void iq_player_close(iq_player_t *p) {
+    if (p == NULL)
+        return;
+    if (p->rx_event_fd >= 0)
+        close(p->rx_event_fd);
+    p->rx_event_fd = -1;
+    if (p->allocated)
+        free(p);
+}
+
+/* rx channels configured in modem firmware */
+uint32_t iq_player_rx_num_chan(iq_player_t *p) {
+    dccivac((uint32_t *)(p->tx_vspa_proxy_ro));
+    return RX_NUM_CHAN(p);
+}
+
+iq_tx_stream_t *iq_player_tx_stream(iq_player_t *p) {
+    return &p->tx;
+}
+
+iq_rx_stream_t *iq_player_rx_stream(iq_player_t *p, uint32_t chan) {
+    if (chan >= RX_NUM_MAX_CHAN)
+        return NULL;
+    return &p->rx[chan];
+}
+
+int iq_tx_init(iq_tx_stream_t *s, uint32_t fifo_start, uint32_t fifo_size) {
+    iq_player_t *p = s->player;
+    uint64_t enqueued_size;
+
+    if (p->v_iqflood_ddr_addr == NULL)
         return 0;
 
-    dccivac((uint32_t *)(tx_vspa_proxy_ro));
+    dccivac((uint32_t *)(p->tx_vspa_proxy_ro));
 
     /* check firmware is idle waiting for new data */
     // if (tx_vspa_proxy_ro->host_produced_size != tx_vspa_proxy_ro->la9310_fifo_enqueued_size) {
@@ -93,159 +272,986 @@ int iq_player_init_tx(uint32_t fifo_start, uint32_t fifo_size) {
     //	return 0;
     //}
 
-    // init fifo pointers
-    tx_modem_ddr_fifo_start = fifo_start;
-    tx_modem_ddr_fifo_size = fifo_size;
-    tx_modem_fifo_offset = tx_vspa_proxy_ro->la9310_fifo_enqueued_size % fifo_size;
-    ((t_tx_ch_host_proxy *)v_tx_vspa_proxy_wo)->host_produced_size = tx_vspa_proxy_ro->la9310_fifo_enqueued_size;
+    // init fifo pointers, 64-bit count keeps offset right across 32-bit wrap for any fifo size
+    enqueued_size = iq_proxy_cnt_read(p->tx_vspa_proxy_ro->la9310_fifo_enqueued_size,
+                                      p->tx_vspa_proxy_ro->la9310_fifo_enqueued_size_hi);
+    s->cmp_width = p->tx_vspa_proxy_ro->tx_cmp_mode;
+    s->cmp_chunk_size = 0;
+    if (s->cmp_width) {
+        // compressed fifo : same layout as rx, counters in cs16 bytes, whole chunks only in DDR
+        if (s->cmp_width < IQ_BFP_WIDTH_MIN || s->cmp_width > IQ_BFP_WIDTH_MAX)
+            return -1;
+        s->cmp_chunk_size = IQ_BFP_CHUNK_SIZE(TX_DDR_STEP(p), s->cmp_width);
+        fifo_size = fifo_size / s->cmp_chunk_size * TX_DDR_STEP(p);
+    }
+    s->fifo_start = fifo_start;
+    s->fifo_size = fifo_size;
+    s->fifo_offset = enqueued_size % fifo_size;
+    s->acquired_size = 0;
+    s->lost_pending = false;
+    p->tx_vspa_proxy_wo->host_produced_size_hi = enqueued_size >> 32;
+    p->tx_vspa_proxy_wo->host_produced_size = (uint32_t)enqueued_size;
+    s->published_size = enqueued_size;
+    s->doorbells = 0;
+    s->chunks = 0;
 
     // init flow control
-    app_TX_total_consumed_size = tx_vspa_proxy_ro->la9310_fifo_enqueued_size;
-    app_TX_total_produced_size = tx_vspa_proxy_ro->la9310_fifo_enqueued_size;
+    s->total_consumed_size = enqueued_size;
+    s->total_produced_size = enqueued_size;
 
     return 1;
 }
 
-int iq_player_send_data(uint32_t *v_buffer, uint32_t size) {
-    uint32_t fifoWaterMark = 0;
-    uint32_t busy_size = 0;
+/*
+ * Zero-copy TX : iq_tx_acquire() returns a writable window located directly in the
+ * IQFLOOD tx fifo, application fills it in place then publishes it with iq_tx_commit().
+ * Window never crosses the fifo wrap, so it is at most (fifo_size - fifo_offset) bytes long.
+ */
+static int iq_tx_space(iq_tx_stream_t *s, uint32_t *len) {
+    iq_player_t *p = s->player;
+    uint64_t busy_size = 0;
     uint32_t empty_size = 0;
-    void *ddr_dst;
 
-    dccivac((uint32_t *)(tx_vspa_proxy_ro));
+    s->acquired_size = 0;
+    *len = 0;
+
+    dccivac((uint32_t *)(p->tx_vspa_proxy_ro));
 
     // check stop/restart
-    if (tx_vspa_proxy_ro->DDR_rd_base_address == 0xdeadbeef) {
-        tx_modem_fifo_offset = 0;
-        app_TX_total_consumed_size = 0;
-        app_TX_total_produced_size = 0;
-        ((t_tx_ch_host_proxy *)v_tx_vspa_proxy_wo)->host_produced_size = 0;
+    if (p->tx_vspa_proxy_ro->DDR_rd_base_address == 0xdeadbeef) {
+        s->fifo_offset = 0;
+        s->total_consumed_size = 0;
+        s->total_produced_size = 0;
+        s->published_size = 0;
+        p->tx_vspa_proxy_wo->host_produced_size_hi = 0;
+        p->tx_vspa_proxy_wo->host_produced_size = 0;
         return 0;
     }
 
     // Check new transfer opty
-    app_TX_total_consumed_size = tx_vspa_proxy_ro->la9310_fifo_enqueued_size;
-    busy_size = app_TX_total_produced_size - app_TX_total_consumed_size;
-    if (busy_size > tx_modem_ddr_fifo_size) {
-        printf("\n TX underrun , exit (busy=0x%08x app_TX_total_produced_size=0x%08x app_TX_total_consumed_size=0x%08x)\n",
-               busy_size, app_TX_total_produced_size, app_TX_total_consumed_size);
-        fflush(stdout);
-        exit(0);
+    s->total_consumed_size = iq_proxy_cnt_extend(s->total_consumed_size, p->tx_vspa_proxy_ro->la9310_fifo_enqueued_size);
+    busy_size = s->total_produced_size - s->total_consumed_size;
+    if (busy_size > s->fifo_size) {
+        // underrun : modem went past host data, restart filling from modem read position
+        s->lost_size = (uint32_t)(s->total_consumed_size - s->total_produced_size);
+        l1_trace(L1_TRACE_MSG_DMA_DDR_RD_UNDERRUN, s->lost_size);
+        p->app_stats->tx_stats[ERROR_EXT_DMA_DDR_RD_UNDERRUN] += s->lost_size / 4;
+        s->total_produced_size = s->total_consumed_size;
+        s->fifo_offset = s->total_consumed_size % s->fifo_size;
+        s->published_size = s->total_produced_size;
+        p->tx_vspa_proxy_wo->host_produced_size_hi = s->total_produced_size >> 32;
+        p->tx_vspa_proxy_wo->host_produced_size = (uint32_t)s->total_produced_size;
+        return -EPIPE;
     }
-    fifoWaterMark = tx_modem_ddr_fifo_size - tx_modem_fifo_offset;
-    empty_size = tx_modem_ddr_fifo_size - busy_size;
-    if (empty_size >= TX_DDR_STEP) {
-        if (empty_size > fifoWaterMark) {
-            empty_size = fifoWaterMark;
-        }
-        if (empty_size > size) {
-            empty_size = size;
-        }
-        // ready to send new data
-        app_TX_total_produced_size += empty_size;
-        app_stats->tx_stats[STAT_EXT_DMA_DDR_RD] += empty_size / TX_DDR_STEP;
-    } else {
-        // no room in tx fifo
+    empty_size = s->fifo_size - busy_size;
+    if (empty_size < TX_DDR_STEP(p)) {
+        // no room in tx fifo, make sure modem sees all of it
+        iq_tx_doorbell(s, true);
         return 0;
     }
 
-    // xfer data
-    ddr_dst = (void *)((uint64_t)v_iqflood_ddr_addr + tx_modem_ddr_fifo_start + tx_modem_fifo_offset);
-    l1_trace(L1_TRACE_MSG_DMA_DDR_RD_START, tx_modem_ddr_fifo_start + tx_modem_fifo_offset);
-    memcpy(ddr_dst, v_buffer, empty_size);
-    flush_region(ddr_dst, empty_size);
-    l1_trace(L1_TRACE_MSG_DMA_DDR_RD_COMP, empty_size);
+    *len = empty_size;
+    return empty_size;
+}
 
-    // update modem flow control
-    ((t_tx_ch_host_proxy *)v_tx_vspa_proxy_wo)->host_produced_size = app_TX_total_produced_size;
+int iq_tx_acquire(iq_tx_stream_t *s, void **ptr, uint32_t *len) {
+    iq_player_t *p = s->player;
+    uint32_t fifoWaterMark = 0;
+    uint32_t empty_size = 0;
+    int ret;
+
+    *ptr = NULL;
+    *len = 0;
 
-    tx_modem_fifo_offset += empty_size;
-    if (tx_modem_fifo_offset >= tx_modem_ddr_fifo_size) {
-        tx_modem_fifo_offset = 0;
+    // compressed fifo content is not cs16, no zero-copy
+    if (s->cmp_width)
+        return -EOPNOTSUPP;
+
+    ret = iq_tx_space(s, &empty_size);
+    if (ret <= 0)
+        return ret;
+
+    fifoWaterMark = s->fifo_size - s->fifo_offset;
+    if (empty_size > fifoWaterMark) {
+        empty_size = fifoWaterMark;
     }
 
+    s->acquired_size = empty_size;
+    *ptr = (void *)((uint64_t)p->v_iqflood_ddr_addr + s->fifo_start + s->fifo_offset);
+    *len = empty_size;
+
     return empty_size;
 }
 
-uint32_t rx_modem_ddr_fifo_start[RX_NUM_MAX_CHAN] = { 0, 0, 0, 0 };
-uint32_t rx_modem_ddr_fifo_size[RX_NUM_MAX_CHAN] = { 0, 0, 0, 0 };
-uint32_t rx_modem_fifo_offset[RX_NUM_MAX_CHAN] = { 0, 0, 0, 0 };
-uint32_t app_RX_total_consumed_size[RX_NUM_MAX_CHAN] = { 0, 0, 0, 0 }; /* Bytes copied from modem rx Fifo */
-uint32_t app_RX_total_produced_size[RX_NUM_MAX_CHAN] = { 0, 0, 0, 0 }; /* Bytes received in modem rx Fifo */
+static int iq_tx_publish(iq_tx_stream_t *s, uint32_t len, bool flush) {
+    iq_player_t *p = s->player;
+    void *ddr_dst;
 
-int iq_player_init_rx(uint32_t chan, uint32_t fifo_start, uint32_t fifo_size) {
-    if (v_iqflood_ddr_addr == NULL)
+    if (len > s->acquired_size) {
+        len = s->acquired_size;
+    }
+    s->acquired_size = 0;
+    if (len == 0)
+        return 0;
+
+    // push data out of cache, unless already done while copying
+    if (flush) {
+        ddr_dst = (void *)((uint64_t)p->v_iqflood_ddr_addr + s->fifo_start + s->fifo_offset);
+        flush_region(ddr_dst, len);
+    }
+    l1_trace(L1_TRACE_MSG_DMA_DDR_RD_COMP, len);
+
+    // update modem flow control
+    s->total_produced_size += len;
+    s->chunks++;
+    p->app_stats->tx_stats[STAT_EXT_DMA_DDR_RD] += len / TX_DDR_STEP(p);
+    iq_tx_doorbell(s, false);
+
+    s->fifo_offset += len;
+    if (s->fifo_offset >= s->fifo_size) {
+        s->fifo_offset -= s->fifo_size;
+    }
+
+    return len;
+}
+
+int iq_tx_commit(iq_tx_stream_t *s, uint32_t len) {
+    return iq_tx_publish(s, len, true);
+}
+
+/*
+ * BFP compressed tx (modem tx_cmp_mode set) : user data is compressed TX_DDR_STEP bytes at a time straight
+ * into DDR fifo, chunk n at n * cmp_chunk_size. Only whole chunks are sent, a shorter tail is left to caller.
+ */
+static int iq_tx_send_bfp(iq_tx_stream_t *s, uint32_t *v_buffer, uint32_t size) {
+    iq_player_t *p = s->player;
+    uint32_t step = TX_DDR_STEP(p);
+    uint32_t empty_size = 0, done, offset;
+    uint8_t *chunk;
+    int ret;
+
+    ret = iq_tx_space(s, &empty_size);
+    if (ret <= 0)
+        return ret;
+    if (empty_size > size)
+        empty_size = size;
+
+    l1_trace(L1_TRACE_MSG_DMA_DDR_RD_START, s->fifo_start + s->fifo_offset);
+    for (done = 0; done + step <= empty_size; done += step) {
+        offset = s->fifo_offset + done;
+        if (offset >= s->fifo_size)
+            offset -= s->fifo_size;
+        chunk = (uint8_t *)p->v_iqflood_ddr_addr + s->fifo_start + offset / step * s->cmp_chunk_size;
+        iq_convert_cs16_to_bfp(chunk, (const int16_t *)((uint8_t *)v_buffer + done), step, s->cmp_width);
+        flush_region(chunk, s->cmp_chunk_size);
+    }
+
+    s->acquired_size = done;
+    return iq_tx_publish(s, done, false);
+}
+
+int iq_tx_send(iq_tx_stream_t *s, uint32_t *v_buffer, uint32_t size) {
+    uint32_t empty_size = 0;
+    void *ddr_dst;
+    int ret;
+
+    if (s->cmp_width)
+        return iq_tx_send_bfp(s, v_buffer, size);
+
+    ret = iq_tx_acquire(s, &ddr_dst, &empty_size);
+    if (ret <= 0)
+        return ret;
+    if (empty_size > size) {
+        empty_size = size;
+    }
+
+    // xfer data, cache lines cleaned on the fly
+    l1_trace(L1_TRACE_MSG_DMA_DDR_RD_START, s->fifo_start + s->fifo_offset);
+    copy_flush_region(ddr_dst, v_buffer, empty_size);
+
+    return iq_tx_publish(s, empty_size, false);
+}
+
+/*
+ * Scatter/gather TX : fill fifo from several user buffers, across fifo wrap, with a single proxy read
+ * and a single host_produced_size update. Returns bytes sent, 0 or -EPIPE.
+ */
+int iq_tx_sendv(iq_tx_stream_t *s, const struct iovec *iov, int iovcnt) {
+    iq_player_t *p = s->player;
+    uint8_t *fifo = (uint8_t *)p->v_iqflood_ddr_addr + s->fifo_start;
+    uint32_t empty_size = 0, done = 0, offset, len;
+    const uint8_t *src;
+    size_t left;
+    int ret, i;
+
+    if (s->cmp_width)
+        return -EOPNOTSUPP;
+
+    ret = iq_tx_space(s, &empty_size);
+    if (ret <= 0)
+        return ret;
+
+    l1_trace(L1_TRACE_MSG_DMA_DDR_RD_START, s->fifo_start + s->fifo_offset);
+    offset = s->fifo_offset;
+    for (i = 0; i < iovcnt && done < empty_size; i++) {
+        src = iov[i].iov_base;
+        left = iov[i].iov_len;
+        while (left && done < empty_size) {
+            len = empty_size - done;
+            if (len > s->fifo_size - offset)
+                len = s->fifo_size - offset;
+            if (len > left)
+                len = left;
+            copy_flush_region(fifo + offset, src, len);
+            src += len;
+            left -= len;
+            done += len;
+            offset += len;
+            if (offset >= s->fifo_size)
+                offset = 0;
+        }
+    }
+
+    s->acquired_size = done;
+    return iq_tx_publish(s, done, false);
+}
+
+/*
+ * Converting variants : fifo is filled / drained IQ_CONVERT_CHUNK bytes at a time, each chunk is
+ * converted then cleaned (tx) or invalidated then converted (rx) while still hot in cache.
+ * Sizes are in samples, return is samples moved, 0 or -EPIPE.
+ */
+#define IQ_CONVERT_CHUNK (16 * CACHE_LINE_SIZE)
+
+int iq_tx_send_fmt(iq_tx_stream_t *s, const void *v_buffer, uint32_t nb_samples, uint32_t fmt, float scale) {
+    uint32_t sample_size = iq_convert_sample_size(fmt);
+    uint32_t empty_size = 0, done, len;
+    uint8_t *ddr_dst;
+    int ret;
+
+    if (fmt >= IQ_FMT_MAX)
+        return -EINVAL;
+    if (s->cmp_width)
+        return -EOPNOTSUPP;
+
+    ret = iq_tx_acquire(s, (void **)&ddr_dst, &empty_size);
+    if (ret <= 0)
+        return ret;
+    empty_size &= ~3;
+    // a call never moves more than one fifo, bound sample count before converting it to bytes
+    if (nb_samples > s->fifo_size / 4)
+        nb_samples = s->fifo_size / 4;
+    if (empty_size > nb_samples * 4) {
+        empty_size = nb_samples * 4;
+    }
+
+    l1_trace(L1_TRACE_MSG_DMA_DDR_RD_START, s->fifo_start + s->fifo_offset);
+    for (done = 0; done < empty_size; done += len) {
+        len = empty_size - done;
+        if (len > IQ_CONVERT_CHUNK)
+            len = IQ_CONVERT_CHUNK;
+        iq_convert_to_cs16((int16_t *)(ddr_dst + done), (const uint8_t *)v_buffer + done / 4 * sample_size, len / 2, fmt,
+                           scale);
+        flush_region(ddr_dst + done, len);
+    }
+
+    ret = iq_tx_publish(s, empty_size, false);
+    return ret < 0 ? ret : ret / 4;
+}
+
+int iq_rx_init(iq_rx_stream_t *s, uint32_t fifo_start, uint32_t fifo_size) {
+    iq_player_t *p = s->player;
+    uint32_t chan = s->chan;
+    uint64_t consumed_size;
+
+    if (p->v_iqflood_ddr_addr == NULL)
         return -1;
 
-    dccivac((uint32_t *)(rx_vspa_proxy_ro));
+    dccivac((uint32_t *)(p->rx_vspa_proxy_ro));
 
-    // init fifo pointers
-    rx_modem_ddr_fifo_start[chan] = fifo_start;
-    rx_modem_ddr_fifo_size[chan] = fifo_size;
-    rx_modem_fifo_offset[chan] = rx_vspa_proxy_ro[chan].la9310_fifo_consumed_size % fifo_size;
+    // init fifo pointers, 64-bit count keeps offset right across 32-bit wrap for any fifo size
+    consumed_size = iq_proxy_cnt_read(p->rx_vspa_proxy_ro[chan].la9310_fifo_consumed_size,
+                                      p->rx_vspa_proxy_ro[chan].la9310_fifo_consumed_size_hi);
+    s->cmp_width = p->rx_vspa_proxy_ro[chan].rx_cmp_mode;
+    s->cmp_chunk_size = 0;
+    if (s->cmp_width) {
+        // compressed fifo : flow counters and fifo size stay in cs16 bytes, DDR holds whole chunks only
+        if (s->cmp_width < IQ_BFP_WIDTH_MIN || s->cmp_width > IQ_BFP_WIDTH_MAX)
+            return -1;
+        s->cmp_chunk_size = IQ_BFP_CHUNK_SIZE(RX_DDR_STEP(p), s->cmp_width);
+        fifo_size = fifo_size / s->cmp_chunk_size * RX_DDR_STEP(p);
+    }
+    s->fifo_start = fifo_start;
+    s->fifo_size = fifo_size;
+    s->fifo_offset = consumed_size % fifo_size;
+    s->peeked_size = 0;
+    s->lost_pending = false;
 
     // init flow counters
-    app_RX_total_consumed_size[chan] = rx_vspa_proxy_ro[chan].la9310_fifo_consumed_size;
-    app_RX_total_produced_size[chan] = rx_vspa_proxy_ro[chan].la9310_fifo_consumed_size;
-    ((t_tx_ch_host_proxy *)v_tx_vspa_proxy_wo)->host_consumed_size[chan] = rx_vspa_proxy_ro[chan].la9310_fifo_consumed_size;
+    s->total_consumed_size = consumed_size;
+    s->total_produced_size = consumed_size;
+    p->tx_vspa_proxy_wo->host_consumed_size_hi[chan] = consumed_size >> 32;
+    p->tx_vspa_proxy_wo->host_consumed_size[chan] = (uint32_t)consumed_size;
+    s->published_size = consumed_size;
+    s->doorbells = 0;
+    s->chunks = 0;
 
     return 1;
 }
 
-int iq_player_receive_data(uint32_t chan, uint32_t *v_buffer, uint32_t max_size) {
+/*
+ * Zero-copy RX : iq_rx_peek() exposes all data ready in the IQFLOOD rx fifo as up to two
+ * contiguous segments (seg1 is the part wrapped at fifo start), cache is invalidated once for both.
+ * iq_rx_release() gives back the first len bytes to the modem.
+ */
+static int iq_rx_get(iq_rx_stream_t *s, void **seg0, uint32_t *len0, void **seg1, uint32_t *len1, bool invalidate) {
+    iq_player_t *p = s->player;
+    uint32_t chan = s->chan;
     uint32_t fifoWaterMark = 0;
-    uint32_t data_size = 0;
-    void *ddr_src;
+    uint64_t data_size = 0;
+
+    s->peeked_size = 0;
+    *seg0 = NULL;
+    *seg1 = NULL;
+    *len0 = 0;
+    *len1 = 0;
 
-    dccivac((uint32_t *)(rx_vspa_proxy_ro));
+    dccivac((uint32_t *)(p->rx_vspa_proxy_ro));
 
     // check stop/restart
-    if (rx_vspa_proxy_ro[chan].DDR_wr_base_address == 0xdeadbeef) {
-        app_RX_total_produced_size[chan] = 0;
-        app_RX_total_consumed_size[chan] = 0;
-        rx_modem_fifo_offset[chan] = 0;
-        ((t_tx_ch_host_proxy *)v_tx_vspa_proxy_wo)->host_consumed_size[chan] = 0;
+    if (p->rx_vspa_proxy_ro[chan].DDR_wr_base_address == 0xdeadbeef) {
+        s->total_produced_size = 0;
+        s->total_consumed_size = 0;
+        s->fifo_offset = 0;
+        s->published_size = 0;
+        p->tx_vspa_proxy_wo->host_consumed_size_hi[chan] = 0;
+        p->tx_vspa_proxy_wo->host_consumed_size[chan] = 0;
         return 0;
     }
 
     // Check new transfer
-    app_RX_total_produced_size[chan] = rx_vspa_proxy_ro[chan].la9310_fifo_consumed_size;
-    data_size = app_RX_total_produced_size[chan] - app_RX_total_consumed_size[chan];
-    if (data_size >= rx_modem_ddr_fifo_size[chan]) {
-        printf("\n RX underrun , exit (data_size=0x%08x app_RX_total_produced_size=0x%08x app_RX_total_consumed_size=0x%08x)\n",
-               data_size, app_RX_total_produced_size[chan], app_RX_total_consumed_size[chan]);
-        fflush(stdout);
-        exit(0);
-    }
-
-    fifoWaterMark = rx_modem_ddr_fifo_size[chan] - rx_modem_fifo_offset[chan];
-    if (data_size >= RX_DDR_STEP) {
-        if (data_size > fifoWaterMark)
-            data_size = fifoWaterMark;
-        if (data_size > max_size)
-            data_size = max_size;
-        // ready to fetch new data
-        app_RX_total_consumed_size[chan] += data_size;
-        app_stats->rx_stats[chan][STAT_EXT_DMA_DDR_WR] += data_size / RX_DDR_STEP;
-    } else {
-        // no data available
+    s->total_produced_size = iq_proxy_cnt_extend(s->total_produced_size, p->rx_vspa_proxy_ro[chan].la9310_fifo_consumed_size);
+    data_size = s->total_produced_size - s->total_consumed_size;
+    if (data_size > s->fifo_size) {
+        // overrun : modem wrote over oldest unread data. Drop only overwritten bytes, plus the oldest chunk left as
+        // modem writes next chunk over it, and keep the fifo_size - RX_DDR_STEP most recent bytes
+        s->lost_size = data_size - (s->fifo_size - RX_DDR_STEP(p));
+        l1_trace(L1_TRACE_MSG_DMA_DDR_WR_OVERRUN, s->lost_size);
+        p->app_stats->rx_stats[chan][ERROR_EXT_DMA_DDR_WR_OVERRUN] += s->lost_size / 4;
+        s->total_consumed_size += s->lost_size;
+        s->fifo_offset = s->total_consumed_size % s->fifo_size;
+        s->published_size = s->total_consumed_size;
+        p->tx_vspa_proxy_wo->host_consumed_size_hi[chan] = s->total_consumed_size >> 32;
+        p->tx_vspa_proxy_wo->host_consumed_size[chan] = (uint32_t)s->total_consumed_size;
+        return -EPIPE;
+    }
+    // modem writes whole RX_DDR_STEP chunks, the current one may already be partly read
+    if (data_size < RX_DDR_STEP(p) - s->total_consumed_size % RX_DDR_STEP(p)) {
+        // no data available, give all room back to modem
+        iq_rx_doorbell(s, true);
         return 0;
     }
 
-    // xfer data
-    ddr_src = (void *)((uint64_t)v_iqflood_ddr_addr + rx_modem_ddr_fifo_start[chan] + rx_modem_fifo_offset[chan]);
-    l1_trace(L1_TRACE_MSG_DMA_DDR_RD_START, rx_modem_ddr_fifo_start[chan] + rx_modem_fifo_offset[chan]);
-    invalidate_region(ddr_src, data_size);
-    memcpy(v_buffer, ddr_src, data_size);
-    l1_trace(L1_TRACE_MSG_DMA_DDR_RD_COMP, data_size);
+    fifoWaterMark = s->fifo_size - s->fifo_offset;
+    *seg0 = (void *)((uint64_t)p->v_iqflood_ddr_addr + s->fifo_start + s->fifo_offset);
+    if (data_size > fifoWaterMark) {
+        *len0 = fifoWaterMark;
+        *seg1 = (void *)((uint64_t)p->v_iqflood_ddr_addr + s->fifo_start);
+        *len1 = data_size - fifoWaterMark;
+    } else {
+        *len0 = data_size;
+    }
+
+    // drop stale lines before reading modem data, unless done while copying
+    l1_trace(L1_TRACE_MSG_DMA_DDR_RD_START, s->fifo_start + s->fifo_offset);
+    if (invalidate) {
+        invalidate_region(*seg0, *len0);
+        if (*len1)
+            invalidate_region(*seg1, *len1);
+    }
+
+    s->peeked_size = data_size;
+
+    return data_size;
+}
+
+int iq_rx_peek(iq_rx_stream_t *s, void **seg0, uint32_t *len0, void **seg1, uint32_t *len1) {
+    // compressed fifo content is not cs16, no zero-copy
+    if (s->cmp_width)
+        return -EOPNOTSUPP;
+    return iq_rx_get(s, seg0, len0, seg1, len1, true);
+}
+
+int iq_rx_release(iq_rx_stream_t *s, uint32_t len) {
+    iq_player_t *p = s->player;
+    uint32_t chan = s->chan;
+
+    if (len > s->peeked_size) {
+        len = s->peeked_size;
+    }
+    s->peeked_size = 0;
+    if (len == 0)
+        return 0;
+
+    l1_trace(L1_TRACE_MSG_DMA_DDR_RD_COMP, len);
 
     // update modem flow control
-    ((t_tx_ch_host_proxy *)v_tx_vspa_proxy_wo)->host_consumed_size[chan] = app_RX_total_consumed_size[chan];
+    s->total_consumed_size += len;
+    s->chunks++;
+    p->app_stats->rx_stats[chan][STAT_EXT_DMA_DDR_WR] += len / RX_DDR_STEP(p);
+    iq_rx_doorbell(s, false);
 
-    rx_modem_fifo_offset[chan] += data_size;
-    if (rx_modem_fifo_offset[chan] >= rx_modem_ddr_fifo_size[chan]) {
-        rx_modem_fifo_offset[chan] = 0;
+    s->fifo_offset += len;
+    if (s->fifo_offset >= s->fifo_size) {
+        s->fifo_offset -= s->fifo_size;
     }
 
-    return data_size;
+    return len;
+}
+
+/*
+ * BFP compressed rx (modem rx_cmp_mode set) : chunk n of RX_DDR_STEP cs16 bytes is at n * cmp_chunk_size
+ * in DDR fifo. Whole chunks are decompressed to user buffer, -ENOSPC when it can't hold one.
+ */
+static int iq_rx_receive_bfp(iq_rx_stream_t *s, uint32_t *v_buffer, uint32_t max_size) {
+    iq_player_t *p = s->player;
+    uint32_t step = RX_DDR_STEP(p);
+    uint32_t len0 = 0, len1 = 0, done, offset;
+    void *seg0, *seg1;
+    uint8_t *chunk;
+    int ret;
+
+    if (max_size < step)
+        return -ENOSPC;
+
+    ret = iq_rx_get(s, &seg0, &len0, &seg1, &len1, false);
+    if (ret <= 0)
+        return ret;
+    if ((uint32_t)ret > max_size)
+        ret = max_size;
+
+    for (done = 0; done + step <= (uint32_t)ret; done += step) {
+        offset = s->fifo_offset + done;
+        if (offset >= s->fifo_size)
+            offset -= s->fifo_size;
+        chunk = (uint8_t *)p->v_iqflood_ddr_addr + s->fifo_start + offset / step * s->cmp_chunk_size;
+        // chunks are 32B aligned, cover the line holding the tail
+        invalidate_region(chunk, s->cmp_chunk_size + CACHE_LINE_SIZE);
+        iq_convert_bfp_to_cs16((int16_t *)((uint8_t *)v_buffer + done), chunk, step, s->cmp_width);
+    }
+
+    return iq_rx_release(s, done);
+}
+
+int iq_rx_receive(iq_rx_stream_t *s, uint32_t *v_buffer, uint32_t max_size) {
+    uint32_t len0 = 0, len1 = 0;
+    void *seg0, *seg1;
+    int ret;
+
+    if (s->cmp_width)
+        return iq_rx_receive_bfp(s, v_buffer, max_size);
+
+    ret = iq_rx_get(s, &seg0, &len0, &seg1, &len1, false);
+    if (ret <= 0)
+        return ret;
+
+    // xfer data, across fifo wrap if needed, cache lines invalidated on the fly
+    if (len0 > max_size)
+        len0 = max_size;
+    invalidate_copy_region(v_buffer, seg0, len0);
+    if (len1 > max_size - len0)
+        len1 = max_size - len0;
+    if (len1)
+        invalidate_copy_region((uint8_t *)v_buffer + len0, seg1, len1);
+
+    return iq_rx_release(s, len0 + len1);
+}
+
+/*
+ * Scatter/gather RX : drain both fifo segments into several user buffers with a single proxy read
+ * and a single host_consumed_size update. Returns bytes received, 0 or -EPIPE.
+ */
+int iq_rx_recvv(iq_rx_stream_t *s, const struct iovec *iov, int iovcnt) {
+    uint32_t seg_len[2] = {0, 0};
+    uint8_t *seg[2];
+    uint32_t done = 0, k = 0, len;
+    uint8_t *dst;
+    size_t left;
+    int ret, i;
+
+    if (s->cmp_width)
+        return -EOPNOTSUPP;
+
+    ret = iq_rx_get(s, (void **)&seg[0], &seg_len[0], (void **)&seg[1], &seg_len[1], false);
+    if (ret <= 0)
+        return ret;
+
+    for (i = 0; i < iovcnt && k < 2; i++) {
+        dst = iov[i].iov_base;
+        left = iov[i].iov_len;
+        while (left && k < 2) {
+            len = seg_len[k];
+            if (len > left)
+                len = left;
+            invalidate_copy_region(dst, seg[k], len);
+            dst += len;
+            left -= len;
+            done += len;
+            seg[k] += len;
+            seg_len[k] -= len;
+            if (seg_len[k] == 0)
+                k++;
+        }
+    }
+
+    return iq_rx_release(s, done);
+}
+
+static void iq_rx_convert_seg(uint8_t *dst, const uint8_t *seg, uint32_t size, uint32_t fmt, float scale) {
+    uint32_t sample_size = iq_convert_sample_size(fmt);
+    uint32_t done, len;
+
+    for (done = 0; done < size; done += len) {
+        len = size - done;
+        if (len > IQ_CONVERT_CHUNK)
+            len = IQ_CONVERT_CHUNK;
+        invalidate_region((void *)(seg + done), len);
+        iq_convert_from_cs16(dst + done / 4 * sample_size, (const int16_t *)(seg + done), len / 2, fmt, scale);
+    }
+}
+
+int iq_rx_receive_fmt(iq_rx_stream_t *s, void *v_buffer, uint32_t max_samples, uint32_t fmt, float scale) {
+    uint32_t sample_size = iq_convert_sample_size(fmt);
+    uint32_t len0 = 0, len1 = 0, max_size;
+    void *seg0, *seg1;
+    int ret;
+
+    if (fmt >= IQ_FMT_MAX)
+        return -EINVAL;
+    if (s->cmp_width)
+        return -EOPNOTSUPP;
+    // a call never moves more than one fifo, bound sample count before converting it to bytes
+    if (max_samples > s->fifo_size / 4)
+        max_samples = s->fifo_size / 4;
+    max_size = max_samples * 4;
+
+    ret = iq_rx_get(s, &seg0, &len0, &seg1, &len1, false);
+    if (ret <= 0)
+        return ret;
+
+    // convert whole samples, across fifo wrap if needed
+    if (len0 > max_size)
+        len0 = max_size;
+    len0 &= ~3;
+    if (len1 > max_size - len0)
+        len1 = max_size - len0;
+    len1 &= ~3;
+    iq_rx_convert_seg(v_buffer, seg0, len0, fmt, scale);
+    if (len1)
+        iq_rx_convert_seg((uint8_t *)v_buffer + len0 / 4 * sample_size, seg1, len1, fmt, scale);
+
+    ret = iq_rx_release(s, len0 + len1);
+    return ret < 0 ? ret : ret / 4;
+}
+
+/* bytes lost on last -EPIPE, running totals (in samples) are kept in app_stats */
+uint32_t iq_tx_lost_size(iq_tx_stream_t *s) {
+    return s->lost_size;
+}
+
+/* send granularity : whole TX_DDR_STEP chunks on a compressed stream, one sample otherwise */
+uint32_t iq_tx_chunk_size(iq_tx_stream_t *s) {
+    return s->cmp_width ? TX_DDR_STEP(s->player) : 4;
+}
+
+uint32_t iq_rx_lost_size(iq_rx_stream_t *s) {
+    return s->lost_size;
+}
+
+/* receive granularity : whole RX_DDR_STEP chunks on a compressed stream, one sample otherwise */
+uint32_t iq_rx_chunk_size(iq_rx_stream_t *s) {
+    return s->cmp_width ? RX_DDR_STEP(s->player) : 4;
+}
+
+void iq_player_set_doorbell(iq_player_t *p, uint32_t min_size, uint32_t max_delay_us) {
+    p->doorbell_min_size = min_size;
+    p->doorbell_max_ns = (uint64_t)max_delay_us * 1000;
+}
+
+/* publish pending flow control, e.g. at end of stream */
+void iq_tx_flush(iq_tx_stream_t *s) {
+    iq_tx_doorbell(s, true);
+}
+
+void iq_rx_flush(iq_rx_stream_t *s) {
+    iq_rx_doorbell(s, true);
+}
+
+void iq_tx_doorbell_stats(iq_tx_stream_t *s, uint64_t *doorbells, uint64_t *chunks) {
+    *doorbells = s->doorbells;
+    *chunks = s->chunks;
+}
+
+void iq_rx_doorbell_stats(iq_rx_stream_t *s, uint64_t *doorbells, uint64_t *chunks) {
+    *doorbells = s->doorbells;
+    *chunks = s->chunks;
+}
+
+/*
+ * Blocking variants : poll fifo, and between polls spin, yield or sleep according to player wait policy.
+ * Sleep time is predicted from sample rate : rx fifo fills at sample_rate*4/rx_decim bytes/s per channel,
+ * tx fifo drains at sample_rate*4/tx_upsmp bytes/s. Adaptive policy sleeps until ~IQ_WAIT_SPIN_NS before
+ * predicted arrival, then spins, then yields, then falls back to short sleeps.
+ */
+#define IQ_WAIT_SPIN_NS 20000           /* busy poll window around predicted arrival */
+#define IQ_WAIT_YIELD_NS 200000         /* yield window once spin window elapsed */
+#define IQ_WAIT_MIN_SLEEP_NS 20000      /* shorter sleeps are dominated by timer slack */
+#define IQ_WAIT_DEFAULT_SLEEP_NS 100000 /* sample rate unknown */
+
+typedef struct {
+    uint64_t deadline;
+    uint64_t idle_start;
+    bool predicted;
+} iq_wait_ctx_t;
+
+static void iq_wait_start(iq_wait_ctx_t *w, uint64_t timeout_ns) {
+    w->idle_start = iq_wait_now_ns();
+    w->predicted = false;
+    if (timeout_ns > IQ_WAIT_FOREVER - w->idle_start)
+        w->deadline = IQ_WAIT_FOREVER;
+    else
+        w->deadline = w->idle_start + timeout_ns;
+}
+
+static void iq_wait_progress(iq_wait_ctx_t *w) {
+    w->idle_start = iq_wait_now_ns();
+    w->predicted = false;
+}
+
+static uint64_t iq_wait_predict_ns(uint32_t missing, uint64_t byte_rate) {
+    if (byte_rate == 0)
+        return IQ_WAIT_DEFAULT_SLEEP_NS;
+    return (uint64_t)missing * 1000000000ULL / byte_rate;
+}
+
+/* returns 0 once deadline is reached */
+static int iq_wait(iq_player_t *p, iq_wait_ctx_t *w, uint32_t missing, uint64_t byte_rate) {
+    struct timespec ts;
+    uint64_t now, sleep_ns;
+    bool predicted_sleep = false;
+
+    now = iq_wait_now_ns();
+    if (now >= w->deadline)
+        return 0;
+
+    switch (p->wait_policy) {
+    case IQ_WAIT_SPIN:
+        return 1;
+    case IQ_WAIT_YIELD:
+        sched_yield();
+        return 1;
+    case IQ_WAIT_SLEEP:
+        sleep_ns = iq_wait_predict_ns(missing, byte_rate);
+        if (sleep_ns < IQ_WAIT_MIN_SLEEP_NS)
+            sleep_ns = IQ_WAIT_MIN_SLEEP_NS;
+        break;
+    case IQ_WAIT_ADAPTIVE:
+    default:
+        if (!w->predicted) {
+            w->predicted = true;
+            sleep_ns = iq_wait_predict_ns(missing, byte_rate);
+            if (sleep_ns > IQ_WAIT_SPIN_NS + IQ_WAIT_MIN_SLEEP_NS) {
+                sleep_ns -= IQ_WAIT_SPIN_NS;
+                predicted_sleep = true;
+                break;
+            }
+        }
+        if (now - w->idle_start < IQ_WAIT_SPIN_NS)
+            return 1;
+        if (now - w->idle_start < IQ_WAIT_SPIN_NS + IQ_WAIT_YIELD_NS) {
+            sched_yield();
+            return 1;
+        }
+        sleep_ns = IQ_WAIT_MIN_SLEEP_NS;
+        break;
+    }
+
+    if (sleep_ns > w->deadline - now)
+        sleep_ns = w->deadline - now;
+    ts.tv_sec = sleep_ns / 1000000000ULL;
+    ts.tv_nsec = sleep_ns % 1000000000ULL;
+    nanosleep(&ts, NULL);
+
+    // spin/yield windows start after predicted sleep
+    if (predicted_sleep)
+        w->idle_start = iq_wait_now_ns();
+
+    return 1;
+}
+
+void iq_player_set_wait_policy(iq_player_t *p, uint32_t policy, uint32_t sample_rate) {
+    p->wait_policy = policy < IQ_WAIT_MAX ? policy : IQ_WAIT_ADAPTIVE;
+    p->sample_rate = sample_rate;
+}
+
+int iq_rx_receive_wait(iq_rx_stream_t *s, uint32_t *v_buffer, uint32_t min_size, uint32_t max_size, uint64_t timeout_ns) {
+    iq_player_t *p = s->player;
+    uint32_t received = 0, missing;
+    uint64_t byte_rate = 0;
+    iq_wait_ctx_t w;
+    int size;
+
+    // overrun hit after partial data on previous call
+    if (s->lost_pending) {
+        s->lost_pending = false;
+        return -EPIPE;
+    }
+
+    // compressed stream moves whole chunks, a partial one would never come
+    if (s->cmp_width) {
+        if (max_size < RX_DDR_STEP(p))
+            return -ENOSPC;
+        max_size -= max_size % RX_DDR_STEP(p);
+    }
+    if (min_size > max_size)
+        min_size = max_size;
+    if (min_size == 0)
+        min_size = 1;
+    if (p->sample_rate)
+        byte_rate = (uint64_t)p->sample_rate * 4 / (RX_DECIM(p) ? RX_DECIM(p) : 1);
+
+    iq_wait_start(&w, timeout_ns);
+    while (1) {
+        size = iq_rx_receive(s, (uint32_t *)((uint8_t *)v_buffer + received), max_size - received);
+        if (size < 0) {
+            // return data before the gap first
+            if (received == 0)
+                return size;
+            s->lost_pending = true;
+            break;
+        }
+        received += size;
+        if (received >= min_size)
+            break;
+        if (size)
+            iq_wait_progress(&w);
+
+        missing = min_size - received;
+        if (missing < RX_DDR_STEP(p))
+            missing = RX_DDR_STEP(p);
+        if (!iq_wait(p, &w, missing, byte_rate))
+            break;
+    }
+
+    return received;
+}
+
+int iq_tx_send_wait(iq_tx_stream_t *s, uint32_t *v_buffer, uint32_t size, uint64_t timeout_ns) {
+    iq_player_t *p = s->player;
+    uint32_t sent = 0;
+    uint64_t byte_rate = 0;
+    iq_wait_ctx_t w;
+    int len;
+
+    // compressed fifo only takes whole chunks, a tail would never fit
+    if (s->cmp_width && size % TX_DDR_STEP(p))
+        return -EINVAL;
+
+    // underrun hit after partial data on previous call
+    if (s->lost_pending) {
+        s->lost_pending = false;
+        return -EPIPE;
+    }
+
+    if (p->sample_rate)
+        byte_rate = (uint64_t)p->sample_rate * 4 / (TX_UPSMP(p) ? TX_UPSMP(p) : 1);
+
+    iq_wait_start(&w, timeout_ns);
+    while (sent < size) {
+        len = iq_tx_send(s, (uint32_t *)((uint8_t *)v_buffer + sent), size - sent);
+        if (len < 0) {
+            if (sent == 0)
+                return len;
+            s->lost_pending = true;
+            break;
+        }
+        sent += len;
+        if (sent >= size)
+            break;
+        if (len)
+            iq_wait_progress(&w);
+
+        // room is given back one TX_DDR_STEP at a time
+        if (!iq_wait(p, &w, TX_DDR_STEP(p), byte_rate))
+            break;
+    }
+
+    return sent;
+}
+
+/*
+ * RX event notification : firmware raises LA9310 MSI on rx progress (see MBOX_OPC_MSI config), exposed
+ * by uio device dev. With dev NULL an eventfd is used instead, signalled by iq_player_rx_event_notify()
+ * to simulate modem MSI. Returned fd is pollable, call iq_player_rx_event_ack() once readable, then
+ * drain rx streams.
+ */
+int iq_player_rx_event_open(iq_player_t *p, const char *dev) {
+    if (p->rx_event_fd >= 0)
+        return p->rx_event_fd;
+
+    if (dev) {
+        uint32_t irq_on = 1;
+
+        p->rx_event_fd = open(dev, O_RDWR | O_CLOEXEC | O_NONBLOCK);
+        if (p->rx_event_fd < 0)
+            return -1;
+        p->rx_event_uio = true;
+        // unmask interrupt
+        if (write(p->rx_event_fd, &irq_on, sizeof(irq_on)) != sizeof(irq_on)) {
+            close(p->rx_event_fd);
+            p->rx_event_fd = -1;
+            return -1;
+        }
+    } else {
+        p->rx_event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (p->rx_event_fd < 0)
+            return -1;
+        p->rx_event_uio = false;
+    }
+
+    return p->rx_event_fd;
+}
+
+int iq_player_rx_event_ack(iq_player_t *p) {
+    if (p->rx_event_fd < 0)
+        return -1;
+
+    if (p->rx_event_uio) {
+        uint32_t irq_count, irq_on = 1;
+
+        if (read(p->rx_event_fd, &irq_count, sizeof(irq_count)) != sizeof(irq_count))
+            return 0;
+        if (write(p->rx_event_fd, &irq_on, sizeof(irq_on)) != sizeof(irq_on))
+            return -1;
+        return 1;
+    } else {
+        uint64_t count;
+
+        if (read(p->rx_event_fd, &count, sizeof(count)) != sizeof(count))
+            return 0;
+        return count;
+    }
+}
+
+int iq_player_rx_event_notify(iq_player_t *p) {
+    uint64_t one = 1;
+
+    if (p->rx_event_fd < 0 || p->rx_event_uio)
+        return -1;
+    if (write(p->rx_event_fd, &one, sizeof(one)) != sizeof(one))
+        return -1;
+    return 1;
+}
+
+/*
+ * Legacy single modem api, routed to default instance
+ */
+int iq_player_init(uint32_t *v_iqflood, uint32_t iqflood_size, uint32_t *v_la9310_pci_bar2) {
+    return iq_player_setup(&iq_player_default, v_iqflood, iqflood_size, v_la9310_pci_bar2);
+}
+
+int iq_player_init_tx(uint32_t fifo_start, uint32_t fifo_size) {
+    return iq_tx_init(&iq_player_default.tx, fifo_start, fifo_size);
+}
+
+int iq_player_tx_acquire(void **ptr, uint32_t *len) {
+    return iq_tx_acquire(&iq_player_default.tx, ptr, len);
+}
+
+int iq_player_tx_commit(uint32_t len) {
+    return iq_tx_commit(&iq_player_default.tx, len);
+}
+
+int iq_player_send_data(uint32_t *v_buffer, uint32_t size) {
+    return iq_tx_send(&iq_player_default.tx, v_buffer, size);
+}
+
+int iq_player_sendv(const struct iovec *iov, int iovcnt) {
+    return iq_tx_sendv(&iq_player_default.tx, iov, iovcnt);
+}
+
+int iq_player_send_data_fmt(const void *v_buffer, uint32_t nb_samples, uint32_t fmt, float scale) {
+    return iq_tx_send_fmt(&iq_player_default.tx, v_buffer, nb_samples, fmt, scale);
+}
+
+int iq_player_init_rx(uint32_t chan, uint32_t fifo_start, uint32_t fifo_size) {
+    if (chan >= RX_NUM_MAX_CHAN)
+        return -1;
+    return iq_rx_init(&iq_player_default.rx[chan], fifo_start, fifo_size);
+}
+
+int iq_player_rx_peek(uint32_t chan, void **seg0, uint32_t *len0, void **seg1, uint32_t *len1) {
+    return iq_rx_peek(&iq_player_default.rx[chan], seg0, len0, seg1, len1);
+}
+
+int iq_player_rx_release(uint32_t chan, uint32_t len) {
+    return iq_rx_release(&iq_player_default.rx[chan], len);
+}
+
+int iq_player_receive_data(uint32_t chan, uint32_t *v_buffer, uint32_t max_size) {
+    return iq_rx_receive(&iq_player_default.rx[chan], v_buffer, max_size);
+}
+
+int iq_player_recvv(uint32_t chan, const struct iovec *iov, int iovcnt) {
+    return iq_rx_recvv(&iq_player_default.rx[chan], iov, iovcnt);
+}
+
+int iq_player_receive_data_fmt(uint32_t chan, void *v_buffer, uint32_t max_samples, uint32_t fmt, float scale) {
+    return iq_rx_receive_fmt(&iq_player_default.rx[chan], v_buffer, max_samples, fmt, scale);
+}
+
+int iq_player_init_doorbell(uint32_t min_size, uint32_t max_delay_us) {
+    iq_player_set_doorbell(&iq_player_default, min_size, max_delay_us);
+    return 1;
+}
+
+void iq_player_tx_flush(void) {
+    iq_tx_flush(&iq_player_default.tx);
+}
+
+void iq_player_rx_flush(uint32_t chan) {
+    iq_rx_flush(&iq_player_default.rx[chan]);
+}
+
+void iq_player_tx_doorbell_stats(uint64_t *doorbells, uint64_t *chunks) {
+    iq_tx_doorbell_stats(&iq_player_default.tx, doorbells, chunks);
+}
+
+void iq_player_rx_doorbell_stats(uint32_t chan, uint64_t *doorbells, uint64_t *chunks) {
+    iq_rx_doorbell_stats(&iq_player_default.rx[chan], doorbells, chunks);
+}
+
+int iq_player_init_wait(uint32_t policy, uint32_t sample_rate) {
+    iq_player_set_wait_policy(&iq_player_default, policy, sample_rate);
+    return 1;
+}
+
+int iq_player_send_wait(uint32_t *v_buffer, uint32_t size, uint64_t timeout_ns) {
+    return iq_tx_send_wait(&iq_player_default.tx, v_buffer, size, timeout_ns);
+}
+
+int iq_player_receive_wait(uint32_t chan, uint32_t *v_buffer, uint32_t min_size, uint32_t max_size, uint64_t timeout_ns) {
+    return iq_rx_receive_wait(&iq_player_default.rx[chan], v_buffer, min_size, max_size, timeout_ns);
+}
+
+uint32_t iq_player_tx_lost_size(void) {
+    return iq_tx_lost_size(&iq_player_default.tx);
+}
+
+uint32_t iq_player_rx_lost_size(uint32_t chan) {
+    return iq_rx_lost_size(&iq_player_default.rx[chan]);
+}
+
+iq_player_t *iq_player_get_default(void) {
+    return &iq_player_default;
 }
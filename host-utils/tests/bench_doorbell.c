@@ -0,0 +1,101 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "lib_iqplayer_api.h"
+#include "iq_fake_modem.h"
+
+/*
+ * Doorbell coalescing against chunk size : host streams TOTAL_SIZE through the software modem one chunk per call,
+ * modem moves half a fifo each time the host finds it full (tx) or empty (rx). Reports MB/s and BAR2 flow control
+ * writes per chunk, without coalescing and with DB_MIN_SIZE / DB_MAX_DELAY_US. BAR2 is heap here, on target each
+ * doorbell is an uncached PCIe write, so doorbells per chunk is the figure that carries over.
+ */
+#define TX_FIFO_START 0x0
+#define RX_FIFO_START 0x200000
+#define FIFO_SIZE (1024 * 1024)
+#define TOTAL_SIZE (256ULL * 1024 * 1024)
+#define DB_MIN_SIZE (64 * 1024)
+#define DB_MAX_DELAY_US 100
+
+static iq_fake_modem_t m;
+static uint8_t *user;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void bench(int rx, uint32_t chunk, int coalesce, double *mbps, double *db_per_chunk) {
+    uint64_t t0, moved = 0, doorbells, chunks;
+    iq_player_t *p;
+    int ret;
+
+    iq_fake_open(&m, 1);
+    iq_fake_tx_start(&m, TX_FIFO_START, FIFO_SIZE, 0);
+    iq_fake_rx_start(&m, 0, RX_FIFO_START, FIFO_SIZE, 0);
+    p = iq_player_open(m.iqflood, m.iqflood_size, m.bar2);
+    if (p == NULL || iq_tx_init(iq_player_tx_stream(p), TX_FIFO_START, FIFO_SIZE) != 1 ||
+        iq_rx_init(iq_player_rx_stream(p, 0), RX_FIFO_START, FIFO_SIZE) != 1)
+        exit(1);
+    if (coalesce)
+        iq_player_set_doorbell(p, DB_MIN_SIZE, DB_MAX_DELAY_US);
+
+    t0 = now_ns();
+    while (moved < TOTAL_SIZE) {
+        if (rx)
+            ret = iq_rx_receive(iq_player_rx_stream(p, 0), (uint32_t *)user, chunk);
+        else
+            ret = iq_tx_send(iq_player_tx_stream(p), (uint32_t *)user, chunk);
+        if (ret > 0) {
+            moved += ret;
+        } else if (rx) {
+            iq_fake_rx_write(&m, 0, user, FIFO_SIZE / 2, false);
+        } else {
+            iq_fake_tx_fetch(&m, NULL, FIFO_SIZE / 2, false);
+        }
+    }
+    t0 = now_ns() - t0;
+    if (rx)
+        iq_rx_doorbell_stats(iq_player_rx_stream(p, 0), &doorbells, &chunks);
+    else
+        iq_tx_doorbell_stats(iq_player_tx_stream(p), &doorbells, &chunks);
+    *mbps = (double)moved * 1000 / t0;
+    *db_per_chunk = (double)doorbells / chunks;
+    iq_player_close(p);
+    iq_fake_close(&m);
+}
+
+int main(void) {
+    static const uint32_t chunks[] = {2048, 4096, 8192, 16384, 65536, 262144};
+    double mbps[2], db[2];
+    uint32_t i;
+    int rx;
+
+    user = iq_mem_alloc(FIFO_SIZE);
+    if (user == NULL)
+        return 1;
+    memset(user, 0, FIFO_SIZE);
+
+    for (rx = 0; rx < 2; rx++) {
+        printf("%s, coalescing %u KB / %u us\n", rx ? "rx" : "tx", DB_MIN_SIZE / 1024, DB_MAX_DELAY_US);
+        for (i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++) {
+            bench(rx, chunks[i], 0, &mbps[0], &db[0]);
+            bench(rx, chunks[i], 1, &mbps[1], &db[1]);
+            printf("  chunk %6u  off %8.1f MB/s %5.3f doorbell/chunk  on %8.1f MB/s %5.3f doorbell/chunk\n", chunks[i],
+                   mbps[0], db[0], mbps[1], db[1]);
+        }
+    }
+    iq_mem_free(user, FIFO_SIZE);
+    return 0;
+}
@@ -0,0 +1,206 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <sched.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "lib_iqplayer_api.h"
+#include "iq_fake_modem.h"
+
+/*
+ * Feeder threads (iq_staging.c) end to end : latency is ring write to modem fetch of the last byte of a block (tx),
+ * and modem write to application ring read of it (rx), one block per BLK_PERIOD_NS (61.44 MSPS cs16). Percentiles
+ * over LAT_BLOCKS blocks. Throughput is TPUT_SIZE moved unpaced, application to modem (tx) and back (rx).
+ * Feeders and modem share the host cores with the application, numbers are host scheduler dependent : on target,
+ * pin feeders (cpu, SCHED_FIFO priority) and run the modem for real.
+ */
+#define TX_FIFO_START 0x0
+#define RX_FIFO_START 0x200000
+#define FIFO_SIZE (64 * IQ_FAKE_DDR_STEP)
+#define RING_SIZE (256 * 1024)
+#define BLK (4 * IQ_FAKE_DDR_STEP)
+#define BLK_PERIOD_NS 33333
+#define LAT_BLOCKS 20000
+#define TPUT_SIZE (256ULL * 1024 * 1024)
+
+static iq_fake_modem_t m;
+static iq_player_t *p;
+static iq_feeder_t *f;
+static volatile uint32_t running;
+static uint32_t nb_blocks; /* 0 : throughput run, no pacing */
+static uint64_t stamp_ns[LAT_BLOCKS];
+static uint32_t lat_ns[LAT_BLOCKS];
+static uint8_t blk[BLK];
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void pace(uint64_t t0, uint32_t i) {
+    uint64_t next = t0 + (uint64_t)(i + 1) * BLK_PERIOD_NS, now = now_ns();
+    struct timespec ts;
+
+    if (next > now) {
+        ts.tv_sec = 0;
+        ts.tv_nsec = next - now;
+        nanosleep(&ts, NULL);
+    }
+}
+
+/* blocks ending at or before pos reached their destination */
+static void record(uint64_t pos, uint32_t *done) {
+    uint64_t t = now_ns();
+
+    while (*done < nb_blocks && (uint64_t)(*done + 1) * BLK <= pos) {
+        lat_ns[*done] = t - __atomic_load_n(&stamp_ns[*done], __ATOMIC_ACQUIRE);
+        (*done)++;
+    }
+}
+
+static void *tx_modem_thread(void *arg) {
+    uint32_t done = 0;
+
+    (void)arg;
+    while (running) {
+        if (iq_fake_tx_fetch(&m, NULL, FIFO_SIZE, false))
+            record(m.tx_enqueued, &done);
+        else
+            sched_yield();
+    }
+    return NULL;
+}
+
+static void *rx_modem_thread(void *arg) {
+    uint64_t t0 = now_ns();
+    uint32_t i, len;
+
+    (void)arg;
+    for (i = 0; running && (nb_blocks == 0 || i < nb_blocks); i++) {
+        if (nb_blocks)
+            __atomic_store_n(&stamp_ns[i], now_ns(), __ATOMIC_RELEASE);
+        for (len = 0; running && len < BLK;) {
+            len += iq_fake_rx_write(&m, 0, blk, BLK - len, false);
+            if (len < BLK)
+                sched_yield();
+        }
+        if (nb_blocks)
+            pace(t0, i);
+    }
+    return NULL;
+}
+
+static void open_modem(int rx) {
+    iq_fake_open(&m, 1);
+    iq_fake_tx_start(&m, TX_FIFO_START, FIFO_SIZE, 0);
+    iq_fake_rx_start(&m, 0, RX_FIFO_START, FIFO_SIZE, 0);
+    p = iq_player_open(m.iqflood, m.iqflood_size, m.bar2);
+    if (p == NULL)
+        exit(1);
+    iq_player_set_wait_policy(p, IQ_WAIT_YIELD, 0);
+    iq_tx_init(iq_player_tx_stream(p), TX_FIFO_START, FIFO_SIZE);
+    iq_rx_init(iq_player_rx_stream(p, 0), RX_FIFO_START, FIFO_SIZE);
+    f = rx ? iq_rx_feeder_start(iq_player_rx_stream(p, 0), RING_SIZE, -1, 0)
+           : iq_tx_feeder_start(iq_player_tx_stream(p), RING_SIZE, -1, 0);
+    if (f == NULL)
+        exit(1);
+}
+
+static void close_modem(void) {
+    iq_feeder_stop(f);
+    iq_player_close(p);
+    iq_fake_close(&m);
+}
+
+/* application side : tx writes blocks to ring, rx reads ring until size */
+static void run(int rx, uint64_t size) {
+    uint8_t buf[BLK];
+    uint64_t t0 = now_ns(), pos = 0;
+    uint32_t i = 0, done = 0, len;
+    int ret;
+
+    while (pos < size) {
+        if (rx) {
+            ret = iq_feeder_read(f, buf, sizeof(buf));
+            pos += ret;
+            record(pos, &done);
+            if (ret == 0)
+                sched_yield();
+            continue;
+        }
+        if (nb_blocks)
+            __atomic_store_n(&stamp_ns[i], now_ns(), __ATOMIC_RELEASE);
+        for (len = 0; len < BLK;) {
+            len += iq_feeder_write(f, blk + len, BLK - len);
+            if (len < BLK)
+                sched_yield();
+        }
+        pos += BLK;
+        if (nb_blocks)
+            pace(t0, i);
+        i++;
+    }
+    // tx : wait for modem to fetch it all
+    while (!rx && m.tx_enqueued < size)
+        sched_yield();
+}
+
+static int cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static void bench(int rx) {
+    uint64_t t0, moved, lost, stalls;
+    pthread_t th;
+
+    // latency, paced
+    open_modem(rx);
+    nb_blocks = LAT_BLOCKS;
+    memset(lat_ns, 0, sizeof(lat_ns));
+    running = 1;
+    pthread_create(&th, NULL, rx ? rx_modem_thread : tx_modem_thread, NULL);
+    run(rx, (uint64_t)LAT_BLOCKS * BLK);
+    running = 0;
+    pthread_join(th, NULL);
+    iq_feeder_stats(f, &moved, &lost, &stalls);
+    close_modem();
+    qsort(lat_ns, LAT_BLOCKS, sizeof(lat_ns[0]), cmp_u32);
+    printf("%s latency  p50 %7.1f us  p99 %7.1f us  p99.9 %8.1f us  max %8.1f us  (%u blocks of %u B, %llu lost)\n",
+           rx ? "rx" : "tx", lat_ns[LAT_BLOCKS / 2] / 1000.0, lat_ns[LAT_BLOCKS * 99 / 100] / 1000.0,
+           lat_ns[LAT_BLOCKS * 999 / 1000] / 1000.0, lat_ns[LAT_BLOCKS - 1] / 1000.0, LAT_BLOCKS, BLK,
+           (unsigned long long)lost);
+
+    // throughput, unpaced
+    open_modem(rx);
+    nb_blocks = 0;
+    running = 1;
+    t0 = now_ns();
+    pthread_create(&th, NULL, rx ? rx_modem_thread : tx_modem_thread, NULL);
+    run(rx, TPUT_SIZE);
+    t0 = now_ns() - t0;
+    running = 0;
+    pthread_join(th, NULL);
+    iq_feeder_stats(f, &moved, &lost, &stalls);
+    close_modem();
+    printf("%s sustained %8.1f MB/s  (%llu MB, %llu ring stalls)\n", rx ? "rx" : "tx", (double)TPUT_SIZE * 1000 / t0,
+           (unsigned long long)(TPUT_SIZE >> 20), (unsigned long long)stalls);
+}
+
+int main(void) {
+    memset(blk, 0, sizeof(blk));
+    bench(0);
+    bench(1);
+    return 0;
+}
@@ -0,0 +1,77 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "lib_iqplayer_api.h"
+
+/*
+ * Stream buffer backing : chunks written to a 4KB page buffer (malloc, first touch during the copy as when a
+ * waveform is loaded) against iq_mem_alloc() (2MB pages, prefaulted and locked), then read back as the fifo
+ * copy does. Reports bandwidth and p99 / max latency of one chunk. Run with hugetlbfs pages reserved to measure the MAP_HUGETLB path.
+ */
+#define BUF_SIZE (64 * 1024 * 1024)
+#define CHUNK (64 * 1024)
+#define NB_CHUNK (BUF_SIZE / CHUNK)
+
+static uint8_t fifo[CHUNK] __attribute__((aligned(64)));
+static uint64_t lat[NB_CHUNK];
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static void bench(const char *name, uint8_t *buf, int load) {
+    uint64_t t0, t, total = 0;
+    uint32_t i;
+
+    for (i = 0; i < NB_CHUNK; i++) {
+        t0 = now_ns();
+        if (load)
+            memcpy(buf + (size_t)i * CHUNK, fifo, CHUNK);
+        else
+            memcpy(fifo, buf + (size_t)i * CHUNK, CHUNK);
+        __asm__ volatile("" ::: "memory");
+        t = now_ns();
+        lat[i] = t - t0;
+        total += lat[i];
+    }
+    qsort(lat, NB_CHUNK, sizeof(lat[0]), cmp_u64);
+    printf("%-12s %6.2f GB/s  p50 %6llu ns  p99 %6llu ns  max %7llu ns\n", name, (double)BUF_SIZE / total,
+           (unsigned long long)lat[NB_CHUNK / 2], (unsigned long long)lat[NB_CHUNK * 99 / 100],
+           (unsigned long long)lat[NB_CHUNK - 1]);
+}
+
+int main(void) {
+    uint8_t *small, *huge;
+
+    small = malloc(BUF_SIZE);
+    huge = iq_mem_alloc(BUF_SIZE);
+    if (small == NULL || huge == NULL)
+        return 1;
+    memset(fifo, 0x5a, CHUNK);
+    bench("4KB load", small, 1);
+    bench("iq_mem load", huge, 1);
+    // both resident : tlb reach only
+    bench("4KB read", small, 0);
+    bench("iq_mem read", huge, 0);
+    free(small);
+    iq_mem_free(huge, BUF_SIZE);
+    return 0;
+}
@@ -0,0 +1,140 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#include "lib_iqplayer_api.h"
+#include "iq_fake_modem.h"
+
+/*
+ * TX file playback as done by iq_app : whole file loaded with fread() before streaming, against mmap with
+ * MADV_SEQUENTIAL readahead and played pages dropped every 64MB (-m 1), and mmap with MAP_POPULATE (-m 2).
+ * Each mode plays the file once to a software modem in its own process, and reports time to first sample
+ * and peak RSS. Set IQ_BENCH_FILE to use an existing waveform (cold cache numbers need a page cache drop).
+ */
+#define FIFO_SIZE (256 * 1024)
+#define DEFAULT_FILE_SIZE (256ULL * 1024 * 1024)
+#define MMAP_RELEASE (64 * 1024 * 1024)
+
+enum { MODE_FREAD = 0, MODE_MMAP_SEQ, MODE_MMAP_POPULATE, MODE_MAX };
+static const char *mode_name[MODE_MAX] = {"fread", "mmap seq", "mmap populate"};
+
+static iq_fake_modem_t m;
+static volatile uint32_t running;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void *modem_thread(void *arg) {
+    (void)arg;
+    while (running)
+        iq_fake_tx_fetch(&m, NULL, FIFO_SIZE, false);
+    return NULL;
+}
+
+static void play(int mode, const char *path) {
+    uint64_t t0 = now_ns(), first_ns = 0, offset = 0, released = 0, size, len;
+    iq_tx_stream_t *s;
+    struct rusage ru;
+    struct stat st;
+    iq_player_t *p;
+    uint8_t *buf;
+    pthread_t th;
+    FILE *fp;
+    int fd, ret;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st))
+        exit(1);
+    size = st.st_size;
+    if (mode == MODE_FREAD) {
+        buf = iq_mem_alloc(size);
+        fp = fdopen(fd, "rb");
+        if (buf == NULL || fp == NULL || fread(buf, 1, size, fp) != size)
+            exit(1);
+    } else {
+        buf = mmap(NULL, size, PROT_READ, MAP_SHARED | (mode == MODE_MMAP_POPULATE ? MAP_POPULATE : 0), fd, 0);
+        if (buf == MAP_FAILED)
+            exit(1);
+        madvise(buf, size, MADV_SEQUENTIAL);
+    }
+
+    iq_fake_open(&m, 1);
+    iq_fake_tx_start(&m, 0, FIFO_SIZE, 0);
+    p = iq_player_open(m.iqflood, m.iqflood_size, m.bar2);
+    s = iq_player_tx_stream(p);
+    iq_tx_init(s, 0, FIFO_SIZE);
+    running = 1;
+    pthread_create(&th, NULL, modem_thread, NULL);
+
+    while (offset < size) {
+        len = size - offset < FIFO_SIZE ? size - offset : FIFO_SIZE;
+        ret = iq_tx_send_wait(s, (uint32_t *)(buf + offset), len, IQ_WAIT_FOREVER);
+        if (ret <= 0)
+            continue;
+        if (first_ns == 0)
+            first_ns = now_ns() - t0;
+        offset += ret;
+        if (mode == MODE_MMAP_SEQ && offset - released >= MMAP_RELEASE) {
+            len = (offset - released) & ~(uint64_t)(sysconf(_SC_PAGESIZE) - 1);
+            madvise(buf + released, len, MADV_DONTNEED);
+            released += len;
+        }
+    }
+    running = 0;
+    pthread_join(th, NULL);
+    getrusage(RUSAGE_SELF, &ru);
+    printf("%-14s first sample %8.2f ms  total %8.2f ms  peak rss %7ld MB\n", mode_name[mode], first_ns / 1e6,
+           (now_ns() - t0) / 1e6, ru.ru_maxrss / 1024);
+    exit(0);
+}
+
+int main(void) {
+    char tmp[] = "/tmp/iq_bench_txXXXXXX";
+    const char *path = getenv("IQ_BENCH_FILE");
+    static uint8_t chunk[1024 * 1024];
+    uint64_t done;
+    int mode, fd, status;
+
+    if (path == NULL) {
+        fd = mkstemp(tmp);
+        if (fd < 0)
+            return 1;
+        for (done = 0; done < DEFAULT_FILE_SIZE; done += sizeof(chunk)) {
+            iq_fake_pattern_fill(chunk, done, sizeof(chunk));
+            if (write(fd, chunk, sizeof(chunk)) != sizeof(chunk))
+                return 1;
+        }
+        close(fd);
+        path = tmp;
+    }
+    printf("waveform %s\n", path);
+    for (mode = 0; mode < MODE_MAX; mode++) {
+        fflush(stdout);
+        if (fork() == 0)
+            play(mode, path);
+        wait(&status);
+    }
+    if (path == tmp)
+        unlink(tmp);
+    return 0;
+}
@@ -0,0 +1,88 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "lib_iqplayer_api.h"
+#include "iq_fake_modem.h"
+
+/*
+ * TX host path throughput, MB/s : application samples built in a user buffer then copied by iq_player_send_data(),
+ * against the same samples built in place in the fifo window of iq_player_tx_acquire() / iq_player_tx_commit().
+ * The software modem drains the fifo after each call, so only host side cost is measured. Sample production is a
+ * copy from a waveform table, the same in both paths.
+ */
+#define FIFO_START 0
+#define FIFO_SIZE (256 * 1024)
+#define TOTAL_SIZE (256ULL * 1024 * 1024)
+
+static iq_fake_modem_t m;
+static uint8_t *wave, *user;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static double bench(int zero_copy, uint32_t chunk) {
+    uint64_t t0, sent = 0;
+    uint32_t len;
+    void *ptr;
+    int ret;
+
+    iq_fake_open(&m, 1);
+    iq_fake_tx_start(&m, FIFO_START, FIFO_SIZE, 0);
+    if (iq_player_init(m.iqflood, m.iqflood_size, m.bar2) != 1 || iq_player_init_tx(FIFO_START, FIFO_SIZE) != 1)
+        exit(1);
+
+    t0 = now_ns();
+    while (sent < TOTAL_SIZE) {
+        if (zero_copy) {
+            ret = iq_player_tx_acquire(&ptr, &len);
+            if (ret > 0) {
+                if (len > chunk)
+                    len = chunk;
+                memcpy(ptr, wave, len);
+                ret = iq_player_tx_commit(len);
+            }
+        } else {
+            memcpy(user, wave, chunk);
+            ret = iq_player_send_data((uint32_t *)user, chunk);
+        }
+        if (ret > 0)
+            sent += ret;
+        iq_fake_tx_fetch(&m, NULL, FIFO_SIZE, false);
+    }
+    t0 = now_ns() - t0;
+    iq_fake_close(&m);
+    return (double)sent * 1000 / t0;
+}
+
+int main(void) {
+    static const uint32_t chunks[] = {2048, 16384, 65536};
+    uint32_t i;
+
+    wave = iq_mem_alloc(FIFO_SIZE);
+    user = iq_mem_alloc(FIFO_SIZE);
+    if (wave == NULL || user == NULL)
+        return 1;
+    iq_fake_pattern_fill(wave, 0, FIFO_SIZE);
+    memset(user, 0, FIFO_SIZE);
+
+    for (i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++) {
+        printf("chunk %6u  send_data copy %8.1f MB/s  acquire/commit %8.1f MB/s\n", chunks[i], bench(0, chunks[i]),
+               bench(1, chunks[i]));
+    }
+    iq_mem_free(wave, FIFO_SIZE);
+    iq_mem_free(user, FIFO_SIZE);
+    return 0;
+}
@@ -0,0 +1,117 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "lib_iqplayer_api.h"
+#include "iq_fake_modem.h"
+
+/*
+ * Wait policy latency / cpu : modem thread writes one rx step per step period at sample_rate, receiver
+ * blocks in iq_rx_receive_wait(min = one step). Latency is chunk write to receive return, cpu is receiver
+ * thread cpu time over wall time. Numbers are host scheduler dependent, run on target cores to choose.
+ */
+#define RX_FIFO_START 0x100000
+#define FIFO_SIZE (16 * IQ_FAKE_DDR_STEP)
+#define STEP IQ_FAKE_DDR_STEP
+#define DURATION_NS 500000000ULL
+#define MAX_CHUNKS 65536
+
+static const char *policy_name[IQ_WAIT_MAX] = {"spin", "yield", "sleep", "adaptive"};
+static const uint32_t rates[] = {1920000, 7680000};
+
+static iq_fake_modem_t m;
+static volatile uint32_t running;
+static uint32_t sample_rate;
+static uint64_t write_ns[MAX_CHUNKS];
+
+static uint64_t clock_ns(clockid_t id) {
+    struct timespec ts;
+
+    clock_gettime(id, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void *modem_thread(void *arg) {
+    uint8_t buf[STEP];
+    uint64_t period = (uint64_t)STEP / 4 * 1000000000ULL / sample_rate;
+    uint64_t next = clock_ns(CLOCK_MONOTONIC), chunk = 0, now;
+    struct timespec ts;
+
+    (void)arg;
+    memset(buf, 0, sizeof(buf));
+    while (running && chunk < MAX_CHUNKS) {
+        write_ns[chunk] = clock_ns(CLOCK_MONOTONIC);
+        chunk += iq_fake_rx_write(&m, 0, buf, STEP, false) / STEP;
+        next += period;
+        now = clock_ns(CLOCK_MONOTONIC);
+        if (next > now) {
+            ts.tv_sec = (next - now) / 1000000000ULL;
+            ts.tv_nsec = (next - now) % 1000000000ULL;
+            nanosleep(&ts, NULL);
+        }
+    }
+    return NULL;
+}
+
+static void bench(uint32_t policy, uint32_t rate) {
+    uint8_t buf[FIFO_SIZE];
+    uint64_t t0, c0, wall, cpu, lat, lat_sum = 0, lat_max = 0, calls = 0, chunk = 0;
+    iq_rx_stream_t *s;
+    iq_player_t *p;
+    pthread_t th;
+    int ret;
+
+    iq_fake_open(&m, 1);
+    iq_fake_rx_start(&m, 0, RX_FIFO_START, FIFO_SIZE, 0);
+    p = iq_player_open(m.iqflood, m.iqflood_size, m.bar2);
+    s = iq_player_rx_stream(p, 0);
+    iq_player_set_wait_policy(p, policy, rate);
+    iq_rx_init(s, RX_FIFO_START, FIFO_SIZE);
+    sample_rate = rate;
+
+    running = 1;
+    pthread_create(&th, NULL, modem_thread, NULL);
+    t0 = clock_ns(CLOCK_MONOTONIC);
+    c0 = clock_ns(CLOCK_THREAD_CPUTIME_ID);
+    while (clock_ns(CLOCK_MONOTONIC) - t0 < DURATION_NS) {
+        ret = iq_rx_receive_wait(s, (uint32_t *)buf, STEP, sizeof(buf), 10000000);
+        if (ret <= 0)
+            continue;
+        // latency of the last chunk received
+        chunk += ret / STEP;
+        lat = clock_ns(CLOCK_MONOTONIC) - write_ns[(chunk - 1) % MAX_CHUNKS];
+        lat_sum += lat;
+        if (lat > lat_max)
+            lat_max = lat;
+        calls++;
+    }
+    cpu = clock_ns(CLOCK_THREAD_CPUTIME_ID) - c0;
+    wall = clock_ns(CLOCK_MONOTONIC) - t0;
+    running = 0;
+    pthread_join(th, NULL);
+
+    printf("%-9s %5u ksps  cpu %5.1f %%  latency avg %7.1f us  max %8.1f us  (%" PRIu64 " chunks, %" PRIu64 " lost)\n",
+           policy_name[policy], rate / 1000, 100.0 * cpu / wall, calls ? lat_sum / 1000.0 / calls : 0.0, lat_max / 1000.0,
+           chunk, (uint64_t)iq_rx_lost_size(s));
+    iq_player_close(p);
+    iq_fake_close(&m);
+}
+
+int main(void) {
+    uint32_t policy, r;
+
+    for (r = 0; r < sizeof(rates) / sizeof(rates[0]); r++)
+        for (policy = 0; policy < IQ_WAIT_MAX; policy++)
+            bench(policy, rates[r]);
+    return 0;
+}
@@ -0,0 +1,227 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "iq_fake_modem.h"
+#include "iq_bfp.h"
+
+/* host dmem proxy window in BAR2, as mapped by lib_iqplayer */
+#define IQ_FAKE_WO_1R 0x400000
+#define IQ_FAKE_WO_XR 0x504000
+
+static inline void iq_fake_cnt_write(uint32_t *lo, uint32_t *hi, uint64_t val) {
+    // epoch first : host extends low word from its last known value, a new low word never comes with an old epoch
+    __atomic_store_n(hi, (uint32_t)(val >> 32), __ATOMIC_RELEASE);
+    __atomic_store_n(lo, (uint32_t)val, __ATOMIC_RELEASE);
+}
+
+static inline uint64_t iq_fake_cnt_read(uint32_t *lo, uint32_t *hi, uint64_t prev) {
+    uint32_t v = __atomic_load_n(lo, __ATOMIC_ACQUIRE);
+
+    (void)hi;
+    return prev + (uint32_t)(v - (uint32_t)prev);
+}
+
+int iq_fake_open(iq_fake_modem_t *m, uint32_t rx_num_chan) {
+    memset(m, 0, sizeof(iq_fake_modem_t));
+    m->iqflood_size = IQ_FAKE_IQFLOOD_SIZE;
+    if (posix_memalign((void **)&m->iqflood, 4096, m->iqflood_size))
+        return -1;
+    m->bar2 = calloc(1, IQ_FAKE_BAR2_SIZE);
+    if (m->bar2 == NULL) {
+        free(m->iqflood);
+        return -1;
+    }
+    memset(m->iqflood, 0, m->iqflood_size);
+
+    m->ro = (t_vspa_dmem_proxy *)((uint8_t *)m->iqflood + m->iqflood_size - VSPA_DMEM_PROXY_SIZE);
+    m->wo = (t_tx_ch_host_proxy *)((uint8_t *)m->bar2 + (rx_num_chan == 1 ? IQ_FAKE_WO_1R : IQ_FAKE_WO_XR));
+
+    m->ro->tx_state_readonly.proxy_version = VSPA_DMEM_PROXY_VERSION;
+    m->ro->tx_state_readonly.rx_num_chan = rx_num_chan;
+    m->ro->tx_state_readonly.rx_decim = 1;
+    m->ro->tx_state_readonly.tx_upsmp = 1;
+    m->ro->tx_state_readonly.rx_ddr_step = IQ_FAKE_DDR_STEP;
+    m->ro->tx_state_readonly.tx_ddr_step = IQ_FAKE_DDR_STEP;
+    m->ro->tx_state_readonly.DDR_rd_base_address = 0xdeadbeef;
+    return 0;
+}
+
+void iq_fake_close(iq_fake_modem_t *m) {
+    free(m->iqflood);
+    free(m->bar2);
+    m->iqflood = NULL;
+    m->bar2 = NULL;
+}
+
+void iq_fake_tx_start(iq_fake_modem_t *m, uint32_t fifo_start, uint32_t fifo_size, uint64_t base) {
+    t_tx_ch_host_proxy *tx = &m->ro->tx_state_readonly;
+
+    m->tx_fifo_start = fifo_start;
+    m->tx_fifo_size = fifo_size;
+    if (m->tx_cmp_width)
+        m->tx_fifo_size = fifo_size / IQ_BFP_CHUNK_SIZE(IQ_FAKE_DDR_STEP, m->tx_cmp_width) * IQ_FAKE_DDR_STEP;
+    m->tx_enqueued = base;
+    iq_fake_cnt_write(&tx->la9310_fifo_enqueued_size, &tx->la9310_fifo_enqueued_size_hi, base);
+    tx->DDR_rd_base_address = fifo_start;
+    tx->DDR_rd_size = fifo_size;
+}
+
+void iq_fake_rx_start(iq_fake_modem_t *m, uint32_t chan, uint32_t fifo_start, uint32_t fifo_size, uint64_t base) {
+    t_rx_ch_host_proxy *rx = &m->ro->rx_state_readonly[chan];
+
+    m->rx_fifo_start[chan] = fifo_start;
+    m->rx_fifo_size[chan] = fifo_size;
+    // raw capacity of a compressed fifo, whole chunks only
+    if (m->rx_cmp_width[chan])
+        m->rx_fifo_size[chan] = fifo_size / IQ_BFP_CHUNK_SIZE(IQ_FAKE_DDR_STEP, m->rx_cmp_width[chan]) * IQ_FAKE_DDR_STEP;
+    m->rx_produced[chan] = base;
+    // la9310_fifo_consumed_size : bytes written to DDR, i.e. produced for host
+    iq_fake_cnt_write(&rx->la9310_fifo_consumed_size, &rx->la9310_fifo_consumed_size_hi, base);
+    rx->DDR_wr_base_address = fifo_start;
+    rx->DDR_wr_size = fifo_size;
+}
+
+void iq_fake_rx_set_cmp(iq_fake_modem_t *m, uint32_t chan, uint32_t width) {
+    m->rx_cmp_width[chan] = width;
+    m->ro->rx_state_readonly[chan].rx_cmp_mode = width;
+}
+
+void iq_fake_tx_set_cmp(iq_fake_modem_t *m, uint32_t width) {
+    m->tx_cmp_width = width;
+    m->ro->tx_state_readonly.tx_cmp_mode = width;
+}
+
+uint64_t iq_fake_host_produced(iq_fake_modem_t *m) {
+    return iq_fake_cnt_read(&m->wo->host_produced_size, &m->wo->host_produced_size_hi, m->tx_enqueued);
+}
+
+uint64_t iq_fake_host_consumed(iq_fake_modem_t *m, uint32_t chan) {
+    return iq_fake_cnt_read(&m->wo->host_consumed_size[chan], &m->wo->host_consumed_size_hi[chan],
+                            m->rx_produced[chan] - m->rx_fifo_size[chan]);
+}
+
+static void iq_fake_copy_out(uint8_t *dst, const uint8_t *fifo, uint32_t fifo_size, uint64_t pos, uint32_t size) {
+    uint32_t offset = pos % fifo_size, len;
+
+    while (size) {
+        len = fifo_size - offset < size ? fifo_size - offset : size;
+        memcpy(dst, fifo + offset, len);
+        dst += len;
+        size -= len;
+        offset = 0;
+    }
+}
+
+static void iq_fake_copy_in(uint8_t *fifo, const uint8_t *src, uint32_t fifo_size, uint64_t pos, uint32_t size) {
+    uint32_t offset = pos % fifo_size, len;
+
+    while (size) {
+        len = fifo_size - offset < size ? fifo_size - offset : size;
+        memcpy(fifo + offset, src, len);
+        src += len;
+        size -= len;
+        offset = 0;
+    }
+}
+
+/* cs16 steps to BFP chunks, chunk n of the fifo at n * chunk size */
+static void iq_fake_compress_in(uint8_t *fifo, const uint8_t *src, uint32_t fifo_size, uint64_t pos, uint32_t size,
+                                uint32_t width) {
+    uint32_t chunk_size = IQ_BFP_CHUNK_SIZE(IQ_FAKE_DDR_STEP, width), done, k;
+    uint16_t sm[IQ_FAKE_DDR_STEP / 2];
+    uint32_t chunk[IQ_FAKE_DDR_STEP / 4];
+    int16_t x;
+
+    for (done = 0; done < size; done += IQ_FAKE_DDR_STEP) {
+        for (k = 0; k < IQ_FAKE_DDR_STEP / 2; k++) {
+            memcpy(&x, src + done + 2 * k, 2);
+            sm[k] = iq_bfp_cs16_to_sm(x);
+        }
+        iq_bfp_compress(chunk, sm, IQ_FAKE_DDR_STEP / IQ_BFP_BLOCK_SIZE, width);
+        memcpy(fifo + (pos + done) % fifo_size / IQ_FAKE_DDR_STEP * chunk_size, chunk, chunk_size);
+    }
+}
+
+/* BFP chunks back to cs16 steps */
+static void iq_fake_expand_out(uint8_t *dst, const uint8_t *fifo, uint32_t fifo_size, uint64_t pos, uint32_t size,
+                               uint32_t width) {
+    uint32_t chunk_size = IQ_BFP_CHUNK_SIZE(IQ_FAKE_DDR_STEP, width), done;
+    uint32_t chunk[IQ_FAKE_DDR_STEP / 4];
+    int16_t step[IQ_FAKE_DDR_STEP / 2];
+
+    for (done = 0; done < size; done += IQ_FAKE_DDR_STEP) {
+        memcpy(chunk, fifo + (pos + done) % fifo_size / IQ_FAKE_DDR_STEP * chunk_size, chunk_size);
+        iq_bfp_decompress(step, chunk, IQ_FAKE_DDR_STEP / IQ_BFP_BLOCK_SIZE, width);
+        memcpy(dst + done, step, IQ_FAKE_DDR_STEP);
+    }
+}
+
+uint32_t iq_fake_tx_fetch(iq_fake_modem_t *m, void *dst, uint32_t max_size, bool force) {
+    t_tx_ch_host_proxy *tx = &m->ro->tx_state_readonly;
+    uint8_t *fifo = (uint8_t *)m->iqflood + m->tx_fifo_start;
+    uint64_t ready = iq_fake_host_produced(m) - m->tx_enqueued;
+    uint32_t size = max_size - max_size % IQ_FAKE_DDR_STEP;
+
+    if (!force && size > ready)
+        size = ready - ready % IQ_FAKE_DDR_STEP;
+    if (size == 0)
+        return 0;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (dst && m->tx_cmp_width)
+        iq_fake_expand_out(dst, fifo, m->tx_fifo_size, m->tx_enqueued, size, m->tx_cmp_width);
+    else if (dst)
+        iq_fake_copy_out(dst, fifo, m->tx_fifo_size, m->tx_enqueued, size);
+    m->tx_enqueued += size;
+    iq_fake_cnt_write(&tx->la9310_fifo_enqueued_size, &tx->la9310_fifo_enqueued_size_hi, m->tx_enqueued);
+
+    return size;
+}
+
+uint32_t iq_fake_rx_write(iq_fake_modem_t *m, uint32_t chan, const void *src, uint32_t size, bool force) {
+    t_rx_ch_host_proxy *rx = &m->ro->rx_state_readonly[chan];
+    uint8_t *fifo = (uint8_t *)m->iqflood + m->rx_fifo_start[chan];
+    uint64_t room = m->rx_fifo_size[chan] - (m->rx_produced[chan] - iq_fake_host_consumed(m, chan));
+
+    size -= size % IQ_FAKE_DDR_STEP;
+    if (!force && size > room)
+        size = room - room % IQ_FAKE_DDR_STEP;
+    if (size == 0)
+        return 0;
+    if (m->rx_cmp_width[chan])
+        iq_fake_compress_in(fifo, src, m->rx_fifo_size[chan], m->rx_produced[chan], size, m->rx_cmp_width[chan]);
+    else
+        iq_fake_copy_in(fifo, src, m->rx_fifo_size[chan], m->rx_produced[chan], size);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    m->rx_produced[chan] += size;
+    iq_fake_cnt_write(&rx->la9310_fifo_consumed_size, &rx->la9310_fifo_consumed_size_hi, m->rx_produced[chan]);
+
+    return size;
+}
+
+void iq_fake_pattern_fill(void *buf, uint64_t pos, uint32_t size) {
+    uint8_t *p = buf;
+    uint32_t i;
+
+    for (i = 0; i < size; i++)
+        p[i] = iq_fake_pattern(pos + i);
+}
+
+uint32_t iq_fake_pattern_check(const void *buf, uint64_t pos, uint32_t size) {
+    const uint8_t *p = buf;
+    uint32_t i;
+
+    for (i = 0; i < size; i++) {
+        if (p[i] != iq_fake_pattern(pos + i))
+            return i;
+    }
+    return size;
+}
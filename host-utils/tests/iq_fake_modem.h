@@ -0,0 +1,83 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#ifndef __IQ_FAKE_MODEM_H__
+#define __IQ_FAKE_MODEM_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "vspa_dmem_proxy.h"
+
+/*
+ * Software modem for host checks of lib_iqplayer : IQFLOOD and LA9310 BAR2 are heap buffers, the fake updates
+ * the iqflood proxy the way firmware DMAs it (64-bit flow counters as lo + _hi epoch) and reads host flow
+ * control from the BAR2 dmem image, at the same offsets lib_iqplayer writes them.
+ * Fake calls may run in their own thread (modem side) while the test drives the library (host side).
+ */
+#define IQ_FAKE_IQFLOOD_SIZE (4 * 1024 * 1024)
+#define IQ_FAKE_BAR2_SIZE 0x508000
+#define IQ_FAKE_DDR_STEP 2048
+
+typedef struct {
+    uint32_t *iqflood;
+    uint32_t iqflood_size;
+    uint32_t *bar2;
+    t_vspa_dmem_proxy *ro;  /* modem -> host, last VSPA_DMEM_PROXY_SIZE bytes of iqflood */
+    t_tx_ch_host_proxy *wo; /* host -> modem, dmem image in BAR2 */
+    uint32_t tx_fifo_start;
+    uint32_t tx_fifo_size;
+    uint64_t tx_enqueued; /* bytes fetched from DDR */
+    uint32_t tx_cmp_width; /* BFP mantissa width, 0 : cs16 */
+    uint32_t rx_fifo_start[RX_NUM_MAX_CHAN];
+    uint32_t rx_fifo_size[RX_NUM_MAX_CHAN];
+    uint64_t rx_produced[RX_NUM_MAX_CHAN]; /* bytes written to DDR */
+    uint32_t rx_cmp_width[RX_NUM_MAX_CHAN]; /* BFP mantissa width, 0 : cs16 */
+} iq_fake_modem_t;
+
+int iq_fake_open(iq_fake_modem_t *m, uint32_t rx_num_chan);
+void iq_fake_close(iq_fake_modem_t *m);
+
+/* stream start, counters begin at base (e.g. close to 4GB to cross the 32-bit wrap) */
+void iq_fake_tx_start(iq_fake_modem_t *m, uint32_t fifo_start, uint32_t fifo_size, uint64_t base);
+void iq_fake_rx_start(iq_fake_modem_t *m, uint32_t chan, uint32_t fifo_start, uint32_t fifo_size, uint64_t base);
+
+/*
+ * RX BFP compression (iq_bfp.h) as a compressing modem would do it, set before iq_fake_rx_start() : fifo_size is then
+ * DDR bytes, flow counters stay in cs16 bytes and the fifo holds whole chunks only.
+ */
+void iq_fake_rx_set_cmp(iq_fake_modem_t *m, uint32_t chan, uint32_t width);
+
+/* TX BFP expansion, set before iq_fake_tx_start() : same fifo layout as RX, iq_fake_tx_fetch() returns cs16 */
+void iq_fake_tx_set_cmp(iq_fake_modem_t *m, uint32_t width);
+
+/* host flow control as seen by modem */
+uint64_t iq_fake_host_produced(iq_fake_modem_t *m);
+uint64_t iq_fake_host_consumed(iq_fake_modem_t *m, uint32_t chan);
+
+/*
+ * TX : fetch up to max_size bytes of host data, whole DDR steps, to dst (NULL to drop).
+ * force plays max_size bytes whatever host produced, i.e. a DAC underrun. Returns bytes fetched.
+ */
+uint32_t iq_fake_tx_fetch(iq_fake_modem_t *m, void *dst, uint32_t max_size, bool force);
+
+/*
+ * RX : write up to size bytes of src (whole DDR steps) to DDR fifo within host flow control.
+ * force ignores flow control, i.e. overwrites unread data as firmware does with flow control disabled.
+ * src is cs16, compressed chunk by chunk on a compressed channel.
+ */
+uint32_t iq_fake_rx_write(iq_fake_modem_t *m, uint32_t chan, const void *src, uint32_t size, bool force);
+
+/* deterministic test pattern, byte n of a stream is iq_fake_pattern(n) */
+static inline uint8_t iq_fake_pattern(uint64_t n) {
+    return (uint8_t)((n * 131) ^ (n >> 9));
+}
+
+void iq_fake_pattern_fill(void *buf, uint64_t pos, uint32_t size);
+/* returns index of first mismatch, size when all match */
+uint32_t iq_fake_pattern_check(const void *buf, uint64_t pos, uint32_t size);
+
+#endif
@@ -0,0 +1,42 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#ifndef __IQ_TEST_H__
+#define __IQ_TEST_H__
+
+#include <stdio.h>
+#include <stdint.h>
+
+/* minimal host check helpers, a test binary exits non zero when any check failed */
+static int iq_test_failed;
+
+#define IQ_CHECK(cond)                                                                                                 \
+    do {                                                                                                               \
+        if (!(cond)) {                                                                                                 \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);                                           \
+            iq_test_failed++;                                                                                          \
+        }                                                                                                              \
+    } while (0)
+
+#define IQ_CHECK_EQ(a, b)                                                                                              \
+    do {                                                                                                               \
+        long long _a = (long long)(a), _b = (long long)(b);                                                            \
+        if (_a != _b) {                                                                                                \
+            printf("%s:%d: check failed: %s == %s (%lld != %lld)\n", __FILE__, __LINE__, #a, #b, _a, _b);              \
+            iq_test_failed++;                                                                                          \
+        }                                                                                                              \
+    } while (0)
+
+#define IQ_TEST_RUN(fn)                                                                                                \
+    do {                                                                                                               \
+        int _f = iq_test_failed;                                                                                       \
+        fn();                                                                                                          \
+        printf("%-40s %s\n", #fn, _f == iq_test_failed ? "ok" : "FAILED");                                             \
+    } while (0)
+
+#define IQ_TEST_EXIT() (iq_test_failed ? 1 : 0)
+
+#endif
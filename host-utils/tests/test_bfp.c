@@ -0,0 +1,327 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "lib_iqplayer_api.h"
+#include "iq_convert.h"
+#include "iq_bfp.h"
+#include "iq_fake_modem.h"
+#include "iq_test.h"
+
+/*
+ * BFP compression (iq_bfp.h) : model round trip and in place operation, host decompressor bit exact with the
+ * model, compressed RX fifo through the library (receive, wait, feeder) against a software modem compressing
+ * like firmware, compressed TX fifo (send, wait, feeder) against a software modem expanding like firmware.
+ */
+void ref_iq_convert_bfp_to_cs16(int16_t *dst, const void *chunk, uint32_t raw_size, uint32_t width);
+
+#define STEP IQ_FAKE_DDR_STEP
+#define NB_BLOCKS (STEP / IQ_BFP_BLOCK_SIZE)
+#define NB_COMP (STEP / 2)
+#define FIFO_START 0x20000
+#define FIFO_SIZE (16 * STEP) /* DDR bytes */
+#define WIDTH 9
+
+static iq_fake_modem_t m;
+static int16_t src[8 * NB_COMP], out[8 * NB_COMP], expect[8 * NB_COMP];
+
+/* per block magnitude ranges from a few lsb to full scale, including -32768 */
+static void fill(int16_t *x, uint32_t nb_comp, uint32_t seed) {
+    uint32_t i, shift;
+
+    for (i = 0; i < nb_comp; i++) {
+        shift = (i / IQ_BFP_BLOCK_COMP + seed) % 16;
+        x[i] = (int16_t)((int32_t)(((i + seed) * 2654435761U) >> 16) >> shift);
+        if ((i + seed) % 97 == 0)
+            x[i] = -32768;
+    }
+}
+
+/* model : cs16 -> DMEM sign-magnitude -> chunk -> cs16 */
+static void model_round_trip(int16_t *dst, const int16_t *x, uint32_t width) {
+    uint32_t chunk[STEP / 4];
+    uint16_t sm[NB_COMP];
+    uint32_t k;
+
+    for (k = 0; k < NB_COMP; k++)
+        sm[k] = iq_bfp_cs16_to_sm(x[k]);
+    iq_bfp_compress(chunk, sm, NB_BLOCKS, width);
+    iq_bfp_decompress(dst, chunk, NB_BLOCKS, width);
+}
+
+static void test_model_round_trip(void) {
+    uint32_t width, b, k, max, e, err;
+    int32_t x, y;
+
+    fill(src, NB_COMP, 1);
+    for (width = IQ_BFP_WIDTH_MIN; width <= IQ_BFP_WIDTH_MAX; width++) {
+        model_round_trip(out, src, width);
+        for (b = 0; b < NB_BLOCKS; b++) {
+            // error bounded by half a step of the block exponent (plus saturation of the rounded max)
+            for (k = 0, max = 0; k < IQ_BFP_BLOCK_COMP; k++) {
+                x = src[b * IQ_BFP_BLOCK_COMP + k];
+                if ((uint32_t)abs(x) > max)
+                    max = abs(x) > 32767 ? 32767 : abs(x);
+            }
+            for (e = 0; (max >> e) > (1U << (width - 1)) - 1; e++)
+                ;
+            for (k = 0; k < IQ_BFP_BLOCK_COMP; k++) {
+                x = src[b * IQ_BFP_BLOCK_COMP + k];
+                y = out[b * IQ_BFP_BLOCK_COMP + k];
+                err = abs(x - y);
+                if (err > (1U << e)) {
+                    printf("  width %u block %u comp %u : %d -> %d (e %u)\n", width, b, k, x, y, e);
+                    iq_test_failed++;
+                    return;
+                }
+                // small blocks are lossless
+                if (e == 0 && x != -32768)
+                    IQ_CHECK_EQ(x, y);
+            }
+        }
+    }
+}
+
+static void test_in_place(void) {
+    uint32_t chunk[STEP / 4], buf[STEP / 4];
+    uint16_t sm[NB_COMP];
+    uint32_t width, k;
+
+    fill(src, NB_COMP, 5);
+    for (k = 0; k < NB_COMP; k++)
+        sm[k] = iq_bfp_cs16_to_sm(src[k]);
+    for (width = IQ_BFP_WIDTH_MIN; width <= IQ_BFP_WIDTH_MAX; width++) {
+        iq_bfp_compress(chunk, sm, NB_BLOCKS, width);
+        memcpy(buf, sm, STEP);
+        iq_bfp_compress(buf, (uint16_t *)buf, NB_BLOCKS, width);
+        IQ_CHECK(memcmp(buf, chunk, IQ_BFP_CHUNK_SIZE(STEP, width)) == 0);
+    }
+}
+
+static void test_decompress_bit_exact(void) {
+    uint32_t chunk[STEP / 4 + 16] __attribute__((aligned(64)));
+    uint16_t sm[NB_COMP];
+    uint32_t width, k, seed;
+
+    for (seed = 0; seed < 16; seed++) {
+        fill(src, NB_COMP, seed);
+        for (k = 0; k < NB_COMP; k++)
+            sm[k] = iq_bfp_cs16_to_sm(src[k]);
+        for (width = IQ_BFP_WIDTH_MIN; width <= IQ_BFP_WIDTH_MAX; width++) {
+            iq_bfp_compress(chunk, sm, NB_BLOCKS, width);
+            iq_bfp_decompress(expect, chunk, NB_BLOCKS, width);
+            iq_convert_bfp_to_cs16(out, chunk, STEP, width);
+            IQ_CHECK(memcmp(out, expect, STEP) == 0);
+            ref_iq_convert_bfp_to_cs16(out, chunk, STEP, width);
+            IQ_CHECK(memcmp(out, expect, STEP) == 0);
+        }
+    }
+}
+
+static iq_rx_stream_t *rx_open(iq_player_t **p, uint64_t base) {
+    iq_fake_open(&m, 1);
+    iq_fake_rx_set_cmp(&m, 0, WIDTH);
+    iq_fake_rx_start(&m, 0, FIFO_START, FIFO_SIZE, base);
+    *p = iq_player_open(m.iqflood, m.iqflood_size, m.bar2);
+    IQ_CHECK(*p != NULL);
+    IQ_CHECK_EQ(iq_rx_init(iq_player_rx_stream(*p, 0), FIFO_START, FIFO_SIZE), 1);
+    return iq_player_rx_stream(*p, 0);
+}
+
+static void player_close(iq_player_t *p) {
+    iq_player_close(p);
+    iq_fake_close(&m);
+}
+
+static void expect_fill(uint32_t nb_steps, uint32_t seed) {
+    uint32_t i;
+
+    fill(src, nb_steps * NB_COMP, seed);
+    for (i = 0; i < nb_steps; i++)
+        model_round_trip(expect + i * NB_COMP, src + i * NB_COMP, WIDTH);
+}
+
+/* chunks across fifo wrap and 32-bit counter wrap, decompressed by the library as the model does */
+static void test_rx_receive(void) {
+    uint32_t raw_size = FIFO_SIZE / IQ_BFP_CHUNK_SIZE(STEP, WIDTH) * STEP;
+    iq_player_t *p;
+    iq_rx_stream_t *s = rx_open(&p, 0x100000000ULL - 5 * STEP);
+    uint32_t round, len;
+    void *seg0, *seg1;
+
+    IQ_CHECK_EQ(iq_rx_chunk_size(s), STEP);
+    for (round = 0; round < 3 * raw_size / (5 * STEP); round++) {
+        expect_fill(5, round);
+        IQ_CHECK_EQ(iq_fake_rx_write(&m, 0, src, 5 * STEP, false), 5 * STEP);
+        // partial chunk room left in user buffer is not used
+        len = iq_rx_receive(s, (uint32_t *)out, 3 * STEP + 100);
+        IQ_CHECK_EQ(len, 3 * STEP);
+        len += iq_rx_receive(s, (uint32_t *)((uint8_t *)out + len), 8 * STEP);
+        IQ_CHECK_EQ(len, 5 * STEP);
+        IQ_CHECK(memcmp(out, expect, 5 * STEP) == 0);
+    }
+    IQ_CHECK_EQ(iq_rx_peek(s, &seg0, &len, &seg1, &len), -EOPNOTSUPP);
+    player_close(p);
+}
+
+/* user buffer below one chunk : error, not a zero length receive the caller would spin on */
+static void test_rx_small_buffer(void) {
+    iq_player_t *p;
+    iq_rx_stream_t *s = rx_open(&p, 0);
+
+    expect_fill(2, 3);
+    IQ_CHECK_EQ(iq_fake_rx_write(&m, 0, src, 2 * STEP, false), 2 * STEP);
+    IQ_CHECK_EQ(iq_rx_receive(s, (uint32_t *)out, STEP - 4), -ENOSPC);
+    IQ_CHECK_EQ(iq_rx_receive_wait(s, (uint32_t *)out, 1, STEP - 4, 1000000), -ENOSPC);
+    // min_size past the last whole chunk of max_size : returns the whole chunks instead of waiting forever
+    IQ_CHECK_EQ(iq_rx_receive_wait(s, (uint32_t *)out, STEP + STEP / 2, STEP + STEP / 2, 1000000), STEP);
+    IQ_CHECK_EQ(iq_rx_receive_wait(s, (uint32_t *)out + NB_COMP / 2, 2 * STEP, 2 * STEP, 1000000), STEP);
+    IQ_CHECK(memcmp(out, expect, 2 * STEP) == 0);
+    player_close(p);
+}
+
+/* feeder ring keeps whole chunks whatever the application read size */
+static void test_rx_feeder(void) {
+    iq_player_t *p;
+    iq_rx_stream_t *s = rx_open(&p, 0);
+    uint32_t nb_steps = 8, done = 0, sent = 0, len;
+    uint64_t moved, lost, stalls;
+    iq_feeder_t *f;
+    int ret;
+
+    IQ_CHECK(iq_rx_feeder_start(s, STEP / 2, -1, 0) == NULL);
+    f = iq_rx_feeder_start(s, 2 * STEP, -1, 0);
+    IQ_CHECK(f != NULL);
+    if (f == NULL) {
+        player_close(p);
+        return;
+    }
+    expect_fill(nb_steps, 7);
+    while (done < nb_steps * STEP) {
+        if (sent < nb_steps * STEP)
+            sent += iq_fake_rx_write(&m, 0, (uint8_t *)src + sent, STEP, false);
+        len = nb_steps * STEP - done < 3000 ? nb_steps * STEP - done : 3000;
+        ret = iq_feeder_read(f, (uint8_t *)out + done, len);
+        IQ_CHECK(ret >= 0);
+        if (ret < 0)
+            break;
+        done += ret;
+        if (ret == 0)
+            usleep(100);
+    }
+    IQ_CHECK(memcmp(out, expect, nb_steps * STEP) == 0);
+    iq_feeder_stats(f, &moved, &lost, &stalls);
+    IQ_CHECK_EQ(moved, nb_steps * STEP);
+    IQ_CHECK_EQ(lost, 0);
+    iq_feeder_stop(f);
+    player_close(p);
+}
+
+static iq_tx_stream_t *tx_open(iq_player_t **p, uint64_t base) {
+    iq_fake_open(&m, 1);
+    iq_fake_tx_set_cmp(&m, WIDTH);
+    iq_fake_tx_start(&m, FIFO_START, FIFO_SIZE, base);
+    *p = iq_player_open(m.iqflood, m.iqflood_size, m.bar2);
+    IQ_CHECK(*p != NULL);
+    iq_tx_init(iq_player_tx_stream(*p), FIFO_START, FIFO_SIZE);
+    return iq_player_tx_stream(*p);
+}
+
+/* chunks across fifo wrap and 32-bit counter wrap, modem expands what the model gives */
+static void test_tx_send(void) {
+    uint32_t raw_size = FIFO_SIZE / IQ_BFP_CHUNK_SIZE(STEP, WIDTH) * STEP;
+    iq_player_t *p;
+    iq_tx_stream_t *s = tx_open(&p, 0x100000000ULL - 5 * STEP);
+    uint32_t round, len;
+
+    IQ_CHECK_EQ(iq_tx_chunk_size(s), STEP);
+    for (round = 0; round < 3 * raw_size / (5 * STEP); round++) {
+        expect_fill(5, round);
+        // a partial chunk tail is left to caller
+        len = iq_tx_send(s, (uint32_t *)src, 3 * STEP + 100);
+        IQ_CHECK_EQ(len, 3 * STEP);
+        IQ_CHECK_EQ(iq_tx_send_wait(s, (uint32_t *)((uint8_t *)src + len), 2 * STEP, 1000000), 2 * STEP);
+        IQ_CHECK_EQ(iq_fake_tx_fetch(&m, out, 8 * STEP, false), 5 * STEP);
+        IQ_CHECK(memcmp(out, expect, 5 * STEP) == 0);
+    }
+    player_close(p);
+}
+
+/* blocking send of a partial chunk : error, not a short count the caller would resend forever */
+static void test_tx_send_wait_tail(void) {
+    iq_player_t *p;
+    iq_tx_stream_t *s = tx_open(&p, 0);
+
+    expect_fill(2, 11);
+    IQ_CHECK_EQ(iq_tx_send_wait(s, (uint32_t *)src, STEP - 4, 1000000), -EINVAL);
+    IQ_CHECK_EQ(iq_tx_send_wait(s, (uint32_t *)src, 2 * STEP + 4, 1000000), -EINVAL);
+    IQ_CHECK_EQ(iq_fake_host_produced(&m), 0);
+    IQ_CHECK_EQ(iq_tx_send_wait(s, (uint32_t *)src, 2 * STEP, 1000000), 2 * STEP);
+    IQ_CHECK_EQ(iq_fake_tx_fetch(&m, out, 2 * STEP, false), 2 * STEP);
+    IQ_CHECK(memcmp(out, expect, 2 * STEP) == 0);
+    player_close(p);
+}
+
+/* feeder sends whole chunks whatever the application write size, tail waits in ring for the next write */
+static void test_tx_feeder(void) {
+    iq_player_t *p;
+    iq_tx_stream_t *s = tx_open(&p, 0);
+    uint32_t nb_steps = 8, done = 0, fetched = 0, len, spins = 0;
+    uint64_t moved, lost, stalls;
+    iq_feeder_t *f;
+    int ret;
+
+    IQ_CHECK(iq_tx_feeder_start(s, STEP / 2, -1, 0) == NULL);
+    f = iq_tx_feeder_start(s, 2 * STEP, -1, 0);
+    IQ_CHECK(f != NULL);
+    if (f == NULL) {
+        player_close(p);
+        return;
+    }
+    expect_fill(nb_steps, 13);
+    while (fetched < nb_steps * STEP && spins < 100000) {
+        if (done < nb_steps * STEP) {
+            len = nb_steps * STEP - done < 3000 ? nb_steps * STEP - done : 3000;
+            ret = iq_feeder_write(f, (uint8_t *)src + done, len);
+            IQ_CHECK(ret >= 0);
+            if (ret < 0)
+                break;
+            done += ret;
+        }
+        len = iq_fake_tx_fetch(&m, (uint8_t *)out + fetched, nb_steps * STEP - fetched, false);
+        fetched += len;
+        if (len == 0) {
+            spins++;
+            usleep(100);
+        }
+    }
+    IQ_CHECK_EQ(fetched, nb_steps * STEP);
+    IQ_CHECK(memcmp(out, expect, nb_steps * STEP) == 0);
+    iq_feeder_stats(f, &moved, &lost, &stalls);
+    IQ_CHECK_EQ(moved, nb_steps * STEP);
+    IQ_CHECK_EQ(lost, 0);
+    iq_feeder_stop(f);
+    player_close(p);
+}
+
+int main(void) {
+    IQ_TEST_RUN(test_model_round_trip);
+    IQ_TEST_RUN(test_in_place);
+    IQ_TEST_RUN(test_decompress_bit_exact);
+    IQ_TEST_RUN(test_rx_receive);
+    IQ_TEST_RUN(test_rx_small_buffer);
+    IQ_TEST_RUN(test_rx_feeder);
+    IQ_TEST_RUN(test_tx_send);
+    IQ_TEST_RUN(test_tx_send_wait_tail);
+    IQ_TEST_RUN(test_tx_feeder);
+    return IQ_TEST_EXIT();
+}
@@ -0,0 +1,175 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "lib_iqplayer_api.h"
+#include "iq_capture.h"
+#include "iq_fake_modem.h"
+#include "iq_test.h"
+
+/*
+ * iq_app streaming capture (iq_capture.c) with the software modem as rx source, files on tmpfs : rotated files hold
+ * the stream in order, a file that can't be opened or written stops the capture with EXIT_FAILURE.
+ */
+#define RX_FIFO_START 0x100000
+#define FIFO_SIZE (64 * IQ_FAKE_DDR_STEP)
+#define STEP IQ_FAKE_DDR_STEP
+#define CAP_BUF_SIZE (4 * 1024 * 1024) /* iq_capture.c buffer */
+#define MB (1024 * 1024)
+
+static iq_fake_modem_t m;
+static volatile uint32_t running, modem_running;
+static uint64_t stream_size; /* 0 : produce until modem_running cleared */
+static char dir[64];
+static char first_file[160]; /* opened by capture once rx stream is initialised */
+static stream_ctx_t ctx;
+
+/* produces pattern, stops capture once application received all of stream_size */
+static void *modem_thread(void *arg) {
+    uint8_t buf[16 * STEP];
+    uint64_t pos = 0;
+    uint32_t len;
+
+    (void)arg;
+    // rx init starts at modem position, data produced before is not part of the capture
+    while (modem_running && access(first_file, F_OK))
+        sched_yield();
+    while (modem_running) {
+        len = sizeof(buf);
+        if (stream_size && stream_size - pos < len)
+            len = stream_size - pos;
+        iq_fake_pattern_fill(buf, pos, len);
+        pos += iq_fake_rx_write(&m, 0, buf, len, false);
+        if (stream_size && pos == stream_size && ctx.bytes == pos) {
+            running = 0;
+            break;
+        }
+        sched_yield();
+    }
+    return NULL;
+}
+
+static int capture(const char *path, uint64_t size, iq_capture_cfg_t *cfg) {
+    pthread_t th;
+    int ret;
+
+    iq_fake_open(&m, 1);
+    iq_fake_rx_start(&m, 0, RX_FIFO_START, FIFO_SIZE, 0);
+    IQ_CHECK_EQ(iq_player_init(m.iqflood, m.iqflood_size, m.bar2), 1);
+    iq_player_init_wait(IQ_WAIT_YIELD, 0);
+    ctx = (stream_ctx_t){ .chan = 0, .path = path, .fifo_start = RX_FIFO_START, .fifo_size = FIFO_SIZE, .quiet = true };
+    if (cfg->rotate_size || cfg->rotate_sec)
+        snprintf(first_file, sizeof(first_file), "%s.0000", path);
+    else
+        snprintf(first_file, sizeof(first_file), "%s", path);
+    stream_size = size;
+    running = 1;
+    modem_running = 1;
+    cfg->running = &running;
+    pthread_create(&th, NULL, modem_thread, NULL);
+    ret = iq_capture_run(&ctx, cfg);
+    modem_running = 0;
+    pthread_join(th, NULL);
+    iq_fake_close(&m);
+    return ret;
+}
+
+/* file content is stream bytes from pos on, returns file size */
+static uint64_t check_file(const char *name, uint64_t pos) {
+    static uint8_t buf[1024 * 1024];
+    uint64_t size = 0;
+    ssize_t len;
+    int fd;
+
+    fd = open(name, O_RDONLY);
+    IQ_CHECK(fd >= 0);
+    if (fd < 0)
+        return 0;
+    while ((len = read(fd, buf, sizeof(buf))) > 0) {
+        IQ_CHECK_EQ(iq_fake_pattern_check(buf, pos + size, len), len);
+        size += len;
+    }
+    close(fd);
+    unlink(name);
+    return size;
+}
+
+/* 20 MB and a partial buffer, rotated every 8 MB : 8 + 8 + 4 MB and the tail */
+static void test_rotate(void) {
+    iq_capture_cfg_t cfg = { .rotate_size = 8 * MB };
+    uint64_t total = 20 * MB + 6 * STEP, pos = 0;
+    char path[128], name[160];
+    uint32_t i;
+
+    snprintf(path, sizeof(path), "%s/rotate", dir);
+    IQ_CHECK_EQ(capture(path, total, &cfg), 0);
+    IQ_CHECK_EQ(cfg.written, total);
+    IQ_CHECK_EQ(cfg.dropped, 0);
+    IQ_CHECK_EQ(cfg.files, 3);
+    for (i = 0; i < 3; i++) {
+        snprintf(name, sizeof(name), "%s.%04u", path, i);
+        pos += check_file(name, pos);
+        IQ_CHECK_EQ(pos, i < 2 ? (i + 1) * 8 * MB : total);
+    }
+}
+
+/* no rotation : single file at path */
+static void test_single_file(void) {
+    iq_capture_cfg_t cfg = { 0 };
+    char path[128];
+
+    snprintf(path, sizeof(path), "%s/single", dir);
+    IQ_CHECK_EQ(capture(path, 3 * STEP, &cfg), 0);
+    IQ_CHECK_EQ(cfg.written, 3 * STEP);
+    IQ_CHECK_EQ(check_file(path, 0), 3 * STEP);
+}
+
+/* next rotated file can't be opened : capture ends by itself, rx loop included */
+static void test_open_error(void) {
+    iq_capture_cfg_t cfg = { .rotate_size = CAP_BUF_SIZE };
+    char path[128], name[160];
+
+    snprintf(path, sizeof(path), "%s/busy", dir);
+    snprintf(name, sizeof(name), "%s.0001", path);
+    IQ_CHECK_EQ(mkdir(name, 0755), 0);
+    IQ_CHECK_EQ(capture(path, 0, &cfg), EXIT_FAILURE);
+    IQ_CHECK_EQ(running, 1);
+    IQ_CHECK_EQ(cfg.written, CAP_BUF_SIZE);
+    rmdir(name);
+    snprintf(name, sizeof(name), "%s.0000", path);
+    IQ_CHECK_EQ(check_file(name, 0), CAP_BUF_SIZE);
+}
+
+/* write error (device full) */
+static void test_write_error(void) {
+    iq_capture_cfg_t cfg = { 0 };
+
+    IQ_CHECK_EQ(capture("/dev/full", 0, &cfg), EXIT_FAILURE);
+    IQ_CHECK_EQ(running, 1);
+    IQ_CHECK_EQ(cfg.written, 0);
+}
+
+int main(void) {
+    snprintf(dir, sizeof(dir), "%s", access("/dev/shm", W_OK) == 0 ? "/dev/shm/iq_capXXXXXX" : "/tmp/iq_capXXXXXX");
+    if (mkdtemp(dir) == NULL)
+        return 1;
+    IQ_TEST_RUN(test_rotate);
+    IQ_TEST_RUN(test_single_file);
+    IQ_TEST_RUN(test_open_error);
+    IQ_TEST_RUN(test_write_error);
+    rmdir(dir);
+    return IQ_TEST_EXIT();
+}
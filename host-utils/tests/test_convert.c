@@ -0,0 +1,150 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "lib_iqplayer_api.h"
+#include "iq_convert.h"
+#include "iq_fake_modem.h"
+#include "iq_test.h"
+
+/*
+ * Format conversion kernels (NEON / SSE2, selected at build time) bit exact with the scalar reference, i.e.
+ * iq_convert.c built again with IQ_CONVERT_SCALAR and ref_ prefixed symbols (see Makefile).
+ */
+void ref_iq_convert_to_cs16(int16_t *dst, const void *src, uint32_t nb_comp, uint32_t fmt, float scale);
+void ref_iq_convert_from_cs16(void *dst, const int16_t *src, uint32_t nb_comp, uint32_t fmt, float scale);
+
+#define NB_COMP 65536
+#define MAX_OFF 7
+
+static int16_t cs16[NB_COMP + MAX_OFF];
+static int8_t cs8[NB_COMP + MAX_OFF];
+static float cf32[NB_COMP + MAX_OFF];
+static uint8_t out[(NB_COMP + MAX_OFF) * 4], ref[(NB_COMP + MAX_OFF) * 4];
+
+static void fill_inputs(void) {
+    uint32_t i;
+
+    for (i = 0; i < NB_COMP + MAX_OFF; i++) {
+        cs16[i] = (int16_t)(i - 32768);
+        cs8[i] = (int8_t)i;
+        // rounding ties, full scale, saturation and random values
+        switch (i % 4) {
+        case 0:
+            cf32[i] = ((float)(int16_t)i + 0.5f) / 32768.0f;
+            break;
+        case 1:
+            cf32[i] = (float)(rand() % 400000 - 200000) / 100000.0f;
+            break;
+        case 2:
+            cf32[i] = (float)(int16_t)i / 32768.0f;
+            break;
+        default:
+            cf32[i] = (i & 4) ? INFINITY : -1e30f;
+            break;
+        }
+    }
+}
+
+static uint32_t fmt_size(uint32_t fmt) {
+    return iq_convert_sample_size(fmt) / 2;
+}
+
+/* every kernel, lengths with all tail sizes, source and destination at odd component offsets */
+static void check_fmt(uint32_t fmt, float scale) {
+    static const uint32_t lengths[] = {0, 1, 2, 3, 7, 8, 15, 16, 17, 31, 33, 63, 64, 65, 1000, NB_COMP};
+    const void *src = fmt == IQ_FMT_CS8 ? (const void *)cs8 : fmt == IQ_FMT_CS16 ? (const void *)cs16 : (const void *)cf32;
+    uint32_t l, off, n;
+
+    for (l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+        for (off = 0; off <= MAX_OFF; off += 3) {
+            n = lengths[l];
+            memset(out, 0x5a, sizeof(out));
+            memset(ref, 0x5a, sizeof(ref));
+            iq_convert_to_cs16((int16_t *)(out + off * 2), (const uint8_t *)src + off * fmt_size(fmt), n, fmt, scale);
+            ref_iq_convert_to_cs16((int16_t *)(ref + off * 2), (const uint8_t *)src + off * fmt_size(fmt), n, fmt, scale);
+            if (memcmp(out, ref, sizeof(out))) {
+                printf("  to_cs16 fmt %u scale %g n %u off %u\n", fmt, scale, n, off);
+                iq_test_failed++;
+                return;
+            }
+            memset(out, 0x5a, sizeof(out));
+            memset(ref, 0x5a, sizeof(ref));
+            iq_convert_from_cs16(out + off * fmt_size(fmt), cs16 + off, n, fmt, scale);
+            ref_iq_convert_from_cs16(ref + off * fmt_size(fmt), cs16 + off, n, fmt, scale);
+            if (memcmp(out, ref, sizeof(out))) {
+                printf("  from_cs16 fmt %u scale %g n %u off %u\n", fmt, scale, n, off);
+                iq_test_failed++;
+                return;
+            }
+        }
+    }
+}
+
+static void test_kernels_bit_exact(void) {
+    fill_inputs();
+    check_fmt(IQ_FMT_CS16, 0);
+    check_fmt(IQ_FMT_CS8, 0);
+    check_fmt(IQ_FMT_CF32, 0);
+    check_fmt(IQ_FMT_CF32_SCALED, 1000.0f);
+    check_fmt(IQ_FMT_CF32_SCALED, 40000.5f);
+}
+
+/* documented reference behaviour on a few values */
+static void test_reference_values(void) {
+    int16_t s16[4] = {32767, -32768, 127, -129};
+    float f32[4] = {1.0f, -1.5f, 0.5f / 32768.0f, 1.5f / 32768.0f};
+    int8_t s8[4];
+    int16_t d16[4];
+
+    ref_iq_convert_from_cs16(s8, s16, 4, IQ_FMT_CS8, 0);
+    IQ_CHECK_EQ(s8[0], 127);
+    IQ_CHECK_EQ(s8[1], -128);
+    IQ_CHECK_EQ(s8[2], 0);
+    IQ_CHECK_EQ(s8[3], -1);
+    ref_iq_convert_to_cs16(d16, s8, 4, IQ_FMT_CS8, 0);
+    IQ_CHECK_EQ(d16[0], 127 << 8);
+    IQ_CHECK_EQ(d16[1], -32768);
+    ref_iq_convert_to_cs16(d16, f32, 4, IQ_FMT_CF32, 0);
+    IQ_CHECK_EQ(d16[0], 32767);
+    IQ_CHECK_EQ(d16[1], -32768);
+    IQ_CHECK_EQ(d16[2], 0); /* ties to even */
+    IQ_CHECK_EQ(d16[3], 2);
+}
+
+/* sample counts close to 2^32 / 4 must not wrap once converted to bytes */
+static void test_fmt_count_overflow(void) {
+    static iq_fake_modem_t m;
+    static int16_t buf[16 * IQ_FAKE_DDR_STEP];
+    iq_player_t *p;
+
+    iq_fake_open(&m, 1);
+    iq_fake_tx_start(&m, 0, 16 * IQ_FAKE_DDR_STEP, 0);
+    iq_fake_rx_start(&m, 0, 0x100000, 16 * IQ_FAKE_DDR_STEP, 0);
+    p = iq_player_open(m.iqflood, m.iqflood_size, m.bar2);
+    iq_tx_init(iq_player_tx_stream(p), 0, 16 * IQ_FAKE_DDR_STEP);
+    iq_rx_init(iq_player_rx_stream(p, 0), 0x100000, 16 * IQ_FAKE_DDR_STEP);
+
+    // 0x40000001 * 4 wraps to 4 bytes in 32-bit
+    IQ_CHECK_EQ(iq_tx_send_fmt(iq_player_tx_stream(p), buf, 0x40000001, IQ_FMT_CS16, 0), 16 * IQ_FAKE_DDR_STEP / 4);
+    iq_fake_rx_write(&m, 0, buf, 4 * IQ_FAKE_DDR_STEP, false);
+    // 0x40000000 * 4 wraps to 0
+    IQ_CHECK_EQ(iq_rx_receive_fmt(iq_player_rx_stream(p, 0), buf, 0x40000000, IQ_FMT_CS16, 0), IQ_FAKE_DDR_STEP);
+    iq_player_close(p);
+    iq_fake_close(&m);
+}
+
+int main(void) {
+    IQ_TEST_RUN(test_kernels_bit_exact);
+    IQ_TEST_RUN(test_reference_values);
+    IQ_TEST_RUN(test_fmt_count_overflow);
+    return IQ_TEST_EXIT();
+}
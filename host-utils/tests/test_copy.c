@@ -0,0 +1,69 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "imx8-host.h"
+#include "iq_fake_modem.h"
+#include "iq_test.h"
+
+/* fused copy + cache maintenance kernels against memcpy : every size up to a few lines, aligned and not */
+#define MAX_SIZE (8 * CACHE_LINE_SIZE + 64)
+#define GUARD 0xa5
+
+static uint8_t src[MAX_SIZE + 2 * CACHE_LINE_SIZE] __attribute__((aligned(CACHE_LINE_SIZE)));
+static uint8_t dst[MAX_SIZE + 2 * CACHE_LINE_SIZE] __attribute__((aligned(CACHE_LINE_SIZE)));
+
+static int check_one(void (*copy)(void *, const void *, uint32_t), uint32_t dst_off, uint32_t src_off, uint32_t size) {
+    uint32_t i;
+
+    memset(dst, GUARD, sizeof(dst));
+    iq_fake_pattern_fill(src, 0, sizeof(src));
+    copy(dst + dst_off, src + src_off, size);
+    if (iq_fake_pattern_check(dst + dst_off, src_off, size) != size)
+        return 0;
+    for (i = 0; i < dst_off; i++)
+        if (dst[i] != GUARD)
+            return 0;
+    for (i = dst_off + size; i < sizeof(dst); i++)
+        if (dst[i] != GUARD)
+            return 0;
+    return 1;
+}
+
+static void check_kernel(void (*copy)(void *, const void *, uint32_t), const char *name) {
+    static const uint32_t offsets[] = {0, 4, 32, 60};
+    uint32_t size, d, s;
+
+    for (size = 0; size <= MAX_SIZE; size += 4) {
+        for (d = 0; d < 4; d++) {
+            for (s = 0; s < 4; s++) {
+                if (!check_one(copy, offsets[d], offsets[s], size)) {
+                    printf("  %s size %u dst +%u src +%u\n", name, size, offsets[d], offsets[s]);
+                    iq_test_failed++;
+                    return;
+                }
+            }
+        }
+    }
+}
+
+static void test_copy_flush_region(void) {
+    check_kernel(copy_flush_region, "copy_flush_region");
+}
+
+static void test_invalidate_copy_region(void) {
+    check_kernel(invalidate_copy_region, "invalidate_copy_region");
+}
+
+int main(void) {
+    IQ_TEST_RUN(test_copy_flush_region);
+    IQ_TEST_RUN(test_invalidate_copy_region);
+    return IQ_TEST_EXIT();
+}
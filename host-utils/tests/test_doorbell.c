@@ -0,0 +1,170 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "lib_iqplayer_api.h"
+#include "iq_fake_modem.h"
+#include "iq_test.h"
+
+#define TX_FIFO_START 0x0
+#define RX_FIFO_START 0x100000
+#define FIFO_SIZE (32 * IQ_FAKE_DDR_STEP)
+#define STEP IQ_FAKE_DDR_STEP
+
+static iq_fake_modem_t m;
+static iq_player_t *p;
+static uint8_t buf[FIFO_SIZE];
+
+static void open_modem(uint32_t min_size, uint32_t max_delay_us) {
+    iq_fake_open(&m, 1);
+    iq_fake_tx_start(&m, TX_FIFO_START, FIFO_SIZE, 0);
+    iq_fake_rx_start(&m, 0, RX_FIFO_START, FIFO_SIZE, 0);
+    p = iq_player_open(m.iqflood, m.iqflood_size, m.bar2);
+    IQ_CHECK(p != NULL);
+    iq_player_set_doorbell(p, min_size, max_delay_us);
+    IQ_CHECK_EQ(iq_tx_init(iq_player_tx_stream(p), TX_FIFO_START, FIFO_SIZE), 1);
+    IQ_CHECK_EQ(iq_rx_init(iq_player_rx_stream(p, 0), RX_FIFO_START, FIFO_SIZE), 1);
+}
+
+static void close_modem(void) {
+    iq_player_close(p);
+    iq_fake_close(&m);
+}
+
+/* default : every chunk is published */
+static void test_no_coalescing(void) {
+    iq_tx_stream_t *s;
+    uint64_t doorbells, chunks;
+    uint32_t i;
+
+    open_modem(0, 0);
+    s = iq_player_tx_stream(p);
+    for (i = 1; i <= 5; i++) {
+        IQ_CHECK_EQ(iq_tx_send(s, (uint32_t *)buf, STEP), STEP);
+        IQ_CHECK_EQ(iq_fake_host_produced(&m), i * STEP);
+    }
+    iq_tx_doorbell_stats(s, &doorbells, &chunks);
+    IQ_CHECK_EQ(doorbells, 5);
+    IQ_CHECK_EQ(chunks, 5);
+    close_modem();
+}
+
+/* tx : publish every min_size, or when modem backlog drops below min_size, or on flush / full fifo */
+static void test_tx_coalescing(void) {
+    iq_tx_stream_t *s;
+    uint64_t doorbells, chunks;
+    uint32_t i;
+
+    open_modem(8 * STEP, 0);
+    s = iq_player_tx_stream(p);
+    // modem backlog empty : rings
+    IQ_CHECK_EQ(iq_tx_send(s, (uint32_t *)buf, 8 * STEP), 8 * STEP);
+    IQ_CHECK_EQ(iq_fake_host_produced(&m), 8 * STEP);
+    for (i = 1; i < 8; i++) {
+        IQ_CHECK_EQ(iq_tx_send(s, (uint32_t *)buf, STEP), STEP);
+        IQ_CHECK_EQ(iq_fake_host_produced(&m), 8 * STEP);
+    }
+    IQ_CHECK_EQ(iq_tx_send(s, (uint32_t *)buf, STEP), STEP);
+    IQ_CHECK_EQ(iq_fake_host_produced(&m), 16 * STEP);
+
+    // modem drains to 6 steps of published backlog : next chunk rings
+    IQ_CHECK_EQ(iq_fake_tx_fetch(&m, NULL, 10 * STEP, false), 10 * STEP);
+    IQ_CHECK_EQ(iq_tx_send(s, (uint32_t *)buf, STEP), STEP);
+    IQ_CHECK_EQ(iq_fake_host_produced(&m), 17 * STEP);
+    IQ_CHECK_EQ(iq_tx_send(s, (uint32_t *)buf, 2 * STEP), 2 * STEP);
+    IQ_CHECK_EQ(iq_fake_host_produced(&m), 19 * STEP);
+
+    // backlog back to 9 steps : coalesced, flush publishes
+    IQ_CHECK_EQ(iq_tx_send(s, (uint32_t *)buf, STEP), STEP);
+    IQ_CHECK_EQ(iq_fake_host_produced(&m), 19 * STEP);
+    IQ_CHECK_EQ(iq_tx_send(s, (uint32_t *)buf, STEP), STEP);
+    IQ_CHECK_EQ(iq_fake_host_produced(&m), 19 * STEP);
+    iq_tx_flush(s);
+    IQ_CHECK_EQ(iq_fake_host_produced(&m), 21 * STEP);
+    // nothing pending, no doorbell
+    iq_tx_flush(s);
+    iq_tx_doorbell_stats(s, &doorbells, &chunks);
+    IQ_CHECK_EQ(doorbells, 5);
+    IQ_CHECK_EQ(chunks, 13);
+
+    // full fifo always rings
+    IQ_CHECK_EQ(iq_tx_send(s, (uint32_t *)buf, 2 * STEP), 2 * STEP);
+    IQ_CHECK_EQ(iq_fake_host_produced(&m), 21 * STEP);
+    while (iq_tx_send(s, (uint32_t *)buf, STEP) > 0)
+        ;
+    IQ_CHECK_EQ(iq_fake_host_produced(&m), m.tx_enqueued + FIFO_SIZE);
+    close_modem();
+}
+
+/* max delay : a pending chunk is published once max_delay_us elapsed */
+static void test_tx_max_delay(void) {
+    iq_tx_stream_t *s;
+
+    open_modem(8 * STEP, 1000);
+    s = iq_player_tx_stream(p);
+    IQ_CHECK_EQ(iq_tx_send(s, (uint32_t *)buf, 10 * STEP), 10 * STEP);
+    IQ_CHECK_EQ(iq_tx_send(s, (uint32_t *)buf, STEP), STEP);
+    IQ_CHECK_EQ(iq_fake_host_produced(&m), 10 * STEP);
+    usleep(2000);
+    IQ_CHECK_EQ(iq_tx_send(s, (uint32_t *)buf, STEP), STEP);
+    IQ_CHECK_EQ(iq_fake_host_produced(&m), 12 * STEP);
+    close_modem();
+}
+
+/* rx : release every min_size, or when modem room drops below min_size, or on empty fifo / flush */
+static void test_rx_coalescing(void) {
+    iq_rx_stream_t *s;
+    uint32_t i;
+
+    open_modem(8 * STEP, 0);
+    s = iq_player_rx_stream(p, 0);
+    IQ_CHECK_EQ(iq_fake_rx_write(&m, 0, buf, 16 * STEP, false), 16 * STEP);
+    for (i = 1; i < 8; i++) {
+        IQ_CHECK_EQ(iq_rx_receive(s, (uint32_t *)buf, STEP), STEP);
+        IQ_CHECK_EQ(iq_fake_host_consumed(&m, 0), 0);
+    }
+    IQ_CHECK_EQ(iq_rx_receive(s, (uint32_t *)buf, STEP), STEP);
+    IQ_CHECK_EQ(iq_fake_host_consumed(&m, 0), 8 * STEP);
+
+    // modem filled the fifo : room below min_size, each chunk rings
+    IQ_CHECK_EQ(iq_fake_rx_write(&m, 0, buf, FIFO_SIZE, false), 24 * STEP);
+    IQ_CHECK_EQ(iq_rx_receive(s, (uint32_t *)buf, STEP), STEP);
+    IQ_CHECK_EQ(iq_fake_host_consumed(&m, 0), 9 * STEP);
+
+    IQ_CHECK_EQ(iq_rx_receive(s, (uint32_t *)buf, STEP), STEP);
+    IQ_CHECK_EQ(iq_fake_host_consumed(&m, 0), 10 * STEP);
+    close_modem();
+
+    // empty fifo gives all room back
+    open_modem(8 * STEP, 0);
+    s = iq_player_rx_stream(p, 0);
+    IQ_CHECK_EQ(iq_fake_rx_write(&m, 0, buf, 2 * STEP, false), 2 * STEP);
+    IQ_CHECK_EQ(iq_rx_receive(s, (uint32_t *)buf, FIFO_SIZE), 2 * STEP);
+    IQ_CHECK_EQ(iq_fake_host_consumed(&m, 0), 0);
+    IQ_CHECK_EQ(iq_rx_receive(s, (uint32_t *)buf, FIFO_SIZE), 0);
+    IQ_CHECK_EQ(iq_fake_host_consumed(&m, 0), 2 * STEP);
+
+    // flush
+    IQ_CHECK_EQ(iq_fake_rx_write(&m, 0, buf, 2 * STEP, false), 2 * STEP);
+    IQ_CHECK_EQ(iq_rx_receive(s, (uint32_t *)buf, STEP), STEP);
+    IQ_CHECK_EQ(iq_fake_host_consumed(&m, 0), 2 * STEP);
+    iq_rx_flush(s);
+    IQ_CHECK_EQ(iq_fake_host_consumed(&m, 0), 3 * STEP);
+    close_modem();
+}
+
+int main(void) {
+    IQ_TEST_RUN(test_no_coalescing);
+    IQ_TEST_RUN(test_tx_coalescing);
+    IQ_TEST_RUN(test_tx_max_delay);
+    IQ_TEST_RUN(test_rx_coalescing);
+    return IQ_TEST_EXIT();
+}
@@ -0,0 +1,168 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "lib_iqplayer_api.h"
+#include "iq_fake_modem.h"
+#include "iq_test.h"
+
+#define TX_FIFO_START 0x0
+#define RX_FIFO_START 0x100000
+#define FIFO_SIZE (24 * IQ_FAKE_DDR_STEP)
+#define STEP IQ_FAKE_DDR_STEP
+#define RING_SIZE (64 * 1024)
+#define STREAM_SIZE (16ULL * 1024 * 1024)
+#define CHUNK (3 * STEP + 100)
+
+static iq_fake_modem_t m;
+static iq_player_t *p;
+static volatile uint32_t running;
+static uint32_t modem_errors;
+
+static void open_modem(void) {
+    iq_fake_open(&m, 1);
+    iq_fake_tx_start(&m, TX_FIFO_START, FIFO_SIZE, 0x100000000ULL - 5 * STEP);
+    iq_fake_rx_start(&m, 0, RX_FIFO_START, FIFO_SIZE, 0x100000000ULL - 5 * STEP);
+    p = iq_player_open(m.iqflood, m.iqflood_size, m.bar2);
+    IQ_CHECK(p != NULL);
+    iq_player_set_wait_policy(p, IQ_WAIT_YIELD, 0);
+    IQ_CHECK_EQ(iq_tx_init(iq_player_tx_stream(p), TX_FIFO_START, FIFO_SIZE), 1);
+    IQ_CHECK_EQ(iq_rx_init(iq_player_rx_stream(p, 0), RX_FIFO_START, FIFO_SIZE), 1);
+}
+
+static void close_modem(void) {
+    iq_player_close(p);
+    iq_fake_close(&m);
+}
+
+/* modem : checks tx data, produces rx data until STREAM_SIZE */
+static void *modem_thread(void *arg) {
+    uint8_t buf[4 * STEP];
+    uint64_t tx_pos = 0, rx_pos = 0;
+    uint32_t len;
+
+    (void)arg;
+    while (running) {
+        len = iq_fake_tx_fetch(&m, buf, sizeof(buf), false);
+        if (iq_fake_pattern_check(buf, tx_pos, len) != len)
+            modem_errors++;
+        tx_pos += len;
+        if (rx_pos < STREAM_SIZE) {
+            len = STREAM_SIZE - rx_pos < sizeof(buf) ? STREAM_SIZE - rx_pos : sizeof(buf);
+            iq_fake_pattern_fill(buf, rx_pos, len);
+            rx_pos += iq_fake_rx_write(&m, 0, buf, len, false);
+        }
+        sched_yield();
+    }
+    return NULL;
+}
+
+/* application writes odd sized blocks in the tx ring, reads odd sized blocks from the rx ring */
+static void test_feeders_stream(void) {
+    uint8_t buf[CHUNK];
+    uint64_t tx_pos = 0, rx_pos = 0, moved, lost, stalls;
+    iq_feeder_t *tx, *rx;
+    pthread_t th;
+    uint32_t len;
+    int ret;
+
+    open_modem();
+    tx = iq_tx_feeder_start(iq_player_tx_stream(p), RING_SIZE, -1, 0);
+    rx = iq_rx_feeder_start(iq_player_rx_stream(p, 0), RING_SIZE, -1, 0);
+    IQ_CHECK(tx != NULL && rx != NULL);
+    if (tx == NULL || rx == NULL)
+        return;
+    modem_errors = 0;
+    running = 1;
+    pthread_create(&th, NULL, modem_thread, NULL);
+
+    while (tx_pos < STREAM_SIZE || rx_pos < STREAM_SIZE) {
+        if (tx_pos < STREAM_SIZE) {
+            len = STREAM_SIZE - tx_pos < CHUNK ? STREAM_SIZE - tx_pos : CHUNK;
+            iq_fake_pattern_fill(buf, tx_pos, len);
+            ret = iq_feeder_write(tx, buf, len);
+            IQ_CHECK(ret >= 0 && ret <= (int)len);
+            tx_pos += ret;
+        }
+        ret = iq_feeder_read(rx, buf, CHUNK);
+        IQ_CHECK(ret >= 0);
+        if (ret > 0) {
+            IQ_CHECK_EQ(iq_fake_pattern_check(buf, rx_pos, ret), ret);
+            rx_pos += ret;
+        }
+        if (iq_test_failed)
+            break;
+        sched_yield();
+    }
+    // tx feeder drains its ring
+    while (m.tx_enqueued - (0x100000000ULL - 5 * STEP) < STREAM_SIZE && !iq_test_failed)
+        sched_yield();
+
+    running = 0;
+    pthread_join(th, NULL);
+    IQ_CHECK_EQ(modem_errors, 0);
+    IQ_CHECK_EQ(iq_feeder_read(tx, buf, CHUNK), -EINVAL);
+    IQ_CHECK_EQ(iq_feeder_write(rx, buf, CHUNK), -EINVAL);
+    iq_feeder_stats(tx, &moved, &lost, &stalls);
+    IQ_CHECK_EQ(moved, STREAM_SIZE);
+    IQ_CHECK_EQ(lost, 0);
+    iq_feeder_stats(rx, &moved, &lost, &stalls);
+    IQ_CHECK_EQ(moved, STREAM_SIZE);
+    IQ_CHECK_EQ(lost, 0);
+    iq_feeder_stop(tx);
+    iq_feeder_stop(rx);
+    close_modem();
+}
+
+/* application stops reading : feeder stalls on full ring, modem overrun shows up as lost bytes once it reads again */
+static void test_rx_feeder_overrun(void) {
+    uint8_t buf[FIFO_SIZE];
+    uint64_t moved, lost, stalls;
+    iq_feeder_t *rx;
+    uint32_t i;
+
+    open_modem();
+    rx = iq_rx_feeder_start(iq_player_rx_stream(p, 0), 4 * STEP, -1, 0);
+    IQ_CHECK(rx != NULL);
+    if (rx == NULL)
+        return;
+    iq_fake_rx_write(&m, 0, buf, 4 * STEP, false);
+    while (iq_feeder_stats(rx, &moved, &lost, &stalls), moved < 4 * STEP)
+        sched_yield();
+    for (i = 0; i < 3; i++)
+        iq_fake_rx_write(&m, 0, buf, FIFO_SIZE, true);
+    while (iq_feeder_stats(rx, &moved, &lost, &stalls), stalls == 0)
+        sched_yield();
+    // ring room back : feeder finds the overrun, then goes on with kept data
+    IQ_CHECK_EQ(iq_feeder_read(rx, buf, sizeof(buf)), 4 * STEP);
+    while (iq_feeder_stats(rx, &moved, &lost, &stalls), moved < 8 * STEP)
+        sched_yield();
+    IQ_CHECK_EQ(lost, 3 * FIFO_SIZE + STEP - FIFO_SIZE);
+    iq_feeder_stop(rx);
+    close_modem();
+}
+
+static void test_bad_ring_size(void) {
+    open_modem();
+    IQ_CHECK(iq_tx_feeder_start(iq_player_tx_stream(p), 3 * 4096, -1, 0) == NULL);
+    IQ_CHECK(iq_rx_feeder_start(iq_player_rx_stream(p, 0), 32, -1, 0) == NULL);
+    close_modem();
+}
+
+int main(void) {
+    IQ_TEST_RUN(test_feeders_stream);
+    IQ_TEST_RUN(test_rx_feeder_overrun);
+    IQ_TEST_RUN(test_bad_ring_size);
+    return IQ_TEST_EXIT();
+}
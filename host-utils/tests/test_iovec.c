@@ -0,0 +1,224 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/uio.h>
+
+#include "lib_iqplayer_api.h"
+#include "iq_fake_modem.h"
+#include "iq_test.h"
+
+/*
+ * Scatter/gather calls : iq_tx_sendv() / iq_rx_recvv() fill or drain the fifo across its wrap and across several
+ * user buffers in one call, published to modem with a single doorbell.
+ */
+#define TX_FIFO_START 0x0
+#define RX_FIFO_START 0x100000
+#define FIFO_SIZE (16 * IQ_FAKE_DDR_STEP)
+#define STEP IQ_FAKE_DDR_STEP
+#define MAX_IOV 64
+
+static iq_fake_modem_t m;
+static iq_player_t *p;
+static uint8_t buf[2 * FIFO_SIZE], out[FIFO_SIZE];
+static struct iovec iov[MAX_IOV];
+
+static void open_modem(void) {
+    iq_fake_open(&m, 1);
+    iq_fake_tx_start(&m, TX_FIFO_START, FIFO_SIZE, 0);
+    iq_fake_rx_start(&m, 0, RX_FIFO_START, FIFO_SIZE, 0);
+    p = iq_player_open(m.iqflood, m.iqflood_size, m.bar2);
+    IQ_CHECK(p != NULL);
+    IQ_CHECK_EQ(iq_tx_init(iq_player_tx_stream(p), TX_FIFO_START, FIFO_SIZE), 1);
+    IQ_CHECK_EQ(iq_rx_init(iq_player_rx_stream(p, 0), RX_FIFO_START, FIFO_SIZE), 1);
+}
+
+static void close_modem(void) {
+    iq_player_close(p);
+    iq_fake_close(&m);
+}
+
+/* split buf into iovecs of given lengths, returns iovec count */
+static int iov_split(const uint32_t *lens, int n) {
+    uint32_t off = 0;
+    int i;
+
+    for (i = 0; i < n; i++) {
+        iov[i].iov_base = buf + off;
+        iov[i].iov_len = lens[i];
+        off += lens[i];
+    }
+    return n;
+}
+
+/* tx fifo at offset, nothing pending at modem */
+static void tx_move_to(iq_tx_stream_t *s, uint32_t offset) {
+    IQ_CHECK_EQ(iq_tx_send(s, (uint32_t *)buf, offset), offset);
+    IQ_CHECK_EQ(iq_fake_tx_fetch(&m, NULL, offset, false), offset);
+}
+
+/* rx fifo at offset, nothing left for host */
+static void rx_move_to(iq_rx_stream_t *s, uint32_t offset) {
+    IQ_CHECK_EQ(iq_fake_rx_write(&m, 0, buf, offset, false), offset);
+    IQ_CHECK_EQ(iq_rx_receive(s, (uint32_t *)out, offset), offset);
+}
+
+/* odd sized buffers, an empty one, one straddling the fifo wrap : one call, one doorbell */
+static void test_tx_wrap(void) {
+    const uint32_t lens[] = {1000, 2 * STEP + 48, 0, 3 * STEP - 1048};
+    uint64_t db0, ch0, db, ch;
+    iq_tx_stream_t *s;
+
+    open_modem();
+    s = iq_player_tx_stream(p);
+    tx_move_to(s, 13 * STEP);
+    iq_tx_doorbell_stats(s, &db0, &ch0);
+
+    iq_fake_pattern_fill(buf, 13 * STEP, 5 * STEP);
+    IQ_CHECK_EQ(iq_tx_sendv(s, iov, iov_split(lens, 4)), 5 * STEP);
+    iq_tx_doorbell_stats(s, &db, &ch);
+    IQ_CHECK_EQ(db - db0, 1);
+    IQ_CHECK_EQ(ch - ch0, 1);
+    IQ_CHECK_EQ(iq_fake_host_produced(&m), 18 * STEP);
+
+    IQ_CHECK_EQ(iq_fake_tx_fetch(&m, out, FIFO_SIZE, false), 5 * STEP);
+    IQ_CHECK_EQ(iq_fake_pattern_check(out, 13 * STEP, 5 * STEP), 5 * STEP);
+    close_modem();
+}
+
+/* room for less than the buffers : sendv stops inside an iovec, full fifo returns 0 */
+static void test_tx_partial(void) {
+    const uint32_t lens[] = {STEP + 100, 2 * STEP, STEP - 100};
+    uint64_t db0, ch0, db, ch;
+    iq_tx_stream_t *s;
+
+    open_modem();
+    s = iq_player_tx_stream(p);
+    tx_move_to(s, 2 * STEP);
+    IQ_CHECK_EQ(iq_tx_send(s, (uint32_t *)buf, 14 * STEP), 14 * STEP);
+    iq_tx_doorbell_stats(s, &db0, &ch0);
+
+    iq_fake_pattern_fill(buf, 16 * STEP, 4 * STEP);
+    IQ_CHECK_EQ(iq_tx_sendv(s, iov, iov_split(lens, 3)), 2 * STEP);
+    iq_tx_doorbell_stats(s, &db, &ch);
+    IQ_CHECK_EQ(db - db0, 1);
+    IQ_CHECK_EQ(ch - ch0, 1);
+    IQ_CHECK_EQ(iq_fake_host_produced(&m), 18 * STEP);
+    IQ_CHECK_EQ(iq_tx_sendv(s, iov, 3), 0);
+
+    IQ_CHECK_EQ(iq_fake_tx_fetch(&m, NULL, 14 * STEP, false), 14 * STEP);
+    IQ_CHECK_EQ(iq_fake_tx_fetch(&m, out, FIFO_SIZE, false), 2 * STEP);
+    IQ_CHECK_EQ(iq_fake_pattern_check(out, 16 * STEP, 2 * STEP), 2 * STEP);
+    close_modem();
+}
+
+/* many buffers shorter than a cache line and than a DDR step, across the wrap */
+static void test_tx_short_buffers(void) {
+    uint32_t lens[MAX_IOV], i;
+    uint64_t db0, ch0, db, ch;
+    iq_tx_stream_t *s;
+
+    for (i = 0; i < MAX_IOV; i++)
+        lens[i] = 64 + (i & 1) * 8 - (i & 2) * 4;
+    open_modem();
+    s = iq_player_tx_stream(p);
+    tx_move_to(s, 15 * STEP);
+    iq_tx_doorbell_stats(s, &db0, &ch0);
+
+    iq_fake_pattern_fill(buf, 15 * STEP, 2 * STEP);
+    IQ_CHECK_EQ(iq_tx_sendv(s, iov, iov_split(lens, MAX_IOV)), 2 * STEP);
+    iq_tx_doorbell_stats(s, &db, &ch);
+    IQ_CHECK_EQ(db - db0, 1);
+    IQ_CHECK_EQ(iq_fake_tx_fetch(&m, out, FIFO_SIZE, false), 2 * STEP);
+    IQ_CHECK_EQ(iq_fake_pattern_check(out, 15 * STEP, 2 * STEP), 2 * STEP);
+    close_modem();
+}
+
+static void test_rx_wrap(void) {
+    const uint32_t lens[] = {1000, 2 * STEP + 48, 0, 3 * STEP - 1048};
+    uint64_t db0, ch0, db, ch;
+    iq_rx_stream_t *s;
+
+    open_modem();
+    s = iq_player_rx_stream(p, 0);
+    rx_move_to(s, 13 * STEP);
+    iq_rx_doorbell_stats(s, &db0, &ch0);
+
+    iq_fake_pattern_fill(out, 13 * STEP, 5 * STEP);
+    IQ_CHECK_EQ(iq_fake_rx_write(&m, 0, out, 5 * STEP, false), 5 * STEP);
+    memset(buf, 0, sizeof(buf));
+    IQ_CHECK_EQ(iq_rx_recvv(s, iov, iov_split(lens, 4)), 5 * STEP);
+    iq_rx_doorbell_stats(s, &db, &ch);
+    IQ_CHECK_EQ(db - db0, 1);
+    IQ_CHECK_EQ(ch - ch0, 1);
+    IQ_CHECK_EQ(iq_fake_host_consumed(&m, 0), 18 * STEP);
+    IQ_CHECK_EQ(iq_fake_pattern_check(buf, 13 * STEP, 5 * STEP), 5 * STEP);
+    close_modem();
+}
+
+/* less data than buffers : last iovec partly filled, the ones after untouched, empty fifo returns 0 */
+static void test_rx_partial(void) {
+    const uint32_t lens[] = {STEP + 100, 2 * STEP, STEP - 100};
+    uint64_t db0, ch0, db, ch;
+    iq_rx_stream_t *s;
+    uint32_t i;
+
+    open_modem();
+    s = iq_player_rx_stream(p, 0);
+    rx_move_to(s, 15 * STEP);
+    iq_rx_doorbell_stats(s, &db0, &ch0);
+
+    iq_fake_pattern_fill(out, 15 * STEP, 2 * STEP);
+    IQ_CHECK_EQ(iq_fake_rx_write(&m, 0, out, 2 * STEP, false), 2 * STEP);
+    memset(buf, 0xAA, sizeof(buf));
+    IQ_CHECK_EQ(iq_rx_recvv(s, iov, iov_split(lens, 3)), 2 * STEP);
+    iq_rx_doorbell_stats(s, &db, &ch);
+    IQ_CHECK_EQ(db - db0, 1);
+    IQ_CHECK_EQ(ch - ch0, 1);
+    IQ_CHECK_EQ(iq_fake_host_consumed(&m, 0), 17 * STEP);
+    IQ_CHECK_EQ(iq_fake_pattern_check(buf, 15 * STEP, 2 * STEP), 2 * STEP);
+    for (i = 2 * STEP; i < 4 * STEP; i++) {
+        if (buf[i] != 0xAA)
+            break;
+    }
+    IQ_CHECK_EQ(i, 4 * STEP);
+    IQ_CHECK_EQ(iq_rx_recvv(s, iov, 3), 0);
+    close_modem();
+}
+
+static void test_rx_short_buffers(void) {
+    uint32_t lens[MAX_IOV], i;
+    uint64_t db0, ch0, db, ch;
+    iq_rx_stream_t *s;
+
+    for (i = 0; i < MAX_IOV; i++)
+        lens[i] = 64 + (i & 1) * 8 - (i & 2) * 4;
+    open_modem();
+    s = iq_player_rx_stream(p, 0);
+    rx_move_to(s, 15 * STEP);
+    iq_rx_doorbell_stats(s, &db0, &ch0);
+
+    iq_fake_pattern_fill(out, 15 * STEP, 2 * STEP);
+    IQ_CHECK_EQ(iq_fake_rx_write(&m, 0, out, 2 * STEP, false), 2 * STEP);
+    IQ_CHECK_EQ(iq_rx_recvv(s, iov, iov_split(lens, MAX_IOV)), 2 * STEP);
+    iq_rx_doorbell_stats(s, &db, &ch);
+    IQ_CHECK_EQ(db - db0, 1);
+    IQ_CHECK_EQ(iq_fake_pattern_check(buf, 15 * STEP, 2 * STEP), 2 * STEP);
+    close_modem();
+}
+
+int main(void) {
+    IQ_TEST_RUN(test_tx_wrap);
+    IQ_TEST_RUN(test_tx_partial);
+    IQ_TEST_RUN(test_tx_short_buffers);
+    IQ_TEST_RUN(test_rx_wrap);
+    IQ_TEST_RUN(test_rx_partial);
+    IQ_TEST_RUN(test_rx_short_buffers);
+    return IQ_TEST_EXIT();
+}
@@ -0,0 +1,161 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "iq_event.h"
+#include "iq_test.h"
+
+/*
+ * Event driven main loop dispatcher (iq_event.h) : poll period, level DMA events and progress reruns, then a
+ * host model of EVENT_LOOP=1 firmware, a fake DMA engine and a TX pipeline stepped like PUSH_TX_DATA()
+ * (4 channel DDR read, QEC, AXIQ write), run by the polling loop and by the dispatcher. Host flow control is a
+ * proxy write that raises no event, only the poll period sees it.
+ */
+#define CH_AXIQ 11
+#define CH_DDR_RD 7
+#define DDR_RD_MASK (0xFU << CH_DDR_RD)
+#define DDR_RD_ROUNDS 300 /* rounds per DDR read */
+#define AXIQ_ROUNDS 400   /* rounds per chunk played */
+#define STAGE_MBOX 0
+#define STAGE_TX 1
+
+typedef struct {
+    uint32_t comp; /* DMA_COMP_STAT */
+    uint32_t rd_busy, rd_end, ax_busy, ax_end;
+    uint32_t host_ready, enqueued, fetched, qeced, axiq, played, underruns;
+    uint32_t runs;
+} sim_t;
+
+static void sim_dma_tick(sim_t *s, uint32_t now) {
+    if (s->rd_busy && now >= s->rd_end) {
+        s->rd_busy = 0;
+        s->comp |= DDR_RD_MASK;
+    }
+    if (s->ax_busy && now >= s->ax_end) {
+        s->ax_busy = 0;
+        s->comp |= 1U << CH_AXIQ;
+    }
+}
+
+/* one PUSH_TX_DATA() pass, returns 1 when a pipeline counter moved */
+static uint32_t sim_push_tx(sim_t *s, uint32_t now) {
+    uint32_t seq = s->enqueued + s->fetched + s->qeced + s->axiq + s->played;
+
+    s->runs++;
+    if (s->comp & (1U << CH_AXIQ)) {
+        s->comp &= ~(1U << CH_AXIQ);
+        s->played++;
+    }
+    // multi DMA read completes once all its channels did
+    if ((s->comp & DDR_RD_MASK) == DDR_RD_MASK) {
+        s->comp &= ~DDR_RD_MASK;
+        s->fetched++;
+    }
+    if (!s->rd_busy && s->enqueued < s->host_ready && s->enqueued - s->qeced < 4) {
+        s->rd_busy = 1;
+        s->rd_end = now + DDR_RD_ROUNDS;
+        s->enqueued++;
+    }
+    if (s->fetched > s->qeced && s->qeced - s->played < 3)
+        s->qeced++;
+    if (!s->ax_busy) {
+        if (s->qeced > s->axiq) {
+            s->ax_busy = 1;
+            s->ax_end = now + AXIQ_ROUNDS;
+            s->axiq++;
+        } else if (s->played) {
+            s->underruns++;
+        }
+    }
+    return s->enqueued + s->fetched + s->qeced + s->axiq + s->played != seq;
+}
+
+static void sim_run(sim_t *s, iq_ev_t *ev, uint32_t rounds, uint32_t host_period) {
+    uint32_t t;
+
+    memset(s, 0, sizeof(*s));
+    if (ev) {
+        iq_ev_init(ev, IQ_EV_POLL_PERIOD);
+        iq_ev_stage(ev, STAGE_MBOX, IQ_EV_MBOX0 | IQ_EV_POLL);
+        iq_ev_stage(ev, STAGE_TX, (1U << CH_AXIQ) | DDR_RD_MASK | IQ_EV_POLL);
+    }
+    for (t = 0; t < rounds; t++) {
+        if (t % host_period == 0)
+            s->host_ready++;
+        sim_dma_tick(s, t);
+        if (ev == NULL)
+            sim_push_tx(s, t);
+        else if ((iq_ev_dispatch(ev, s->comp & IQ_EV_DMA_MASK) & (1U << STAGE_TX)) && sim_push_tx(s, t))
+            iq_ev_progress(ev, STAGE_TX);
+    }
+}
+
+static void test_poll_period(void) {
+    iq_ev_t ev;
+    uint32_t round, run;
+
+    iq_ev_init(&ev, 8);
+    iq_ev_stage(&ev, 0, IQ_EV_POLL);
+    iq_ev_stage(&ev, 2, 1);
+    IQ_CHECK_EQ(ev.nb_stages, 3);
+    for (round = 0; round < 80; round++) {
+        run = iq_ev_dispatch(&ev, 0);
+        IQ_CHECK_EQ(!!(run & 1), round % 8 == 7);
+        IQ_CHECK_EQ(run & 4, 0);
+    }
+    IQ_CHECK_EQ(ev.runs[0], 10);
+    IQ_CHECK_EQ(ev.runs[1], 0);
+    IQ_CHECK_EQ(ev.runs[2], 0);
+    IQ_CHECK_EQ(ev.rounds, 80);
+    IQ_CHECK_EQ(ev.idle_rounds, 70);
+}
+
+static void test_level_and_progress(void) {
+    iq_ev_t ev;
+
+    iq_ev_init(&ev, IQ_EV_POLL_PERIOD);
+    iq_ev_stage(&ev, 0, IQ_EV_MBOX0);
+    iq_ev_stage(&ev, 1, 0x3);
+    // a DMA status bit left set keeps waking its stage
+    IQ_CHECK_EQ(iq_ev_dispatch(&ev, 0x2), 2);
+    IQ_CHECK_EQ(iq_ev_dispatch(&ev, 0x2), 2);
+    IQ_CHECK_EQ(iq_ev_dispatch(&ev, IQ_EV_MBOX0 | 0x4), 1);
+    // progress reruns once, with no event
+    iq_ev_progress(&ev, 1);
+    IQ_CHECK_EQ(iq_ev_dispatch(&ev, 0), 2);
+    IQ_CHECK_EQ(iq_ev_dispatch(&ev, 0), 0);
+    IQ_CHECK_EQ(ev.runs[1], 3);
+    IQ_CHECK_EQ(ev.idle_rounds, 1);
+}
+
+/* same chunks played as the polling loop, with far fewer stage runs, streaming and host throttled */
+static void test_tx_pipeline(void) {
+    static const uint32_t host_period[] = { 100, 500 };
+    sim_t poll, event;
+    iq_ev_t ev;
+    uint32_t i;
+
+    for (i = 0; i < 2; i++) {
+        sim_run(&poll, NULL, 1000000, host_period[i]);
+        sim_run(&event, &ev, 1000000, host_period[i]);
+        printf("  host chunk every %3u rounds : poll %7u runs %4u played | event %6u runs %4u played, %u idle\n",
+               host_period[i], poll.runs, poll.played, event.runs, event.played, ev.idle_rounds);
+        IQ_CHECK(event.played + 2 >= poll.played);
+        IQ_CHECK(event.runs * 10 < poll.runs);
+        IQ_CHECK_EQ(event.runs, ev.runs[STAGE_TX]);
+    }
+}
+
+int main(void) {
+    IQ_TEST_RUN(test_poll_period);
+    IQ_TEST_RUN(test_level_and_progress);
+    IQ_TEST_RUN(test_tx_pipeline);
+    return IQ_TEST_EXIT();
+}
@@ -0,0 +1,272 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#define IQMOD_RX_1T1R
+#include "iqmod_rx.h"
+#include "iqmod_tx.h"
+#include "iq_bfp.h"
+#include "iq_rx_budget.h"
+#include "iq_sched.h"
+#include "iq_test.h"
+
+/*
+ * Full duplex DDR DMA arbitration (iq_sched.h) : gate semantics, and a host model of 1T1R firmware streaming
+ * both ways under DDR contention, run with the policy off (fixed channel counts, greedy DMAs, firmware before
+ * iq_sched.h) and on (as PUSH_TX_DATA() / PUSH_RX_DATA() call it), cs16 and BFP compressed TX.
+ *
+ * Model, time stepped at 20ns over 200ms, cs16 at 122.88 MSPS both ways, BFP at the TX_BFP firmware rate
+ * (15.36 MSPS both ways, scalar expansion does not fit higher rates, iq_rx_budget.h) :
+ *  - TX : DDR reads of one chunk (TX_DDR_STEP, or its BFP size) into TX_NUM_BUF + TX_NUM_QEC_BUF DMEM chunks,
+ *    a BFP chunk is playable once expanded (IQ_TXB_BFP_CYCLES of VCPU, one chunk at a time),
+ *    the DAC plays from DMEM once started, missing bytes are lost (underrun).
+ *  - RX : the ADC fills a 4KB AXIQ fifo, AXIQ reads move chunks to RX_NUM_BUF + RX_NUM_QEC_BUF DMEM chunks,
+ *    DDR writes empty them, bytes the ADC finds no room for are lost (overflow).
+ *  - DDR DMA bandwidth per channel count is the LA9310 measurement of iqmod_tx.c / iqmod_rx.c, reads and writes
+ *    share the DDR bandwidth, which dips at random (other bus masters). AXIQ reads slow down while TX DDR reads
+ *    hold the 4 AXI read slots.
+ * Prints lost bytes per scenario, checks the policy never loses more than the greedy baseline and BFP TX never
+ * underruns.
+ */
+#define STEP TX_DDR_STEP
+#define TX_CAP ((TX_NUM_BUF + TX_NUM_QEC_BUF) * STEP)
+#define RX_CAP ((RX_NUM_BUF + RX_NUM_QEC_BUF) * RX_DDR_STEP)
+#define AXIQ_FIFO 4096
+#define SIM_DT 0.02         /* us */
+#define SIM_T 200000.0      /* us */
+#define SIM_DAC_START 50.0  /* us, TX prefetch before DAC starts */
+#define SIM_RATE 491.52     /* B/us, 122.88 MSPS cs16 */
+#define SIM_RATE_BFP 61.44  /* B/us, 15.36 MSPS, Sources/Makefile TX_BFP_KSPS */
+#define SIM_BFP_EXPAND (IQ_TXB_BFP_CYCLES * 1000.0 / IQ_RXB_VSPA_KHZ) /* us per chunk */
+#define SIM_AXIQ_RD 2000.0  /* B/us */
+#define SIM_AXIQ_RD_4 300.0 /* B/us, AXI read slots held by 4 TX DDR reads */
+
+typedef struct {
+    double ddr_bw; /* B/us shared by DDR reads and writes */
+    double dip_bw; /* B/us during dips */
+    double rate;   /* B/us, ADC and DAC */
+    uint32_t cmp_width;
+} sim_cfg_t;
+
+typedef struct {
+    double under;
+    double over;
+    uint32_t deferred[2];
+    uint32_t ch_switch[2];
+} sim_res_t;
+
+/* imx_dma / firmware measurements, B/us */
+static double sim_rd_bw(uint32_t nb) {
+    return nb == 1 ? 200 : nb == 2 ? 393 : 590;
+}
+
+static double sim_wr_bw(uint32_t nb) {
+    return nb == 1 ? 490 : 529;
+}
+
+/* same dips for every run of a scenario */
+static uint32_t sim_rand(uint32_t *seed) {
+    *seed = *seed * 1103515245 + 12345;
+    return (*seed >> 8) & 0xFFFFFF;
+}
+
+static sim_res_t sim_run(const sim_cfg_t *c, int use_sched) {
+    iq_sched_t s = { { IQ_SCHED_IDLE, IQ_SCHED_IDLE } };
+    double rd_size = c->cmp_width ? IQ_BFP_CHUNK_SIZE(STEP, c->cmp_width) : STEP;
+    double tx_fetched = 0, tx_enqueued = 0, tx_played = 0, rd_left = 0, tx_raw = 0, exp_left = 0;
+    double axiq = 0, rx_enqueued = 0, rx_read = 0, rx_written = 0, rx_done = 0, wr_left = 0, ax_left = 0;
+    double t, bw, rd, wr, share, need, dip_end = -1;
+    uint32_t rd_nb = 2, wr_nb = 1, tx_ready, rx_ready, seed = 1;
+    sim_res_t r;
+
+    memset(&r, 0, sizeof(r));
+    // firmware defaults : 2 TX read, 1 RX write channels, channel count left to firmware, as iqmod_tx.c / iqmod_rx.c
+    iq_sched_start(&s, IQ_SCHED_TX, STEP, use_sched && !c->cmp_width, !c->cmp_width, 1, rd_nb, 4);
+    iq_sched_start(&s, IQ_SCHED_RX, RX_DDR_STEP, use_sched, 1, 1, wr_nb, 2);
+    for (t = 0; t < SIM_T; t += SIM_DT) {
+        if (t > dip_end && sim_rand(&seed) % 100000 < 3)
+            dip_end = t + 10 + sim_rand(&seed) % 40;
+        bw = t < dip_end ? c->dip_bw : c->ddr_bw;
+
+        // firmware pass : publish slack and readiness, adapt channel count between transfers, gate
+        tx_ready = tx_enqueued - tx_played <= TX_CAP - STEP;
+        rx_ready = rx_read - rx_written >= RX_DDR_STEP;
+        if (use_sched) {
+            iq_sched_update(&s, IQ_SCHED_TX, (uint32_t)(tx_fetched - tx_played), tx_ready);
+            iq_sched_update(&s, IQ_SCHED_RX, (uint32_t)(RX_CAP - (rx_enqueued - rx_done)), rx_ready);
+            if (rd_left <= 0)
+                rd_nb = iq_sched_ch_nb(&s, IQ_SCHED_TX, rd_nb);
+            if (wr_left <= 0)
+                wr_nb = iq_sched_ch_nb(&s, IQ_SCHED_RX, wr_nb);
+            tx_ready = tx_ready && iq_sched_may_issue(&s, IQ_SCHED_TX);
+            rx_ready = rx_ready && iq_sched_may_issue(&s, IQ_SCHED_RX);
+        }
+        if (tx_ready && rd_left <= 0) {
+            rd_left = rd_size;
+            tx_enqueued += STEP;
+        }
+        if (rx_ready && wr_left <= 0) {
+            wr_left = RX_DDR_STEP;
+            rx_written += RX_DDR_STEP;
+        }
+        if (ax_left <= 0 && axiq >= RX_DDR_STEP && rx_enqueued - rx_done <= RX_CAP - RX_DDR_STEP) {
+            ax_left = RX_DDR_STEP;
+            rx_enqueued += RX_DDR_STEP;
+            axiq -= RX_DDR_STEP;
+        }
+
+        // DMAs share DDR bandwidth
+        rd = rd_left > 0 ? sim_rd_bw(rd_nb) : 0;
+        wr = wr_left > 0 ? sim_wr_bw(wr_nb) : 0;
+        share = rd + wr > bw ? bw / (rd + wr) : 1;
+        if (rd_left > 0) {
+            rd_left -= rd * share * SIM_DT;
+            if (rd_left <= 0)
+                tx_raw += STEP;
+        }
+        if (wr_left > 0) {
+            wr_left -= wr * share * SIM_DT;
+            if (wr_left <= 0)
+                rx_done += RX_DDR_STEP;
+        }
+        if (ax_left > 0) {
+            ax_left -= (rd_left > 0 && rd_nb == 4 ? SIM_AXIQ_RD_4 : SIM_AXIQ_RD) * SIM_DT;
+            if (ax_left <= 0)
+                rx_read += RX_DDR_STEP;
+        }
+
+        // VCPU expands fetched BFP chunks one at a time
+        if (!c->cmp_width)
+            tx_fetched = tx_raw;
+        else if (exp_left > 0) {
+            exp_left -= SIM_DT;
+            if (exp_left <= 0)
+                tx_fetched += STEP;
+        } else if (tx_raw - tx_fetched >= STEP)
+            exp_left = SIM_BFP_EXPAND;
+
+        // converters
+        axiq += c->rate * SIM_DT;
+        if (axiq > AXIQ_FIFO) {
+            r.over += axiq - AXIQ_FIFO;
+            axiq = AXIQ_FIFO;
+        }
+        if (t > SIM_DAC_START) {
+            need = c->rate * SIM_DT;
+            if (tx_fetched - tx_played >= need)
+                tx_played += need;
+            else
+                r.under += need;
+        }
+    }
+    memcpy(r.deferred, s.deferred, sizeof(r.deferred));
+    memcpy(r.ch_switch, s.ch_switch, sizeof(r.ch_switch));
+    return r;
+}
+
+static void test_gate(void) {
+    iq_sched_t s = { { IQ_SCHED_IDLE, IQ_SCHED_IDLE } };
+    uint32_t guard = IQ_SCHED_GUARD_CHUNKS * STEP;
+
+    iq_sched_start(&s, IQ_SCHED_TX, STEP, 1, 1, 1, 2, 4);
+    iq_sched_start(&s, IQ_SCHED_RX, STEP, 1, 1, 1, 1, 2);
+    // other direction stopped or not urgent : never held back
+    iq_sched_update(&s, IQ_SCHED_TX, 4 * STEP, 1);
+    IQ_CHECK(iq_sched_may_issue(&s, IQ_SCHED_TX));
+    iq_sched_update(&s, IQ_SCHED_RX, guard, 1);
+    IQ_CHECK(iq_sched_may_issue(&s, IQ_SCHED_TX));
+    // rx urgent with the earlier deadline and a DMA ready : tx waits, rx does not
+    iq_sched_update(&s, IQ_SCHED_RX, guard - 1, 1);
+    IQ_CHECK(!iq_sched_may_issue(&s, IQ_SCHED_TX));
+    IQ_CHECK(iq_sched_may_issue(&s, IQ_SCHED_RX));
+    IQ_CHECK_EQ(s.deferred[IQ_SCHED_TX], 1);
+    // nothing to write : no reason to hold tx
+    iq_sched_update(&s, IQ_SCHED_RX, guard - 1, 0);
+    IQ_CHECK(iq_sched_may_issue(&s, IQ_SCHED_TX));
+    // both urgent : earlier deadline first
+    iq_sched_update(&s, IQ_SCHED_RX, 0, 1);
+    iq_sched_update(&s, IQ_SCHED_TX, guard - 1, 1);
+    IQ_CHECK(!iq_sched_may_issue(&s, IQ_SCHED_TX));
+    IQ_CHECK(iq_sched_may_issue(&s, IQ_SCHED_RX));
+    // compressed tx (yield 0) : never held back
+    iq_sched_start(&s, IQ_SCHED_TX, STEP, 0, 0, 1, 2, 2);
+    iq_sched_update(&s, IQ_SCHED_TX, 4 * STEP, 1);
+    IQ_CHECK(iq_sched_may_issue(&s, IQ_SCHED_TX));
+    IQ_CHECK_EQ(s.deferred[IQ_SCHED_TX], 0);
+    // stopped direction
+    iq_sched_stop(&s, IQ_SCHED_RX);
+    iq_sched_update(&s, IQ_SCHED_TX, 0, 1);
+    IQ_CHECK(iq_sched_may_issue(&s, IQ_SCHED_TX));
+}
+
+static void test_ch_nb(void) {
+    iq_sched_t s = { { IQ_SCHED_IDLE, IQ_SCHED_IDLE } };
+    uint32_t guard = IQ_SCHED_GUARD_CHUNKS * STEP;
+
+    // host set the count : kept
+    iq_sched_start(&s, IQ_SCHED_TX, STEP, 0, 1, 1, 3, 4);
+    iq_sched_update(&s, IQ_SCHED_TX, 0, 1);
+    IQ_CHECK_EQ(iq_sched_ch_nb(&s, IQ_SCHED_TX, 3), 3);
+
+    iq_sched_start(&s, IQ_SCHED_TX, STEP, 1, 1, 1, 2, 4);
+    iq_sched_start(&s, IQ_SCHED_RX, STEP, 1, 1, 1, 1, 2);
+    iq_sched_update(&s, IQ_SCHED_RX, 6 * STEP, 1);
+    iq_sched_update(&s, IQ_SCHED_TX, 6 * STEP, 1);
+    IQ_CHECK_EQ(iq_sched_ch_nb(&s, IQ_SCHED_TX, 2), 2);
+    // urgent : ch_max, held until slack is back over twice the guard
+    iq_sched_update(&s, IQ_SCHED_TX, guard - 1, 1);
+    IQ_CHECK_EQ(iq_sched_ch_nb(&s, IQ_SCHED_TX, 2), 4);
+    iq_sched_update(&s, IQ_SCHED_TX, 2 * guard - 1, 1);
+    IQ_CHECK_EQ(iq_sched_ch_nb(&s, IQ_SCHED_TX, 4), 4);
+    iq_sched_update(&s, IQ_SCHED_TX, 2 * guard, 1);
+    IQ_CHECK_EQ(iq_sched_ch_nb(&s, IQ_SCHED_TX, 4), 2);
+    // rx urgent : tx reads leave AXI read slots to AXIQ
+    iq_sched_update(&s, IQ_SCHED_RX, guard - 1, 1);
+    IQ_CHECK_EQ(iq_sched_ch_nb(&s, IQ_SCHED_TX, 2), 1);
+    IQ_CHECK_EQ(iq_sched_ch_nb(&s, IQ_SCHED_RX, 1), 2);
+    IQ_CHECK_EQ(s.ch_switch[IQ_SCHED_TX], 3);
+    IQ_CHECK_EQ(s.ch_switch[IQ_SCHED_RX], 1);
+}
+
+static void test_full_duplex_model(void) {
+    static const double ddr_bw[] = { 1100, 1000, 950 }, dip_bw[] = { 700, 500 };
+    static const uint32_t cmp[] = { 0, IQ_BFP_WIDTH_DEFAULT };
+    sim_res_t a, b;
+    sim_cfg_t c;
+    uint32_t i, j, k;
+
+    for (k = 0; k < 2; k++) {
+        for (i = 0; i < 3; i++) {
+            for (j = 0; j < 2; j++) {
+                c.ddr_bw = ddr_bw[i];
+                c.dip_bw = dip_bw[j];
+                c.cmp_width = cmp[k];
+                c.rate = k ? SIM_RATE_BFP : SIM_RATE;
+                a = sim_run(&c, 0);
+                b = sim_run(&c, 1);
+                printf("  tx %-5s %6.2f MSPS ddr %4.0f dip %3.0f MB/s : lost %5.2f -> %5.2f MB (under %5.2f over %5.2f, "
+                       "deferred %u/%u, switches %u/%u)\n",
+                       k ? "bfp9" : "cs16", c.rate / 4, c.ddr_bw, c.dip_bw, (a.under + a.over) / 1e6, (b.under + b.over) / 1e6,
+                       b.under / 1e6, b.over / 1e6, b.deferred[0], b.deferred[1], b.ch_switch[0], b.ch_switch[1]);
+                IQ_CHECK(b.under + b.over <= a.under + a.over);
+                // expansion keeps up at the TX_BFP rate
+                if (c.cmp_width)
+                    IQ_CHECK_EQ(b.under, 0);
+            }
+        }
+    }
+}
+
+int main(void) {
+    IQ_TEST_RUN(test_gate);
+    IQ_TEST_RUN(test_ch_nb);
+    IQ_TEST_RUN(test_full_duplex_model);
+    return IQ_TEST_EXIT();
+}
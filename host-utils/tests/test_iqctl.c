@@ -0,0 +1,237 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "vspa_dmem_proxy.h"
+#include "iqctl.h"
+#include "iq_test.h"
+
+/*
+ * iqctl against the fake mailbox (iqctl_open_fake()) : tx / rx / stats command words as the firmware decodes them,
+ * argument checks that must not reach the mailbox, fake firmware replies, and round trip time accounting.
+ */
+#define SHM_NAME "/iq_test_iqctl"
+#define LOG_SIZE 16
+#define SLOW_NS 200000
+
+/* recording vspa : logs every command, acks it after delay_ns */
+typedef struct {
+    uint32_t msb[LOG_SIZE];
+    uint32_t lsb[LOG_SIZE];
+    uint32_t nb;
+    uint64_t delay_ns;
+} cmd_log_t;
+
+static iqctl_t vspa, host;
+static pthread_t th;
+static cmd_log_t cmd_log;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint32_t record_handler(void *arg, uint32_t msb, uint32_t lsb, uint32_t *rsp_msb) {
+    cmd_log_t *l = arg;
+    uint64_t end = now_ns() + l->delay_ns;
+
+    if (l->nb < LOG_SIZE) {
+        l->msb[l->nb] = msb;
+        l->lsb[l->nb] = lsb;
+    }
+    __atomic_store_n(&l->nb, l->nb + 1, __ATOMIC_RELEASE);
+    while (now_ns() < end)
+        ;
+    *rsp_msb = 0;
+    return 0x1;
+}
+
+static void *record_thread(void *arg) {
+    vspa_mbox_mock_serve(&vspa.mbox, record_handler, &cmd_log, 0);
+    return NULL;
+}
+
+static void *fake_thread(void *arg) {
+    iqctl_fake_vspa(&vspa, 0);
+    return NULL;
+}
+
+static void open_fake(void *(*vspa_fn)(void *)) {
+    memset(&cmd_log, 0, sizeof(cmd_log));
+    IQ_CHECK_EQ(iqctl_open_fake(&vspa, SHM_NAME), 0);
+    IQ_CHECK_EQ(iqctl_open_fake(&host, SHM_NAME), 0);
+    pthread_create(&th, NULL, vspa_fn, NULL);
+}
+
+static void close_fake(void) {
+    vspa_mbox_mock_stop(&vspa.mbox);
+    pthread_join(th, NULL);
+    iqctl_close(&host);
+    iqctl_close(&vspa);
+    shm_unlink(SHM_NAME);
+}
+
+/* last logged command */
+static uint32_t last_msb(void) {
+    return cmd_log.msb[cmd_log.nb - 1];
+}
+
+static uint32_t last_lsb(void) {
+    return cmd_log.lsb[cmd_log.nb - 1];
+}
+
+static void test_tx_words(void) {
+    uint32_t addr = IQCTL_FAKE_IQFLOOD_MODEM_ADDR, max_4k = (IQCTL_FAKE_IQFLOOD_SIZE - VSPA_DMEM_PROXY_SIZE) / 4096;
+
+    open_fake(record_thread);
+    IQ_CHECK_EQ(iqctl_tx_fifo_start(&host, 16, 0, false, 0), 0);
+    IQ_CHECK_EQ(last_msb(), MBOX_CMD_OPC(MBOX_OPC_IQ_MOD_TX) | MBOX_IQMOD_START | MBOX_IQMOD_SIZE_4K(16));
+    IQ_CHECK_EQ(last_lsb(), addr);
+
+    // half duplex multi burst, BFP9 fifo
+    IQ_CHECK_EQ(iqctl_tx_fifo_start(&host, max_4k, 2, true, 9), 0);
+    IQ_CHECK_EQ(last_msb(), MBOX_CMD_OPC(MBOX_OPC_IQ_MOD_TX) | MBOX_IQMOD_START | MBOX_IQMOD_DMA_CH(2) | MBOX_IQMOD_TX_MBURST |
+                                MBOX_IQMOD_SIZE_4K(max_4k) | MBOX_IQMOD_TX_CMP);
+    IQ_CHECK_EQ(last_lsb(), addr | 9);
+
+    IQ_CHECK_EQ(iqctl_tx_replay_start(&host, 8, 0, false), 0);
+    IQ_CHECK_EQ(last_msb(),
+                MBOX_CMD_OPC(MBOX_OPC_IQ_MOD_TX) | MBOX_IQMOD_START | MBOX_IQMOD_FC_DISABLE | MBOX_IQMOD_SIZE_4K(8));
+    IQ_CHECK_EQ(last_lsb(), addr);
+
+    IQ_CHECK_EQ(iqctl_tx_stop(&host), 0);
+    IQ_CHECK_EQ(last_msb(), MBOX_CMD_OPC(MBOX_OPC_IQ_MOD_TX));
+    IQ_CHECK_EQ(last_lsb(), 0);
+    IQ_CHECK_EQ(cmd_log.nb, 4);
+
+    // rejected before the mailbox : fifo over the proxy, empty fifo, width out of field
+    IQ_CHECK_EQ(iqctl_tx_fifo_start(&host, max_4k + 1, 0, false, 0), -EINVAL);
+    IQ_CHECK_EQ(iqctl_tx_fifo_start(&host, 0, 0, false, 0), -EINVAL);
+    IQ_CHECK_EQ(iqctl_tx_fifo_start(&host, 16, 0, false, MBOX_IQMOD_TX_CMP_WIDTH_MASK + 1), -EINVAL);
+    IQ_CHECK_EQ(iqctl_tx_replay_start(&host, max_4k + 1, 0, false), -EINVAL);
+    IQ_CHECK_EQ(cmd_log.nb, 4);
+    close_fake();
+}
+
+static void test_rx_words(void) {
+    uint32_t addr = IQCTL_FAKE_IQFLOOD_MODEM_ADDR + IQCTL_FAKE_IQFLOOD_SIZE / 2, half_4k = IQCTL_FAKE_IQFLOOD_SIZE / 2 / 4096;
+
+    open_fake(record_thread);
+    IQ_CHECK_EQ(iqctl_rx_fifo_start(&host, half_4k, 0, 0), 0);
+    IQ_CHECK_EQ(last_msb(), MBOX_CMD_OPC(MBOX_OPC_IQ_MOD_RX) | MBOX_IQMOD_START | MBOX_IQMOD_RX_CONTINUOUS |
+                                MBOX_IQMOD_SIZE_4K(half_4k));
+    IQ_CHECK_EQ(last_lsb(), addr);
+
+    IQ_CHECK_EQ(iqctl_rx_fifo_start(&host, 32, 1, 8), 0);
+    IQ_CHECK_EQ(last_msb(), MBOX_CMD_OPC(MBOX_OPC_IQ_MOD_RX) | MBOX_IQMOD_START | MBOX_IQMOD_RX_CONTINUOUS |
+                                MBOX_IQMOD_DMA_CH(1) | MBOX_IQMOD_SIZE_4K(32) | MBOX_IQMOD_RX_CMP);
+    IQ_CHECK_EQ(last_lsb(), addr | 8);
+
+    IQ_CHECK_EQ(iqctl_rx_capture_start(&host, 4, 0), 0);
+    IQ_CHECK_EQ(last_msb(),
+                MBOX_CMD_OPC(MBOX_OPC_IQ_MOD_RX) | MBOX_IQMOD_START | MBOX_IQMOD_FC_DISABLE | MBOX_IQMOD_SIZE_4K(4));
+    IQ_CHECK_EQ(last_lsb(), addr);
+
+    IQ_CHECK_EQ(iqctl_rx_msi_config(&host, 4, 2), 0);
+    IQ_CHECK_EQ(last_msb(), MBOX_CMD_OPC(MBOX_OPC_MSI) | MBOX_MSI_CONFIG | MBOX_MSI_WATERMARK(2) | MBOX_MSI_EVERY(4));
+
+    IQ_CHECK_EQ(iqctl_rx_stop(&host), 0);
+    IQ_CHECK_EQ(last_msb(), MBOX_CMD_OPC(MBOX_OPC_IQ_MOD_RX));
+    IQ_CHECK_EQ(last_lsb(), 0);
+    IQ_CHECK_EQ(cmd_log.nb, 5);
+
+    // rx lives in upper half of iqflood
+    IQ_CHECK_EQ(iqctl_rx_fifo_start(&host, half_4k + 1, 0, 0), -EINVAL);
+    IQ_CHECK_EQ(iqctl_rx_fifo_start(&host, 32, 0, MBOX_IQMOD_RX_CMP_WIDTH_MASK + 1), -EINVAL);
+    IQ_CHECK_EQ(iqctl_rx_capture_start(&host, 0, 0), -EINVAL);
+    IQ_CHECK_EQ(cmd_log.nb, 5);
+    close_fake();
+}
+
+static void test_stats_words(void) {
+    uint32_t val;
+
+    open_fake(record_thread);
+    IQ_CHECK_EQ(iqctl_stats_read(&host, 5, false, &val), 0);
+    IQ_CHECK_EQ(last_msb(), MBOX_CMD_OPC(MBOX_OPC_GET_STATS_COUNT) | MBOX_STATS_IDX(5));
+    IQ_CHECK_EQ(iqctl_stats_read(&host, 0, true, &val), 0);
+    IQ_CHECK_EQ(last_msb(), MBOX_CMD_OPC(MBOX_OPC_GET_STATS_COUNT) | MBOX_STATS_RST | MBOX_STATS_IDX(0));
+    close_fake();
+}
+
+/* fake firmware replies : stats counter in ack MSB, reset, NACK of an out of range dma channel */
+static void test_fake_replies(void) {
+    uint32_t val = ~0U, i;
+
+    open_fake(fake_thread);
+    for (i = 0; i < 3; i++) {
+        IQ_CHECK_EQ(iqctl_stats_read(&host, 3, false, &val), 0);
+        IQ_CHECK_EQ(val, i);
+    }
+    IQ_CHECK_EQ(iqctl_stats_read(&host, 3, true, &val), 0);
+    IQ_CHECK_EQ(val, 3);
+    IQ_CHECK_EQ(iqctl_stats_read(&host, 3, false, &val), 0);
+    IQ_CHECK_EQ(val, 0);
+
+    IQ_CHECK_EQ(iqctl_tx_fifo_start(&host, 16, 5, false, 0), -EIO);
+    IQ_CHECK_EQ(host.mbox.stats.nacks, 1);
+    IQ_CHECK_EQ(host.mbox.stats.count, 6);
+    close_fake();
+}
+
+/* round trip covers the vspa service time, batch rtt feeds stats, no reply is a timeout */
+static void test_rtt(void) {
+    vspa_mbox_msg_t msgs[LOG_SIZE];
+    uint32_t i;
+
+    open_fake(record_thread);
+    cmd_log.delay_ns = SLOW_NS;
+    IQ_CHECK_EQ(iqctl_tx_stop(&host), 0);
+    IQ_CHECK(host.mbox.stats.last_ns >= SLOW_NS);
+
+    vspa_mbox_stats_reset(&host.mbox);
+    memset(msgs, 0, sizeof(msgs));
+    for (i = 0; i < LOG_SIZE; i++)
+        msgs[i].msb = MBOX_CMD_OPC(MBOX_OPC_EMPTY_2);
+    IQ_CHECK_EQ(vspa_mbox_send_batch(&host.mbox, msgs, LOG_SIZE), LOG_SIZE);
+    IQ_CHECK_EQ(host.mbox.stats.count, LOG_SIZE);
+    IQ_CHECK(host.mbox.stats.min_ns >= SLOW_NS);
+    IQ_CHECK(host.mbox.stats.max_ns >= host.mbox.stats.min_ns);
+    for (i = 0; i < LOG_SIZE; i++) {
+        IQ_CHECK_EQ(msgs[i].ret, 0);
+        IQ_CHECK(msgs[i].rtt_ns >= host.mbox.stats.min_ns && msgs[i].rtt_ns <= host.mbox.stats.max_ns);
+    }
+
+    // vspa gone
+    vspa_mbox_mock_stop(&vspa.mbox);
+    pthread_join(th, NULL);
+    host.mbox.timeout_us = 1000;
+    IQ_CHECK_EQ(iqctl_rx_stop(&host), -ETIMEDOUT);
+    IQ_CHECK_EQ(host.mbox.stats.timeouts, 1);
+    IQ_CHECK_EQ(host.mbox.stats.count, LOG_SIZE);
+    iqctl_close(&host);
+    iqctl_close(&vspa);
+    shm_unlink(SHM_NAME);
+}
+
+int main(void) {
+    IQ_TEST_RUN(test_tx_words);
+    IQ_TEST_RUN(test_rx_words);
+    IQ_TEST_RUN(test_stats_words);
+    IQ_TEST_RUN(test_fake_replies);
+    IQ_TEST_RUN(test_rtt);
+    return IQ_TEST_EXIT();
+}
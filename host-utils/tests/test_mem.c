@@ -0,0 +1,84 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "lib_iqplayer_api.h"
+#include "iq_test.h"
+
+/* iq_mem_alloc() : 2MB aligned, size rounded up to 2MB and mapped, resident at return, fully unmapped on free */
+#define HUGE_SIZE (2 * 1024 * 1024UL)
+
+/* pages of [buf, buf + size) resident in memory, -1 when any part is not mapped */
+static long resident_pages(void *buf, size_t size) {
+    size_t page = sysconf(_SC_PAGESIZE), n = (size + page - 1) / page, i;
+    unsigned char *vec = malloc(n);
+    long count = 0;
+
+    if (vec == NULL)
+        return -1;
+    if (mincore(buf, size, vec)) {
+        free(vec);
+        return errno == ENOMEM ? -1 : -2;
+    }
+    for (i = 0; i < n; i++)
+        count += vec[i] & 1;
+    free(vec);
+    return count;
+}
+
+static void test_zero_size(void) {
+    IQ_CHECK(iq_mem_alloc(0) == NULL);
+    iq_mem_free(NULL, 0);
+}
+
+static void test_alignment_rounding(void) {
+    static const size_t sizes[] = {1, 4096, HUGE_SIZE - 1, HUGE_SIZE, HUGE_SIZE + 1, 5 * HUGE_SIZE + 12345};
+    size_t page = sysconf(_SC_PAGESIZE), rounded, i;
+    uint8_t *buf;
+
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        rounded = (sizes[i] + HUGE_SIZE - 1) / HUGE_SIZE * HUGE_SIZE;
+        buf = iq_mem_alloc(sizes[i]);
+        IQ_CHECK(buf != NULL);
+        if (buf == NULL)
+            continue;
+        IQ_CHECK_EQ((uintptr_t)buf % HUGE_SIZE, 0);
+        // whole rounded window mapped and prefaulted, nothing mapped right after it (trimmed slack)
+        IQ_CHECK_EQ(resident_pages(buf, rounded), rounded / page);
+        IQ_CHECK_EQ(resident_pages(buf + rounded, page), -1);
+        memset(buf, 0x5a, rounded);
+        IQ_CHECK(buf[0] == 0x5a && buf[rounded - 1] == 0x5a);
+        iq_mem_free(buf, sizes[i]);
+        IQ_CHECK_EQ(resident_pages(buf, rounded), -1);
+    }
+}
+
+static void test_free_unmaps_rounded(void) {
+    uint8_t *a, *b;
+
+    // freeing with the requested (unrounded) size releases the whole 2MB window
+    a = iq_mem_alloc(HUGE_SIZE + 1);
+    b = iq_mem_alloc(HUGE_SIZE);
+    IQ_CHECK(a != NULL && b != NULL);
+    iq_mem_free(a, HUGE_SIZE + 1);
+    IQ_CHECK_EQ(resident_pages(a, 2 * HUGE_SIZE), -1);
+    IQ_CHECK(resident_pages(b, HUGE_SIZE) > 0);
+    iq_mem_free(b, HUGE_SIZE);
+}
+
+int main(void) {
+    IQ_TEST_RUN(test_zero_size);
+    IQ_TEST_RUN(test_alignment_rounding);
+    IQ_TEST_RUN(test_free_unmaps_rounded);
+    return IQ_TEST_EXIT();
+}
@@ -0,0 +1,193 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "lib_iqplayer_api.h"
+#include "iq_fake_modem.h"
+#include "iq_test.h"
+
+/*
+ * Two modems in one process, each with TX and two RX channels driven by their own thread, while a modem
+ * thread per instance moves data. Every byte crossing a fifo is checked against the stream pattern.
+ */
+#define NB_MODEM 2
+#define NB_RX 2
+#define STEP IQ_FAKE_DDR_STEP
+#define TX_FIFO_START 0x0
+#define TX_FIFO_SIZE (24 * STEP)
+#define RX_FIFO_START(c) (0x100000 + (c) * 0x40000)
+#define RX_FIFO_SIZE (20 * STEP)
+#define STREAM_SIZE (64ULL * 1024 * 1024)
+#define CHUNK (5 * STEP)
+
+typedef struct {
+    iq_fake_modem_t m;
+    iq_player_t *p;
+    uint32_t id;
+    volatile uint32_t running;
+    uint32_t errors;
+} modem_ctx_t;
+
+typedef struct {
+    modem_ctx_t *mc;
+    uint32_t chan;
+    uint32_t errors;
+} stream_ctx_t;
+
+static modem_ctx_t modems[NB_MODEM];
+
+/* stream pattern offset, so that a byte landing in the wrong stream or modem is caught */
+static inline uint64_t stream_base(uint32_t modem, uint32_t stream) {
+    return ((uint64_t)modem << 44) | ((uint64_t)stream << 40);
+}
+
+static void *modem_thread(void *arg) {
+    modem_ctx_t *mc = arg;
+    uint8_t *buf = malloc(CHUNK);
+    uint64_t tx_pos = 0, rx_pos[NB_RX] = {0};
+    uint32_t chan, len;
+    bool idle;
+
+    while (mc->running) {
+        idle = true;
+        if (tx_pos < STREAM_SIZE) {
+            len = iq_fake_tx_fetch(&mc->m, buf, CHUNK, false);
+            if (len) {
+                if (iq_fake_pattern_check(buf, stream_base(mc->id, 0) + tx_pos, len) != len)
+                    mc->errors++;
+                tx_pos += len;
+                idle = false;
+            }
+        }
+        for (chan = 0; chan < NB_RX; chan++) {
+            if (rx_pos[chan] >= STREAM_SIZE)
+                continue;
+            iq_fake_pattern_fill(buf, stream_base(mc->id, 1 + chan) + rx_pos[chan], CHUNK);
+            len = STREAM_SIZE - rx_pos[chan] < CHUNK ? STREAM_SIZE - rx_pos[chan] : CHUNK;
+            len = iq_fake_rx_write(&mc->m, chan, buf, len, false);
+            rx_pos[chan] += len;
+            if (len)
+                idle = false;
+        }
+        if (idle)
+            sched_yield();
+    }
+    free(buf);
+    return NULL;
+}
+
+static void *tx_thread(void *arg) {
+    stream_ctx_t *sc = arg;
+    iq_tx_stream_t *s = iq_player_tx_stream(sc->mc->p);
+    uint8_t *buf = malloc(CHUNK);
+    uint64_t pos = 0;
+    uint32_t len;
+    int ret;
+
+    while (pos < STREAM_SIZE) {
+        len = CHUNK - (pos / STEP % 3) * STEP;
+        if (len > STREAM_SIZE - pos)
+            len = STREAM_SIZE - pos;
+        iq_fake_pattern_fill(buf, stream_base(sc->mc->id, 0) + pos, len);
+        ret = iq_tx_send_wait(s, (uint32_t *)buf, len, IQ_WAIT_FOREVER);
+        if (ret != (int)len) {
+            sc->errors++;
+            break;
+        }
+        pos += len;
+    }
+    iq_tx_flush(s);
+    free(buf);
+    return NULL;
+}
+
+static void *rx_thread(void *arg) {
+    stream_ctx_t *sc = arg;
+    iq_rx_stream_t *s = iq_player_rx_stream(sc->mc->p, sc->chan);
+    uint8_t *buf = malloc(CHUNK);
+    uint64_t pos = 0;
+    int ret;
+
+    while (pos < STREAM_SIZE) {
+        ret = iq_rx_receive_wait(s, (uint32_t *)buf, STEP, CHUNK, IQ_WAIT_FOREVER);
+        if (ret <= 0 || iq_fake_pattern_check(buf, stream_base(sc->mc->id, 1 + sc->chan) + pos, ret) != (uint32_t)ret) {
+            sc->errors++;
+            break;
+        }
+        pos += ret;
+    }
+    free(buf);
+    return NULL;
+}
+
+static void test_two_modems_threads(void) {
+    pthread_t mt[NB_MODEM], st[NB_MODEM][1 + NB_RX];
+    stream_ctx_t sc[NB_MODEM][1 + NB_RX];
+    modem_ctx_t *mc;
+    uint32_t i, k;
+
+    for (i = 0; i < NB_MODEM; i++) {
+        mc = &modems[i];
+        mc->id = i;
+        IQ_CHECK_EQ(iq_fake_open(&mc->m, NB_RX), 0);
+        iq_fake_tx_start(&mc->m, TX_FIFO_START, TX_FIFO_SIZE, 0xffffff00000ULL * i);
+        for (k = 0; k < NB_RX; k++)
+            iq_fake_rx_start(&mc->m, k, RX_FIFO_START(k), RX_FIFO_SIZE, 0xfffff000ULL * (i + k));
+        mc->p = iq_player_open(mc->m.iqflood, mc->m.iqflood_size, mc->m.bar2);
+        IQ_CHECK(mc->p != NULL);
+        IQ_CHECK_EQ(iq_player_rx_num_chan(mc->p), NB_RX);
+        iq_player_set_wait_policy(mc->p, IQ_WAIT_YIELD, 0);
+        IQ_CHECK_EQ(iq_tx_init(iq_player_tx_stream(mc->p), TX_FIFO_START, TX_FIFO_SIZE), 1);
+        for (k = 0; k < NB_RX; k++)
+            IQ_CHECK_EQ(iq_rx_init(iq_player_rx_stream(mc->p, k), RX_FIFO_START(k), RX_FIFO_SIZE), 1);
+        mc->running = 1;
+        pthread_create(&mt[i], NULL, modem_thread, mc);
+    }
+    // streams of one player do not share state with each other
+    IQ_CHECK((uint8_t *)iq_player_rx_stream(modems[0].p, 1) - (uint8_t *)iq_player_rx_stream(modems[0].p, 0) >= 64);
+
+    for (i = 0; i < NB_MODEM; i++) {
+        for (k = 0; k < 1 + NB_RX; k++) {
+            sc[i][k].mc = &modems[i];
+            sc[i][k].chan = k - 1;
+            sc[i][k].errors = 0;
+            pthread_create(&st[i][k], NULL, k ? rx_thread : tx_thread, &sc[i][k]);
+        }
+    }
+    for (i = 0; i < NB_MODEM; i++) {
+        for (k = 0; k < 1 + NB_RX; k++) {
+            pthread_join(st[i][k], NULL);
+            IQ_CHECK_EQ(sc[i][k].errors, 0);
+        }
+    }
+    for (i = 0; i < NB_MODEM; i++) {
+        mc = &modems[i];
+        // modem fetches last tx data once host stopped
+        while (mc->m.tx_enqueued - 0xffffff00000ULL * i < STREAM_SIZE)
+            sched_yield();
+        mc->running = 0;
+        pthread_join(mt[i], NULL);
+        IQ_CHECK_EQ(mc->errors, 0);
+        IQ_CHECK_EQ(iq_fake_host_produced(&mc->m), 0xffffff00000ULL * i + STREAM_SIZE);
+        for (k = 0; k < NB_RX; k++)
+            IQ_CHECK_EQ(iq_fake_host_consumed(&mc->m, k), 0xfffff000ULL * (i + k) + STREAM_SIZE);
+        IQ_CHECK_EQ(iq_tx_lost_size(iq_player_tx_stream(mc->p)), 0);
+        iq_player_close(mc->p);
+        iq_fake_close(&mc->m);
+    }
+}
+
+int main(void) {
+    IQ_TEST_RUN(test_two_modems_threads);
+    return IQ_TEST_EXIT();
+}
@@ -0,0 +1,99 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include "lib_iqplayer_api.h"
+#include "iq_fake_modem.h"
+#include "iq_test.h"
+
+/*
+ * 64-bit flow counters (32-bit low word + _hi epoch) : streams start just below 1, 2 and 3 times 4GB and run
+ * across the 32-bit wrap with fifo sizes that are not a power of 2, so a modulo on a 32-bit counter would
+ * put host and modem at different fifo offsets.
+ */
+#define TX_FIFO_START 0x0
+#define RX_FIFO_START 0x100000
+#define STEP IQ_FAKE_DDR_STEP
+#define STREAM_SIZE (48ULL * 1024 * 1024)
+#define CHUNK (7 * STEP)
+
+static iq_fake_modem_t m;
+static uint8_t buf[CHUNK], out[CHUNK];
+
+static void run(uint64_t base, uint32_t fifo_size) {
+    iq_tx_stream_t *tx;
+    iq_rx_stream_t *rx;
+    uint64_t tx_pos = 0, rx_pos = 0, host_tx = 0, host_rx = 0;
+    uint32_t len;
+    iq_player_t *p;
+    int ret;
+
+    iq_fake_open(&m, 1);
+    iq_fake_tx_start(&m, TX_FIFO_START, fifo_size, base);
+    iq_fake_rx_start(&m, 0, RX_FIFO_START, fifo_size, base);
+    p = iq_player_open(m.iqflood, m.iqflood_size, m.bar2);
+    tx = iq_player_tx_stream(p);
+    rx = iq_player_rx_stream(p, 0);
+    IQ_CHECK_EQ(iq_tx_init(tx, TX_FIFO_START, fifo_size), 1);
+    IQ_CHECK_EQ(iq_rx_init(rx, RX_FIFO_START, fifo_size), 1);
+
+    while (rx_pos < STREAM_SIZE || tx_pos < STREAM_SIZE) {
+        // host side, odd sizes so that calls end anywhere in a chunk
+        len = CHUNK - (host_tx / STEP % 5) * 1000;
+        iq_fake_pattern_fill(buf, host_tx, len);
+        ret = iq_tx_send(tx, (uint32_t *)buf, len);
+        IQ_CHECK(ret >= 0);
+        host_tx += ret > 0 ? ret : 0;
+        ret = iq_rx_receive(rx, (uint32_t *)out, CHUNK - (host_rx / STEP % 3) * 1000);
+        IQ_CHECK(ret >= 0);
+        if (ret > 0) {
+            IQ_CHECK_EQ(iq_fake_pattern_check(out, host_rx, ret), ret);
+            host_rx += ret;
+        }
+
+        // modem side
+        len = iq_fake_tx_fetch(&m, out, CHUNK, false);
+        IQ_CHECK_EQ(iq_fake_pattern_check(out, tx_pos, len), len);
+        tx_pos += len;
+        iq_fake_pattern_fill(buf, rx_pos, CHUNK);
+        rx_pos += iq_fake_rx_write(&m, 0, buf, CHUNK, false);
+        if (iq_test_failed)
+            break;
+    }
+    IQ_CHECK_EQ(iq_fake_host_produced(&m), base + host_tx);
+    IQ_CHECK_EQ(m.wo->host_produced_size_hi, (base + host_tx) >> 32);
+    IQ_CHECK_EQ(m.wo->host_consumed_size_hi[0], (base + host_rx) >> 32);
+    IQ_CHECK_EQ(iq_tx_lost_size(tx), 0);
+    IQ_CHECK_EQ(iq_rx_lost_size(rx), 0);
+    iq_player_close(p);
+    iq_fake_close(&m);
+}
+
+static void test_wrap_non_pow2_fifo(void) {
+    static const uint32_t fifo_size[] = {23 * STEP, 37 * STEP, 64 * STEP};
+    uint64_t k;
+    uint32_t i;
+
+    for (k = 1; k <= 3; k++) {
+        for (i = 0; i < sizeof(fifo_size) / sizeof(fifo_size[0]); i++) {
+            run((uint64_t)((k << 32) - STREAM_SIZE / 2), fifo_size[i]);
+            if (iq_test_failed) {
+                printf("  base %" PRIx64 " fifo %u\n", (uint64_t)((k << 32) - STREAM_SIZE / 2), fifo_size[i]);
+                return;
+            }
+        }
+    }
+}
+
+int main(void) {
+    IQ_TEST_RUN(test_wrap_non_pow2_fifo);
+    return IQ_TEST_EXIT();
+}
@@ -0,0 +1,124 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "vspa_dmem_proxy.h"
+#include "iqctl.h"
+#include "iq_test.h"
+
+/*
+ * MBOX_OPC_IQ_CORR_BLOCK with negative taps / DC : the block must reach VSPA bit exact, i.e. a raw DMA read
+ * (DMAC_RD). A DMAC_RDC read converts every 16 bit half from two's complement to sign-magnitude, modelled here,
+ * which corrupts negative floats and fails the checksum.
+ */
+#define SHM_NAME "/iq_test_qec_block"
+
+static iqctl_t vspa, host;
+static pthread_t th;
+
+static const float taps[MBOX_QEC_BLOCK_NB_TAPS] = {-1.0f, 0.5f,     -0.25f, -0.001f, 0.0f, -3.5f,
+                                                   2.0f,  -0.0625f, 0.75f,  -0.5f,   1e-6f, -1e-6f};
+
+static void *vspa_thread(void *arg) {
+    iqctl_fake_vspa(&vspa, 0);
+    return NULL;
+}
+
+static void open_fake(void) {
+    iqctl_open_fake(&vspa, SHM_NAME);
+    iqctl_open_fake(&host, SHM_NAME);
+    pthread_create(&th, NULL, vspa_thread, NULL);
+}
+
+static void close_fake(void) {
+    vspa_mbox_mock_stop(&vspa.mbox);
+    pthread_join(th, NULL);
+    iqctl_close(&host);
+    iqctl_close(&vspa);
+    shm_unlink(SHM_NAME);
+}
+
+static void block_fill(mbox_qec_block_t *blk) {
+    uint32_t i;
+
+    iqctl_qec_block_init(blk, true, 0, true);
+    for (i = 0; i < MBOX_QEC_BLOCK_NB_TAPS; i++)
+        iqctl_qec_block_set_tap(blk, i, taps[i]);
+    iqctl_qec_block_set_dc(blk, -0.125f, -7.0f);
+    iqctl_qec_block_set_delay(blk, 3);
+}
+
+/* DMAC_RDC : 16 bit two's complement to sign-magnitude */
+static void dma_rdc_model(void *dst, const void *src, uint32_t size) {
+    const int16_t *s = src;
+    uint16_t *d = dst;
+    uint32_t i;
+
+    for (i = 0; i < size / 2; i++)
+        d[i] = s[i] < 0 ? 0x8000 | (uint16_t)-s[i] : (uint16_t)s[i];
+}
+
+static void test_negative_taps_raw(void) {
+    mbox_qec_block_t blk, vspa_view;
+
+    block_fill(&blk);
+    iqctl_qec_block_seal(&blk);
+    memcpy(&vspa_view, &blk, sizeof(blk));
+    IQ_CHECK_EQ(iqctl_qec_block_validate(&vspa_view), 0);
+    IQ_CHECK(vspa_view.ftaps[0] == -1.0f && vspa_view.ftaps[11] == -1e-6f && vspa_view.dc_q == -7.0f);
+}
+
+static void test_negative_taps_rdc(void) {
+    mbox_qec_block_t blk, vspa_view;
+
+    block_fill(&blk);
+    iqctl_qec_block_seal(&blk);
+    dma_rdc_model(&vspa_view, &blk, sizeof(blk));
+    IQ_CHECK(vspa_view.ftaps[0] != -1.0f);
+    IQ_CHECK_EQ(iqctl_qec_block_validate(&vspa_view), MBOX_QEC_BLOCK_ERR_CHECKSUM);
+}
+
+static void test_load(void) {
+    uint32_t offset = IQCTL_FAKE_IQFLOOD_SIZE - VSPA_DMEM_PROXY_SIZE - MBOX_QEC_BLOCK_SIZE, err = 0, seq;
+    mbox_qec_block_t blk;
+    const mbox_qec_block_t *staged;
+    uint32_t i;
+
+    open_fake();
+    staged = (const mbox_qec_block_t *)(host.iqflood + offset);
+    block_fill(&blk);
+    IQ_CHECK_EQ(iqctl_qec_load(&host, &blk, &err), 0);
+    IQ_CHECK_EQ(blk.seq, 1);
+    for (i = 0; i < MBOX_QEC_BLOCK_NB_TAPS; i++)
+        IQ_CHECK(staged->ftaps[i] == taps[i]);
+    IQ_CHECK(staged->dc_i == -0.125f && staged->dc_q == -7.0f);
+
+    // same block as a sign-magnitude read would deliver it : NACK with checksum error
+    dma_rdc_model(host.iqflood + offset, &blk, sizeof(blk));
+    IQ_CHECK_EQ(iqctl_cmd(&host, MBOX_CMD_OPC(MBOX_OPC_IQ_CORR_BLOCK), IQCTL_FAKE_IQFLOOD_MODEM_ADDR + offset, &seq, NULL),
+                -EIO);
+    IQ_CHECK_EQ(seq, MBOX_QEC_BLOCK_ERR_CHECKSUM);
+
+    // next load acked with its own sequence number
+    IQ_CHECK_EQ(iqctl_qec_load(&host, &blk, &err), 0);
+    IQ_CHECK_EQ(blk.seq, 2);
+    close_fake();
+}
+
+int main(void) {
+    IQ_TEST_RUN(test_negative_taps_raw);
+    IQ_TEST_RUN(test_negative_taps_rdc);
+    IQ_TEST_RUN(test_load);
+    return IQ_TEST_EXIT();
+}
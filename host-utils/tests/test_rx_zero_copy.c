@@ -0,0 +1,149 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#include "lib_iqplayer_api.h"
+#include "iq_fake_modem.h"
+#include "iq_test.h"
+
+#define FIFO_START 0x20000
+#define FIFO_SIZE (32 * IQ_FAKE_DDR_STEP)
+#define STEP IQ_FAKE_DDR_STEP
+
+static iq_fake_modem_t m;
+static uint8_t in[FIFO_SIZE];
+
+static iq_rx_stream_t *rx_open(iq_player_t **p, uint64_t base) {
+    iq_fake_open(&m, 1);
+    iq_fake_rx_start(&m, 0, FIFO_START, FIFO_SIZE, base);
+    *p = iq_player_open(m.iqflood, m.iqflood_size, m.bar2);
+    IQ_CHECK(*p != NULL);
+    IQ_CHECK_EQ(iq_rx_init(iq_player_rx_stream(*p, 0), FIFO_START, FIFO_SIZE), 1);
+    return iq_player_rx_stream(*p, 0);
+}
+
+static void rx_close(iq_player_t *p) {
+    iq_player_close(p);
+    iq_fake_close(&m);
+}
+
+static uint32_t rx_produce(uint64_t pos, uint32_t size) {
+    iq_fake_pattern_fill(in, pos, size);
+    return iq_fake_rx_write(&m, 0, in, size, false);
+}
+
+/* peek exposes modem data in place, release gives room back */
+static void test_peek_release(void) {
+    iq_player_t *p;
+    iq_rx_stream_t *s = rx_open(&p, 0);
+    void *seg0, *seg1;
+    uint32_t len0, len1;
+
+    IQ_CHECK_EQ(iq_rx_peek(s, &seg0, &len0, &seg1, &len1), 0);
+    IQ_CHECK(seg0 == NULL && seg1 == NULL);
+
+    IQ_CHECK_EQ(rx_produce(0, 5 * STEP), 5 * STEP);
+    IQ_CHECK_EQ(iq_rx_peek(s, &seg0, &len0, &seg1, &len1), 5 * STEP);
+    IQ_CHECK(seg0 == (uint8_t *)m.iqflood + FIFO_START);
+    IQ_CHECK_EQ(len0, 5 * STEP);
+    IQ_CHECK(seg1 == NULL);
+    IQ_CHECK_EQ(len1, 0);
+    IQ_CHECK_EQ(iq_fake_pattern_check(seg0, 0, len0), len0);
+
+    // partial release, rest is peeked again
+    IQ_CHECK_EQ(iq_rx_release(s, 2 * STEP), 2 * STEP);
+    IQ_CHECK_EQ(iq_fake_host_consumed(&m, 0), 2 * STEP);
+    IQ_CHECK_EQ(iq_rx_peek(s, &seg0, &len0, &seg1, &len1), 3 * STEP);
+    IQ_CHECK(seg0 == (uint8_t *)m.iqflood + FIFO_START + 2 * STEP);
+    IQ_CHECK_EQ(iq_fake_pattern_check(seg0, 2 * STEP, len0), len0);
+
+    // release is clamped to peeked size, release without peek moves nothing
+    IQ_CHECK_EQ(iq_rx_release(s, FIFO_SIZE), 3 * STEP);
+    IQ_CHECK_EQ(iq_rx_release(s, STEP), 0);
+    IQ_CHECK_EQ(iq_fake_host_consumed(&m, 0), 5 * STEP);
+    rx_close(p);
+}
+
+/* data across fifo wrap comes as two segments */
+static void test_peek_wrap(void) {
+    iq_player_t *p;
+    iq_rx_stream_t *s = rx_open(&p, 0x100000000ULL - 3 * STEP);
+    uint64_t pos = 0, base = 0x100000000ULL - 3 * STEP;
+    void *seg0, *seg1;
+    uint32_t len0, len1, i, first = (uint32_t)(base % FIFO_SIZE);
+
+    IQ_CHECK_EQ(rx_produce(pos, FIFO_SIZE), FIFO_SIZE);
+    // fifo full, modem may not write more
+    IQ_CHECK_EQ(rx_produce(pos, STEP), 0);
+    IQ_CHECK_EQ(iq_rx_peek(s, &seg0, &len0, &seg1, &len1), FIFO_SIZE);
+    IQ_CHECK(seg0 == (uint8_t *)m.iqflood + FIFO_START + first);
+    IQ_CHECK_EQ(len0, FIFO_SIZE - first);
+    IQ_CHECK(seg1 == (uint8_t *)m.iqflood + FIFO_START);
+    IQ_CHECK_EQ(len1, first);
+    IQ_CHECK_EQ(iq_fake_pattern_check(seg0, pos, len0), len0);
+    IQ_CHECK_EQ(iq_fake_pattern_check(seg1, pos + len0, len1), len1);
+    IQ_CHECK_EQ(iq_rx_release(s, len0 + len1), FIFO_SIZE);
+    pos += FIFO_SIZE;
+    // counter crossed 4GB
+    IQ_CHECK_EQ(m.wo->host_consumed_size_hi[0], 1);
+
+    // several turns, consumer always checks both segments
+    for (i = 0; i < 100; i++) {
+        IQ_CHECK_EQ(rx_produce(m.rx_produced[0] - base, 7 * STEP), 7 * STEP);
+        IQ_CHECK_EQ(iq_rx_peek(s, &seg0, &len0, &seg1, &len1), 7 * STEP);
+        IQ_CHECK_EQ(iq_fake_pattern_check(seg0, pos, len0), len0);
+        if (len1)
+            IQ_CHECK_EQ(iq_fake_pattern_check(seg1, pos + len0, len1), len1);
+        pos += iq_rx_release(s, len0 + len1);
+    }
+    IQ_CHECK_EQ(iq_fake_host_consumed(&m, 0), base + pos);
+    rx_close(p);
+}
+
+/* reads shorter than a DDR step : tail of a partly read step is still returned once modem stopped */
+static void test_partial_step(void) {
+    iq_player_t *p;
+    iq_rx_stream_t *s = rx_open(&p, 0);
+    uint8_t out[STEP];
+
+    IQ_CHECK_EQ(rx_produce(0, STEP), STEP);
+    IQ_CHECK_EQ(iq_rx_receive(s, (uint32_t *)out, 100), 100);
+    IQ_CHECK_EQ(iq_rx_receive(s, (uint32_t *)out, STEP), STEP - 100);
+    IQ_CHECK_EQ(iq_fake_pattern_check(out, 100, STEP - 100), STEP - 100);
+    IQ_CHECK_EQ(iq_rx_receive(s, (uint32_t *)out, STEP), 0);
+    IQ_CHECK_EQ(iq_fake_host_consumed(&m, 0), STEP);
+    rx_close(p);
+}
+
+/* legacy single modem api on default instance */
+static void test_legacy(void) {
+    void *seg0, *seg1;
+    uint32_t len0, len1;
+
+    iq_fake_open(&m, 1);
+    iq_fake_rx_start(&m, 0, FIFO_START, FIFO_SIZE, 0);
+    IQ_CHECK_EQ(iq_player_init(m.iqflood, m.iqflood_size, m.bar2), 1);
+    IQ_CHECK_EQ(iq_player_init_rx(0, FIFO_START, FIFO_SIZE), 1);
+    IQ_CHECK_EQ(rx_produce(0, 4 * STEP), 4 * STEP);
+    IQ_CHECK_EQ(iq_player_rx_peek(0, &seg0, &len0, &seg1, &len1), 4 * STEP);
+    IQ_CHECK_EQ(iq_fake_pattern_check(seg0, 0, len0), 4 * STEP);
+    IQ_CHECK_EQ(iq_player_rx_release(0, 4 * STEP), 4 * STEP);
+    IQ_CHECK_EQ(iq_fake_host_consumed(&m, 0), 4 * STEP);
+    iq_fake_close(&m);
+}
+
+int main(void) {
+    IQ_TEST_RUN(test_peek_release);
+    IQ_TEST_RUN(test_peek_wrap);
+    IQ_TEST_RUN(test_partial_step);
+    IQ_TEST_RUN(test_legacy);
+    return IQ_TEST_EXIT();
+}
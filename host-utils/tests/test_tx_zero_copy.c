@@ -0,0 +1,150 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#include "lib_iqplayer_api.h"
+#include "iq_fake_modem.h"
+#include "iq_test.h"
+
+#define FIFO_START 0x10000
+#define FIFO_SIZE (32 * IQ_FAKE_DDR_STEP)
+#define STEP IQ_FAKE_DDR_STEP
+
+static iq_fake_modem_t m;
+static uint8_t out[FIFO_SIZE];
+
+static iq_tx_stream_t *tx_open(iq_player_t **p, uint64_t base) {
+    iq_fake_open(&m, 1);
+    iq_fake_tx_start(&m, FIFO_START, FIFO_SIZE, base);
+    *p = iq_player_open(m.iqflood, m.iqflood_size, m.bar2);
+    IQ_CHECK(*p != NULL);
+    IQ_CHECK_EQ(iq_tx_init(iq_player_tx_stream(*p), FIFO_START, FIFO_SIZE), 1);
+    return iq_player_tx_stream(*p);
+}
+
+static void tx_close(iq_player_t *p) {
+    iq_player_close(p);
+    iq_fake_close(&m);
+}
+
+/* window is in iqflood tx fifo, committed bytes reach modem unchanged */
+static void test_acquire_commit(void) {
+    iq_player_t *p;
+    iq_tx_stream_t *s = tx_open(&p, 0);
+    void *ptr;
+    uint32_t len;
+
+    IQ_CHECK_EQ(iq_tx_acquire(s, &ptr, &len), FIFO_SIZE);
+    IQ_CHECK_EQ(len, FIFO_SIZE);
+    IQ_CHECK(ptr == (uint8_t *)m.iqflood + FIFO_START);
+    iq_fake_pattern_fill(ptr, 0, 3 * STEP);
+    IQ_CHECK_EQ(iq_tx_commit(s, 3 * STEP), 3 * STEP);
+    IQ_CHECK_EQ(iq_fake_host_produced(&m), 3 * STEP);
+
+    IQ_CHECK_EQ(iq_fake_tx_fetch(&m, out, FIFO_SIZE, false), 3 * STEP);
+    IQ_CHECK_EQ(iq_fake_pattern_check(out, 0, 3 * STEP), 3 * STEP);
+
+    // commit without acquire moves nothing
+    IQ_CHECK_EQ(iq_tx_commit(s, STEP), 0);
+    IQ_CHECK_EQ(iq_fake_host_produced(&m), 3 * STEP);
+    tx_close(p);
+}
+
+/* commit is clamped to acquired window */
+static void test_commit_clamp(void) {
+    iq_player_t *p;
+    iq_tx_stream_t *s = tx_open(&p, 0);
+    void *ptr;
+    uint32_t len;
+
+    IQ_CHECK_EQ(iq_fake_tx_fetch(&m, NULL, 4 * STEP, true), 4 * STEP);
+    iq_tx_commit(s, 0);
+    // modem went past host data : first acquire reports the underrun
+    IQ_CHECK_EQ(iq_tx_acquire(s, &ptr, &len), -EPIPE);
+    IQ_CHECK_EQ(iq_tx_lost_size(s), 4 * STEP);
+    IQ_CHECK_EQ(iq_fake_host_produced(&m), 4 * STEP);
+
+    // window stops at fifo wrap
+    IQ_CHECK_EQ(iq_tx_acquire(s, &ptr, &len), FIFO_SIZE - 4 * STEP);
+    IQ_CHECK(ptr == (uint8_t *)m.iqflood + FIFO_START + 4 * STEP);
+    IQ_CHECK_EQ(iq_tx_commit(s, FIFO_SIZE), FIFO_SIZE - 4 * STEP);
+    IQ_CHECK_EQ(iq_fake_host_produced(&m), FIFO_SIZE);
+    tx_close(p);
+}
+
+/* full fifo returns 0, modem drains, window restarts at fifo base after wrap */
+static void test_full_and_wrap(void) {
+    iq_player_t *p;
+    iq_tx_stream_t *s = tx_open(&p, 0);
+    uint64_t pos = 0;
+    void *ptr;
+    uint32_t len, i;
+    int ret;
+
+    iq_player_set_doorbell(p, 8 * STEP, 0);
+    IQ_CHECK_EQ(iq_tx_acquire(s, &ptr, &len), FIFO_SIZE);
+    iq_fake_pattern_fill(ptr, pos, len);
+    pos += iq_tx_commit(s, len);
+    IQ_CHECK_EQ(iq_tx_acquire(s, &ptr, &len), 0);
+    IQ_CHECK(ptr == NULL);
+    IQ_CHECK_EQ(len, 0);
+    // full fifo always rings
+    IQ_CHECK_EQ(iq_fake_host_produced(&m), FIFO_SIZE);
+
+    // several turns of fifo, odd sized commits
+    for (i = 0; i < 200; i++) {
+        IQ_CHECK_EQ(iq_fake_tx_fetch(&m, out, 5 * STEP, false), 5 * STEP);
+        IQ_CHECK_EQ(iq_fake_pattern_check(out, m.tx_enqueued - 5 * STEP, 5 * STEP), 5 * STEP);
+        while ((ret = iq_tx_acquire(s, &ptr, &len)) > 0) {
+            IQ_CHECK((uint8_t *)ptr + len <= (uint8_t *)m.iqflood + FIFO_START + FIFO_SIZE);
+            if (len > 3 * STEP)
+                len = 3 * STEP;
+            iq_fake_pattern_fill(ptr, pos, len);
+            pos += iq_tx_commit(s, len);
+        }
+        IQ_CHECK_EQ(ret, 0);
+    }
+    IQ_CHECK_EQ(iq_fake_host_produced(&m), pos);
+    IQ_CHECK_EQ(pos - m.tx_enqueued, FIFO_SIZE);
+    tx_close(p);
+}
+
+/* legacy single modem api on default instance */
+static void test_legacy(void) {
+    void *ptr;
+    uint32_t len;
+
+    iq_fake_open(&m, 1);
+    iq_fake_tx_start(&m, FIFO_START, FIFO_SIZE, 0x100000000ULL - 2 * STEP);
+    IQ_CHECK_EQ(iq_player_init(m.iqflood, m.iqflood_size, m.bar2), 1);
+    IQ_CHECK_EQ(iq_player_init_tx(FIFO_START, FIFO_SIZE), 1);
+    IQ_CHECK_EQ(iq_player_tx_acquire(&ptr, &len), 2 * STEP);
+    iq_fake_pattern_fill(ptr, 0, len);
+    IQ_CHECK_EQ(iq_player_tx_commit(len), 2 * STEP);
+    IQ_CHECK_EQ(iq_player_tx_acquire(&ptr, &len), FIFO_SIZE - 2 * STEP);
+    IQ_CHECK(ptr == (uint8_t *)m.iqflood + FIFO_START);
+    iq_fake_pattern_fill(ptr, 2 * STEP, len);
+    IQ_CHECK_EQ(iq_player_tx_commit(len), FIFO_SIZE - 2 * STEP);
+    // counter crossed 4GB
+    IQ_CHECK_EQ(iq_fake_host_produced(&m), 0x100000000ULL - 2 * STEP + FIFO_SIZE);
+    IQ_CHECK_EQ(m.wo->host_produced_size_hi, 1);
+    IQ_CHECK_EQ(iq_fake_tx_fetch(&m, out, FIFO_SIZE, false), FIFO_SIZE);
+    IQ_CHECK_EQ(iq_fake_pattern_check(out, 0, FIFO_SIZE), FIFO_SIZE);
+    iq_fake_close(&m);
+}
+
+int main(void) {
+    IQ_TEST_RUN(test_acquire_commit);
+    IQ_TEST_RUN(test_commit_clamp);
+    IQ_TEST_RUN(test_full_and_wrap);
+    IQ_TEST_RUN(test_legacy);
+    return IQ_TEST_EXIT();
+}
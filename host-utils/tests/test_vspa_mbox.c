@@ -0,0 +1,125 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "vspa_mbox.h"
+#include "iq_test.h"
+
+/* libvspambox on a mock window : VSPA side served by a thread, NACK on a marked command, timeout without VSPA */
+#define CORE 3
+#define MBOX 1
+#define NACK_MSB 0xdead
+#define NB_MSG 100
+
+static void *window;
+static vspa_mbox_t vspa, host;
+static pthread_t th;
+
+static uint32_t handler(void *arg, uint32_t msb, uint32_t lsb, uint32_t *rsp_msb) {
+    (void)arg;
+    *rsp_msb = msb ^ lsb;
+    return msb == NACK_MSB ? 0 : 1;
+}
+
+static void *vspa_thread(void *arg) {
+    vspa_mbox_mock_serve(&vspa, handler, NULL, 0);
+    return NULL;
+}
+
+static void open_mbox(int serve) {
+    window = calloc(1, VSPA_MBOX_MAP_SIZE);
+    vspa_mbox_open_mock(&vspa, window, CORE, MBOX);
+    vspa_mbox_open_mock(&host, window, CORE, MBOX);
+    if (serve)
+        pthread_create(&th, NULL, vspa_thread, NULL);
+}
+
+static void close_mbox(int serve) {
+    if (serve) {
+        vspa_mbox_mock_stop(&vspa);
+        pthread_join(th, NULL);
+    }
+    vspa_mbox_close(&host);
+    vspa_mbox_close(&vspa);
+    free(window);
+}
+
+static void test_transact(void) {
+    uint32_t msb = 0, lsb = 0;
+
+    open_mbox(1);
+    IQ_CHECK_EQ(vspa_mbox_transact(&host, 0x1234, 0x10, &msb, &lsb), 0);
+    IQ_CHECK_EQ(msb, 0x1234 ^ 0x10);
+    IQ_CHECK_EQ(lsb, 1);
+    IQ_CHECK_EQ(vspa_mbox_transact(&host, NACK_MSB, 0x10, &msb, &lsb), -EIO);
+    IQ_CHECK_EQ(msb, NACK_MSB ^ 0x10);
+    IQ_CHECK_EQ(host.stats.count, 2);
+    IQ_CHECK_EQ(host.stats.nacks, 1);
+    IQ_CHECK(host.stats.min_ns <= host.stats.max_ns);
+    close_mbox(1);
+}
+
+static void test_batch_nack(void) {
+    vspa_mbox_msg_t msgs[NB_MSG];
+    int i;
+
+    open_mbox(1);
+    for (i = 0; i < NB_MSG; i++) {
+        msgs[i].msb = i == NB_MSG / 2 ? NACK_MSB : i;
+        msgs[i].lsb = 7 * i;
+    }
+    // a NACK does not stop the batch, every command gets its own reply
+    IQ_CHECK_EQ(vspa_mbox_send_batch(&host, msgs, NB_MSG), NB_MSG);
+    for (i = 0; i < NB_MSG; i++) {
+        IQ_CHECK_EQ(msgs[i].rsp_msb, msgs[i].msb ^ msgs[i].lsb);
+        IQ_CHECK_EQ(msgs[i].ret, i == NB_MSG / 2 ? -EIO : 0);
+        IQ_CHECK(msgs[i].rtt_ns > 0);
+    }
+    IQ_CHECK_EQ(host.stats.count, NB_MSG);
+    IQ_CHECK_EQ(host.stats.nacks, 1);
+    IQ_CHECK_EQ(host.stats.timeouts, 0);
+    close_mbox(1);
+}
+
+static void test_timeout(void) {
+    vspa_mbox_msg_t msgs[4] = {{.msb = 1}, {.msb = 2}, {.msb = 3}, {.msb = 4}};
+
+    // no VSPA side : first command times out and stops the batch
+    open_mbox(0);
+    host.timeout_us = 1000;
+    IQ_CHECK_EQ(vspa_mbox_transact(&host, 1, 1, NULL, NULL), -ETIMEDOUT);
+    IQ_CHECK_EQ(vspa_mbox_send_batch(&host, msgs, 4), 0);
+    IQ_CHECK_EQ(msgs[0].ret, -ETIMEDOUT);
+    IQ_CHECK_EQ(host.stats.timeouts, 2);
+    IQ_CHECK_EQ(host.stats.count, 0);
+    close_mbox(0);
+}
+
+static void test_stale_reply(void) {
+    uint32_t msb = 0;
+
+    // reply left by an aborted command (status bit set) is dropped, not taken as the next answer
+    open_mbox(0);
+    vspa_mbox_post(&host, 0x55, 0);
+    vspa_mbox_mock_serve(&vspa, handler, NULL, 1);
+    pthread_create(&th, NULL, vspa_thread, NULL);
+    IQ_CHECK_EQ(vspa_mbox_transact(&host, 0x66, 0x1, &msb, NULL), 0);
+    IQ_CHECK_EQ(msb, 0x66 ^ 0x1);
+    close_mbox(1);
+}
+
+int main(void) {
+    IQ_TEST_RUN(test_transact);
+    IQ_TEST_RUN(test_batch_nack);
+    IQ_TEST_RUN(test_timeout);
+    IQ_TEST_RUN(test_stale_reply);
+    return IQ_TEST_EXIT();
+}
@@ -0,0 +1,157 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "lib_iqplayer_api.h"
+#include "iq_fake_modem.h"
+#include "iq_test.h"
+
+#define TX_FIFO_START 0x0
+#define RX_FIFO_START 0x100000
+#define FIFO_SIZE (16 * IQ_FAKE_DDR_STEP)
+#define STEP IQ_FAKE_DDR_STEP
+#define SAMPLE_RATE 2000000 /* modem thread pace, one step every ~256us */
+
+static const char *policy_name[IQ_WAIT_MAX] = {"spin", "yield", "sleep", "adaptive"};
+
+static iq_fake_modem_t m;
+static iq_player_t *p;
+static volatile uint32_t running;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void sleep_ns(uint64_t ns) {
+    struct timespec ts = {.tv_sec = ns / 1000000000ULL, .tv_nsec = ns % 1000000000ULL};
+
+    nanosleep(&ts, NULL);
+}
+
+static void open_modem(uint32_t policy) {
+    iq_fake_open(&m, 1);
+    iq_fake_tx_start(&m, TX_FIFO_START, FIFO_SIZE, 0);
+    iq_fake_rx_start(&m, 0, RX_FIFO_START, FIFO_SIZE, 0);
+    p = iq_player_open(m.iqflood, m.iqflood_size, m.bar2);
+    IQ_CHECK(p != NULL);
+    iq_player_set_wait_policy(p, policy, SAMPLE_RATE);
+    IQ_CHECK_EQ(iq_tx_init(iq_player_tx_stream(p), TX_FIFO_START, FIFO_SIZE), 1);
+    IQ_CHECK_EQ(iq_rx_init(iq_player_rx_stream(p, 0), RX_FIFO_START, FIFO_SIZE), 1);
+}
+
+static void close_modem(void) {
+    iq_player_close(p);
+    iq_fake_close(&m);
+}
+
+/* modem paced at SAMPLE_RATE : one rx step written and one tx step fetched per step period */
+static void *modem_thread(void *arg) {
+    uint8_t buf[STEP];
+    uint64_t rx_pos = 0, period = (uint64_t)STEP / 4 * 1000000000ULL / SAMPLE_RATE;
+    uint64_t next = now_ns();
+
+    (void)arg;
+    while (running) {
+        iq_fake_pattern_fill(buf, rx_pos, STEP);
+        rx_pos += iq_fake_rx_write(&m, 0, buf, STEP, false);
+        iq_fake_tx_fetch(&m, NULL, STEP, false);
+        next += period;
+        if (next > now_ns())
+            sleep_ns(next - now_ns());
+    }
+    return NULL;
+}
+
+/* no modem progress : blocking calls give up at timeout, whatever the policy */
+static void test_timeout(void) {
+    uint8_t buf[4 * STEP];
+    uint64_t t0, dt;
+    uint32_t policy;
+    void *ptr;
+    uint32_t len;
+
+    for (policy = 0; policy < IQ_WAIT_MAX; policy++) {
+        open_modem(policy);
+        t0 = now_ns();
+        IQ_CHECK_EQ(iq_rx_receive_wait(iq_player_rx_stream(p, 0), (uint32_t *)buf, STEP, sizeof(buf), 2000000), 0);
+        dt = now_ns() - t0;
+        IQ_CHECK(dt >= 2000000 && dt < 200000000);
+
+        // tx : fill fifo then wait for room that never comes
+        IQ_CHECK_EQ(iq_tx_acquire(iq_player_tx_stream(p), &ptr, &len), FIFO_SIZE);
+        iq_tx_commit(iq_player_tx_stream(p), len);
+        t0 = now_ns();
+        IQ_CHECK_EQ(iq_tx_send_wait(iq_player_tx_stream(p), (uint32_t *)buf, sizeof(buf), 2000000), 0);
+        dt = now_ns() - t0;
+        IQ_CHECK(dt >= 2000000 && dt < 200000000);
+        if (iq_test_failed)
+            printf("  policy %s\n", policy_name[policy]);
+        close_modem();
+    }
+}
+
+/* paced modem : each call returns once min_size bytes arrived, data intact, tx takes whole buffer */
+static void test_paced(void) {
+    uint8_t buf[8 * STEP];
+    uint64_t pos;
+    uint32_t policy, i;
+    pthread_t th;
+    int ret;
+
+    for (policy = IQ_WAIT_YIELD; policy < IQ_WAIT_MAX; policy++) {
+        open_modem(policy);
+        running = 1;
+        pthread_create(&th, NULL, modem_thread, NULL);
+        for (i = 0, pos = 0; i < 20; i++) {
+            ret = iq_rx_receive_wait(iq_player_rx_stream(p, 0), (uint32_t *)buf, 3 * STEP, sizeof(buf), IQ_WAIT_FOREVER);
+            IQ_CHECK(ret >= 3 * STEP && ret <= (int)sizeof(buf));
+            if (ret > 0) {
+                IQ_CHECK_EQ(iq_fake_pattern_check(buf, pos, ret), ret);
+                pos += ret;
+            }
+            IQ_CHECK_EQ(iq_tx_send_wait(iq_player_tx_stream(p), (uint32_t *)buf, 3 * STEP, IQ_WAIT_FOREVER), 3 * STEP);
+        }
+        running = 0;
+        pthread_join(th, NULL);
+        if (iq_test_failed)
+            printf("  policy %s\n", policy_name[policy]);
+        close_modem();
+    }
+}
+
+/* overrun while waiting is reported, then stream restarts */
+static void test_overrun(void) {
+    uint8_t buf[FIFO_SIZE * 2];
+    uint32_t i;
+
+    open_modem(IQ_WAIT_SLEEP);
+    iq_fake_pattern_fill(buf, 0, FIFO_SIZE);
+    IQ_CHECK_EQ(iq_fake_rx_write(&m, 0, buf, 2 * STEP, false), 2 * STEP);
+    IQ_CHECK_EQ(iq_rx_receive_wait(iq_player_rx_stream(p, 0), (uint32_t *)buf, STEP, STEP, 0), STEP);
+    for (i = 0; i < 2; i++)
+        iq_fake_rx_write(&m, 0, buf, FIFO_SIZE, true);
+    IQ_CHECK_EQ(iq_rx_receive_wait(iq_player_rx_stream(p, 0), (uint32_t *)buf, 4 * STEP, sizeof(buf), 0), -EPIPE);
+    IQ_CHECK(iq_rx_lost_size(iq_player_rx_stream(p, 0)) > 0);
+    IQ_CHECK_EQ(iq_rx_receive_wait(iq_player_rx_stream(p, 0), (uint32_t *)buf, STEP, sizeof(buf), 0), FIFO_SIZE - STEP);
+    close_modem();
+}
+
+int main(void) {
+    IQ_TEST_RUN(test_timeout);
+    IQ_TEST_RUN(test_paced);
+    IQ_TEST_RUN(test_overrun);
+    return IQ_TEST_EXIT();
+}
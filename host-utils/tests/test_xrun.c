@@ -0,0 +1,127 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/uio.h>
+
+#include "lib_iqplayer_api.h"
+#include "iq_fake_modem.h"
+#include "iq_test.h"
+
+#define TX_FIFO_START 0x0
+#define RX_FIFO_START 0x100000
+#define FIFO_SIZE (16 * IQ_FAKE_DDR_STEP)
+#define STEP IQ_FAKE_DDR_STEP
+
+static iq_fake_modem_t m;
+static iq_player_t *p;
+static uint8_t buf[4 * FIFO_SIZE];
+static uint8_t out[FIFO_SIZE];
+
+static void open_modem(uint64_t base) {
+    iq_fake_open(&m, 1);
+    iq_fake_tx_start(&m, TX_FIFO_START, FIFO_SIZE, base);
+    iq_fake_rx_start(&m, 0, RX_FIFO_START, FIFO_SIZE, base);
+    p = iq_player_open(m.iqflood, m.iqflood_size, m.bar2);
+    IQ_CHECK(p != NULL);
+    IQ_CHECK_EQ(iq_tx_init(iq_player_tx_stream(p), TX_FIFO_START, FIFO_SIZE), 1);
+    IQ_CHECK_EQ(iq_rx_init(iq_player_rx_stream(p, 0), RX_FIFO_START, FIFO_SIZE), 1);
+}
+
+static void close_modem(void) {
+    iq_player_close(p);
+    iq_fake_close(&m);
+}
+
+/* modem plays past host data : -EPIPE once, lost size, host restarts at modem read position */
+static void test_underrun(void) {
+    struct iovec iov = {.iov_base = buf, .iov_len = FIFO_SIZE};
+    iq_tx_stream_t *s;
+
+    open_modem(0x100000000ULL - 2 * STEP);
+    s = iq_player_tx_stream(p);
+    iq_fake_pattern_fill(buf, 0, FIFO_SIZE);
+    IQ_CHECK_EQ(iq_tx_send(s, (uint32_t *)buf, 2 * STEP), 2 * STEP);
+    IQ_CHECK_EQ(iq_fake_tx_fetch(&m, NULL, 7 * STEP, true), 7 * STEP);
+
+    IQ_CHECK_EQ(iq_tx_send(s, (uint32_t *)buf, STEP), -EPIPE);
+    IQ_CHECK_EQ(iq_tx_lost_size(s), 5 * STEP);
+    IQ_CHECK_EQ(m.ro->app_stats.tx_stats[ERROR_EXT_DMA_DDR_RD_UNDERRUN], 5 * STEP / 4);
+    IQ_CHECK_EQ(iq_fake_host_produced(&m), m.tx_enqueued);
+
+    // stream goes on from modem position, whole fifo free
+    IQ_CHECK_EQ(iq_tx_sendv(s, &iov, 1), FIFO_SIZE);
+    IQ_CHECK_EQ(iq_fake_tx_fetch(&m, out, FIFO_SIZE, false), FIFO_SIZE);
+    IQ_CHECK_EQ(iq_fake_pattern_check(out, 0, FIFO_SIZE), FIFO_SIZE);
+    IQ_CHECK_EQ(iq_tx_send(s, (uint32_t *)buf, STEP), STEP);
+    IQ_CHECK_EQ(iq_tx_lost_size(s), 5 * STEP);
+    close_modem();
+}
+
+/* modem writes over unread data : only overwritten bytes are lost, most recent data is kept */
+static void test_overrun(void) {
+    iq_rx_stream_t *s;
+    uint64_t pos = 0;
+    int ret;
+
+    open_modem(0x100000000ULL - 3 * STEP);
+    s = iq_player_rx_stream(p, 0);
+    iq_fake_pattern_fill(buf, 0, sizeof(buf));
+    IQ_CHECK_EQ(iq_fake_rx_write(&m, 0, buf, 3 * STEP, false), 3 * STEP);
+    IQ_CHECK_EQ(iq_rx_receive(s, (uint32_t *)out, STEP), STEP);
+    pos += STEP;
+
+    // 2 unread + 19 more steps in a 16 steps fifo : 5 overwritten, 1 being overwritten, 15 still valid
+    IQ_CHECK_EQ(iq_fake_rx_write(&m, 0, buf + 3 * STEP, 19 * STEP, true), 19 * STEP);
+    IQ_CHECK_EQ(iq_rx_receive(s, (uint32_t *)out, FIFO_SIZE), -EPIPE);
+    IQ_CHECK_EQ(iq_rx_lost_size(s), 6 * STEP);
+    IQ_CHECK_EQ(m.ro->app_stats.rx_stats[0][ERROR_EXT_DMA_DDR_WR_OVERRUN], 6 * STEP / 4);
+    pos += 6 * STEP;
+    IQ_CHECK_EQ(iq_fake_host_consumed(&m, 0), 0x100000000ULL - 3 * STEP + pos);
+
+    ret = iq_rx_receive(s, (uint32_t *)out, FIFO_SIZE);
+    IQ_CHECK_EQ(ret, FIFO_SIZE - STEP);
+    IQ_CHECK_EQ(iq_fake_pattern_check(out, pos, FIFO_SIZE - STEP), FIFO_SIZE - STEP);
+    pos += ret;
+    IQ_CHECK_EQ(pos, 22 * STEP);
+
+    // flow control back to normal
+    IQ_CHECK_EQ(iq_fake_rx_write(&m, 0, buf + pos, 2 * STEP, false), 2 * STEP);
+    IQ_CHECK_EQ(iq_rx_receive(s, (uint32_t *)out, FIFO_SIZE), 2 * STEP);
+    IQ_CHECK_EQ(iq_fake_pattern_check(out, pos, 2 * STEP), 2 * STEP);
+    close_modem();
+}
+
+/* modem several fifo turns ahead : loss counts every overwritten byte */
+static void test_overrun_many_turns(void) {
+    iq_rx_stream_t *s;
+    void *seg0, *seg1;
+    uint32_t len0, len1, i;
+
+    open_modem(0);
+    s = iq_player_rx_stream(p, 0);
+    for (i = 0; i < 3; i++) {
+        iq_fake_pattern_fill(buf, i * FIFO_SIZE, FIFO_SIZE);
+        iq_fake_rx_write(&m, 0, buf, FIFO_SIZE, true);
+    }
+    IQ_CHECK_EQ(iq_rx_peek(s, &seg0, &len0, &seg1, &len1), -EPIPE);
+    IQ_CHECK_EQ(iq_rx_lost_size(s), 2 * FIFO_SIZE + STEP);
+    IQ_CHECK_EQ(iq_rx_peek(s, &seg0, &len0, &seg1, &len1), FIFO_SIZE - STEP);
+    IQ_CHECK_EQ(iq_fake_pattern_check(seg0, 2 * FIFO_SIZE + STEP, len0), len0);
+    IQ_CHECK_EQ(len1, 0);
+    close_modem();
+}
+
+int main(void) {
+    IQ_TEST_RUN(test_underrun);
+    IQ_TEST_RUN(test_overrun);
+    IQ_TEST_RUN(test_overrun_many_turns);
+    return IQ_TEST_EXIT();
+}
@@ -0,0 +1,272 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/mman.h>
+
+#include "vspa_mbox.h"
+
+#define MAILBOX_ADDR(mbox, direction) (0x680 + (direction) * 0x10 + (mbox) * 8)
+#define MAILBOX_STATUS 0x660
+#define MAILBOX_CLEAR 0x10
+#define MAILBOX_CORE_STRIDE 0x4000
+
+#if defined(__aarch64__)
+static inline uint32_t ioread32(const volatile void *addr) {
+    uint32_t val;
+
+    asm volatile("ldr %w[val], [%x[addr]]" : [val] "=r"(val) : [addr] "r"(addr));
+    asm volatile("dsb ld" : : : "memory");
+    return val;
+}
+
+static inline void iowrite32(uint32_t val, volatile void *addr) {
+    asm volatile("dsb st" : : : "memory");
+    asm volatile("str %w[val], [%x[addr]]" : : [val] "r"(val), [addr] "r"(addr));
+}
+#else
+// mock window on a x86 test host
+static inline uint32_t ioread32(const volatile void *addr) {
+    uint32_t val = *(const volatile uint32_t *)addr;
+
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return val;
+}
+
+static inline void iowrite32(uint32_t val, volatile void *addr) {
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    *(volatile uint32_t *)addr = val;
+}
+#endif
+
+static inline uint64_t vspa_mbox_now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline uint32_t vspa_mbox_ready(vspa_mbox_t *m) {
+    return ioread32(m->regs + MAILBOX_STATUS) & (1 << m->mbox_id);
+}
+
+static void vspa_mbox_init(vspa_mbox_t *m, int core_idx, int mbox_id) {
+    memset(m, 0, sizeof(vspa_mbox_t));
+    m->fd = -1;
+    m->core_idx = core_idx;
+    m->mbox_id = mbox_id;
+    m->timeout_us = VSPA_MBOX_DEFAULT_TIMEOUT_US;
+    m->stats.min_ns = UINT64_MAX;
+}
+
+int vspa_mbox_open(vspa_mbox_t *m, uint64_t vspa_phys, int core_idx, int mbox_id) {
+    void *map;
+
+    if (core_idx < 0 || core_idx >= 8 || mbox_id < 0 || mbox_id > 1)
+        return -EINVAL;
+    vspa_mbox_init(m, core_idx, mbox_id);
+
+    m->fd = open("/dev/mem", O_RDWR | O_SYNC);
+    if (m->fd < 0) {
+        perror("/dev/mem open failed");
+        return -errno;
+    }
+    map = mmap(NULL, VSPA_MBOX_MAP_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, m->fd, vspa_phys);
+    if (map == MAP_FAILED) {
+        printf("Failed mmap mbox memory to user-space\n");
+        close(m->fd);
+        m->fd = -1;
+        return -ENOMEM;
+    }
+    m->map = map;
+    m->regs = m->map + MAILBOX_CORE_STRIDE * core_idx;
+
+    return 0;
+}
+
+int vspa_mbox_open_mock(vspa_mbox_t *m, void *window, int core_idx, int mbox_id) {
+    if (core_idx < 0 || core_idx >= 8 || mbox_id < 0 || mbox_id > 1)
+        return -EINVAL;
+    vspa_mbox_init(m, core_idx, mbox_id);
+    m->mock = true;
+    m->mock_run = true;
+    m->regs = (uint8_t *)window + MAILBOX_CORE_STRIDE * core_idx;
+    m->mock_seq = ioread32(m->regs + VSPA_MBOX_MOCK_SEQ + 4 * mbox_id);
+
+    return 0;
+}
+
+void vspa_mbox_close(vspa_mbox_t *m) {
+    if (m->map)
+        munmap(m->map, VSPA_MBOX_MAP_SIZE);
+    if (m->fd >= 0)
+        close(m->fd);
+    m->map = NULL;
+    m->regs = NULL;
+    m->fd = -1;
+}
+
+void vspa_mbox_post(vspa_mbox_t *m, uint32_t msb, uint32_t lsb) {
+    volatile uint8_t *addr = m->regs + MAILBOX_ADDR(m->mbox_id, 0);
+
+    // LSB write raises the VSPA mailbox event
+    iowrite32(msb, addr);
+    iowrite32(lsb, addr + 4);
+    if (m->mock)
+        iowrite32(++m->mock_seq, m->regs + VSPA_MBOX_MOCK_SEQ + 4 * m->mbox_id);
+}
+
+void vspa_mbox_clear(vspa_mbox_t *m) {
+    iowrite32(1 << (14 + m->mbox_id), m->regs + MAILBOX_CLEAR);
+    // no w1c logic behind a mock window
+    if (m->mock)
+        __atomic_fetch_and((uint32_t *)(m->regs + MAILBOX_STATUS), ~(1U << m->mbox_id), __ATOMIC_ACQ_REL);
+}
+
+/* busy-wait VSPA reply, read and clear it */
+int vspa_mbox_wait(vspa_mbox_t *m, uint32_t *rsp_msb, uint32_t *rsp_lsb) {
+    uint64_t deadline = vspa_mbox_now_ns() + (uint64_t)m->timeout_us * 1000;
+    volatile uint8_t *addr = m->regs + MAILBOX_ADDR(m->mbox_id, 1);
+    uint32_t msb, lsb;
+
+    while (!vspa_mbox_ready(m)) {
+        if (vspa_mbox_now_ns() > deadline && !vspa_mbox_ready(m))
+            return -ETIMEDOUT;
+        // mock responder may share this core
+        if (m->mock)
+            sched_yield();
+    }
+
+    msb = ioread32(addr);
+    lsb = ioread32(addr + 4);
+    vspa_mbox_clear(m);
+    if (rsp_msb)
+        *rsp_msb = msb;
+    if (rsp_lsb)
+        *rsp_lsb = lsb;
+
+    return 0;
+}
+
+int vspa_mbox_transact(vspa_mbox_t *m, uint32_t msb, uint32_t lsb, uint32_t *rsp_msb, uint32_t *rsp_lsb) {
+    uint32_t out_msb, out_lsb;
+    uint64_t start, rtt;
+    int ret;
+
+    // drop a stale reply, e.g. left by an aborted send without recv
+    if (vspa_mbox_ready(m))
+        vspa_mbox_clear(m);
+
+    start = vspa_mbox_now_ns();
+    vspa_mbox_post(m, msb, lsb);
+    ret = vspa_mbox_wait(m, &out_msb, &out_lsb);
+    if (ret < 0) {
+        m->stats.timeouts++;
+        return ret;
+    }
+
+    rtt = vspa_mbox_now_ns() - start;
+    m->stats.count++;
+    m->stats.sum_ns += rtt;
+    m->stats.last_ns = rtt;
+    if (rtt < m->stats.min_ns)
+        m->stats.min_ns = rtt;
+    if (rtt > m->stats.max_ns)
+        m->stats.max_ns = rtt;
+
+    if (rsp_msb)
+        *rsp_msb = out_msb;
+    if (rsp_lsb)
+        *rsp_lsb = out_lsb;
+    if (!(out_lsb & 0x1)) {
+        m->stats.nacks++;
+        return -EIO;
+    }
+
+    return 0;
+}
+
+int vspa_mbox_send_batch(vspa_mbox_t *m, vspa_mbox_msg_t *msgs, int nb) {
+    int i;
+
+    for (i = 0; i < nb; i++) {
+        msgs[i].ret = vspa_mbox_transact(m, msgs[i].msb, msgs[i].lsb, &msgs[i].rsp_msb, &msgs[i].rsp_lsb);
+        if (msgs[i].ret == -ETIMEDOUT) {
+            msgs[i].rtt_ns = 0;
+            break;
+        }
+        msgs[i].rtt_ns = m->stats.last_ns;
+    }
+
+    return i;
+}
+
+void vspa_mbox_stats_reset(vspa_mbox_t *m) {
+    memset(&m->stats, 0, sizeof(vspa_mbox_stats_t));
+    m->stats.min_ns = UINT64_MAX;
+}
+
+void vspa_mbox_stats_print(vspa_mbox_t *m, const char *name) {
+    vspa_mbox_stats_t *s = &m->stats;
+
+    if (s->count == 0) {
+        printf("%s: VSPA:%d MBox:%d no reply, %lu timeouts\n", name, m->core_idx, m->mbox_id, s->timeouts);
+        return;
+    }
+    printf("%s: VSPA:%d MBox:%d %lu cmds, %lu nacks, %lu timeouts, rtt min %lu avg %lu max %lu ns\n", name, m->core_idx,
+           m->mbox_id, s->count, s->nacks, s->timeouts, s->min_ns, s->sum_ns / s->count, s->max_ns);
+}
+
+/*
+ * Mock VSPA side, run by a test thread or process on the same window.
+ * A post is detected by the mock sequence word, reply is posted in direction 1 and status bit set.
+ */
+int vspa_mbox_mock_serve(vspa_mbox_t *m, vspa_mbox_mock_handler_t handler, void *arg, uint64_t nb) {
+    volatile uint32_t *seq_reg = (volatile uint32_t *)(m->regs + VSPA_MBOX_MOCK_SEQ + 4 * m->mbox_id);
+    volatile uint8_t *in = m->regs + MAILBOX_ADDR(m->mbox_id, 0);
+    volatile uint8_t *out = m->regs + MAILBOX_ADDR(m->mbox_id, 1);
+    uint32_t seq = m->mock_seq, cur, msb, lsb, rsp_msb, rsp_lsb;
+    uint64_t done = 0;
+
+    if (!m->mock)
+        return -EINVAL;
+
+    while (m->mock_run && (nb == 0 || done < nb)) {
+        cur = ioread32(seq_reg);
+        if (cur == seq) {
+            sched_yield();
+            continue;
+        }
+        seq = cur;
+
+        msb = ioread32(in);
+        lsb = ioread32(in + 4);
+        rsp_msb = 0;
+        rsp_lsb = handler ? handler(arg, msb, lsb, &rsp_msb) : 0x1;
+
+        iowrite32(rsp_msb, out);
+        iowrite32(rsp_lsb, out + 4);
+        __atomic_fetch_or((uint32_t *)(m->regs + MAILBOX_STATUS), 1U << m->mbox_id, __ATOMIC_ACQ_REL);
+        done++;
+    }
+
+    return 0;
+}
+
+void vspa_mbox_mock_stop(vspa_mbox_t *m) {
+    m->mock_run = false;
+}
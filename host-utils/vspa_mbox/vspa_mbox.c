@@ -13,37 +13,9 @@
 #include <sys/mman.h>
 #include <string.h>
 #include <stdlib.h>
+#include <errno.h>
 
-#define dsb(opt) asm volatile("dsb " #opt : : : "memory")
-#define dmb(opt) asm volatile("dmb " #opt : : : "memory")
-
-static inline uint32_t ioread32(const volatile void *addr) {
-    uint32_t val;
-
-    asm volatile("ldr %w[val], [%x[addr]]" : [val] "=r"(val) : [addr] "r"(addr));
-
-    dsb(ld);
-    return val;
-}
-
-static inline uint64_t ioread64(const volatile void *addr) {
-    uint64_t val;
-
-    asm volatile("ldr %x[val], [%x[addr]]" : [val] "=r"(val) : [addr] "r"(addr));
-
-    dsb(ld);
-    return val;
-}
-
-static inline void iowrite32(uint32_t val, volatile void *addr) {
-    dsb(st);
-    asm volatile("str %w[val], [%x[addr]]" : : [val] "r"(val), [addr] "r"(addr));
-}
-
-static inline void iowrite64(uint64_t val, volatile void *addr) {
-    dsb(st);
-    asm volatile("str %x[val], [%x[addr]]" : : [val] "r"(val), [addr] "r"(addr));
-}
+#include "vspa_mbox.h"
 
 static inline uint64_t read_from_cfg(char *filename) {
     uint64_t val = 0;
@@ -96,55 +68,49 @@ static inline uint64_t get_modem_ccsr_base(void) {
     return val;
 }
 
-#define MAILBOX_ADDR(base, mbox, direction, core_idx) (base + 0x680 + direction * 0x10 + mbox * 8 + 0x4000 * core_idx)
-/* Assumption: msg is 4 32bit words. */
-static inline void vspa_mbox_send(uint64_t vspa_addr, int core_idx, int mbox_id, uint32_t msb, uint32_t lsb) {
-    uint64_t addr = MAILBOX_ADDR(vspa_addr, mbox_id, 0, core_idx);
-
-    // printf("%s: VSPA[%d] addr 0x%lX  val 0x%lX.\n",__func__, core_idx, addr, (uint64_t)(msb)<<32|(uint64_t)lsb);
-    iowrite32(msb, (void *)addr);
-    iowrite32(lsb, (void *)(addr + 4));
+static void usage(char *argv[]) {
+    printf("%s send core_id mbox_id msb32 lsb32\n", argv[0]);
+    printf("%s recv core_id mbox_id\n", argv[0]);
+    printf("%s batch core_id mbox_id msb32 lsb32 [msb32 lsb32 ...]\n", argv[0]);
 }
 
-static int vspa_mbox_recv(uint64_t vspa_addr, int core_idx, int mbox_id) {
-    uint64_t addr = vspa_addr + 0x660 + 0x4000 * core_idx;
-    uint64_t timeout = 1000000;
-    uint32_t msb, lsb;
-
-    while (timeout && !(ioread32((void *)addr) & (1 << (mbox_id /*+ 2*/))))
-        timeout--;
+/* back to back commands, each waiting for its ACK, in one process / mapping */
+static int batch(vspa_mbox_t *m, int argc, char *argv[]) {
+    vspa_mbox_msg_t *msgs;
+    int nb = argc / 2, done, i;
 
-    if (!timeout) {
-        printf("%s: VCPU:%d MBox:%d is not responding!!\n", __func__, core_idx, mbox_id);
+    if (nb == 0 || argc % 2) {
+        printf("Wrong number of parameters\n");
         return -1;
     }
+    msgs = calloc(nb, sizeof(vspa_mbox_msg_t));
+    if (msgs == NULL)
+        return -1;
+    for (i = 0; i < nb; i++) {
+        msgs[i].msb = strtoul(argv[2 * i], NULL, 16);
+        msgs[i].lsb = strtoul(argv[2 * i + 1], NULL, 16);
+    }
 
-    addr = MAILBOX_ADDR(vspa_addr, mbox_id, 1, core_idx);
-    msb = ioread32((void *)addr);
-    lsb = ioread32((void *)(addr + 4));
-    printf("Received from VSPA:%d, MBox:%d, MSB:0x%08x, LSB:0x%08x.\n", core_idx, mbox_id, msb, lsb);
-    return 0;
-}
-
-static inline void vspa_mbox_clear(uint64_t vspa_addr, int core_idx, int mbox_id) {
-    // uint64_t addr0 = MAILBOX_ADDR(vspa_addr, mbox_id, 1, core_idx);
-    // ioread64((void*)addr0);
-
-    if (mbox_id == 0)
-        iowrite32(1 << 14, (void *)(vspa_addr + 0x10 + 0x4000 * core_idx));
-    else
-        iowrite32(1 << 15, (void *)(vspa_addr + 0x10 + 0x4000 * core_idx));
-}
+    done = vspa_mbox_send_batch(m, msgs, nb);
+    for (i = 0; i < nb; i++) {
+        if (i >= done)
+            printf("0x%08x-0x%08x: not sent\n", msgs[i].msb, msgs[i].lsb);
+        else if (msgs[i].ret == -ETIMEDOUT)
+            printf("0x%08x-0x%08x: VCPU:%d MBox:%d is not responding!!\n", msgs[i].msb, msgs[i].lsb, m->core_idx, m->mbox_id);
+        else
+            printf("0x%08x-0x%08x: %s MSB:0x%08x, LSB:0x%08x, rtt %lu ns\n", msgs[i].msb, msgs[i].lsb,
+                   msgs[i].ret ? "NACK" : "ACK ", msgs[i].rsp_msb, msgs[i].rsp_lsb, msgs[i].rtt_ns);
+    }
+    vspa_mbox_stats_print(m, "batch");
+    free(msgs);
 
-static void usage(char *argv[]) {
-    printf("%s send core_id mbox_id msb32 lsb32\n", argv[0]);
-    printf("%s recv core_id mbox_id\n", argv[0]);
+    return done == nb && m->stats.nacks == 0 ? 0 : -1;
 }
 
 int main(int argc, char *argv[]) {
-    int fd, size;
-    uint64_t vspa_addr_phys, vspa_addr;
     uint32_t core_id = 0, mbox_id = 0, msb32 = 0, lsb32 = 0;
+    vspa_mbox_t mbox;
+    int ret = 0;
 
     if (argc < 4) {
         printf("Wrong number of parameters\n");
@@ -152,8 +118,8 @@ int main(int argc, char *argv[]) {
         return -1;
     }
 
-    if (!((strcmp(argv[1], "send") == 0) || (strcmp(argv[1], "recv") == 0))) {
-        printf("command must be either 'send' or 'recv'\n");
+    if (!((strcmp(argv[1], "send") == 0) || (strcmp(argv[1], "recv") == 0) || (strcmp(argv[1], "batch") == 0))) {
+        printf("command must be either 'send', 'recv' or 'batch'\n");
         usage(argv);
         return -1;
     }
@@ -170,24 +136,14 @@ int main(int argc, char *argv[]) {
         return -1;
     }
 
-    fd = open("/dev/mem", O_RDWR);
-    size = 0x20000;
-
-    // vspa_addr_phys = 0x18000000 + 0x1000000;
-    vspa_addr_phys = get_modem_ccsr_base() + 0x1000000;
-    vspa_addr = (uint64_t)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, vspa_addr_phys);
-
-    if (MAP_FAILED == (void *)vspa_addr) {
-        printf("Failed mmap mbox memory to user-space\n");
-        close(fd);
+    if (vspa_mbox_open(&mbox, get_modem_ccsr_base() + VSPA_MBOX_CCSR_OFFSET, core_id, mbox_id) < 0)
         return -1;
-    }
-    // printf("%s: mailbox_addr_phys 0x%lX vir_addr 0x%lX\n",__func__, vspa_addr_phys, vspa_addr);
 
     if ((strcmp(argv[1], "send") == 0)) {
         if (argc != 6) {
             printf("Wrong number of parameters\n");
             usage(argv);
+            vspa_mbox_close(&mbox);
             return -1;
         }
 
@@ -195,20 +151,25 @@ int main(int argc, char *argv[]) {
         lsb32 = strtoul(argv[5], NULL, 16);
 
         printf("Ready to send 0x%08x-0x%08x to vspa:%d mail box:%d\n", msb32, lsb32, core_id, mbox_id);
-        vspa_mbox_send(vspa_addr, core_id, mbox_id, msb32, lsb32);
+        vspa_mbox_post(&mbox, msb32, lsb32);
 
     } else if ((strcmp(argv[1], "recv") == 0)) {
         if (argc != 4) {
             printf("wrong number of parameters\n");
             usage(argv);
+            vspa_mbox_close(&mbox);
             return -1;
         }
 
-        vspa_mbox_recv(vspa_addr, core_id, mbox_id);
-        vspa_mbox_clear(vspa_addr, core_id, mbox_id);
+        if (vspa_mbox_wait(&mbox, &msb32, &lsb32) < 0)
+            printf("%s: VCPU:%d MBox:%d is not responding!!\n", __func__, core_id, mbox_id);
+        else
+            printf("Received from VSPA:%d, MBox:%d, MSB:0x%08x, LSB:0x%08x.\n", core_id, mbox_id, msb32, lsb32);
+    } else {
+        ret = batch(&mbox, argc - 4, argv + 4);
     }
 
-    //  close(fd);
+    vspa_mbox_close(&mbox);
 
-    return 0;
+    return ret;
 }
@@ -0,0 +1,81 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#ifndef __VSPA_MBOX_H__
+#define __VSPA_MBOX_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * libvspambox : host side of the VSPA mailboxes, mapping kept open across commands.
+ * A transaction posts MSB/LSB in direction 0 and busy-waits the VSPA reply in direction 1,
+ * ACK is reply LSB bit 0. Round trip of every command is timed.
+ */
+
+#define VSPA_MBOX_MAP_SIZE 0x20000
+#define VSPA_MBOX_CCSR_OFFSET 0x1000000 /* VSPA registers in modem CCSR (BAR0) */
+#define VSPA_MBOX_DEFAULT_TIMEOUT_US 1000000 /* ~ former 1,000,000 status polls */
+
+/* mock window : spare word per mailbox bumped after each post, polled by vspa_mbox_mock_serve() */
+#define VSPA_MBOX_MOCK_SEQ 0x1000
+
+typedef struct {
+    uint32_t msb;
+    uint32_t lsb;
+    uint32_t rsp_msb;
+    uint32_t rsp_lsb;
+    int ret; /* 0 ACK, -EIO NACK, -ETIMEDOUT */
+    uint64_t rtt_ns;
+} vspa_mbox_msg_t;
+
+typedef struct {
+    uint64_t count;
+    uint64_t timeouts;
+    uint64_t nacks;
+    uint64_t min_ns;
+    uint64_t max_ns;
+    uint64_t sum_ns;
+    uint64_t last_ns;
+} vspa_mbox_stats_t;
+
+typedef struct {
+    volatile uint8_t *regs; /* VSPA register window of the core */
+    uint8_t *map;
+    int fd;
+    int core_idx;
+    int mbox_id;
+    bool mock;
+    uint32_t mock_seq;
+    volatile bool mock_run;
+    uint32_t timeout_us;
+    vspa_mbox_stats_t stats;
+} vspa_mbox_t;
+
+/* vspa_phys : VSPA register window, i.e. modem CCSR + VSPA_MBOX_CCSR_OFFSET */
+int vspa_mbox_open(vspa_mbox_t *m, uint64_t vspa_phys, int core_idx, int mbox_id);
+/* mock : caller provided VSPA_MBOX_MAP_SIZE window (heap, /dev/shm mapping ...), no hardware */
+int vspa_mbox_open_mock(vspa_mbox_t *m, void *window, int core_idx, int mbox_id);
+void vspa_mbox_close(vspa_mbox_t *m);
+
+void vspa_mbox_post(vspa_mbox_t *m, uint32_t msb, uint32_t lsb);
+int vspa_mbox_wait(vspa_mbox_t *m, uint32_t *rsp_msb, uint32_t *rsp_lsb);
+void vspa_mbox_clear(vspa_mbox_t *m);
+
+/* post and wait ACK, returns 0 on ACK, -EIO on NACK, -ETIMEDOUT */
+int vspa_mbox_transact(vspa_mbox_t *m, uint32_t msb, uint32_t lsb, uint32_t *rsp_msb, uint32_t *rsp_lsb);
+/* back to back transactions, stops on first timeout, returns number of commands answered */
+int vspa_mbox_send_batch(vspa_mbox_t *m, vspa_mbox_msg_t *msgs, int nb);
+
+void vspa_mbox_stats_reset(vspa_mbox_t *m);
+void vspa_mbox_stats_print(vspa_mbox_t *m, const char *name);
+
+/* mock VSPA side : reply to nb posted commands (0 forever), handler returns reply LSB and sets reply MSB */
+typedef uint32_t (*vspa_mbox_mock_handler_t)(void *arg, uint32_t msb, uint32_t lsb, uint32_t *rsp_msb);
+int vspa_mbox_mock_serve(vspa_mbox_t *m, vspa_mbox_mock_handler_t handler, void *arg, uint64_t nb);
+void vspa_mbox_mock_stop(vspa_mbox_t *m);
+
+#endif
@@ -36,6 +36,20 @@ t_rx_ch_host_proxy rx_vspa_proxy[RX_NUM_MAX_CHAN] __attribute__((section(".dmem_
 uint32_t tx_proxy_updated = 0;
 uint32_t rx_proxy_updated = 0;
 uint32_t g_iqflood_proxy_offset = 0;
+/* full duplex DDR DMA arbitration, see iq_sched.h */
+iq_sched_t g_sched = { { IQ_SCHED_IDLE, IQ_SCHED_IDLE } };
+/* event driven main loop, see iq_event.h */
+iq_ev_t g_ev;
+
+/* RX streaming MSI notification, see RX_MSI_config() */
+#define RX_MSI_ADDR 0xA0000000
+#define RX_MSI_SEL_ADDR(reg) (0xB0000000 + (reg) * 0x100)
+static uint32_t rx_msi_every = 0, rx_msi_watermark = 0, rx_msi_count = 0, rx_msi_armed = 1, rx_msi_pending = 0;
+static uint32_t rx_msi_reg = 0;
+static uint32_t rx_msi_proxy_out = 0; /* rx proxy write carrying pending msi level is issued */
+static uint32_t rx_msi_sel_out = 0;   /* msi select write issued, trigger write next */
+static uint32_t rx_msi_data __attribute__((aligned(64))) = 0x0b0b0b0b;
+static mbox_qec_block_t qec_block __attribute__((aligned(64)));
 
 uint32_t TX_SingleT_start_bit_update = 0, RX_SingleT_start_bit_update = 0, RX_SingleT_continue = 0;
 
@@ -89,13 +103,14 @@ bool first_run = true;
 
 void VSPA_PROXY_update(void) {
     if (rx_proxy_updated) {
-        rx_proxy_updated = 0;
+        // keep update pending while channel is busy, msi may only follow an issued proxy write
         if (dmac_is_available(0x1 << DDR_WR_DMA_CHANNEL_5)) {
+            rx_proxy_updated = 0;
             DDR_write_VSPA_PROXY(DDR_WR_DMA_CHANNEL_5,
                                  VSPA_DMEM_PROXY_ADDR + offsetof(struct s_vspa_dmem_proxy, rx_state_readonly) * 2,
                                  2 * (uint32_t) & (rx_vspa_proxy[0]), sizeof(t_rx_ch_host_proxy) * 2 * RX_NUM_CHAN);
-        } else {
-            g_stats.gbl_stats[ERROR_DMA_XFER_ERROR]++;
+            if (rx_msi_pending)
+                rx_msi_proxy_out = 1;
         }
     }
     if (tx_proxy_updated) {
@@ -108,6 +123,60 @@ void VSPA_PROXY_update(void) {
             g_stats.gbl_stats[ERROR_DMA_XFER_ERROR]++;
         }
     }
+    // raise RX MSI once proxy write is out, same dma channel keeps msi behind proxy data
+    // select then trigger writes, as one shot MBOX_OPC_MSI does, one per pass
+    if (rx_msi_proxy_out && !rx_proxy_updated) {
+        if (dmac_is_available(0x1 << DDR_WR_DMA_CHANNEL_5)) {
+            if (!rx_msi_sel_out) {
+                rx_msi_sel_out = 1;
+                DDR_write_MSI(DDR_WR_DMA_CHANNEL_5, RX_MSI_SEL_ADDR(rx_msi_reg), 2 * (uint32_t)&rx_msi_data);
+            } else {
+                rx_msi_pending = 0;
+                rx_msi_proxy_out = 0;
+                rx_msi_sel_out = 0;
+                DDR_write_MSI(DDR_WR_DMA_CHANNEL_5, RX_MSI_ADDR, 2 * (uint32_t)&rx_msi_data);
+                g_stats.gbl_stats[STAT_RX_MSI]++;
+            }
+        }
+    }
+}
+
+/*
+ * RX MSI notification : raise MSI every msi_every RX_DDR_STEP chunks written to DDR (all channels)
+ * and/or once data ready for host reaches msi_watermark chunks (re-armed when it drops below).
+ * 0 disables the trigger. msi_reg selects the MSI as for one shot MBOX_OPC_MSI.
+ */
+void RX_MSI_config(uint32_t msi_reg, uint32_t msi_every, uint32_t msi_watermark) {
+    rx_msi_reg = msi_reg;
+    rx_msi_every = msi_every;
+    rx_msi_watermark = msi_watermark;
+    rx_msi_count = 0;
+    rx_msi_armed = 1;
+    rx_msi_pending = 0;
+    rx_msi_proxy_out = 0;
+    rx_msi_sel_out = 0;
+}
+
+void RX_MSI_chunk_done(uint32_t ready_size) {
+    if (rx_msi_every) {
+        if (++rx_msi_count >= rx_msi_every) {
+            rx_msi_count = 0;
+            rx_msi_pending = 1;
+        }
+    }
+    if (rx_msi_watermark) {
+        if (ready_size >= rx_msi_watermark * RX_DDR_STEP) {
+            if (rx_msi_armed) {
+                rx_msi_armed = 0;
+                rx_msi_pending = 1;
+            }
+        } else {
+            rx_msi_armed = 1;
+        }
+    }
+    // host must see new fifo level before msi
+    if (rx_msi_pending)
+        rx_proxy_updated = 1;
 }
 
 void DDR_write_VSPA_PROXY(uint32_t DDR_wr_dma_channel, uint32_t DDR_address, uint32_t vsp_address, uint32_t size) {
@@ -213,9 +282,35 @@ void DDR_write_MSI(uint32_t DDR_wr_dma_channel, uint32_t DDR_address, uint32_t v
     dmac_enable(ctrl, size, DDR_address, vsp_address);
 }
 
+#ifdef IQ_EVENT_LOOP
+static void iq_ev_setup(void) {
+    uint32_t ddr_rd = 0xF << DDR_RD_DMA_CHANNEL_1, ddr_wr = 0xF << DDR_WR_DMA_CHANNEL_1, axiq_rd = 0, i;
+
+    for (i = 0; i < RX_NUM_MAX_CHAN; i++)
+        axiq_rd |= 0x1 << Rx_Antenna2axiq_dma_chan[i];
+
+    iq_ev_init(&g_ev, IQ_EV_POLL_PERIOD);
+    iq_ev_stage(&g_ev, IQ_EV_STAGE_MBOX, IQ_EV_MBOX0 | IQ_EV_MBOX1 | IQ_EV_POLL);
+    // DDR channels of the other direction too, iq_sched.h gate may hold a DDR DMA back for them
+    iq_ev_stage(&g_ev, IQ_EV_STAGE_TX, (0x1 << DMA_CHANNEL_WR) | ddr_rd | ddr_wr | IQ_EV_POLL);
+    iq_ev_stage(&g_ev, IQ_EV_STAGE_RX, axiq_rd | ddr_wr | ddr_rd | IQ_EV_POLL);
+}
+
+static uint32_t iq_ev_sample(uint32_t mbox_status) {
+    uint32_t events = (dmac_is_complete() | dmac_errxfr()) & IQ_EV_DMA_MASK;
+
+    if (mbox_status & 0x4)
+        events |= IQ_EV_MBOX0;
+    if (mbox_status & 0x8)
+        events |= IQ_EV_MBOX1;
+    return events;
+}
+#endif
+
 //----------------------------------------------------------------------------------------------------
 __attribute__((noreturn)) void main(void) {
     uint64_t msg64 = 0, i = 0;
+    uint32_t ev_run = 0xFFFFFFFF;
 
     l1_trace(L1_TRACE_MSG_ENTRY_MAIN, (uint32_t)iord(CONTROL));
     l1_trace(L1_TRACE_MSG_ENTRY_MAIN, (uint32_t)iord(DMA_GO_STAT));
@@ -245,17 +340,38 @@ __attribute__((noreturn)) void main(void) {
         tx_vspa_proxy.rx_ddr_step = RX_DDR_STEP;
         tx_vspa_proxy.tx_ddr_step = TX_DDR_STEP;
         tx_vspa_proxy.rx_num_chan = RX_NUM_CHAN;
+        tx_vspa_proxy.proxy_version = VSPA_DMEM_PROXY_VERSION;
+        tx_vspa_proxy.tx_cmp_mode = 0;
         tx_proxy_updated = 1;
         for (i = 0; i < RX_NUM_MAX_CHAN; i++) {
             rx_vspa_proxy[i].DDR_wr_base_address = 0xdeadbeef;
             rx_vspa_proxy[i].DDR_wr_size = i;
+            rx_vspa_proxy[i].rx_cmp_mode = 0;
         }
         rx_proxy_updated = 1;
         tx_vspa_proxy.gbl_stats_fetch = 1;
     }
 
+#ifdef IQ_EVENT_LOOP
+    iq_ev_setup();
+#endif
+
     while (1) {
 
+#ifndef IS_SIMULATOR
+        mailbox_in_0_status = (vspa_mbox0_is_valid() | vspa_mbox1_is_valid());
+#else
+        // No mailbox but debugger/tcl script init
+        mailbox_in_0_status = 0x4;
+#endif
+
+#ifdef IQ_EVENT_LOOP
+        // one status sample per round, stages run on their events only
+        ev_run = iq_ev_dispatch(&g_ev, iq_ev_sample(mailbox_in_0_status));
+        if (!ev_run)
+            continue;
+#endif
+
         if (tx_vspa_proxy.gbl_stats_fetch) {
             if (dmac_is_available(0x1 << DDR_WR_DMA_CHANNEL_5)) {
                 tx_vspa_proxy.gbl_stats_fetch = 0;
@@ -267,13 +383,6 @@ __attribute__((noreturn)) void main(void) {
             }
         }
 
-#ifndef IS_SIMULATOR
-        mailbox_in_0_status = (vspa_mbox0_is_valid() | vspa_mbox1_is_valid());
-#else
-        // No mailbox but debugger/tcl script init
-        mailbox_in_0_status = 0x4;
-#endif
-
         if (mailbox_in_0_status & 0x4) {
 #ifndef IS_SIMULATOR
             msg64 = host_mbox0_read();
@@ -340,6 +449,15 @@ __attribute__((noreturn)) void main(void) {
             case MBOX_OPC_MSI: {
                 uint32_t msi_reg = mailbox_in_msg_0_LSB;
 
+                // bit 55 : configure rx streaming notification on MSI msi_reg, every n chunks (bit 39-32) / watermark (bit 47-40)
+                if (mailbox_in_msg_0_MSB & 0x00800000) {
+                    RX_MSI_config(msi_reg, mailbox_in_msg_0_MSB & 0x000000FF, (mailbox_in_msg_0_MSB & 0x0000FF00) >> 8);
+                    mailbox_out_msg_0_MSB = 0;
+                    mailbox_out_msg_0_LSB = 0x1;
+                    host_mbox0_post(MAKEDWORD(mailbox_out_msg_0_MSB, mailbox_out_msg_0_LSB));
+                    break;
+                }
+
                 ((vspa_complex_fixed16 *)input_buffer)->real = 0x0b0b;
                 ((vspa_complex_fixed16 *)input_buffer)->imag = 0x0b0b;
                 dmac_abort(0x1 << DDR_WR_DMA_CHANNEL_1);
@@ -448,6 +566,58 @@ __attribute__((noreturn)) void main(void) {
                 host_mbox0_post(MAKEDWORD(mailbox_out_msg_0_MSB, mailbox_out_msg_0_LSB));
                 break;
 
+            case MBOX_OPC_IQ_CORR_BLOCK: {
+                // full QEC set in one exchange : block read from DDR, then loaded before next QEC kernel call
+                uint32_t blk_err = 0;
+
+                if (mailbox_in_msg_0_LSB & 0xF) {
+                    blk_err = MBOX_QEC_BLOCK_ERR_ALIGN;
+                } else {
+                    // raw read : DMAC_RDC would turn each 16 bit half into sign-magnitude (float taps, checksum)
+                    dmac_enable(DMAC_RD | QEC_BLOCK_DMA_CHANNEL, MBOX_QEC_BLOCK_SIZE, mailbox_in_msg_0_LSB,
+                                2 * (uint32_t)&qec_block);
+                    wait_for_pending_transfers(QEC_BLOCK_DMA_CHANNEL);
+                    if (qec_block.magic != MBOX_QEC_BLOCK_MAGIC)
+                        blk_err = MBOX_QEC_BLOCK_ERR_MAGIC;
+                    else if (qec_block.version != MBOX_QEC_BLOCK_VERSION)
+                        blk_err = MBOX_QEC_BLOCK_ERR_VERSION;
+                    else if (qec_block.checksum != mbox_qec_block_checksum((uint32_t *)&qec_block))
+                        blk_err = MBOX_QEC_BLOCK_ERR_CHECKSUM;
+                }
+
+                if (blk_err) {
+                    mailbox_out_msg_0_MSB = blk_err;
+                    mailbox_out_msg_0_LSB = 0x0;
+                    host_mbox0_post(MAKEDWORD(mailbox_out_msg_0_MSB, mailbox_out_msg_0_LSB));
+                    break;
+                }
+
+                if (qec_block.flags & MBOX_QEC_BLOCK_TX) {
+#ifdef TXIQCOMP2
+                    rf_load_iq_comp_params2(&iq_comp_params2_tx, &qec_block);
+#else
+                    rf_load_iq_comp_params(&txiqcompcfg_struct, &qec_block);
+#endif
+#ifndef IQMOD_RX_0T1R
+                    // update single tone pattern
+                    if (TX_SingleT_start_bit_update) {
+                        gen_nco_single_tone(TX_SingleT_buffer);
+                    }
+#endif
+                } else {
+#ifdef RXIQCOMP2
+                    rf_load_iq_comp_params2(&iq_comp_params2_rx, &qec_block);
+#else
+                    rf_load_iq_comp_params(&rxiqcompcfg_struct, &qec_block);
+#endif
+                }
+
+                mailbox_out_msg_0_MSB = qec_block.seq;
+                mailbox_out_msg_0_LSB = 0x1;
+                host_mbox0_post(MAKEDWORD(mailbox_out_msg_0_MSB, mailbox_out_msg_0_LSB));
+                break;
+            }
+
             case MBOX_OPC_GET_STATS_COUNT:
                 uint32_t counter_rst = ((mailbox_in_msg_0_MSB & 0x00100000) >> 20); /* bit 52 */
                 uint32_t counter_idx = mailbox_in_msg_0_MSB & 0x0000FFFF;           /* bit 47-32*/
@@ -517,10 +687,12 @@ __attribute__((noreturn)) void main(void) {
         }
 
 #ifndef IQMOD_RX_0T1R
-        PUSH_TX_DATA();
+        if (ev_run & (1U << IQ_EV_STAGE_TX))
+            PUSH_TX_DATA();
 #endif
 #ifndef IQMOD_RX_1T0R
-        PUSH_RX_DATA();
+        if (ev_run & (1U << IQ_EV_STAGE_RX))
+            PUSH_RX_DATA();
 #endif
     }
 
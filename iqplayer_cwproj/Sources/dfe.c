@@ -161,6 +161,44 @@ void rf_update_iq_comp_params(structTXIQCompParams *params_ptr, uint32_t rst, ui
     }
 }
 
+// MBOX_OPC_IQ_CORR_BLOCK : load all valid fields at once, QEC kernel never runs on a partial set
+void rf_load_iq_comp_params2(structTXIQCompParams2 *params_ptr, const mbox_qec_block_t *blk) {
+    uint32_t i;
+
+    if (blk->flags & MBOX_QEC_BLOCK_RST)
+        rf_update_iq_comp_params2(params_ptr, 1, 0, 0);
+
+    for (i = 0; i < MBOX_QEC_BLOCK_NB_TAPS; i++) {
+#pragma loop_count(12, 12, 12, 0)
+        if (blk->valid_mask & MBOX_QEC_BLOCK_FTAP(i))
+            params_ptr->IQImb_ftaps[i] = blk->ftaps[i];
+    }
+    if (blk->valid_mask & MBOX_QEC_BLOCK_DC_I)
+        params_ptr->dcOffset.real = blk->dc_i;
+    if (blk->valid_mask & MBOX_QEC_BLOCK_DC_Q)
+        params_ptr->dcOffset.imag = blk->dc_q;
+    if (blk->valid_mask & MBOX_QEC_BLOCK_FDELAY)
+        params_ptr->IQImb_delay = blk->delay;
+}
+
+// 4 taps kernel, taps 4-11 and delay of the block are ignored
+void rf_load_iq_comp_params(structTXIQCompParams *params_ptr, const mbox_qec_block_t *blk) {
+    uint32_t i;
+
+    if (blk->flags & MBOX_QEC_BLOCK_RST)
+        rf_update_iq_comp_params(params_ptr, 1, 0, 0);
+
+    for (i = 0; i < 4; i++) {
+#pragma loop_count(4, 4, 4, 0)
+        if (blk->valid_mask & MBOX_QEC_BLOCK_FTAP(i))
+            params_ptr->IQImb_ftaps[i] = blk->ftaps[i];
+    }
+    if (blk->valid_mask & MBOX_QEC_BLOCK_DC_I)
+        params_ptr->dcOffset.real = blk->dc_i;
+    if (blk->valid_mask & MBOX_QEC_BLOCK_DC_Q)
+        params_ptr->dcOffset.imag = blk->dc_q;
+}
+
 #ifndef IQMOD_RX_0T1R
 void stream_write_ptr_rst(uint32_t dma_channel_wr, uint32_t axi_wr) {
     uint32_t ctrl = DMAC_FIFO_RESET | DMAC_WRC | dma_channel_wr;
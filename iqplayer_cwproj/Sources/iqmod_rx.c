@@ -23,6 +23,7 @@
 #include "iqmod_rx.h"
 #include "stats.h"
 #include "vspa_dmem_proxy.h"
+#include "iq_rx_budget.h"
 
 vspa_complex_fixed16 input_buffer[RX_NUM_BUF * RX_DMA_TXR_size] __attribute__((section(".vcpu_dmem")))
 __attribute__((aligned(64))) = { 0x00000000, 0x00010001, 0x00020002, 0x00030003 };
@@ -31,6 +32,7 @@ __attribute__((aligned(64))) = { 0x00000000, 0x00010001, 0x00020002, 0x00030003
 
 // uint32_t DDR_wr_QEC_enable= 0, DDR_wr_CMP_enable=0;
 #define DDR_wr_QEC_enable 1
+// no VSPA compressor : MBOX_IQMOD_RX_CMP is NACKed, BFP format and model in iq_bfp.h (host side only)
 #define DDR_wr_CMP_enable 0
 uint32_t DDR_wr_start_bit_update = 0, DDR_wr_load_start_bit_update = 0, DDR_wr_continuous = 0;
 uint32_t ddr_wr_dma_xfr_size = RX_DDR_STEP;
@@ -50,6 +52,13 @@ static uint32_t RX_total_ddr_enqueued_size = 0;
 #define RX_total_dmem_consumed_size (rx_vspa_proxy[0].la9310_fifo_consumed_size) /* 6: xfer to DDR complete 	*/
 #define RX_total_ddr_consumed_size (tx_vspa_proxy.host_consumed_size[0])         /* 7: DDR data ready */
 
+#ifdef IQ_EVENT_LOOP
+// moves whenever PUSH_RX_DATA() did some work, next round may have more, see iq_event.h
+#define RX_EV_SEQ()                                                                                                 \
+    (RX_total_axiq_enqueued_size + RX_total_axiq_received_size + RX_total_dmem_QECed_size + RX_total_dmem_CMPed_size + \
+     RX_total_ddr_enqueued_size + RX_total_dmem_consumed_size + g_stats.rx_stats[0][STAT_DMA_DDR_WR])
+#endif
+
 static vspa_complex_fixed16 *p_rx_axiq_enqueued = &input_buffer[0];
 static vspa_complex_fixed16 *p_rx_axiq_received = &input_buffer[0];
 static vspa_complex_fixed16 *p_rx_dmem_QECed_in = &input_buffer[0];
@@ -91,14 +100,10 @@ void DDR_write_multi_dma(uint32_t DDR_wr_dma_channel, uint32_t nb_dma, uint32_t
     }
 }
 
-volatile cmp_cycle = 0;
-#define CMP_CYCLES (24 + 2 * 512 / 32)
+// CMP stage, empty until a vector BFP kernel fits the chunk period (doc : RX BFP compression)
 void rx_compress(vspa_complex_fixed16 *data) {
     if (!DDR_wr_CMP_enable)
         return;
-    // compression place holder
-    for (cmp_cycle = 0; cmp_cycle < CMP_CYCLES; cmp_cycle++) {
-    };
 }
 void rx_qec_correction(vspa_complex_fixed16 *dataIn, vspa_complex_fixed16 *dataOut) {
     if (!DDR_wr_QEC_enable)
@@ -119,11 +124,13 @@ void RX_IQ_DATA_TO_DDR(void) {
     uint32_t cmd_start = (HIWORD(msg64)) & 0x00100000;
 
     if ((cmd_start) && (!DDR_wr_start_bit_update)) {
+        // no firmware compressor, checked before the start bit is taken
+        if ((HIWORD(msg64)) & MBOX_IQMOD_RX_CMP)
+            goto fail_rx_iq_data;
         DDR_wr_start_bit_update = 1;
         DDR_wr_load_start_bit_update = (HIWORD(msg64)) & 0x00200000;
         DDR_wr_continuous = (HIWORD(msg64)) & 0x00800000;
         // DDR_wr_QEC_enable= 				(HIWORD(msg64)) & 0x00400000;
-        // DDR_wr_CMP_enable=  			(HIWORD(msg64)) & 0x00080000;
         ddr_wr_dma_ch_nb = ((HIWORD(msg64)) & 0x00070000) >> 16;
         host_flow_control_disable = (HIWORD(msg64)) & 0x00400000;
 
@@ -132,12 +139,15 @@ void RX_IQ_DATA_TO_DDR(void) {
 
         if (ddr_wr_dma_ch_nb > 2)
             goto fail_rx_iq_data;
+        // channel count left to firmware : scheduler adapts it to full duplex deadlines
+        iq_sched_start(&g_sched, IQ_SCHED_RX, RX_DDR_STEP, !ddr_wr_dma_ch_nb, 1, 1, 1, 2);
         if (!ddr_wr_dma_ch_nb) {
             // default 1 DMA write 526MB/s half duplex, 490MB/s full duplex
             ddr_wr_dma_ch_nb = 1;
         }
         ddr_wr_dma_ch_mask = dma_chan_mask(DDR_WR_DMA_CHANNEL_1, ddr_wr_dma_ch_nb);
-        ddr_wr_dma_xfr_size = (DDR_wr_CMP_enable ? RX_DDR_STEP * RX_COMPRESS_RATIO_PCT / 100 : RX_DDR_STEP);
+        ddr_wr_dma_xfr_size = RX_DDR_STEP;
+        rx_vspa_proxy[0].rx_cmp_mode = DDR_wr_CMP_enable;
 
         dmac_reset(0x1 << dma_channel_rd);
 
@@ -153,8 +163,10 @@ void RX_IQ_DATA_TO_DDR(void) {
         RX_total_axiq_received_size = 0;
         RX_total_dmem_QECed_size = 0;
         RX_total_dmem_CMPed_size = 0;
+        rx_vspa_proxy[0].la9310_fifo_produced_size_hi = 0;
         RX_total_ddr_enqueued_size = 0;
         RX_total_dmem_consumed_size = 0;
+        rx_vspa_proxy[0].la9310_fifo_consumed_size_hi = 0;
 
         DDR_wr_size = ((mailbox_in_msg_0_MSB & 0x0000FFFF) * SIZE_4K); // send chunks of 4KB can be sent
         DDR_wr_base_address = mailbox_in_msg_0_LSB;
@@ -220,8 +232,11 @@ void RX_IQ_DATA_TO_DDR(void) {
         }
 
         DDR_wr_base_address = 0xdeadbeef;
+        iq_sched_stop(&g_sched, IQ_SCHED_RX);
         RX_total_dmem_CMPed_size = 0;
+        rx_vspa_proxy[0].la9310_fifo_produced_size_hi = 0;
         RX_total_dmem_consumed_size = 0;
+        rx_vspa_proxy[0].la9310_fifo_consumed_size_hi = 0;
 
         DDR_wr_start_bit_update = 0;
         DDR_wr_load_start_bit_update = 0;
@@ -251,6 +266,10 @@ void PUSH_RX_DATA(void) {
     uint32_t tmp_status;
     uint32_t tmp_dma_errors;
     uint32_t rx_empty_size;
+    uint32_t nb, ready;
+#ifdef IQ_EVENT_LOOP
+    uint32_t ev_seq = RX_EV_SEQ();
+#endif
 
     // Check AXIQ rx fifo is not full or overrun
     tmp_status = axiq_fifo_rx_sr(AXIQ_BANK_0, Rx_Antenna2fifo_index[RX_index], AXIQ_SR_FIELD_ERROVER | AXIQ_SR_FIELD_ERRUNDER);
@@ -358,9 +377,9 @@ void PUSH_RX_DATA(void) {
         if ((RX_total_dmem_QECed_size - RX_total_dmem_CMPed_size) >= RX_DDR_STEP) {
             // Compress buffer
             l1_trace(L1_TRACE_L1APP_RX_CMP_START, (uint32_t)p_rx_dmem_CMPed);
-            // rx_compress((vspa_complex_fixed16 *)p_rx_dmem_CMPed);
+            rx_compress((vspa_complex_fixed16 *)p_rx_dmem_CMPed);
             INCR_RX_QEC_BUFF(p_rx_dmem_CMPed);
-            RX_total_dmem_CMPed_size += RX_DDR_STEP;
+            PROXY_CNT_ADD(RX_total_dmem_CMPed_size, rx_vspa_proxy[0].la9310_fifo_produced_size_hi, RX_DDR_STEP);
             l1_trace(L1_TRACE_L1APP_RX_CMP_COMP, (uint32_t)RX_total_dmem_QECed_size);
 
             // update host vspa_dmem_proxy
@@ -371,30 +390,47 @@ void PUSH_RX_DATA(void) {
             // check DDR dma completion
             if (dmac_is_complete(ddr_wr_dma_ch_mask) == ddr_wr_dma_ch_mask) {
                 dmac_clear_complete(ddr_wr_dma_ch_mask);
-                RX_total_dmem_consumed_size += RX_DDR_STEP;
+                PROXY_CNT_ADD(RX_total_dmem_consumed_size, rx_vspa_proxy[0].la9310_fifo_consumed_size_hi, RX_DDR_STEP);
                 g_stats.rx_stats[0][STAT_DMA_DDR_WR]++;
                 l1_trace(L1_TRACE_MSG_DMA_DDR_WR_COMP, (uint32_t)g_stats.rx_stats[0][STAT_DMA_DDR_WR]);
+                RX_MSI_chunk_done(RX_total_dmem_consumed_size - RX_total_ddr_consumed_size);
                 if (DDR_wr_buff_wrap_equeued) {
                     DDR_wr_buff_wrap_equeued = 0;
                     DDR_wr_buff_loop_count++;
                 }
             }
 
+            // deadline is AXIQ RX overflow once dmem is full, publish it with write readiness
+            rx_busy_size = RX_total_axiq_enqueued_size - RX_total_dmem_consumed_size;
+            rx_empty_size = (RX_NUM_BUF + RX_NUM_QEC_BUF) * RX_DDR_STEP - rx_busy_size;
             // host flow control
-            if ((RX_total_ddr_enqueued_size - tx_vspa_proxy.host_consumed_size[0] < DDR_wr_size) || host_flow_control_disable) {
-                if ((RX_total_dmem_CMPed_size - RX_total_ddr_enqueued_size) >= RX_DDR_STEP) {
-                    if (dmac_is_available(ddr_wr_dma_ch_mask) == ddr_wr_dma_ch_mask) {
-                        DDR_write_multi_dma(DDR_WR_DMA_CHANNEL_1, ddr_wr_dma_ch_nb, DDR_wr_base_address + DDR_wr_offset,
-                                            2 * (uint32_t)p_rx_ddr_enqueued, ddr_wr_dma_xfr_size);
-                        INCR_RX_QEC_BUFF(p_rx_ddr_enqueued);
-                        RX_total_ddr_enqueued_size += RX_DDR_STEP;
-                        DDR_wr_offset += ddr_wr_dma_xfr_size;
-                        if (DDR_wr_offset >= DDR_wr_size) {
-                            DDR_wr_buff_wrap_equeued = 1;
-                            DDR_wr_offset = 0;
-                        }
-                        l1_trace(L1_TRACE_MSG_DMA_DDR_WR_START, (uint32_t)p_rx_ddr_enqueued);
+            ready = (RX_total_ddr_enqueued_size - tx_vspa_proxy.host_consumed_size[0] < DDR_wr_size);
+            ready = ready || host_flow_control_disable;
+            ready = ready && ((RX_total_dmem_CMPed_size - RX_total_ddr_enqueued_size) >= RX_DDR_STEP);
+            iq_sched_update(&g_sched, IQ_SCHED_RX, rx_empty_size, ready);
+
+            // DDR channel count follows deadlines, only between transfers
+            if (RX_total_ddr_enqueued_size == RX_total_dmem_consumed_size) {
+                nb = iq_sched_ch_nb(&g_sched, IQ_SCHED_RX, ddr_wr_dma_ch_nb);
+                if (nb != ddr_wr_dma_ch_nb) {
+                    ddr_wr_dma_ch_nb = nb;
+                    ddr_wr_dma_ch_mask = dma_chan_mask(DDR_WR_DMA_CHANNEL_1, ddr_wr_dma_ch_nb);
+                }
+            }
+
+            // earliest deadline first with tx DDR reads
+            if (g_sched.pending[IQ_SCHED_RX] && iq_sched_may_issue(&g_sched, IQ_SCHED_RX)) {
+                if (dmac_is_available(ddr_wr_dma_ch_mask) == ddr_wr_dma_ch_mask) {
+                    DDR_write_multi_dma(DDR_WR_DMA_CHANNEL_1, ddr_wr_dma_ch_nb, DDR_wr_base_address + DDR_wr_offset,
+                                        2 * (uint32_t)p_rx_ddr_enqueued, ddr_wr_dma_xfr_size);
+                    INCR_RX_QEC_BUFF(p_rx_ddr_enqueued);
+                    RX_total_ddr_enqueued_size += RX_DDR_STEP;
+                    DDR_wr_offset += ddr_wr_dma_xfr_size;
+                    if (DDR_wr_offset + ddr_wr_dma_xfr_size > DDR_wr_size) {
+                        DDR_wr_buff_wrap_equeued = 1;
+                        DDR_wr_offset = 0;
                     }
+                    l1_trace(L1_TRACE_MSG_DMA_DDR_WR_START, (uint32_t)p_rx_ddr_enqueued);
                 }
             }
         }
@@ -405,6 +441,7 @@ void PUSH_RX_DATA(void) {
             axiq_fifo_rx_disable(AXIQ_BANK_0, Rx_Antenna2fifo_index[RX_index]);
 
             DDR_wr_base_address = 0xdeadbeef;
+            iq_sched_stop(&g_sched, IQ_SCHED_RX);
             DDR_wr_start_bit_update = 0;
             mailbox_out_msg_0_MSB = 0;
             mailbox_out_msg_0_LSB = 0x1;
@@ -428,5 +465,9 @@ end_rx_push:
 
     // update host proxy if needed
     VSPA_PROXY_update();
+#ifdef IQ_EVENT_LOOP
+    if (RX_EV_SEQ() != ev_seq)
+        iq_ev_progress(&g_ev, IQ_EV_STAGE_RX);
+#endif
 }
 #pragma optimize_for_size reset
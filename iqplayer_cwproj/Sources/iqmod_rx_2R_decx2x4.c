@@ -25,6 +25,7 @@
 #include "stats.h"
 #include "ddc2x4x.h"
 #include "vspa_dmem_proxy.h"
+#include "iq_rx_budget.h"
 
 vspa_complex_fixed16 input_buffer[RX_NUM_CHAN][RX_NUM_BUF * RX_DMA_TXR_size] __attribute__((section(".ippu_dmem")))
 __attribute__((aligned(64)));
@@ -75,19 +76,41 @@ void DDR_write_multi_dma(uint32_t DDR_wr_dma_channel, uint32_t nb_dma, uint32_t
     }
 }
 
+// QEC one AXIQ chunk in place, RX chunk is 256 samples in 1T4R : MEM_LINE_SIZE (512 samples) would run into next buffer
+#define RX_QEC_LINES (RX_DMA_TXR_size / 32)
+
 void rx_qec_correction(vspa_complex_fixed16 *dataIn, vspa_complex_fixed16 *dataOut) {
     //	if(!DDR_wr_QEC_enable)
     //		return;
 
 #ifdef RXIQCOMP2
-    txiqcomp_x32chf_5t((vspa_complex_fixed16 *)dataIn, (vspa_complex_fixed16 *)dataOut, &iq_comp_params2_rx, MEM_LINE_SIZE);
+    txiqcomp_x32chf_5t((vspa_complex_fixed16 *)dataIn, (vspa_complex_fixed16 *)dataOut, &iq_comp_params2_rx, RX_QEC_LINES);
 #else
 #ifdef RXIQCOMP
-    txiqcomp((vspa_complex_fixed16 *)dataIn, (vspa_complex_fixed16 *)dataOut, &rxiqcompcfg_struct, MEM_LINE_SIZE);
+    txiqcomp((vspa_complex_fixed16 *)dataIn, (vspa_complex_fixed16 *)dataOut, &rxiqcompcfg_struct, RX_QEC_LINES);
 #endif
 #endif
 }
 
+// arm next AXIQ read of channel i if a DMEM chunk is free, returns 0 when DMA is available but RX ring is full
+static inline uint32_t rx_axiq_rearm(uint32_t i) {
+    uint32_t rx_busy, rx_empty;
+
+    dma_channel_rd = Rx_Antenna2axiq_dma_chan[i + RX_index];
+    if (!dmac_is_available(0x1 << dma_channel_rd))
+        return 1;
+    rx_busy = rx_ch_context[i].RX_total_axiq_enqueued_size - rx_ch_context[i].RX_total_dmem_input_Decimated_size;
+    rx_empty = (RX_NUM_BUF * RX_DMA_TXR_STEP) - rx_busy;
+    if (rx_empty < RX_DMA_TXR_STEP)
+        return 0;
+    axi_rd = axi_ADC_FIFO_addr[i];
+    stream_read(dma_channel_rd, axi_rd, 2 * (uint32_t)(rx_ch_context[i].p_rx_axiq_enqueued));
+    INCR_RX_BUFF(rx_ch_context[i].p_rx_axiq_enqueued, i);
+    rx_ch_context[i].RX_total_axiq_enqueued_size += RX_DMA_TXR_STEP;
+    l1_trace(L1_TRACE_MSG_DMA_AXIQ_RX_START, (uint32_t)rx_ch_context[i].p_rx_axiq_enqueued);
+    return 1;
+}
+
 //__attribute__(( section(".text.opcode_6") ))
 void RX_IQ_DATA_TO_DDR(void) {
     uint64_t msg64 = host_mbox0_read();
@@ -131,8 +154,10 @@ void RX_IQ_DATA_TO_DDR(void) {
             rx_ch_context[i].RX_total_dmem_input_Decimated_size = 0;
             // rx_ch_context[i].RX_total_dmem_output_Decimated_size = 0;
             rx_vspa_proxy[i].la9310_fifo_produced_size = 0; // RX_total_dmem_output_Decimated_size = 0;
+            rx_vspa_proxy[i].la9310_fifo_produced_size_hi = 0;
             rx_ch_context[i].RX_total_ddr_enqueued_size = 0;
             rx_vspa_proxy[i].la9310_fifo_consumed_size = 0;
+            rx_vspa_proxy[i].la9310_fifo_consumed_size_hi = 0;
             rx_ch_context[i].DDR_wr_offset = 0;
             // rx_ch_context[i].DDR_wr_base_address=mailbox_in_msg_0_LSB+i*DDR_wr_size/RX_NUM_CHAN;
             rx_vspa_proxy[i].DDR_wr_base_address = mailbox_in_msg_0_LSB + i * DDR_wr_size / RX_NUM_CHAN;
@@ -196,6 +221,8 @@ void RX_IQ_DATA_TO_DDR(void) {
             rx_vspa_proxy[i].DDR_wr_base_address = 0xdeadbeef;
             rx_vspa_proxy[i].la9310_fifo_produced_size = 0;
             rx_vspa_proxy[i].la9310_fifo_consumed_size = 0;
+            rx_vspa_proxy[i].la9310_fifo_produced_size_hi = 0;
+            rx_vspa_proxy[i].la9310_fifo_consumed_size_hi = 0;
             dma_channel_rd = Rx_Antenna2axiq_dma_chan[i + RX_index];
             dmac_abort(0x1 << dma_channel_rd);
             dmac_clear_complete(0x1 << dma_channel_rd);
@@ -226,9 +253,11 @@ void PUSH_RX_DATA(void) {
     uint32_t tmp_dma_errors;
     uint32_t rx_empty_size;
     uint32_t all_chan_ddr_consumed_size = 0;
+    uint32_t axiq_sr, dma_comp, nb_chunks, ddr_room;
 
-    // Check AXIQ rx fifo is not full or overrun
-    for (i = 0; i < RX_NUM_CHAN; i++) {
+    // Check AXIQ rx fifo is not full or overrun, all RX fifos share AXIQ_SR0 : one read, walk channels on error only
+    axiq_sr = iord(AXIQ_SR0, AXIQ_SR_FIELD_ERROVER_RX_ALL | AXIQ_SR_FIELD_ERRUNDER_RX_ALL);
+    for (i = 0; (i < RX_NUM_CHAN) && axiq_sr; i++) {
         dma_channel_rd = Rx_Antenna2axiq_dma_chan[i + RX_index];
         axi_rd = axi_ADC_FIFO_addr[i];
         tmp_status = axiq_fifo_rx_sr(AXIQ_BANK_0, Rx_Antenna2fifo_index[rx_ch_context[i].RX_index],
@@ -301,11 +330,13 @@ void PUSH_RX_DATA(void) {
     // Stream waveform to DDR
     if (DDR_wr_start_bit_update) {
 
+        // DMA completion status sampled once per round, AXIQ reads and DDR writes of all channels
+        dma_comp = dmac_is_complete();
+
         // check axiq dma completion
         for (i = 0; i < RX_NUM_CHAN; i++) {
             dma_channel_rd = Rx_Antenna2axiq_dma_chan[i + RX_index];
-            axi_rd = axi_ADC_FIFO_addr[i];
-            if (dmac_is_complete(0x1 << dma_channel_rd)) {
+            if (dma_comp & (0x1 << dma_channel_rd)) {
                 dmac_clear_complete(0x1 << dma_channel_rd);
                 dmac_clear_event(0x1 << dma_channel_rd);
                 rx_ch_context[i].RX_total_axiq_received_size += RX_DMA_TXR_STEP;
@@ -331,7 +362,8 @@ void PUSH_RX_DATA(void) {
             }
         }
 
-        // Decimation
+        // Decimation, one decimator pass per channel back to back, AXIQ read re-armed as soon as its chunk is freed
+        // so that channel 0 does not wait for the decimation of channels 1-3
         for (i = 0; i < RX_NUM_CHAN; i++) {
             if ((rx_ch_context[i].RX_total_dmem_QECed_size - rx_ch_context[i].RX_total_dmem_input_Decimated_size) >=
                 RX_DMA_TXR_STEP) {
@@ -341,81 +373,88 @@ void PUSH_RX_DATA(void) {
                 rx_empty_size = (RX_NUM_DEC_BUF * RX_DDR_STEP) - rx_busy_size;
                 if (rx_empty_size >= RX_DDR_STEP) {
                     l1_trace(L1_TRACE_L1APP_RX_DEC_START, (uint32_t)rx_ch_context[i].p_rx_dmem_QECed);
-#if defined(IQMOD_RX_1T2R) || defined(IQMOD_RX_1T4R)
-                    decimator_2x_8_Taps_asm((cfixed16_t *)rx_ch_context[i].p_rx_dmem_output_decimated,
-                                            (cfixed16_t *)rx_ch_context[i].p_rx_dmem_input_decimated,
-                                            (float32_t *)filter_taps_downsampling, (cfixed16_t *)filtState[i], RX_DMA_TXR_size);
-
-#endif
-#ifdef IQMOD_RX_1T4R
                     decimator_2x_8_Taps_asm((cfixed16_t *)rx_ch_context[i].p_rx_dmem_output_decimated,
                                             (cfixed16_t *)rx_ch_context[i].p_rx_dmem_input_decimated,
                                             (float32_t *)filter_taps_downsampling, (cfixed16_t *)filtState[i], RX_DMA_TXR_size);
-#endif
                     INCR_RX_BUFF(rx_ch_context[i].p_rx_dmem_input_decimated, i);
                     INCR_RX_DEC_BUFF(rx_ch_context[i].p_rx_dmem_output_decimated, i);
                     rx_ch_context[i].RX_total_dmem_input_Decimated_size += RX_DMA_TXR_STEP;
                     // rx_ch_context[i].RX_total_dmem_output_Decimated_size+= RX_DDR_STEP;
-                    rx_vspa_proxy[i].la9310_fifo_produced_size += RX_DDR_STEP;
+                    PROXY_CNT_ADD(rx_vspa_proxy[i].la9310_fifo_produced_size, rx_vspa_proxy[i].la9310_fifo_produced_size_hi,
+                                  RX_DDR_STEP);
                     rx_proxy_updated = 1;
                     l1_trace(L1_TRACE_L1APP_RX_DEC_COMP, (uint32_t)rx_ch_context[i].RX_total_dmem_input_Decimated_size);
+                    rx_axiq_rearm(i);
                 }
             }
         }
 
         // Push data to DDR if standalone mode
+        // One DDR write in flight per channel, chunks decimated meanwhile go in the next write up to DMEM ring wrap,
+        // DDR buffer wrap and host flow control : fewer, larger DMAs when DDR lags. Completion bit is a level, a
+        // single transfer in flight keeps consumed size exact.
         if (!RX_ext_dma_enabled) {
             for (i = 0; i < RX_NUM_CHAN; i++) {
                 // check DDR dma completion
                 ddr_wr_dma_ch_mask = dma_chan_mask(DDR_WR_DMA_CHANNEL_1 + i, 1);
-                if (dmac_is_complete(ddr_wr_dma_ch_mask) == ddr_wr_dma_ch_mask) {
+                if ((dma_comp & ddr_wr_dma_ch_mask) == ddr_wr_dma_ch_mask) {
                     dmac_clear_complete(ddr_wr_dma_ch_mask);
-                    rx_vspa_proxy[i].la9310_fifo_consumed_size += RX_DDR_STEP;
+                    nb_chunks = (rx_ch_context[i].RX_total_ddr_enqueued_size - rx_vspa_proxy[i].la9310_fifo_consumed_size) /
+                                RX_DDR_STEP;
+                    PROXY_CNT_ADD(rx_vspa_proxy[i].la9310_fifo_consumed_size, rx_vspa_proxy[i].la9310_fifo_consumed_size_hi,
+                                  nb_chunks * RX_DDR_STEP);
                     g_stats.rx_stats[i][STAT_DMA_DDR_WR]++;
                     l1_trace(L1_TRACE_MSG_DMA_DDR_WR_COMP, (uint32_t)g_stats.rx_stats[i][STAT_DMA_DDR_WR]);
+                    while (nb_chunks--)
+                        RX_MSI_chunk_done(rx_vspa_proxy[i].la9310_fifo_consumed_size - tx_vspa_proxy.host_consumed_size[i]);
                 }
-
+                if (rx_ch_context[i].RX_total_ddr_enqueued_size != rx_vspa_proxy[i].la9310_fifo_consumed_size)
+                    continue;
+
+                // if ((rx_ch_context[i].RX_total_dmem_output_Decimated_size-rx_ch_context[i].RX_total_ddr_enqueued_size) >=
+                // RX_DDR_STEP)
+                nb_chunks = rx_vspa_proxy[i].la9310_fifo_produced_size - rx_ch_context[i].RX_total_ddr_enqueued_size;
+                nb_chunks /= RX_DDR_STEP;
+                // contiguous in DMEM before decimated ring wraps
+                ddr_room = (&input_dec_buffer[i][RX_NUM_DEC_BUF * RX_DMA_TXR_size / RX_DECIM] -
+                            rx_ch_context[i].p_rx_ddr_enqueued) /
+                           (RX_DMA_TXR_size / RX_DECIM);
+                if (nb_chunks > ddr_room)
+                    nb_chunks = ddr_room;
+                // contiguous in DDR before DDR buffer wraps
+                ddr_room = (rx_vspa_proxy[i].DDR_wr_size - rx_ch_context[i].DDR_wr_offset) / RX_DDR_STEP;
+                if (nb_chunks > ddr_room)
+                    nb_chunks = ddr_room;
                 // host flow control
-                if ((rx_ch_context[i].RX_total_ddr_enqueued_size - tx_vspa_proxy.host_consumed_size[i] <
-                     rx_vspa_proxy[i].DDR_wr_size) ||
-                    host_flow_control_disable) {
-                    // if ((rx_ch_context[i].RX_total_dmem_output_Decimated_size-rx_ch_context[i].RX_total_ddr_enqueued_size) >=
-                    // RX_DDR_STEP)
-                    if ((rx_vspa_proxy[i].la9310_fifo_produced_size - rx_ch_context[i].RX_total_ddr_enqueued_size) >= RX_DDR_STEP) {
-                        if (dmac_is_available(ddr_wr_dma_ch_mask) == ddr_wr_dma_ch_mask) {
-                            DDR_write_multi_dma(DDR_WR_DMA_CHANNEL_1 + i, 1,
-                                                rx_vspa_proxy[i].DDR_wr_base_address + rx_ch_context[i].DDR_wr_offset,
-                                                2 * (uint32_t)rx_ch_context[i].p_rx_ddr_enqueued, ddr_wr_dma_xfr_size);
-                            INCR_RX_DEC_BUFF(rx_ch_context[i].p_rx_ddr_enqueued, i);
-                            rx_ch_context[i].RX_total_ddr_enqueued_size += RX_DDR_STEP;
-                            rx_ch_context[i].DDR_wr_offset += ddr_wr_dma_xfr_size;
-                            if (rx_ch_context[i].DDR_wr_offset >= rx_vspa_proxy[i].DDR_wr_size)
-                                rx_ch_context[i].DDR_wr_offset = 0;
-                            l1_trace(L1_TRACE_MSG_DMA_DDR_WR_START, (uint32_t)rx_ch_context[i].p_rx_ddr_enqueued);
-                        }
-                    }
+                if (!host_flow_control_disable) {
+                    ddr_room = rx_ch_context[i].RX_total_ddr_enqueued_size - tx_vspa_proxy.host_consumed_size[i];
+                    ddr_room = (ddr_room < rx_vspa_proxy[i].DDR_wr_size) ? (rx_vspa_proxy[i].DDR_wr_size - ddr_room) / RX_DDR_STEP
+                                                                         : 0;
+                    if (nb_chunks > ddr_room)
+                        nb_chunks = ddr_room;
+                }
+                if (nb_chunks && (dmac_is_available(ddr_wr_dma_ch_mask) == ddr_wr_dma_ch_mask)) {
+                    DDR_write_multi_dma(DDR_WR_DMA_CHANNEL_1 + i, 1,
+                                        rx_vspa_proxy[i].DDR_wr_base_address + rx_ch_context[i].DDR_wr_offset,
+                                        2 * (uint32_t)rx_ch_context[i].p_rx_ddr_enqueued, nb_chunks * ddr_wr_dma_xfr_size);
+                    rx_ch_context[i].RX_total_ddr_enqueued_size += nb_chunks * RX_DDR_STEP;
+                    rx_ch_context[i].DDR_wr_offset += nb_chunks * ddr_wr_dma_xfr_size;
+                    if (rx_ch_context[i].DDR_wr_offset >= rx_vspa_proxy[i].DDR_wr_size)
+                        rx_ch_context[i].DDR_wr_offset = 0;
+                    while (nb_chunks--)
+                        INCR_RX_DEC_BUFF(rx_ch_context[i].p_rx_ddr_enqueued, i);
+                    l1_trace(L1_TRACE_MSG_DMA_DDR_WR_START, (uint32_t)rx_ch_context[i].p_rx_ddr_enqueued);
                 }
             }
         }
 
         // restart axiq  dma if possible
         for (i = 0; i < RX_NUM_CHAN; i++) {
-            dma_channel_rd = Rx_Antenna2axiq_dma_chan[i + RX_index];
-            if (dmac_is_available(0x1 << dma_channel_rd)) {
-                axi_rd = axi_ADC_FIFO_addr[i];
-                rx_busy_size = rx_ch_context[i].RX_total_axiq_enqueued_size - rx_ch_context[i].RX_total_dmem_input_Decimated_size;
-                rx_empty_size = (RX_NUM_BUF * RX_DMA_TXR_STEP) - rx_busy_size;
-                if (rx_empty_size >= RX_DMA_TXR_STEP) {
-                    stream_read(dma_channel_rd, axi_rd, 2 * (uint32_t)(rx_ch_context[i].p_rx_axiq_enqueued));
-                    INCR_RX_BUFF(rx_ch_context[i].p_rx_axiq_enqueued, i);
-                    rx_ch_context[i].RX_total_axiq_enqueued_size += RX_DMA_TXR_STEP;
-                    l1_trace(L1_TRACE_MSG_DMA_AXIQ_RX_START, (uint32_t)rx_ch_context[i].p_rx_axiq_enqueued);
-                } else {
-                    // overflow no more dmem buffer to arm new axiq DMA
-                    g_stats.rx_stats[i][ERROR_DMA_DDR_WR_OVERRUN]++;
-                    l1_trace(L1_TRACE_MSG_DMA_DDR_WR_OVERRUN, (uint32_t)g_stats.rx_stats[i][ERROR_DMA_DDR_WR_OVERRUN]);
-                    // l1_trace_disable = 1;
-                }
+            if (!rx_axiq_rearm(i)) {
+                // overflow no more dmem buffer to arm new axiq DMA
+                g_stats.rx_stats[i][ERROR_DMA_DDR_WR_OVERRUN]++;
+                l1_trace(L1_TRACE_MSG_DMA_DDR_WR_OVERRUN, (uint32_t)g_stats.rx_stats[i][ERROR_DMA_DDR_WR_OVERRUN]);
+                // l1_trace_disable = 1;
             }
         }
 
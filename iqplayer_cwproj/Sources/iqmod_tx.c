@@ -23,6 +23,9 @@
 #include "cal_signal.h"
 #include "stats.h"
 #include "vspa_dmem_proxy.h"
+#include "vspa_mbox_cmd.h"
+#include "iq_bfp.h"
+#include "iq_rx_budget.h"
 
 vspa_complex_fixed16 output_buffer[TX_NUM_BUF * TX_DMA_TXR_size] __attribute__((section(".ippu_dmem")))
 __attribute__((aligned(64))) = { 0x00000000, 0x00010001, 0x00020002, 0x00030003 };
@@ -31,7 +34,9 @@ __attribute__((aligned(64))) = { 0x00000000, 0x00010001, 0x00020002, 0x00030003
 
 uint32_t DDR_rd_start_bit_update = 0, DDR_rd_load_start_bit_update = 0;
 #define DDR_rd_QEC_enable 1
+uint32_t DDR_rd_CMP_enable = 0; /* BFP mantissa width, 0 : cs16 */
 uint32_t ddr_rd_dma_xfr_size = TX_DDR_STEP;
+static uint32_t ddr_rd_dma_mode = DMAC_RDC;
 
 volatile uint32_t TX_ext_dma_enabled = 0;
 static uint32_t ddr_rd_dma_ch_nb = 0;
@@ -49,6 +54,13 @@ static uint32_t TX_total_ddr_enqueued_size = 0;                             /* 0
 static uint32_t TX_total_axiq_enqueued_size = 0;                            /* 3: Axiq Tx in fifo cmd	*/
 static uint32_t TX_total_axiq_consumed_size = 0;                            /* 4: Axiq Tx completed	*/
 
+#ifdef IQ_EVENT_LOOP
+// moves whenever PUSH_TX_DATA() did some work, next round may have more, see iq_event.h
+#define TX_EV_SEQ()                                                                                                    \
+    (TX_total_ddr_enqueued_size + TX_total_ddr_fetched_size + TX_total_dmem_QECced_size + TX_total_axiq_enqueued_size + \
+     TX_total_axiq_consumed_size + g_stats.tx_stats[STAT_DMA_DDR_RD])
+#endif
+
 vspa_complex_fixed16 *p_tx_ddr_enqueued = &output_buffer[0];
 vspa_complex_fixed16 *p_tx_ddr_fetched = &output_buffer[0];
 vspa_complex_fixed16 *p_tx_dmem_QECed_in = &output_buffer[0];
@@ -73,7 +85,7 @@ void DDR_read_multi_dma(uint32_t DDR_rd_dma_channel, uint32_t nb_dma, uint32_t D
 
     for (i = 0; i < nb_dma; i++) {
 #pragma loop_count(1, 16, 2, 0)
-        uint32_t ctrl = DMAC_RDC | (DDR_rd_dma_channel + i);
+        uint32_t ctrl = ddr_rd_dma_mode | (DDR_rd_dma_channel + i);
         if (ddr_rd_dma_mBurst) {
             ctrl |= DMAC_MBRE;
         }
@@ -91,6 +103,19 @@ static uint32_t dma_chan_mask(uint32_t dma_channel, uint32_t nb_dma) {
     return mask;
 }
 
+#if TX_DDR_STEP > IQ_BFP_MAX_BLOCKS * IQ_BFP_BLOCK_SIZE
+#error "TX_DDR_STEP too large for BFP compression"
+#endif
+
+// BFP expansion in place, chunk from DDR is the first ddr_rd_dma_xfr_size bytes of the buffer
+void tx_expand(vspa_complex_fixed16 *data) {
+    if (!DDR_rd_CMP_enable)
+        return;
+#ifdef IQ_TX_BFP
+    iq_bfp_expand((uint16_t *)data, (uint32_t *)data, TX_DDR_STEP / IQ_BFP_BLOCK_SIZE, DDR_rd_CMP_enable);
+#endif
+}
+
 void tx_qec_correction(vspa_complex_fixed16 *dataIn, vspa_complex_fixed16 *dataOut) {
     if (!DDR_rd_QEC_enable)
         return;
@@ -110,8 +135,22 @@ uint32_t rd_dmem_dst_byte_ptr;
 void TX_IQ_DATA_FROM_DDR(void) {
     uint64_t msg64 = host_mbox0_read();
     uint32_t cmd_start = (HIWORD(msg64)) & 0x00100000;
+    uint32_t sched_adapt;
 
     if ((cmd_start) && (!DDR_rd_start_bit_update)) {
+        DDR_rd_CMP_enable = 0;
+        if ((HIWORD(msg64)) & MBOX_IQMOD_TX_CMP) {
+#ifdef IQ_TX_BFP
+            DDR_rd_CMP_enable = mailbox_in_msg_0_LSB & MBOX_IQMOD_TX_CMP_WIDTH_MASK;
+            if (!DDR_rd_CMP_enable)
+                DDR_rd_CMP_enable = IQ_BFP_WIDTH_DEFAULT;
+            if (DDR_rd_CMP_enable < IQ_BFP_WIDTH_MIN)
+                goto fail_tx_iq_data;
+#else
+            // scalar expansion does not fit high DAC rates, only built for reduced rates (iq_rx_budget.h)
+            goto fail_tx_iq_data;
+#endif
+        }
         DDR_rd_start_bit_update = 1;
         DDR_rd_load_start_bit_update = (HIWORD(msg64)) & 0x00200000;
         // DDR_rd_QEC_enable= (HIWORD(msg64)) & 0x00400000;
@@ -120,6 +159,9 @@ void TX_IQ_DATA_FROM_DDR(void) {
         host_flow_control_disable = (HIWORD(msg64)) & 0x00400000;
         if (ddr_rd_dma_ch_nb > 4)
             goto fail_tx_iq_data;
+        // channel count left to firmware : scheduler adapts it to full duplex deadlines. Compressed reads keep 2
+        // channels, 1 is below the DAC rate and 2 never hold all AXI read slots
+        sched_adapt = !ddr_rd_dma_ch_nb && !DDR_rd_CMP_enable;
         if (!ddr_rd_dma_ch_nb) {
             /* LA9310 AXI bus supports 4 opened RD transactions
              * Read measurements ( wo/ multi-burst):
@@ -134,17 +176,26 @@ void TX_IQ_DATA_FROM_DDR(void) {
             ddr_rd_dma_mBurst = 0;
             ddr_rd_dma_ch_nb = 2;
         }
+        // compressed chunk is 32B multiple only, at most 2 DMAs keep 16B aligned parts
+        if (DDR_rd_CMP_enable && ddr_rd_dma_ch_nb > 2)
+            ddr_rd_dma_ch_nb = 2;
 
         ddr_rd_dma_ch_mask = dma_chan_mask(DDR_RD_DMA_CHANNEL_1, ddr_rd_dma_ch_nb);
+        // compressed reads are never held back for rx, see iq_sched.h
+        iq_sched_start(&g_sched, IQ_SCHED_TX, TX_DDR_STEP, sched_adapt, !DDR_rd_CMP_enable, 1, ddr_rd_dma_ch_nb, 4);
 
         DDR_rd_counter = 0;
-        ddr_rd_dma_xfr_size = TX_DDR_STEP;
+        ddr_rd_dma_xfr_size = (DDR_rd_CMP_enable ? IQ_BFP_CHUNK_SIZE(TX_DDR_STEP, DDR_rd_CMP_enable) : TX_DDR_STEP);
+        // compressed chunk is a bit stream, no sign-magnitude conversion on the way in
+        ddr_rd_dma_mode = (DDR_rd_CMP_enable ? DMAC_RD : DMAC_RDC);
+        tx_vspa_proxy.tx_cmp_mode = DDR_rd_CMP_enable;
 
         if (0 == TX_total_ddr_ready_size) {
             TX_total_ddr_ready_size = TX_NUM_BUF * TX_DDR_STEP;
         }
         TX_total_ddr_enqueued_size = 0;
         TX_total_ddr_fetched_size = 0;
+        tx_vspa_proxy.la9310_fifo_enqueued_size_hi = 0;
         TX_total_dmem_QECced_size = 0;
         TX_total_axiq_enqueued_size = 0;
         TX_total_axiq_consumed_size = 0;
@@ -157,7 +208,9 @@ void TX_IQ_DATA_FROM_DDR(void) {
         p_tx_axiq_consumed = &output_qec_buffer[0];
 
         DDR_rd_size = ((mailbox_in_msg_0_MSB & 0x0000FFFF) * SIZE_4K);
-        DDR_rd_base_address = mailbox_in_msg_0_LSB;
+        DDR_rd_base_address = mailbox_in_msg_0_LSB & ~(DDR_rd_CMP_enable ? MBOX_IQMOD_TX_CMP_WIDTH_MASK : 0);
+        // whole chunks only in DDR fifo, host wraps at the same place
+        DDR_rd_size = DDR_rd_size / ddr_rd_dma_xfr_size * ddr_rd_dma_xfr_size;
 
         // update host vspa_dmem_proxy
         tx_proxy_updated = 1;
@@ -220,7 +273,9 @@ void TX_IQ_DATA_FROM_DDR(void) {
         host_mbox0_post(MAKEDWORD(mailbox_out_msg_0_MSB, mailbox_out_msg_0_LSB));
 
         DDR_rd_base_address = 0xdeadbeef;
+        iq_sched_stop(&g_sched, IQ_SCHED_TX);
         TX_total_ddr_fetched_size = 0;
+        tx_vspa_proxy.la9310_fifo_enqueued_size_hi = 0;
         TX_total_dmem_QECced_size = 0;
 
         DDR_rd_start_bit_update = 0;
@@ -246,6 +301,10 @@ void PUSH_TX_DATA(void) {
     uint32_t tmp_status;
     uint32_t tmp_dma_errors;
     uint32_t tx_empty_size;
+    uint32_t nb, ready;
+#ifdef IQ_EVENT_LOOP
+    uint32_t ev_seq = TX_EV_SEQ();
+#endif
 
     // Check AXIQ tx fifo is not empty or underrun
     tmp_status = axiq_fifo_tx_sr(AXIQ_BANK_0, AXIQ_FIFO_TX0, AXIQ_SR_FIELD_ERRUNDER | AXIQ_SR_FIELD_ERROVER);
@@ -335,33 +394,45 @@ void PUSH_TX_DATA(void) {
                 while (dbg_gbl == 8) {
                 };
                 INCR_TX_BUFF(p_tx_ddr_fetched);
-                TX_total_ddr_fetched_size += TX_DDR_STEP;
+                PROXY_CNT_ADD(TX_total_ddr_fetched_size, tx_vspa_proxy.la9310_fifo_enqueued_size_hi, TX_DDR_STEP);
                 g_stats.tx_stats[STAT_DMA_DDR_RD]++;
                 l1_trace(L1_TRACE_MSG_DMA_DDR_RD_COMP, (uint32_t)TX_total_ddr_fetched_size);
                 // update host vspa_dmem_proxy
                 tx_proxy_updated = 1;
             }
 
+            // deadline is DAC underrun once fetched data is played, publish it with read readiness
+            tx_busy_size = TX_total_ddr_enqueued_size - TX_total_dmem_QECced_size;
+            tx_empty_size = (TX_NUM_BUF * TX_DDR_STEP) - tx_busy_size;
             // host flow control
-            if ((TX_total_ddr_ready_size - TX_total_ddr_enqueued_size >= TX_DDR_STEP) || host_flow_control_disable) {
-                // start new transfer from DDR if possible
+            ready = (TX_total_ddr_ready_size - TX_total_ddr_enqueued_size >= TX_DDR_STEP) || host_flow_control_disable;
+            ready = ready && (tx_empty_size >= TX_DDR_STEP);
+            iq_sched_update(&g_sched, IQ_SCHED_TX, TX_total_ddr_fetched_size - TX_total_axiq_consumed_size, ready);
+
+            // DDR channel count follows deadlines, only between transfers
+            if (TX_total_ddr_enqueued_size == TX_total_ddr_fetched_size) {
+                nb = iq_sched_ch_nb(&g_sched, IQ_SCHED_TX, ddr_rd_dma_ch_nb);
+                if (nb != ddr_rd_dma_ch_nb) {
+                    ddr_rd_dma_ch_nb = nb;
+                    ddr_rd_dma_ch_mask = dma_chan_mask(DDR_RD_DMA_CHANNEL_1, ddr_rd_dma_ch_nb);
+                }
+            }
+
+            // start new transfer from DDR if possible, earliest deadline first with rx DDR writes
+            if (g_sched.pending[IQ_SCHED_TX] && iq_sched_may_issue(&g_sched, IQ_SCHED_TX)) {
                 if (dmac_is_available(ddr_rd_dma_ch_mask) == ddr_rd_dma_ch_mask) {
-                    tx_busy_size = TX_total_ddr_enqueued_size - TX_total_dmem_QECced_size;
-                    tx_empty_size = (TX_NUM_BUF * TX_DDR_STEP) - tx_busy_size;
-                    if (tx_empty_size >= TX_DDR_STEP) {
-                        // start new transfer from ddr ( using 4 DMA to take advantage of possible 4 outstanding Read on AXIQ bus )
-                        rd_ddr_src_ptr = DDR_rd_base_address + DDR_rd_counter;
-                        rd_dmem_dst_byte_ptr = 2 * (uint32_t)(p_tx_ddr_enqueued);
-                        while (dbg_gbl == 7) {
-                        };
-                        DDR_read_multi_dma(DDR_RD_DMA_CHANNEL_1, ddr_rd_dma_ch_nb, rd_ddr_src_ptr, rd_dmem_dst_byte_ptr,
-                                           ddr_rd_dma_xfr_size);
-                        DDR_rd_counter = (DDR_rd_counter + ddr_rd_dma_xfr_size) % DDR_rd_size;
-                        l1_trace(L1_TRACE_MSG_DMA_DDR_RD_START, (uint32_t)rd_ddr_src_ptr);
-                        l1_trace(L1_TRACE_MSG_DMA_DDR_RD_START, (uint32_t)p_tx_ddr_enqueued);
-                        INCR_TX_BUFF(p_tx_ddr_enqueued);
-                        TX_total_ddr_enqueued_size += TX_DDR_STEP;
-                    }
+                    // start new transfer from ddr ( using 4 DMA to take advantage of possible 4 outstanding Read on AXIQ bus )
+                    rd_ddr_src_ptr = DDR_rd_base_address + DDR_rd_counter;
+                    rd_dmem_dst_byte_ptr = 2 * (uint32_t)(p_tx_ddr_enqueued);
+                    while (dbg_gbl == 7) {
+                    };
+                    DDR_read_multi_dma(DDR_RD_DMA_CHANNEL_1, ddr_rd_dma_ch_nb, rd_ddr_src_ptr, rd_dmem_dst_byte_ptr,
+                                       ddr_rd_dma_xfr_size);
+                    DDR_rd_counter = (DDR_rd_counter + ddr_rd_dma_xfr_size) % DDR_rd_size;
+                    l1_trace(L1_TRACE_MSG_DMA_DDR_RD_START, (uint32_t)rd_ddr_src_ptr);
+                    l1_trace(L1_TRACE_MSG_DMA_DDR_RD_START, (uint32_t)p_tx_ddr_enqueued);
+                    INCR_TX_BUFF(p_tx_ddr_enqueued);
+                    TX_total_ddr_enqueued_size += TX_DDR_STEP;
                 }
             }
         }
@@ -372,6 +443,7 @@ void PUSH_TX_DATA(void) {
             tx_busy_size = TX_total_dmem_QECced_size - TX_total_axiq_consumed_size;
             tx_empty_size = (TX_NUM_QEC_BUF * TX_DDR_STEP) - tx_busy_size;
             if (tx_empty_size >= TX_DDR_STEP) {
+                tx_expand(p_tx_dmem_QECed_in);
                 l1_trace(L1_TRACE_L1APP_TX_QEC_START, (uint32_t)p_tx_dmem_QECed_in);
                 tx_qec_correction(p_tx_dmem_QECed_in, p_tx_dmem_QECed_out);
                 INCR_TX_BUFF(p_tx_dmem_QECed_in);
@@ -410,4 +482,8 @@ end_tx_push:
 
     // update host proxy if needed
     VSPA_PROXY_update();
+#ifdef IQ_EVENT_LOOP
+    if (TX_EV_SEQ() != ev_seq)
+        iq_ev_progress(&g_ev, IQ_EV_STAGE_TX);
+#endif
 }
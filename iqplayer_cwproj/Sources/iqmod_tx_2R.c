@@ -142,6 +142,7 @@ void TX_IQ_DATA_FROM_DDR(void) {
         }
         TX_total_ddr_enqueued_size = 0;
         TX_total_ddr_fetched_size = 0;
+        tx_vspa_proxy.la9310_fifo_enqueued_size_hi = 0;
         TX_total_dmem_QECced_size = 0;
         TX_total_axiq_enqueued_size = 0;
         TX_total_axiq_consumed_size = 0;
@@ -212,6 +213,7 @@ void TX_IQ_DATA_FROM_DDR(void) {
 
         DDR_rd_base_address = 0xdeadbeef;
         TX_total_ddr_fetched_size = 0;
+        tx_vspa_proxy.la9310_fifo_enqueued_size_hi = 0;
         TX_total_axiq_consumed_size = 0;
 
         DDR_rd_start_bit_update = 0;
@@ -328,7 +330,7 @@ void PUSH_TX_DATA(void) {
             if (dmac_is_complete(ddr_rd_dma_ch_mask) == ddr_rd_dma_ch_mask) {
                 dmac_clear_complete(ddr_rd_dma_ch_mask);
                 INCR_TX_BUFF(p_tx_ddr_fetched);
-                TX_total_ddr_fetched_size += TX_DDR_STEP;
+                PROXY_CNT_ADD(TX_total_ddr_fetched_size, tx_vspa_proxy.la9310_fifo_enqueued_size_hi, TX_DDR_STEP);
                 g_stats.tx_stats[STAT_DMA_DDR_RD]++;
                 l1_trace(L1_TRACE_MSG_DMA_DDR_RD_COMP, (uint32_t)g_stats.tx_stats[STAT_DMA_DDR_RD]);
             }
@@ -11,6 +11,7 @@
 #include "gpio.h"
 #include "chip-la9310.h"
 #include "axiq-la9310.h"
+#include "vspa_mbox_cmd.h"
 
 /**
  *  RX and TX kernel selection for QEC
@@ -24,6 +25,9 @@
 #define TXIQCOMP
 #define RXIQCOMP
 
+/* DDR read of MBOX_OPC_IQ_CORR_BLOCK command block, spare AXIQ RSSI channel */
+#define QEC_BLOCK_DMA_CHANNEL 0x6
+
 #ifdef TXIQCOMP2
 extern structTXIQCompParams2 iq_comp_params2_tx _VSPA_VECTOR_ALIGN;
 #else
@@ -39,6 +43,8 @@ extern structTXIQCompParams rxiqcompcfg_struct _VSPA_VECTOR_ALIGN;
 void rf_init(void);
 void rf_update_iq_comp_params2(structTXIQCompParams2 *params_ptr, uint32_t rst, uint32_t idx, uint32_t val);
 void rf_update_iq_comp_params(structTXIQCompParams *params_ptr, uint32_t rst, uint32_t idx, uint32_t val);
+void rf_load_iq_comp_params2(structTXIQCompParams2 *params_ptr, const mbox_qec_block_t *blk);
+void rf_load_iq_comp_params(structTXIQCompParams *params_ptr, const mbox_qec_block_t *blk);
 void stream_write_ptr_rst(uint32_t dma_channel_wr, uint32_t axi_wr);
 void stream_read_ptr_rst(uint32_t dma_channel_rd, uint32_t axi_rd);
 void stream_write(uint32_t dma_channel_wr, uint32_t axi_wr, uint32_t vsp);
@@ -0,0 +1,153 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#ifndef __IQ_BFP_H__
+#define __IQ_BFP_H__
+
+#include <stdint.h>
+
+/*
+ * Block floating point (BFP) compression of DDR chunks : RX chunks compressed by modem before DDR write, TX chunks
+ * compressed by host and expanded by firmware after DDR read. Bit exact reference of the host SIMD versions and of
+ * the software modem, built as is for VSPA and host. Firmware has no RX compressor (scalar iq_bfp_compress() is
+ * ~15k VCPU cycles per 2KB chunk, a vector kernel is needed), RX compressed start is NACKed. Scalar TX expansion
+ * has the same cost and is only built for reduced DAC rates (TX_BFP=1, iq_rx_budget.h).
+ *
+ * Block : one DMEM line, 16 I/Q samples = 32 components in DMEM sign-magnitude format (DMAC_RDC).
+ * Shared exponent e is the smallest shift so that the largest magnitude fits W - 1 bits, each mantissa is
+ * (magnitude + rounding) >> e saturated to 2^(W-1) - 1, stored as W-bit two's complement.
+ * Component k is at bits [k*W, k*W + W) of the W little-endian 32-bit words of the block.
+ *
+ * Chunk : nb_blocks packed blocks, then one exponent byte per block padded to 32 bytes. Size stays a
+ * multiple of 32 bytes, chunk may be split over 2 DMAs. Moved with DMAC_WR / DMAC_RD (no conversion),
+ * value is sext(mantissa) << e.
+ *
+ * Compression may run in place : block b output never goes past block b input still to be read.
+ * Expansion may run in place too, last block first : block b output never reaches blocks below b.
+ */
+
+#define IQ_BFP_BLOCK_COMP 32                         /* I or Q components per block */
+#define IQ_BFP_BLOCK_SIZE (IQ_BFP_BLOCK_COMP * 2)    /* uncompressed bytes per block */
+#define IQ_BFP_MAX_BLOCKS 32                         /* 2KB chunk */
+#define IQ_BFP_WIDTH_MIN 4
+#define IQ_BFP_WIDTH_MAX 15
+#define IQ_BFP_WIDTH_DEFAULT 9
+
+#define IQ_BFP_EXP_SIZE(nb_blocks) (((nb_blocks) + 31) & ~31)
+#define IQ_BFP_CHUNK_SIZE(raw_size, width) \
+    ((raw_size) / IQ_BFP_BLOCK_SIZE * 4 * (width) + IQ_BFP_EXP_SIZE((raw_size) / IQ_BFP_BLOCK_SIZE))
+
+/* cs16 to DMEM sign-magnitude, -32768 saturated to -32767 */
+static inline uint16_t iq_bfp_cs16_to_sm(int16_t x) {
+    if (x >= 0)
+        return (uint16_t)x;
+    return x == -32768 ? 0xFFFF : (uint16_t)(0x8000 | -x);
+}
+
+/* compress 32 sign-magnitude components into width words, returns exponent */
+static inline uint32_t iq_bfp_compress_block(uint32_t *out, const uint16_t *in, uint32_t width) {
+    uint32_t mmax = (1U << (width - 1)) - 1, mask = (1U << width) - 1;
+    uint32_t k, mag, max = 0, e = 0, half, m, acc = 0, nbits = 0;
+
+    for (k = 0; k < IQ_BFP_BLOCK_COMP; k++) {
+        mag = in[k] & 0x7FFF;
+        if (mag > max)
+            max = mag;
+    }
+    while ((max >> e) > mmax)
+        e++;
+    half = e ? 1U << (e - 1) : 0;
+
+    for (k = 0; k < IQ_BFP_BLOCK_COMP; k++) {
+        mag = in[k] & 0x7FFF;
+        m = (mag + half) >> e;
+        if (m > mmax)
+            m = mmax;
+        if (in[k] & 0x8000)
+            m = -m;
+        m &= mask;
+        acc |= m << nbits;
+        nbits += width;
+        if (nbits >= 32) {
+            *out++ = acc;
+            nbits -= 32;
+            acc = nbits ? m >> (width - nbits) : 0;
+        }
+    }
+
+    return e;
+}
+
+static inline void iq_bfp_compress(uint32_t *out, const uint16_t *in, uint32_t nb_blocks, uint32_t width) {
+    uint32_t exps[IQ_BFP_EXP_SIZE(IQ_BFP_MAX_BLOCKS) / 4];
+    uint32_t b, e;
+
+    for (b = 0; b < IQ_BFP_EXP_SIZE(nb_blocks) / 4; b++)
+        exps[b] = 0;
+    for (b = 0; b < nb_blocks; b++) {
+        e = iq_bfp_compress_block(out + b * width, in + b * IQ_BFP_BLOCK_COMP, width);
+        exps[b / 4] |= e << (8 * (b % 4));
+    }
+    // exponents last, their place may still hold input of later blocks
+    out += nb_blocks * width;
+    for (b = 0; b < IQ_BFP_EXP_SIZE(nb_blocks) / 4; b++)
+        out[b] = exps[b];
+}
+
+/* sign extended mantissa of component k */
+static inline int32_t iq_bfp_field(const uint32_t *in, uint32_t k, uint32_t width) {
+    uint32_t bit = k * width, sh = bit & 31, v;
+
+    v = in[bit >> 5] >> sh;
+    if (sh + width > 32)
+        v |= in[(bit >> 5) + 1] << (32 - sh);
+    return (int32_t)(v << (32 - width)) >> (32 - width);
+}
+
+/* reference decompressor, block to cs16 */
+static inline void iq_bfp_decompress_block(int16_t *out, const uint32_t *in, uint32_t e, uint32_t width) {
+    uint32_t k;
+
+    for (k = 0; k < IQ_BFP_BLOCK_COMP; k++)
+        out[k] = (int16_t)(iq_bfp_field(in, k, width) * (1 << e));
+}
+
+static inline void iq_bfp_decompress(int16_t *out, const uint32_t *in, uint32_t nb_blocks, uint32_t width) {
+    const uint32_t *exps = in + nb_blocks * width;
+    uint32_t b;
+
+    for (b = 0; b < nb_blocks; b++)
+        iq_bfp_decompress_block(out + b * IQ_BFP_BLOCK_COMP, in + b * width, (exps[b / 4] >> (8 * (b % 4))) & 0xFF,
+                                width);
+}
+
+/* expand one block to DMEM sign-magnitude, block input is copied first so out may overlap it */
+static inline void iq_bfp_expand_block(uint16_t *out, const uint32_t *in, uint32_t e, uint32_t width) {
+    uint32_t words[IQ_BFP_WIDTH_MAX];
+    uint32_t k;
+    int32_t x;
+
+    for (k = 0; k < width; k++)
+        words[k] = in[k];
+    for (k = 0; k < IQ_BFP_BLOCK_COMP; k++) {
+        x = iq_bfp_field(words, k, width);
+        out[k] = x < 0 ? (uint16_t)(0x8000 | ((-x << e) & 0x7FFF)) : (uint16_t)((x << e) & 0x7FFF);
+    }
+}
+
+/* chunk to DMEM sign-magnitude (what DMAC_RDC gives for cs16), in place : out may be the chunk itself */
+static inline void iq_bfp_expand(uint16_t *out, const uint32_t *in, uint32_t nb_blocks, uint32_t width) {
+    uint32_t exps[IQ_BFP_EXP_SIZE(IQ_BFP_MAX_BLOCKS) / 4];
+    uint32_t b;
+
+    // exponents first, later blocks output overwrites them
+    for (b = 0; b < IQ_BFP_EXP_SIZE(nb_blocks) / 4; b++)
+        exps[b] = in[nb_blocks * width + b];
+    for (b = nb_blocks; b-- > 0;)
+        iq_bfp_expand_block(out + b * IQ_BFP_BLOCK_COMP, in + b * width, (exps[b / 4] >> (8 * (b % 4))) & 0xFF, width);
+}
+
+#endif /* __IQ_BFP_H__ */
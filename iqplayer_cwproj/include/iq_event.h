@@ -0,0 +1,93 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#ifndef __IQ_EVENT_H__
+#define __IQ_EVENT_H__
+
+#include <stdint.h>
+
+/*
+ * Event driven dispatch of main loop stages, pure C so the very same dispatcher runs in the firmware main loop
+ * and in a host model.
+ *
+ * Event word, sampled once per round by the caller :
+ *  bits 15-0 : DMA channel completion / transfer error (DMA_COMP_STAT | DMA_XFRERR_STAT)
+ *  IQ_EV_MBOX0 / IQ_EV_MBOX1 : host mailbox valid
+ *  IQ_EV_POLL : raised by the dispatcher every poll_period rounds, for state with no event source (host proxy
+ *  writes for flow control, AXIQ fifo status, DMA config errors)
+ * DMA status bits are levels, they stay set until the stage owning the channel clears them : a stage is
+ * dispatched until it consumed its completion (all channels of a multi DMA transfer).
+ * A stage runs when one of its wait events is set, and again next round when it made progress, as one pass
+ * may leave the following chunk ready (QEC, DDR write) with no new DMA event.
+ * A round dispatching nothing costs the status sample only.
+ */
+
+#define IQ_EV_DMA_MASK 0x0000FFFF
+#define IQ_EV_MBOX0 (1U << 16)
+#define IQ_EV_MBOX1 (1U << 17)
+#define IQ_EV_POLL (1U << 18)
+
+#define IQ_EV_MAX_STAGES 8
+#define IQ_EV_POLL_PERIOD 64 /* rounds */
+
+typedef struct {
+    uint32_t nb_stages;
+    uint32_t wait[IQ_EV_MAX_STAGES]; /* events waking stage */
+    uint32_t again;                  /* stages that made progress, run next round */
+    uint32_t poll_period;
+    uint32_t poll_cnt;
+    uint32_t rounds;
+    uint32_t idle_rounds; /* rounds dispatching nothing */
+    uint32_t runs[IQ_EV_MAX_STAGES];
+} iq_ev_t;
+
+static inline void iq_ev_init(iq_ev_t *ev, uint32_t poll_period) {
+    uint32_t i;
+
+    ev->nb_stages = 0;
+    for (i = 0; i < IQ_EV_MAX_STAGES; i++) {
+        ev->wait[i] = 0;
+        ev->runs[i] = 0;
+    }
+    ev->again = 0;
+    ev->poll_period = poll_period;
+    ev->poll_cnt = 0;
+    ev->rounds = 0;
+    ev->idle_rounds = 0;
+}
+
+static inline void iq_ev_stage(iq_ev_t *ev, uint32_t stage, uint32_t wait) {
+    ev->wait[stage] = wait;
+    if (stage >= ev->nb_stages)
+        ev->nb_stages = stage + 1;
+}
+
+/* stages to run this round, bit n for stage n */
+static inline uint32_t iq_ev_dispatch(iq_ev_t *ev, uint32_t events) {
+    uint32_t run = ev->again, i;
+
+    ev->again = 0;
+    ev->rounds++;
+    if (++ev->poll_cnt >= ev->poll_period) {
+        ev->poll_cnt = 0;
+        events |= IQ_EV_POLL;
+    }
+    for (i = 0; i < ev->nb_stages; i++) {
+        if (events & ev->wait[i])
+            run |= 1U << i;
+        if (run & (1U << i))
+            ev->runs[i]++;
+    }
+    if (!run)
+        ev->idle_rounds++;
+
+    return run;
+}
+
+/* called by a stage that moved data, it is run again next round */
+static inline void iq_ev_progress(iq_ev_t *ev, uint32_t stage) { ev->again |= 1U << stage; }
+
+#endif /* __IQ_EVENT_H__ */
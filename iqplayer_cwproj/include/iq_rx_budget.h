@@ -0,0 +1,100 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#ifndef __IQ_RX_BUDGET_H__
+#define __IQ_RX_BUDGET_H__
+
+#include "iqmod_rx.h"
+#include "iqmod_tx.h"
+
+/*
+ * Multi channel RX (1T2R/1T4R) throughput budget with all channels streaming : VCPU cycles per chunk per stage,
+ * DDR write bandwidth and DMEM slack against the ADC chunk period, and 1T0R/1T1R TX BFP expansion budget.
+ * Preprocessor integer arithmetic only, a configuration over budget stops the firmware build with #error, and the
+ * same check runs on a PC :
+ *   cc -fsyntax-only -DIQMOD_RX_1T4R -I iqplayer_cwproj/include -x c iqplayer_cwproj/include/iq_rx_budget.h
+ * Kernel costs are the @cycle figures of vspa-lib (txiqcomp.h, ddc2x4x.h). VCPU clock and control cost per
+ * chunk (DMA issue / completion, proxy, trace) are estimates, override them with -D once measured with ccnt.
+ */
+
+#ifndef IQ_RXB_VSPA_KHZ
+#define IQ_RXB_VSPA_KHZ 614400 /* assumed VCPU clock */
+#endif
+#ifndef IQ_RXB_ADC_KSPS
+#define IQ_RXB_ADC_KSPS 61440 /* per ADC */
+#endif
+#ifndef IQ_RXB_CTRL_CYCLES
+#define IQ_RXB_CTRL_CYCLES 200 /* per chunk per channel, estimate */
+#endif
+#define IQ_RXB_DDR_WR_MBPS 528 /* inbound PCIe writes on i.MX8MP, see doc */
+#define IQ_RXB_MAX_LOAD_PCT 80 /* headroom for main loop jitter (mailbox, stats) */
+
+/* ADC chunk period per channel, in VCPU cycles */
+#define IQ_RXB_PERIOD_CYCLES ((RX_DMA_TXR_size * IQ_RXB_VSPA_KHZ) / IQ_RXB_ADC_KSPS)
+
+/* QEC on one RX chunk, DMEM line is 32 samples */
+#define IQ_RXB_QEC_LINES (RX_DMA_TXR_size / 32)
+#ifdef RXIQCOMP2
+#define IQ_RXB_QEC_CYCLES (30 + 6 * IQ_RXB_QEC_LINES) /* txiqcomp_x32chf_5t */
+#else
+#define IQ_RXB_QEC_CYCLES (24 + 4 * IQ_RXB_QEC_LINES) /* txiqcomp */
+#endif
+
+/* decimator_2x_8_Taps_asm, 73 / 169 cycles for 256 / 1024 input samples, linear in between */
+#define IQ_RXB_DEC_CYCLES (41 + RX_DMA_TXR_size / 8)
+
+#define IQ_RXB_CHAN_CYCLES (IQ_RXB_QEC_CYCLES + IQ_RXB_DEC_CYCLES + IQ_RXB_CTRL_CYCLES)
+
+/* TX share of one RX chunk period : one QEC + control per TX chunk */
+#define IQ_RXB_TX_CYCLES (((24 + 4 * (TX_DMA_TXR_size / 32)) + IQ_RXB_CTRL_CYCLES) * RX_DMA_TXR_size / TX_DMA_TXR_size)
+
+#define IQ_RXB_LOAD_CYCLES (RX_NUM_CHAN * IQ_RXB_CHAN_CYCLES + IQ_RXB_TX_CYCLES)
+#define IQ_RXB_LOAD_PCT (100 * IQ_RXB_LOAD_CYCLES / IQ_RXB_PERIOD_CYCLES)
+
+/* decimated output of all channels to DDR */
+#define IQ_RXB_DDR_WR_MBPS_NEEDED (RX_NUM_CHAN * IQ_RXB_ADC_KSPS * 4 / RX_DECIM / 1000)
+
+/* AXIQ side slack : one chunk in QEC/decimation, the others may wait for one full pass over all channels */
+#define IQ_RXB_AXIQ_SLACK_CYCLES ((RX_NUM_BUF - 1) * IQ_RXB_PERIOD_CYCLES)
+
+/*
+ * TX BFP expansion (iq_bfp.h, MBOX_IQMOD_TX_CMP) is a scalar C kernel : unpack, sign extend, shift and
+ * sign-magnitude of every I/Q component, ~15k cycles per 2KB chunk against a 2560 cycle chunk period at
+ * 122.88 MSPS. It is only built in (IQ_TX_BFP, TX_BFP=1 make option) for a DAC rate IQ_TXB_KSPS that fits with
+ * RX streaming at the same rate, firmware NACKs compressed TX start otherwise.
+ */
+#ifndef IQ_TXB_KSPS
+#define IQ_TXB_KSPS 122880
+#endif
+#ifndef IQ_TXB_BFP_CYCLES_PER_COMP
+#define IQ_TXB_BFP_CYCLES_PER_COMP 15 /* estimate */
+#endif
+#define IQ_TXB_PERIOD_CYCLES ((TX_DMA_TXR_size * IQ_RXB_VSPA_KHZ) / IQ_TXB_KSPS)
+#define IQ_TXB_QEC_CYCLES (24 + 4 * (TX_DMA_TXR_size / 32))
+#define IQ_TXB_BFP_CYCLES (TX_DDR_STEP / 2 * IQ_TXB_BFP_CYCLES_PER_COMP)
+/* RX share of one TX chunk period, RX at the same rate : one QEC + control per RX chunk */
+#define IQ_TXB_RX_CYCLES (RX_NUM_CHAN * (IQ_RXB_QEC_CYCLES + IQ_RXB_CTRL_CYCLES) * TX_DMA_TXR_size / RX_DMA_TXR_size)
+#define IQ_TXB_BFP_LOAD_CYCLES (IQ_TXB_QEC_CYCLES + IQ_TXB_BFP_CYCLES + IQ_RXB_CTRL_CYCLES + IQ_TXB_RX_CYCLES)
+#define IQ_TXB_BFP_LOAD_PCT (100 * IQ_TXB_BFP_LOAD_CYCLES / IQ_TXB_PERIOD_CYCLES)
+
+/* 1T2R/1T4R TX (iqmod_tx_2R.c) has no BFP path */
+#if defined(IQ_TX_BFP) && RX_NUM_CHAN <= 1 && IQ_TXB_BFP_LOAD_PCT > IQ_RXB_MAX_LOAD_PCT
+#error "TX BFP expansion over VCPU budget at IQ_TXB_KSPS, see iq_rx_budget.h"
+#endif
+
+#if RX_NUM_CHAN > 1
+#if IQ_RXB_LOAD_PCT > IQ_RXB_MAX_LOAD_PCT
+#error "multi channel RX over VCPU budget, see iq_rx_budget.h"
+#endif
+#if IQ_RXB_DDR_WR_MBPS_NEEDED > IQ_RXB_DDR_WR_MBPS
+#error "multi channel RX over DDR write bandwidth, see iq_rx_budget.h"
+#endif
+#if IQ_RXB_LOAD_CYCLES > IQ_RXB_AXIQ_SLACK_CYCLES
+#error "multi channel RX pass longer than AXIQ DMEM slack, see iq_rx_budget.h"
+#endif
+#endif
+
+#endif /* __IQ_RX_BUDGET_H__ */
@@ -0,0 +1,111 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#ifndef __IQ_SCHED_H__
+#define __IQ_SCHED_H__
+
+#include <stdint.h>
+
+/*
+ * Full duplex DDR DMA arbitration between TX DDR reads and RX DDR writes, pure C so the very same policy
+ * runs in the firmware main loop and in a host model.
+ *
+ * Each direction publishes its slack, bytes left before its AXIQ deadline, from PUSH_TX_DATA() /
+ * PUSH_RX_DATA() :
+ *  tx : bytes fetched from DDR and not yet played by AXIQ TX, deadline is DAC underrun
+ *  rx : DMEM room left for AXIQ RX reads, deadline is ADC fifo overflow
+ * TX and RX stream at the same byte rate (TX_UPSMP = RX_DECIM = 1), so slack in bytes orders deadlines.
+ *
+ * Earliest deadline first : a DDR DMA is held back only while the other direction has one ready, is urgent
+ * (slack under guard) and has the earlier deadline. A direction started with yield 0 is never held back : BFP
+ * compressed TX reads 58% of the cs16 bytes on at most 2 channels, holding it frees little DDR bandwidth and
+ * no AXI read slot for RX while it pulls TX slack down to the RX one, both then lose data.
+ * DDR channel counts follow deadlines when host left them to firmware : the urgent direction gets ch_max,
+ * TX reads drop to ch_min while rx is urgent as AXIQ RX reads share the 4 AXI read slots. ch_max is kept
+ * until slack is back over twice the guard, count would flip at each chunk otherwise. Count may only change
+ * with no DDR DMA of that direction in flight.
+ *
+ * host-utils/tests/test_iq_sched.c runs this header in a full duplex model against the greedy policy.
+ */
+
+#define IQ_SCHED_TX 0
+#define IQ_SCHED_RX 1
+#define IQ_SCHED_IDLE 0xFFFFFFFF /* slack of a stopped direction */
+#define IQ_SCHED_GUARD_CHUNKS 2  /* urgent under 2 DDR chunks of slack */
+
+typedef struct {
+    uint32_t slack[2];    /* bytes to deadline, IQ_SCHED_IDLE when stopped */
+    uint32_t pending[2];  /* a DDR DMA is ready to go */
+    uint32_t guard[2];    /* bytes */
+    uint32_t adapt[2];    /* channel count picked by scheduler */
+    uint32_t yield[2];    /* may be held back for the other direction */
+    uint32_t ch_min[2];   /* DDR DMA channels when the other direction is urgent */
+    uint32_t ch_def[2];   /* DDR DMA channels when no one is urgent */
+    uint32_t ch_max[2];   /* DDR DMA channels when urgent */
+    uint32_t deferred[2]; /* DDR DMAs held back for the other direction */
+    uint32_t ch_switch[2];
+} iq_sched_t;
+
+static inline void iq_sched_start(iq_sched_t *s, uint32_t dir, uint32_t step, uint32_t adapt, uint32_t yield,
+                                  uint32_t ch_min, uint32_t ch_def, uint32_t ch_max) {
+    s->slack[dir] = IQ_SCHED_IDLE;
+    s->pending[dir] = 0;
+    s->guard[dir] = IQ_SCHED_GUARD_CHUNKS * step;
+    s->adapt[dir] = adapt;
+    s->yield[dir] = yield;
+    s->ch_min[dir] = ch_min;
+    s->ch_def[dir] = ch_def;
+    s->ch_max[dir] = ch_max;
+    s->deferred[dir] = 0;
+    s->ch_switch[dir] = 0;
+}
+
+static inline void iq_sched_stop(iq_sched_t *s, uint32_t dir) {
+    s->slack[dir] = IQ_SCHED_IDLE;
+    s->pending[dir] = 0;
+    s->adapt[dir] = 0;
+}
+
+static inline void iq_sched_update(iq_sched_t *s, uint32_t dir, uint32_t slack, uint32_t pending) {
+    s->slack[dir] = slack;
+    s->pending[dir] = pending;
+}
+
+static inline uint32_t iq_sched_urgent(const iq_sched_t *s, uint32_t dir) {
+    return s->slack[dir] < s->guard[dir];
+}
+
+/* EDF gate, call with a DDR DMA of dir ready to go */
+static inline uint32_t iq_sched_may_issue(iq_sched_t *s, uint32_t dir) {
+    uint32_t other = dir ^ 1;
+
+    if (s->yield[dir] && s->pending[other] && iq_sched_urgent(s, other) && s->slack[other] < s->slack[dir]) {
+        s->deferred[dir]++;
+        return 0;
+    }
+    return 1;
+}
+
+/* DDR DMA channel count for next transfer of dir, cur is kept when host set it */
+static inline uint32_t iq_sched_ch_nb(iq_sched_t *s, uint32_t dir, uint32_t cur) {
+    uint32_t other = dir ^ 1, nb;
+
+    if (!s->adapt[dir])
+        return cur;
+    if (iq_sched_urgent(s, dir) && s->slack[dir] <= s->slack[other])
+        nb = s->ch_max[dir];
+    else if (cur == s->ch_max[dir] && s->slack[dir] < 2 * s->guard[dir])
+        nb = cur; // hysteresis, leave ch_max once slack is back over twice the guard
+    else if (iq_sched_urgent(s, other))
+        nb = s->ch_min[dir];
+    else
+        nb = s->ch_def[dir];
+    if (nb != cur)
+        s->ch_switch[dir]++;
+    return nb;
+}
+
+#endif /* __IQ_SCHED_H__ */
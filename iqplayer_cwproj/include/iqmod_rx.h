@@ -19,7 +19,6 @@
 #define RX_NUM_CHAN 1
 #define RX_NUM_BUF 7
 #define RX_NUM_QEC_BUF 8
-#define RX_COMPRESS_RATIO_PCT 100
 #define RX_DMA_TXR_size (512)
 #define RX_DECIM 1
 #endif
@@ -28,7 +27,6 @@
 #define RX_NUM_CHAN 1
 #define RX_NUM_BUF 3
 #define RX_NUM_QEC_BUF 4
-#define RX_COMPRESS_RATIO_PCT 100
 #define RX_DMA_TXR_size (512)
 #define RX_DECIM 1
 #endif
@@ -36,7 +34,6 @@
 #ifdef IQMOD_RX_1T2R
 #define RX_NUM_CHAN 2
 #define RX_NUM_BUF 3
-#define RX_COMPRESS_RATIO_PCT 100
 #define RX_NUM_DEC_BUF 3
 #define RX_DMA_TXR_size (512)
 #define RX_DECIM 2
@@ -45,7 +42,6 @@
 #ifdef IQMOD_RX_1T4R
 #define RX_NUM_CHAN 4
 #define RX_NUM_BUF 3
-#define RX_COMPRESS_RATIO_PCT 100
 #define RX_NUM_DEC_BUF 3
 #define RX_DMA_TXR_size (256)
 #define RX_DECIM 2
@@ -95,13 +91,13 @@ __attribute__((aligned(64)));
             rxbuff_ptr = &input_buffer[chan][0];                               \
         }                                                                      \
     }
-#define INCR_RX_DEC_BUFF(rxbuff_ptr, chan)                                                    \
-    {                                                                                         \
-        /*rxbuff_ptr##_prev=rxbuff_ptr;*/                                                     \
-        rxbuff_ptr += RX_DMA_TXR_size / RX_DECIM;                                             \
-        if (rxbuff_ptr >= &input_dec_buffer[chan][RX_NUM_BUF * RX_DMA_TXR_size / RX_DECIM]) { \
-            rxbuff_ptr = &input_dec_buffer[chan][0];                                          \
-        }                                                                                     \
+#define INCR_RX_DEC_BUFF(rxbuff_ptr, chan)                                                        \
+    {                                                                                             \
+        /*rxbuff_ptr##_prev=rxbuff_ptr;*/                                                         \
+        rxbuff_ptr += RX_DMA_TXR_size / RX_DECIM;                                                 \
+        if (rxbuff_ptr >= &input_dec_buffer[chan][RX_NUM_DEC_BUF * RX_DMA_TXR_size / RX_DECIM]) { \
+            rxbuff_ptr = &input_dec_buffer[chan][0];                                              \
+        }                                                                                         \
     }
 
 #endif
@@ -133,6 +129,8 @@ void rx_qec_correction(vspa_complex_fixed16 *dataIn, vspa_complex_fixed16 *dataO
 void RX_IQ_DATA_TO_DDR(void);
 void PUSH_RX_DATA(void);
 uint32_t dma_chan_mask(uint32_t dma_channel, uint32_t nb_dma);
+void RX_MSI_config(uint32_t msi_reg, uint32_t msi_every, uint32_t msi_watermark);
+void RX_MSI_chunk_done(uint32_t ready_size);
 
 extern uint32_t DDR_wr_start_bit_update, DDR_wr_load_start_bit_update, DDR_wr_continuous;
 extern uint32_t ddr_wr_dma_ch_nb;
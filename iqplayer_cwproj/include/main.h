@@ -16,11 +16,22 @@
 #include "iohw.h"
 #include "dmac.h"
 #include "axiq.h"
+#include "vspa_mbox_cmd.h"
+#include "iq_sched.h"
+#include "iq_event.h"
 //#include "bitRev.h"
 //#include "la9310.h"
 
 /* parameters */
 
+// event driven main loop (make EVENT_LOOP=1), streaming stages of 1T0R/1T1R/0T1R report progress to it
+#if defined(IQ_EVENT_LOOP) && (defined(IQMOD_RX_1T2R) || defined(IQMOD_RX_1T4R))
+#undef IQ_EVENT_LOOP
+#endif
+#define IQ_EV_STAGE_MBOX 0
+#define IQ_EV_STAGE_TX 1
+#define IQ_EV_STAGE_RX 2
+
 #define FFT_SIZE (512)
 #define SIZE_4K (4096)
 #define KILO_SIZE (1024)
@@ -43,6 +54,8 @@ extern tone_index, image_tone_index;
 extern volatile int dbg_gbl;
 extern uint32_t TX_SingleT_start_bit_update, RX_SingleT_start_bit_update, RX_SingleT_continue;
 extern uint32_t g_iqflood_proxy_offset;
+extern iq_sched_t g_sched;
+extern iq_ev_t g_ev;
 
 extern volatile uint32_t mailbox_out_msg_0_MSB; // (VCPU_OUT_0_MSB)
 extern volatile uint32_t mailbox_out_msg_0_LSB; // (VCPU_OUT_0_LSB)
@@ -75,31 +88,10 @@ typedef enum {
     MBOX_IQ_CORR_MAX,    // 0x11
 } mbox_iq_corr_factor_e;
 
-typedef enum {
-    MBOX_OPC_EMPTY_0,         // 0x0
-    MBOX_OPC_SINGLE_TONE_TX,  // 0x1
-    MBOX_OPC_SINGLE_TONE_RX,  // 0x2
-    MBOX_OPC_DCOC,            // 0x3
-    MBOX_OPC_BW_CAL,          // 0x4
-    MBOX_OPC_IQ_MOD_TX,       // 0x5
-    MBOX_OPC_IQ_MOD_RX,       // 0x6
-    MBOX_OPC_MSI,             // 0x7
-    MBOX_OPC_IQ_CORR,         // 0x8
-    MBOX_OPC_EMPTY_1,         // 0x9
-    MBOX_OPC_EMPTY_2,         // 0xA
-    MBOX_OPC_TX_DCO_CORR,     // 0xB
-    MBOX_OPC_OVERLAY_BASE,    // 0xC
-    MBOX_OPC_RX_CHAN_SELECT,  // 0xD
-    MBOX_OPC_RX_DCO_CORR,     // 0xE
-    MBOX_OPC_GET_STATS_COUNT, // 0xF
-    MBOX_OPC_DONE_SWRESET,    // 0x10
-    MBOX_OPC_PROXY_OFFSET     // 0x11
-   
-} mbox_opc_e;
-
 void PUSH_TX_DATA(void);
 void wait_for_pending_transfers(uint32_t ch);
 void DDR_write_VSPA_PROXY(uint32_t DDR_wr_dma_channel, uint32_t DDR_address, uint32_t vsp_address, uint32_t size);
 void VSPA_PROXY_update(void);
+void DDR_write_MSI(uint32_t DDR_wr_dma_channel, uint32_t DDR_address, uint32_t vsp_address);
 
 #endif // __MAIN_H__
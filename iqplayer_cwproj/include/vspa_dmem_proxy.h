@@ -16,6 +16,21 @@
 #define VSPA_DMEM_PROXY_SIZE 1024
 #define VSPA_DMEM_PROXY_ADDR (IQFLOOD_OUTBOUND_ADDR + g_iqflood_proxy_offset)
 
+/* bumped on any proxy layout change, host checks it before streaming */
+#define VSPA_DMEM_PROXY_VERSION 4
+
+/*
+ * Flow counters are 64-bit : 32-bit low word (legacy field, used for wrap-safe differences) and _hi epoch
+ * word incremented when low word wraps, to be read as ((uint64_t)hi << 32) | lo.
+ */
+#define PROXY_CNT_ADD(lo, hi, incr)     \
+    {                                   \
+        uint32_t proxy_cnt_prev = (lo); \
+        (lo) += (incr);                 \
+        if ((lo) < proxy_cnt_prev)      \
+            (hi)++;                     \
+    }
+
 typedef struct s_tx_ch_host_proxy {
     uint32_t la9310_fifo_enqueued_size;
     uint32_t la9310_fifo_consumed_size;
@@ -30,6 +45,11 @@ typedef struct s_tx_ch_host_proxy {
     uint32_t tx_ddr_step;
     uint32_t gbl_stats_fetch;
     uint32_t dmemProxyOffset;
+    uint32_t proxy_version;
+    uint32_t la9310_fifo_enqueued_size_hi;
+    uint32_t host_produced_size_hi;
+    uint32_t host_consumed_size_hi[RX_NUM_MAX_CHAN];
+    uint32_t tx_cmp_mode; /* 0 : cs16, else BFP mantissa width of DDR chunks (iq_bfp.h) */
 } t_tx_ch_host_proxy;
 
 typedef struct s_rx_ch_host_proxy {
@@ -37,6 +57,10 @@ typedef struct s_rx_ch_host_proxy {
     uint32_t la9310_fifo_consumed_size;
     uint32_t DDR_wr_base_address;
     uint32_t DDR_wr_size;
+    uint32_t la9310_fifo_produced_size_hi;
+    uint32_t la9310_fifo_consumed_size_hi;
+    uint32_t rx_cmp_mode; /* 0 : cs16, else BFP mantissa width of DDR chunks (iq_bfp.h) */
+    uint32_t reserved;
 } t_rx_ch_host_proxy;
 
 typedef struct s_vspa_dmem_proxy {
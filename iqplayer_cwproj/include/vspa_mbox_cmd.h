@@ -0,0 +1,121 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Copyright 2024 NXP
+ */
+
+#ifndef __VSPA_MBOX_CMD_H__
+#define __VSPA_MBOX_CMD_H__
+
+/*
+ * Host -> VSPA mailbox 0 command words, shared by firmware and host tools.
+ * MSB[31:24] opcode, other MSB bits are opcode specific, LSB is an address or a value.
+ * VSPA acks with LSB = 1 (MSB opcode specific), NACK with LSB = 0.
+ */
+typedef enum {
+    MBOX_OPC_EMPTY_0,         // 0x0
+    MBOX_OPC_SINGLE_TONE_TX,  // 0x1
+    MBOX_OPC_SINGLE_TONE_RX,  // 0x2
+    MBOX_OPC_DCOC,            // 0x3
+    MBOX_OPC_BW_CAL,          // 0x4
+    MBOX_OPC_IQ_MOD_TX,       // 0x5
+    MBOX_OPC_IQ_MOD_RX,       // 0x6
+    MBOX_OPC_MSI,             // 0x7
+    MBOX_OPC_IQ_CORR,         // 0x8
+    MBOX_OPC_EMPTY_1,         // 0x9
+    MBOX_OPC_EMPTY_2,         // 0xA
+    MBOX_OPC_TX_DCO_CORR,     // 0xB
+    MBOX_OPC_OVERLAY_BASE,    // 0xC
+    MBOX_OPC_RX_CHAN_SELECT,  // 0xD
+    MBOX_OPC_RX_DCO_CORR,     // 0xE
+    MBOX_OPC_GET_STATS_COUNT, // 0xF
+    MBOX_OPC_DONE_SWRESET,    // 0x10
+    MBOX_OPC_PROXY_OFFSET,    // 0x11
+    MBOX_OPC_IQ_CORR_BLOCK    // 0x12
+} mbox_opc_e;
+
+#define MBOX_OPC_SHIFT 24
+#define MBOX_OPC_MASK 0xFF000000
+#define MBOX_CMD_OPC(opc) ((uint32_t)(opc) << MBOX_OPC_SHIFT)
+
+/* MBOX_OPC_IQ_MOD_TX / MBOX_OPC_IQ_MOD_RX, LSB : DDR buffer/fifo modem address */
+#define MBOX_IQMOD_START 0x00100000
+#define MBOX_IQMOD_LOAD_TEST 0x00200000
+#define MBOX_IQMOD_FC_DISABLE 0x00400000     /* replay / capture from buffer, no host flow control */
+#define MBOX_IQMOD_RX_CONTINUOUS 0x00800000  /* rx fifo mode */
+#define MBOX_IQMOD_TX_MBURST 0x00080000
+#define MBOX_IQMOD_RX_CMP 0x00080000         /* rx BFP compression (iq_bfp.h), W in LSB bits 3-0, NACKed by firmware */
+#define MBOX_IQMOD_RX_CMP_WIDTH_MASK 0xF     /* 0 : IQ_BFP_WIDTH_DEFAULT */
+#define MBOX_IQMOD_TX_CMP 0x00800000         /* tx BFP compression (iq_bfp.h), W in LSB bits 3-0, TX_BFP builds */
+#define MBOX_IQMOD_TX_CMP_WIDTH_MASK 0xF     /* 0 : IQ_BFP_WIDTH_DEFAULT */
+#define MBOX_IQMOD_DMA_CH_MASK 0x00070000
+#define MBOX_IQMOD_DMA_CH(n) (((uint32_t)(n) & 0x7) << 16)
+#define MBOX_IQMOD_SIZE_4K(n) ((uint32_t)(n) & 0xFFFF)
+
+/* MBOX_OPC_MSI, rx fifo MSI notification config, LSB : MSI index as for one shot MSI */
+#define MBOX_MSI_CONFIG 0x00800000
+#define MBOX_MSI_WATERMARK(n) (((uint32_t)(n) & 0xFF) << 8)
+#define MBOX_MSI_EVERY(n) ((uint32_t)(n) & 0xFF)
+
+/* MBOX_OPC_IQ_CORR, LSB : value */
+#define MBOX_IQ_CORR_TX 0x00200000
+#define MBOX_IQ_CORR_RST 0x00100000
+#define MBOX_IQ_CORR_CHAN(n) (((uint32_t)(n) & 0x3) << 16)
+#define MBOX_IQ_CORR_IDX(n) ((uint32_t)(n) & 0xFFFF)
+
+/* MBOX_OPC_GET_STATS_COUNT, ack MSB : counter value */
+#define MBOX_STATS_RST 0x00100000
+#define MBOX_STATS_IDX(n) ((uint32_t)(n) & 0xFFFF)
+
+/* MBOX_OPC_PROXY_OFFSET, LSB : iqflood proxy offset, ack MSB : current offset */
+#define MBOX_PROXY_OFFSET_RO 0x00100000
+
+/*
+ * MBOX_OPC_IQ_CORR_BLOCK, LSB : modem address of a mbox_qec_block_t in iqflood (16B aligned).
+ * Firmware DMAs the block in, checks it and loads every field of valid_mask into the tx or rx QEC
+ * parameters in one go, between two QEC kernel calls. Ack MSB : block seq, NACK MSB : MBOX_QEC_BLOCK_ERR_xxx.
+ * Layout is 32 bit words only, identical on host and VSPA.
+ */
+#define MBOX_QEC_BLOCK_MAGIC 0x51454342 /* "QECB" */
+#define MBOX_QEC_BLOCK_VERSION 1
+#define MBOX_QEC_BLOCK_SIZE 128 /* bytes */
+#define MBOX_QEC_BLOCK_WORDS (MBOX_QEC_BLOCK_SIZE / 4)
+#define MBOX_QEC_BLOCK_NB_TAPS 12
+
+#define MBOX_QEC_BLOCK_TX 0x1  /* flags : tx params, rx otherwise */
+#define MBOX_QEC_BLOCK_RST 0x2 /* flags : reset params before load */
+
+#define MBOX_QEC_BLOCK_FTAP(n) (1 << (n)) /* valid_mask */
+#define MBOX_QEC_BLOCK_DC_I (1 << 12)
+#define MBOX_QEC_BLOCK_DC_Q (1 << 13)
+#define MBOX_QEC_BLOCK_FDELAY (1 << 14)
+
+#define MBOX_QEC_BLOCK_ERR_MAGIC 1
+#define MBOX_QEC_BLOCK_ERR_VERSION 2
+#define MBOX_QEC_BLOCK_ERR_CHECKSUM 3
+#define MBOX_QEC_BLOCK_ERR_ALIGN 4
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t flags;
+    uint32_t chan;       /* same as MBOX_OPC_IQ_CORR channel field */
+    uint32_t valid_mask; /* fields to load, others untouched */
+    float ftaps[MBOX_QEC_BLOCK_NB_TAPS];
+    float dc_i;
+    float dc_q;
+    uint32_t delay;
+    uint32_t seq; /* echoed in ack */
+    uint32_t reserved[10];
+    uint32_t checksum; /* ~(sum of all previous words) */
+} mbox_qec_block_t;
+
+static inline uint32_t mbox_qec_block_checksum(const uint32_t *words) {
+    uint32_t i, sum = 0;
+
+    for (i = 0; i < MBOX_QEC_BLOCK_WORDS - 1; i++)
+        sum += words[i];
+    return ~sum;
+}
+
+#endif // __VSPA_MBOX_CMD_H__